@@ -21,6 +21,8 @@
 // $Id$
 #include <getfem_interface.h>
 #include <getfemint.h>
+#include <getfem/getfem_omp.h>
+#include <mutex>
 
 using namespace getfemint;
 
@@ -76,12 +78,13 @@ void gf_util(getfemint::mexargs_in& in, getfemint::mexargs_out& out);
 void gf_exit(getfemint::mexargs_in&, getfemint::mexargs_out&) { exit(0); }
 
 namespace getfemint {
-  std::stringstream *global_pinfomsg = 0;
+  // Each thread calling the interface has its own messages and config.
+  thread_local std::stringstream *global_pinfomsg = 0;
   std::ostream& infomsg() {
     return *global_pinfomsg;
   }
 
-  config *config::cfg = 0;
+  thread_local config *config::cfg = 0;
   config::config(gfi_interface_type t) : current_function_(0) {
     switch (t) {
     case MATLAB_INTERFACE:
@@ -122,8 +125,9 @@ char* getfem_interface_main(int config_id, const char *function,
 
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
     subc_tab["workspace"] = gf_workspace;
     subc_tab["delete"] = gf_delete;
     subc_tab["eltm"] = gf_eltm;
@@ -174,7 +178,13 @@ char* getfem_interface_main(int config_id, const char *function,
     subc_tab["linsolve"] = gf_linsolve;
     subc_tab["util"] = gf_util;
     subc_tab["exit"] = gf_exit;
-  }
+  });
+
+  // Calls from several threads run concurrently, each one with its own
+  // GetFEM caches, up to the number set by 'set num caller threads'. The
+  // others wait for a free slot. The object workspace is shared and locked
+  // only while accessed.
+  getfem::caller_thread caller;
 
 
   std::stringstream info;
@@ -187,11 +197,12 @@ char* getfem_interface_main(int config_id, const char *function,
   //     gfi_array_print((gfi_array*)in_args[i]); cout << "\n";
   //  }
   try {
-    static getfemint::config *conf[3];
+    static thread_local std::unique_ptr<getfemint::config> conf[3];
     if (!conf[config_id])
-      conf[config_id] = new getfemint::config((gfi_interface_type)config_id);
+      conf[config_id] = std::make_unique<getfemint::config>
+        ((gfi_interface_type)config_id);
     conf[config_id]->current_function_ = function;
-    config::set_current_config(conf[config_id]);
+    config::set_current_config(conf[config_id].get());
     mexargs_in in(nb_in_args, in_args, false);
     mexargs_out out(*nb_out_args);
     out.set_scilab(bool(scilab_flag));
@@ -38,6 +38,10 @@
 extern "C" {
 #endif
 
+/* Can be called from several threads (with the Python GIL released for
+   instance). Up to getfem::nb_caller_threads() calls run concurrently,
+   each one with its own GetFEM caches, the others wait. The object
+   workspace is shared and locked only while it is accessed. */
 char* getfem_interface_main(int config_id, const char *function, 
 			    int nb_in_args,
 			    const gfi_array *in_args[], 
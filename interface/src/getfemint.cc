@@ -691,30 +691,34 @@ namespace getfemint {
       id_type id = store_spmat_object(gsp);
       from_object_id(id, SPMAT_CLASS_ID);
     } else {
-      M.to_csc();
-      size_type nnz = M.nnz();
-      size_type ni = M.nrows(), nj = M.ncols();
-      arg = checked_gfi_create_sparse(int(ni), int(nj), int(nnz),
-                                      M.is_complex() ? GFI_COMPLEX : GFI_REAL);
-      assert(arg != NULL);
-      double *pr;
-      unsigned *ir, *jc;
-      pr = gfi_sparse_get_pr(arg); assert(pr != NULL);
-      ir = gfi_sparse_get_ir(arg); assert(ir != NULL);
-      jc = gfi_sparse_get_jc(arg); assert(jc != NULL); /* dim == nj+1 */
-      if (!M.is_complex()) {
-        memcpy(pr, M.real_csc().pr, sizeof(double)*nnz);
-        memcpy(ir, M.real_csc().ir, sizeof(int)*nnz);
-        memcpy(jc, M.real_csc().jc, sizeof(int)*(nj+1));
-      } else {
-        memcpy(pr, M.cplx_csc().pr, sizeof(complex_type)*nnz);
-        memcpy(ir, M.cplx_csc().ir, sizeof(int)*nnz);
-        memcpy(jc, M.cplx_csc().jc, sizeof(int)*(nj+1));
-      }
+      from_native_sparse(M);
       M.deallocate(); // avoid nasty leak
     }
   }
 
+  void mexarg_out::from_native_sparse(gsparse& M) {
+    M.to_csc();
+    size_type nnz = M.nnz();
+    size_type ni = M.nrows(), nj = M.ncols();
+    arg = checked_gfi_create_sparse(int(ni), int(nj), int(nnz),
+                                    M.is_complex() ? GFI_COMPLEX : GFI_REAL);
+    assert(arg != NULL);
+    double *pr;
+    unsigned *ir, *jc;
+    pr = gfi_sparse_get_pr(arg); assert(pr != NULL);
+    ir = gfi_sparse_get_ir(arg); assert(ir != NULL);
+    jc = gfi_sparse_get_jc(arg); assert(jc != NULL); /* dim == nj+1 */
+    if (!M.is_complex()) {
+      memcpy(pr, M.real_csc().pr, sizeof(double)*nnz);
+      memcpy(ir, M.real_csc().ir, sizeof(int)*nnz);
+      memcpy(jc, M.real_csc().jc, sizeof(int)*(nj+1));
+    } else {
+      memcpy(pr, M.cplx_csc().pr, sizeof(complex_type)*nnz);
+      memcpy(ir, M.cplx_csc().ir, sizeof(int)*nnz);
+      memcpy(jc, M.cplx_csc().jc, sizeof(int)*(nj+1));
+    }
+  }
+
   void
   mexarg_out::from_tensor(const getfem::base_tensor& t) {
     std::vector<int> tab(t.sizes().begin(), t.sizes().end());
@@ -1082,15 +1086,11 @@ namespace getfemint {
   }									\
 									\
   id_type store_##NAME##_object(const std::shared_ptr<TYPE> &shp) {	\
-    auto &w = workspace();						\
-    id_type id = w.object((const void *)(shp.get()));			\
-    if (id == id_type(-1)) {						\
-      auto p =	std::dynamic_pointer_cast				\
-	<const dal::static_stored_object>(shp);				\
-      if (!(p.get())) THROW_INTERNAL_ERROR;				\
-      id = w.push_object(p, (const void *)(shp.get()), CLASS_ID);	\
-    }									\
-    return id;								\
+    auto p = std::dynamic_pointer_cast					\
+      <const dal::static_stored_object>(shp);				\
+    if (!(p.get())) THROW_INTERNAL_ERROR;				\
+    /* finds or inserts at once, another thread may store it as well */	\
+    return workspace().push_object(p, (const void *)(shp.get()), CLASS_ID);\
   }									\
 									\
   TYPE *to_##NAME##_object(const mexarg_in &p) {			\
@@ -1117,15 +1117,11 @@ namespace getfemint {
 									\
   id_type store_##NAME##_object(const std::shared_ptr<const TYPE> &shp)	\
   {									\
-    auto &w = workspace();						\
-    id_type id = w.object((const void *)(shp.get()));			\
-    if (id == id_type(-1)) {						\
-      auto p =								\
-       std::dynamic_pointer_cast<const dal::static_stored_object>(shp); \
-      if (!(p.get())) THROW_INTERNAL_ERROR;				\
-      id = w.push_object(p, (const void *)(shp.get()), CLASS_ID);	\
-    }									\
-    return id;								\
+    auto p = std::dynamic_pointer_cast					\
+      <const dal::static_stored_object>(shp);				\
+    if (!(p.get())) THROW_INTERNAL_ERROR;				\
+    /* finds or inserts at once, another thread may store it as well */	\
+    return workspace().push_object(p, (const void *)(shp.get()), CLASS_ID);\
   }									\
 									\
   std::shared_ptr<const TYPE> to_##NAME##_object(const mexarg_in &p) {	\
@@ -38,6 +38,7 @@
 
 #include <getfemint_std.h>
 #include <set>
+#include <mutex>
 #include <getfem/dal_static_stored_objects.h>
 #include <getfem/dal_bit_vector.h>
 #include <getfem/getfem_config.h>
@@ -537,6 +538,8 @@ namespace getfemint {
     void from_sparse(gf_cplx_sparse_by_col& M,
                      output_sparse_fmt fmt = USE_DEFAULT_SPARSE);
     void from_sparse(gsparse& M, output_sparse_fmt fmt = USE_DEFAULT_SPARSE);
+    /* M is converted to CSC but not erased */
+    void from_native_sparse(gsparse& M);
 
     void from_tensor(const getfem::base_tensor& t);
     carray create_carray_v(unsigned dim);
@@ -90,7 +90,7 @@ namespace getfemint
 
   /* see getfem_interface.C */
   struct config {
-    static config *cfg;
+    static thread_local config *cfg; /* config of the current thread call */
     gfi_interface_type interface_type_;
     int base_index_; /* base indexing of arrays (matlab starts at 1, python at 0 */
     bool can_return_integer_; /* matlab < 7 is brain-damaged with respect to int32 type */
@@ -25,18 +25,21 @@
 #include <getfem/bgeot_config.h>
 #include <getfemint_workspace.h>
 #include <iomanip>
+#include <algorithm>
 
 namespace getfemint {
 
+  // Shared by all the caller threads.
   workspace_stack& workspace() {
-    return dal::singleton<workspace_stack>::instance();
+    return dal::singleton<workspace_stack>::instance(0);
   }
 
   /* deletes the current workspace and returns to the parent workspace */
   void workspace_stack::pop_workspace(bool keep_all) {
+    write_lock lock(mutex);
     if (wrk.size() == 1) THROW_ERROR("You cannot pop the main workspace\n");
-    if (keep_all) send_all_objects_to_parent_workspace();
-    else clear_workspace();
+    if (keep_all) send_all_objects_to_parent_workspace_();
+    else clear_workspace_(current_workspace_());
     wrk.pop_back();
   }
 
@@ -44,6 +47,19 @@ namespace getfemint {
   id_type workspace_stack::push_object(const dal::pstatic_stored_object &p,
 					const void *raw_pointer,
 					getfemint_class_id class_id) {
+    write_lock lock(mutex);
+    auto it = kmap.find(raw_pointer);
+    if (it != kmap.end()) {
+      // Already stored, possibly by the current call of another thread
+      // which can no longer destroy it.
+      id_type id = it->second;
+      for (auto &nc : newly_created_objects)
+	if (nc.first != std::this_thread::get_id())
+	  nc.second.erase(std::remove(nc.second.begin(), nc.second.end(), id),
+			  nc.second.end());
+      return id;
+    }
+
     id_type id = id_type(valid_objects.first_false());
     valid_objects.add(id);
     if (id >= obj.size()) obj.push_back(object_info());
@@ -51,16 +67,17 @@ namespace getfemint {
     object_info &o = obj[id];
     o.p = p;
     o.raw_pointer = raw_pointer;
-    o.workspace = get_current_workspace();
+    o.workspace = current_workspace_();
     o.class_id = class_id;
     o.dependent_on.clear();
 
     kmap[raw_pointer] = id;
-    newly_created_objects.push_back(id);
+    newly_created_objects[std::this_thread::get_id()].push_back(id);
     return id;
   }
 
   void workspace_stack::sup_dependence(id_type user, id_type used) {
+    write_lock lock(mutex);
     if (!(valid_objects.is_in(user)) || !(valid_objects.is_in(used)))
       THROW_ERROR("Invalid object\n");
     auto &u = obj[user].dependent_on;
@@ -73,6 +90,12 @@ namespace getfemint {
   
   void workspace_stack::add_hidden_object(id_type user,
 					  const dal::pstatic_stored_object &p) {
+    write_lock lock(mutex);
+    add_hidden_object_(user, p);
+  }
+
+  void workspace_stack::add_hidden_object_(id_type user,
+					   const dal::pstatic_stored_object &p) {
     if (!(valid_objects.is_in(user))) THROW_ERROR("Invalid object\n");
     auto &u = obj[user].dependent_on;
     for (auto it = u.begin(); it != u.end(); ++it)
@@ -82,6 +105,7 @@ namespace getfemint {
 
   dal::pstatic_stored_object workspace_stack::hidden_object(id_type user,
 							    const void *p) {
+    read_lock lock(mutex);
     if (!(valid_objects.is_in(user))) THROW_ERROR("Invalid object\n");
     auto &u = obj[user].dependent_on;
     for (auto it = u.begin(); it != u.end(); ++it)
@@ -90,50 +114,77 @@ namespace getfemint {
   }
 
   void workspace_stack::set_dependence(id_type user, id_type used) {
+    write_lock lock(mutex);
     if (!(valid_objects.is_in(user)) || !(valid_objects.is_in(used)))
       THROW_ERROR("Invalid object\n");
-    add_hidden_object(user, obj[used].p);
+    add_hidden_object_(user, obj[used].p);
   }
 
   void workspace_stack::delete_object(id_type id) {
+    write_lock lock(mutex);
+    delete_object_(id);
+  }
+
+  void workspace_stack::delete_object_(id_type id) {
     if (valid_objects[id]) {
       object_info &ob = obj[id];
       valid_objects.sup(id);
       kmap.erase(ob.raw_pointer);
       ob = object_info();
+      // The id may be reused, it must not be destroyed again by a thread.
+      for (auto &nc : newly_created_objects)
+	nc.second.erase(std::remove(nc.second.begin(), nc.second.end(), id),
+			nc.second.end());
     }
   }
 
   void workspace_stack::send_object_to_parent_workspace(id_type id) {
-    if (get_current_workspace() == 0) THROW_ERROR("Invalid operation\n");
+    write_lock lock(mutex);
+    if (current_workspace_() == 0) THROW_ERROR("Invalid operation\n");
     if (!(valid_objects.is_in(id))) THROW_ERROR("Invalid objects\n");
     auto &o = obj[id];
-    o.workspace = id_type(get_current_workspace() - 1);
+    o.workspace = id_type(current_workspace_() - 1);
   }
 
   void workspace_stack::send_all_objects_to_parent_workspace() {
-    id_type cw = get_current_workspace();
+    write_lock lock(mutex);
+    send_all_objects_to_parent_workspace_();
+  }
+
+  void workspace_stack::send_all_objects_to_parent_workspace_() {
+    id_type cw = current_workspace_();
     for (dal::bv_visitor_c id(valid_objects); !id.finished(); ++id)
       if ((obj[id]).workspace == cw) obj[id].workspace = id_type(cw-1);
   }
 
   void workspace_stack::clear_workspace(id_type wid) {
-    if (wid > get_current_workspace()) THROW_INTERNAL_ERROR;
+    write_lock lock(mutex);
+    clear_workspace_(wid);
+  }
+
+  void workspace_stack::clear_workspace_(id_type wid) {
+    if (wid > current_workspace_()) THROW_INTERNAL_ERROR;
     dal::bit_vector bv = valid_objects;
     for (dal::bv_visitor_c id(bv); !id.finished(); ++id) {
       if (valid_objects.is_in(id)) {
 	id_type owid = obj[id].workspace;
-	if (owid > get_current_workspace()) THROW_INTERNAL_ERROR;
-	if (owid == wid) delete_object(id_type(id));
+	if (owid > current_workspace_()) THROW_INTERNAL_ERROR;
+	if (owid == wid) delete_object_(id_type(id));
       }
     }
   }
 
+  bool workspace_stack::is_newly_created_(id_type id) const {
+    for (const auto &nc : newly_created_objects)
+      if (std::find(nc.second.begin(), nc.second.end(), id)
+	  != nc.second.end()) return true;
+    return false;
+  }
+
   const void *workspace_stack::object(id_type id,
 				       const char *expected_type) const {
-    if (valid_objects[id] &&
-        std::find(newly_created_objects.begin(),newly_created_objects.end(),id)
-	== newly_created_objects.end()) {
+    read_lock lock(mutex);
+    if (valid_objects[id] && !is_newly_created_(id)) {
       return obj[id].raw_pointer;
     } else {
       THROW_ERROR("object " << expected_type << " [id=" << id << "] not found");
@@ -141,11 +192,10 @@ namespace getfemint {
     return 0;
   }
 
-  const dal::pstatic_stored_object &workspace_stack::shared_pointer
+  dal::pstatic_stored_object workspace_stack::shared_pointer
   (id_type id, const char *expected_type) const {
-    if (valid_objects[id] &&
-        std::find(newly_created_objects.begin(),newly_created_objects.end(),id)
-	== newly_created_objects.end()) {
+    read_lock lock(mutex);
+    if (valid_objects[id] && !is_newly_created_(id)) {
       return obj[id].p;
     } else {
       THROW_ERROR("object " << expected_type << " [id=" << id << "] not found");
@@ -153,6 +203,11 @@ namespace getfemint {
   }
 
   id_type workspace_stack::object(const void *raw_pointer) const {
+    read_lock lock(mutex);
+    return object_(raw_pointer);
+  }
+
+  id_type workspace_stack::object_(const void *raw_pointer) const {
     auto it = kmap.find(raw_pointer);
     if (it != kmap.end()) return it->second; else return id_type(-1);
   }
@@ -160,17 +215,30 @@ namespace getfemint {
   id_type workspace_stack::object(const dal::pstatic_stored_object &p) const
   { const void *q; class_id_of_object(p, &q); return object(q); }
 
-  void workspace_stack::commit_newly_created_objects()
-  { newly_created_objects.resize(0); }
+  void workspace_stack::commit_newly_created_objects() {
+    write_lock lock(mutex);
+    newly_created_objects.erase(std::this_thread::get_id());
+  }
 
   void workspace_stack::destroy_newly_created_objects() {
-    while (newly_created_objects.size()) {
-      delete_object(newly_created_objects.back());
-      newly_created_objects.pop_back();
+    write_lock lock(mutex);
+    auto it = newly_created_objects.find(std::this_thread::get_id());
+    if (it == newly_created_objects.end()) return;
+    std::vector<id_type> ids;
+    ids.swap(it->second);
+    newly_created_objects.erase(it);
+    while (ids.size()) {
+      delete_object_(ids.back());
+      ids.pop_back();
     }
   }
 
-  void workspace_stack::do_stats(std::ostream &o, id_type wid) {  
+  void workspace_stack::do_stats(std::ostream &o, id_type wid) const {
+    read_lock lock(mutex);
+    do_stats_(o, wid);
+  }
+
+  void workspace_stack::do_stats_(std::ostream &o, id_type wid) const {
     if (wid == id_type(-1)) {
       o << "Anonymous workspace (objects waiting for deletion)\n";
     } else {
@@ -184,7 +252,7 @@ namespace getfemint {
     }
     
     for (dal::bv_visitor ii(valid_objects); !ii.finished(); ++ii) {
-      object_info &ob = obj[ii];
+      const object_info &ob = obj[ii];
       if (ob.workspace == wid) {
 	std::string subclassname;
 	o << " ID" << std::setw(4) << ii << " " << std::setw(20)
@@ -193,7 +261,9 @@ namespace getfemint {
 	if (ob.dependent_on.size()) {
 	  o << " depends on ";
 	  for (size_type i=0; i < ob.dependent_on.size(); ++i) {
-	    id_type id = object(ob.dependent_on[i]);
+	    const void *q;
+	    class_id_of_object(ob.dependent_on[i], &q);
+	    id_type id = object_(q);
 	    if (id != id_type(-1))
 	      o << " ID" << id;
 	    else
@@ -208,9 +278,10 @@ namespace getfemint {
     }
   }
 
-  void workspace_stack::do_stats(std::ostream &o) {
+  void workspace_stack::do_stats(std::ostream &o) const {
+    read_lock lock(mutex);
     for (size_type wid = 0; wid < wrk.size(); ++wid)
-      do_stats(o, id_type(wid));
+      do_stats_(o, id_type(wid));
   }
 
 }
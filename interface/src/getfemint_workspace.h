@@ -35,6 +35,8 @@
 #include <getfemint.h>
 #include <getfem/dal_bit_vector.h>
 #include <getfem/dal_static_stored_objects.h>
+#include <shared_mutex>
+#include <thread>
 
 namespace getfemint {
 
@@ -50,6 +52,9 @@ namespace getfemint {
   // The object having a delayed deletion are called hidden objects. It is
   // also possible to directlycreate an hidden object. An hidden object
   // can eventually be retransformed in a normal object.
+  // The workspace is shared by all the threads calling the interface. It is
+  // protected by a readers-writer lock which is only held while the
+  // workspace itself is accessed, not while the objects are used.
 
   class workspace_stack {
     
@@ -72,17 +77,34 @@ namespace getfemint {
     wrk_ct wrk;                      // Stack of used workspaces.
 
     std::map<const void *, id_type> kmap;
-    std::vector<id_type> newly_created_objects;
+    // Objects created by the current call of each thread.
+    std::map<std::thread::id, std::vector<id_type>> newly_created_objects;
+
+    mutable std::shared_timed_mutex mutex;
+    using read_lock = std::shared_lock<std::shared_timed_mutex>;
+    using write_lock = std::unique_lock<std::shared_timed_mutex>;
+
+    // Versions of the public methods called with the lock already held.
+    id_type current_workspace_() const { return id_type(wrk.size()-1); }
+    bool is_newly_created_(id_type id) const;
+    void add_hidden_object_(id_type user, const dal::pstatic_stored_object &p);
+    void delete_object_(id_type id);
+    void send_all_objects_to_parent_workspace_();
+    void clear_workspace_(id_type w);
+    id_type object_(const void *raw_pointer) const;
+    void do_stats_(std::ostream &o, id_type wid) const;
 
   public:
 
     // Creates a new workspace on top of the stack
-    void push_workspace(const std::string &n = "Unnamed") { wrk.push_back(n); }
+    void push_workspace(const std::string &n = "Unnamed")
+    { write_lock lock(mutex); wrk.push_back(n); }
 
     // Deletes the current workspace and returns to the parent workspace
     void pop_workspace(bool keep_all = false);
 
-    // Inserts a new object (and gives it an id)
+    // Inserts a new object (and gives it an id). Returns the id of the
+    // object if it is already stored.
     id_type push_object(const dal::pstatic_stored_object &p,
 			const void *raw_pointer, getfemint_class_id class_id);
 
@@ -113,20 +135,22 @@ namespace getfemint {
     void send_object_to_parent_workspace(id_type obj_id);
     void send_all_objects_to_parent_workspace();
 
-    id_type get_current_workspace() const { return id_type(wrk.size()-1); }
+    id_type get_current_workspace() const
+    { read_lock lock(mutex); return current_workspace_(); }
     id_type get_base_workspace() const { return id_type(0); }
     /* Delete every object in the workspace, but *does not* delete the
        workspace itself */
     void clear_workspace(id_type w);
     /* clears the current workspace */
-    void clear_workspace() { clear_workspace(get_current_workspace()); }
+    void clear_workspace()
+    { write_lock lock(mutex); clear_workspace_(current_workspace_()); }
 
     
     /* Throw an error if not found */
     const void *object(id_type id, const char *expected_type="") const;
 
     /* Throw an error if not found */
-    const dal::pstatic_stored_object &shared_pointer
+    dal::pstatic_stored_object shared_pointer
     (id_type id, const char *expected_class="") const;
 
     /* Return id_type(-1) if not found */
@@ -137,11 +161,12 @@ namespace getfemint {
     
     workspace_stack() { push_workspace("main"); }
 
+    // Validates or destroys the objects created by the current thread.
     void commit_newly_created_objects();
     void destroy_newly_created_objects();
 
-    void do_stats(std::ostream &o, id_type wid);
-    void do_stats(std::ostream &o);
+    void do_stats(std::ostream &o, id_type wid) const;
+    void do_stats(std::ostream &o) const;
   };
 
   workspace_stack& workspace();
@@ -766,8 +766,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_asm(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@FUNC @CELL{...} = ('generic', @tmim mim, @int order, @str expression, @int region, [@tmodel model, ['Secondary_domain', 'name',]] [@str varname, @int is_variable[, {@tmf mf, @tmimd mimd}], value], ['select_output', 'varname1'[, 'varname2]], ...)
       High-level generic assembly procedure for volumic or boundary assembly.
@@ -1474,7 +1475,7 @@ void gf_asm(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        out.pop().from_sparse(M);
        );
 
-  }
+  });
 
   if (m_in.narg() < 1)  THROW_BADARG( "Wrong number of input arguments");
 
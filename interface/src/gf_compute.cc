@@ -228,8 +228,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_compute(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@FUNC n = ('L2 norm', @tmim mim[, @mat CVids])
@@ -615,7 +616,7 @@ void gf_compute(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        );
 
 
-  }
+  });
   
   
   if (m_in.narg() < 3)  THROW_BADARG( "Wrong number of input arguments");
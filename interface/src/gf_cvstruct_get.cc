@@ -69,8 +69,9 @@ void gf_cvstruct_get(getfemint::mexargs_in& m_in,
                      getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@RDATTR n = ('nbpts')
       Get the number of points of the convex structure.@*/
@@ -139,7 +140,7 @@ void gf_cvstruct_get(getfemint::mexargs_in& m_in,
        );
 
 
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
@@ -73,8 +73,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_fem_get(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@RDATTR n = ('nbdof'[, @int cv])
@@ -256,7 +257,7 @@ void gf_fem_get(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        infomsg() << endl;
        );
 
-  }
+  });
 
 
 
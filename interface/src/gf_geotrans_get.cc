@@ -64,8 +64,9 @@ void gf_geotrans_get(getfemint::mexargs_in& m_in,
 		     getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@RDATTR d = ('dim')
       Get the dimension of the @tgt.
@@ -153,7 +154,7 @@ void gf_geotrans_get(getfemint::mexargs_in& m_in,
        << ", with " << pgt->nb_points() << " points \n";
        );
 
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
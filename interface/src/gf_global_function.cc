@@ -69,8 +69,9 @@ void gf_global_function(getfemint::mexargs_in& m_in,
                         getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@INIT GF = ('cutoff', @int fn, @scalar r, @scalar r1, @scalar r0)
@@ -129,7 +130,7 @@ void gf_global_function(getfemint::mexargs_in& m_in,
        ggf = std::make_shared<getfem::add_of_xy_functions>(af1,af2);
        );
 
-  }
+  });
 
 
 
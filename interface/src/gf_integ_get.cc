@@ -70,8 +70,9 @@ void gf_integ_get(getfemint::mexargs_in& m_in,
 		  getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
   
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@RDATTR b = ('is_exact')
     Return 0 if the integration is an approximate one.@*/
@@ -192,7 +193,7 @@ void gf_integ_get(getfemint::mexargs_in& m_in,
 		   << " Gauss points \n";
        );
   
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
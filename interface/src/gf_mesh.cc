@@ -409,8 +409,9 @@ void gf_mesh(getfemint::mexargs_in& m_in,
 	     getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@INIT M = ('empty', @int dim)
       Create a new empty mesh.@*/
@@ -613,7 +614,7 @@ void gf_mesh(getfemint::mexargs_in& m_in,
 
        getfem::build_mesh(*pmesh, psd, h, fixed, K, -1, max_iter, prefind);
        );
-  }
+  });
 
 
   if (m_in.narg() < 1)  THROW_BADARG( "Wrong number of input arguments");
@@ -81,8 +81,9 @@ void gf_mesh_fem(getfemint::mexargs_in& m_in,
                  getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@INIT MF = ('load', @str fname[, @tmesh m])
       Load a @tmf from a file.
@@ -382,7 +383,7 @@ void gf_mesh_fem(getfemint::mexargs_in& m_in,
        store_meshfem_object(mmf);
        workspace().set_dependence(mmf.get(), gmf);
        );
-  }
+  });
 
 
   if (m_in.narg() < 1) THROW_BADARG("Wrong number of input arguments");
@@ -138,8 +138,9 @@ void gf_mesh_fem_set(getfemint::mexargs_in& m_in,
                      getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
   
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     
     /*@SET ('fem', @tfem f[, @ivec CVids])
@@ -310,7 +311,7 @@ void gf_mesh_fem_set(getfemint::mexargs_in& m_in,
        mfprod->set_enrichment(doflst);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
@@ -380,8 +380,9 @@ void gf_mesh_get(getfemint::mexargs_in& m_in,
                  getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@RDATTR d = ('dim')
     Get the dimension of the mesh (2 for a 2D mesh, etc).@*/
@@ -1336,7 +1337,7 @@ void gf_mesh_get(getfemint::mexargs_in& m_in,
        << pmesh->convex_index().card() << " elements\n";
        );
 
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
   const getfem::mesh *pmesh = extract_mesh_object(m_in.pop());
@@ -70,8 +70,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_mesh_im(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@INIT MIM = ('load', @str fname[, @tmesh m])
@@ -224,7 +225,7 @@ void gf_mesh_im(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        workspace().set_dependence(mim.get(), &mls);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 1) THROW_BADARG("Wrong number of input arguments");
@@ -71,8 +71,9 @@ void gf_mesh_im_data_get(getfemint::mexargs_in& m_in,
                          getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@GET ('region')
       Output the region that the @tmimd is restricted to.
@@ -145,7 +146,7 @@ void gf_mesh_im_data_get(getfemint::mexargs_in& m_in,
        out.pop().from_object_id(id, MESH_CLASS_ID);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
@@ -87,8 +87,9 @@ void gf_mesh_im_get(getfemint::mexargs_in& m_in,
                     getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@GET @CELL{I, CV2I} = ('integ'[, @mat CVids])
     Return a list of integration methods used by the @tmim.
@@ -294,7 +295,7 @@ void gf_mesh_im_get(getfemint::mexargs_in& m_in,
        out.pop().from_integer(int(mim->memsize()));
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
@@ -65,8 +65,9 @@ void gf_mesh_levelset_get(getfemint::mexargs_in& m_in,
                           getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@GET M = ('cut_mesh')
@@ -154,7 +155,7 @@ void gf_mesh_levelset_get(getfemint::mexargs_in& m_in,
        );
 
 
-  }
+  });
 
 
 
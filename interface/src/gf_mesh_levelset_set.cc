@@ -67,8 +67,9 @@ void gf_mesh_levelset_set(getfemint::mexargs_in& m_in,
                           getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@SET ('add', @tls ls)
     Add a link to the @tls `ls`.
@@ -102,18 +103,22 @@ void gf_mesh_levelset_set(getfemint::mexargs_in& m_in,
        );
 
 
-    /*@SET ('adapt')
+    /*@SET ('adapt'[, @int incremental])
     Do all the work (cut the convexes with the levelsets).
 
     To initialice the @tmls object or to actualize it when the
     value of any levelset function is modified, one has to call
-    this method.@*/
+    this method. If `incremental` is not zero, only the convexes on
+    which the value of a levelset function has changed since the
+    last call are cut again.@*/
     sub_command
-      ("adapt", 0, 0, 0, 0,
-       mls.adapt();
+      ("adapt", 0, 1, 0, 0,
+       bool incremental = false;
+       if (in.remaining()) incremental = (in.pop().to_integer(0, 1) != 0);
+       mls.adapt(incremental);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
@@ -122,8 +122,9 @@ void gf_mesh_set(getfemint::mexargs_in& m_in,
                  getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@SET PIDs = ('pts', @mat PTS)
@@ -402,7 +403,7 @@ void gf_mesh_set(getfemint::mexargs_in& m_in,
        pmesh->Bank_refine(bv);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
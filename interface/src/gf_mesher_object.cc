@@ -65,8 +65,9 @@ void gf_mesher_object(getfemint::mexargs_in& m_in,
 		      getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
     
     /*@INIT MF = ('ball', @vec center, @scalar radius)
       Represents a ball of corresponding center and radius.
@@ -206,7 +207,7 @@ void gf_mesher_object(getfemint::mexargs_in& m_in,
        getfem::pmesher_signed_distance psd2 = to_mesher_object(in.pop());
        psd = getfem::new_mesher_setminus(psd1, psd2);
        );
-  }
+  });
 
   if (m_in.narg() < 1) THROW_BADARG("Wrong number of input arguments");
   getfem::pmesher_signed_distance psd;
@@ -64,8 +64,9 @@ void gf_mesher_object_get(getfemint::mexargs_in& m_in,
 			    getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
   
 
     /*@GET s = ('char')
@@ -89,7 +90,7 @@ void gf_mesher_object_get(getfemint::mexargs_in& m_in,
       ("display", 0, 0, 0, 0,
        infomsg() << "gfMesherObject object\n";
        );
-  }
+  });
 
 
 
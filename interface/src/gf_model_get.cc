@@ -97,8 +97,9 @@ void gf_model_get(getfemint::mexargs_in& m_in,
                   getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@GET b = ('is_complex')
       Return 0 is the model is real, 1 if it is complex.@*/
@@ -130,6 +131,57 @@ void gf_model_get(getfemint::mexargs_in& m_in,
        out.pop().from_scalar(md->get_time());
        );
 
+    /*@GET ('assembly profile'[, @str what])
+      Return the profile of the generic assemblies of the model (the
+      profiling being enabled with MODEL:SET('enable assembly profiling')).
+      Without argument, a readable report is returned as a string. If
+      `what` is 'summary', the vector [nb_assemblies, nb_elements,
+      nb_gauss_points, compile_time, exec_time, nb_scatter_calls,
+      scatter_time] is returned. If `what` is 'instructions' (resp.
+      'expressions'), a list of instruction types (resp. expressions), the
+      corresponding numbers of calls (resp. of integration points) and
+      cumulated times are returned. @*/
+    sub_command
+      ("assembly profile", 0, 1, 0, 3,
+       const getfem::ga_assembly_profile &p = md->assembly_profile();
+       if (!in.remaining()) {
+         std::stringstream s; s << p;
+         out.pop().from_string(s.str().c_str());
+       } else {
+         std::string what = in.pop().to_string();
+         if (cmd_strmatch(what, "summary")) {
+           std::vector<double> v(7);
+           v[0] = double(p.nb_assemblies); v[1] = double(p.nb_elements);
+           v[2] = double(p.nb_gauss_points); v[3] = p.compile_time;
+           v[4] = p.exec_time; v[5] = double(p.scatter.nb_calls);
+           v[6] = p.scatter.time;
+           out.pop().from_dcvector(v);
+         } else if (cmd_strmatch(what, "instructions")
+                    || cmd_strmatch(what, "expressions")) {
+           bool instr = cmd_strmatch(what, "instructions");
+           std::vector<std::string> names;
+           std::vector<double> counts;
+           std::vector<double> times;
+           if (instr)
+             for (const auto &i : p.instructions) {
+               names.push_back(i.first);
+               counts.push_back(double(i.second.nb_calls));
+               times.push_back(i.second.time);
+             }
+           else
+             for (const auto &e : p.expressions) {
+               names.push_back(e.first);
+               counts.push_back(double(e.second.nb_gauss_points));
+               times.push_back(e.second.instructions.time);
+             }
+           out.pop().from_string_container(names);
+           if (out.remaining()) out.pop().from_dcvector(counts);
+           if (out.remaining()) out.pop().from_dcvector(times);
+         } else
+           THROW_BADARG("Invalid argument " << what);
+       }
+       );
+
     /*@GET T = ('tangent_matrix')
       Return the tangent matrix stored in the model .@*/
     sub_command
@@ -1353,7 +1405,7 @@ void gf_model_get(getfemint::mexargs_in& m_in,
        << " degrees of freedom\n";
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
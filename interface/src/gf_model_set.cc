@@ -82,8 +82,9 @@ void gf_model_set(getfemint::mexargs_in& m_in,
                   getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@SET ('clear')
       Clear the model.@*/
@@ -2930,6 +2931,27 @@ void gf_model_set(getfemint::mexargs_in& m_in,
        getfem::add_Houbolt_scheme(*md, varname);
        );
 
+     /*@SET ('enable assembly profiling'[, @int enable])
+       Enable (or disable if `enable` is 0) the profiling of the generic
+       assemblies of the model: time and number of calls per compiled
+       instruction type and per expression, elements and integration points
+       visited, time spent in the addition of the element matrices. The
+       profile is cumulated over the assemblies and is obtained with
+       MODEL:GET('assembly profile'). @*/
+     sub_command
+       ("enable assembly profiling", 0, 1, 0, 0,
+        bool enable = true;
+        if (in.remaining()) enable = (in.pop().to_integer(0, 1) != 0);
+        md->enable_assembly_profiling(enable);
+        );
+
+     /*@SET ('clear assembly profile')
+       Reset the cumulated profile of the assemblies. @*/
+     sub_command
+       ("clear assembly profile", 0, 0, 0, 0,
+        md->clear_assembly_profile();
+        );
+
      /*@SET ('disable bricks', @ivec bricks_indices)
        Disable a brick (the brick will no longer participate to the
        building of the tangent linear system).@*/
@@ -4066,7 +4088,7 @@ void gf_model_set(getfemint::mexargs_in& m_in,
        (*md, ind, *mim, region, true, true, true,
         dispname, sigma, wname);
        );
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
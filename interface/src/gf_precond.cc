@@ -128,8 +128,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_precond(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@INIT PC = ('identity')
@@ -254,7 +255,7 @@ void gf_precond(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        precond_spmat(ggsp, out);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 1)  THROW_BADARG( "Wrong number of input arguments");
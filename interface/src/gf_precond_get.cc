@@ -72,8 +72,9 @@ void gf_precond_get(getfemint::mexargs_in& m_in,
 		    getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@GET ('mult', @vec V)
@@ -161,7 +162,7 @@ void gf_precond_get(getfemint::mexargs_in& m_in,
        << precond->memsize() << " bytes]";
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 1)  THROW_BADARG( "Wrong number of input arguments");
@@ -163,8 +163,9 @@ void gf_slice_get(getfemint::mexargs_in& m_in,
 
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@RDATTR d = ('dim')
       Return the dimension of the slice (2 for a 2D mesh, etc..).@*/
@@ -652,7 +653,7 @@ void gf_slice_get(getfemint::mexargs_in& m_in,
        << " and " << sl->nb_points() << " points.\n";
        );
 
-  }
+  });
  
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
@@ -175,8 +175,9 @@ void gf_spmat(getfemint::mexargs_in& m_in,
 	      getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@INIT SM = ('empty', @int m [, @int n])
@@ -302,7 +303,7 @@ void gf_spmat(getfemint::mexargs_in& m_in,
        load_spmat(in, *gsp);
        );
 
-  }
+  });
 
 
   if (m_in.narg() < 1)  THROW_BADARG( "Wrong number of input arguments");
@@ -205,8 +205,9 @@ void gf_spmat_get(getfemint::mexargs_in& m_in,
 		  getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
   
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
   
 
     /*@GET n = ('nnz')
@@ -306,6 +307,17 @@ void gf_spmat_get(getfemint::mexargs_in& m_in,
        );
 
     
+    /*@GET Mn = ('csc')
+      Return a copy of `M` as a native sparse matrix of the interface
+      language (a scipy.sparse.csc_matrix for Python).
+
+      If `M` is not stored as a CSC matrix, it is converted into CSC.@*/
+    sub_command
+      ("csc", 0, 0, 0, 1,
+       out.pop().from_native_sparse(gsp);
+       );
+
+
     /*@GET V = ('csc_val')
       Return the array of values of all non-zero entries of `M`.
       
@@ -424,7 +436,7 @@ void gf_spmat_get(getfemint::mexargs_in& m_in,
        if (out.remaining()) out.pop().from_integer(exponent);
        );
 #endif
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
@@ -141,8 +141,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_spmat_set(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@SET ('clear'[, @list I[, @list J]])
@@ -270,7 +271,7 @@ void gf_spmat_set(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        spmat_set_or_add_sub_matrix(gsp, in, true);
        );
 
-  }
+  });
 
   if (m_in.narg() < 2)  THROW_BADARG( "Wrong number of input arguments");
 
@@ -66,8 +66,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_util(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
 
     /*@FUNC ('save matrix', @str FMT, @str FILENAME, @mat A)
@@ -140,7 +141,18 @@ void gf_util(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        getfem::set_num_threads(in.pop().to_integer(0, 100));
        );
 
-  }
+    /*@FUNC tl = ('set num caller threads', @int nb_threads)
+      Sets the number of threads of the script which can call GetFEM at
+      the same time (1 by default), each one with its own caches and
+      'num threads' OpenMP threads. Further calls wait for one of them to
+      return. To be set before the first threads are started. It is
+      available only when GetFEM is compiled with openmp support. @*/
+    sub_command
+      ("set num caller threads", 1, 1, 0, 0,
+       getfem::set_nb_caller_threads(in.pop().to_integer(1, 100));
+       );
+
+  });
 
 
   if (m_in.narg() < 1)  THROW_BADARG("Wrong number of input arguments");
@@ -73,8 +73,9 @@ template <typename T> static inline void dummy_func(T &) {}
 void gf_workspace(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
   typedef std::map<std::string, psub_command > SUBC_TAB;
   static SUBC_TAB subc_tab;
+  static std::once_flag subc_tab_initialized;
 
-  if (subc_tab.size() == 0) {
+  std::call_once(subc_tab_initialized, [] {
 
     /*@FUNC ('push')
       Create a new temporary workspace on the workspace stack. @*/
@@ -201,7 +202,7 @@ void gf_workspace(getfemint::mexargs_in& m_in, getfemint::mexargs_out& m_out) {
        out.pop().from_integer(int(dal::nb_stored_objects()));
        );
 
-  }
+  });
 
 
 
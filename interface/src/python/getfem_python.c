@@ -576,6 +576,63 @@ build_gfi_array_list(gcollect *gc, PyObject *tuple, const char **pfunction_name,
   return l;
 }
 
+/* The data buffer of a gfi_array returned by getfem_interface_main is
+   handed over to numpy instead of being copied: the array keeps a capsule
+   as base object which frees the buffer with the array. */
+static void
+gfi_buffer_capsule_destructor(PyObject *capsule) {
+  gfi_free(PyCapsule_GetPointer(capsule, NULL));
+}
+
+static PyObject *
+PyArray_from_gfi_buffer(int nd, const u_int *dim_val, int typenum,
+                        void *data) {
+  PyObject *o, *capsule;
+  npy_intp *dim = PyDimMem_NEW(nd);
+  for (int i=0; i < nd; i++) dim[i] = (npy_intp)dim_val[i];
+  o = PyArray_New(&PyArray_Type, nd, dim, typenum, NULL, data, 0,
+                  NPY_ARRAY_FARRAY, NULL);
+  PyDimMem_FREE(dim);
+  if (!o) return NULL;
+  if (!(capsule = PyCapsule_New(data, NULL, gfi_buffer_capsule_destructor))) {
+    Py_DECREF(o); return NULL;
+  }
+  if (PyArray_SetBaseObject((PyArrayObject *)o, capsule) < 0) {
+    Py_DECREF(o); return NULL; /* the capsule reference is stolen */
+  }
+  return o;
+}
+
+/* Build a scipy.sparse.csc_matrix sharing the (stolen) ir, jc and pr
+   buffers of a sparse gfi_array. */
+static PyObject *
+csc_matrix_from_gfi_sparse(gfi_array *t) {
+  gfi_sparse *sp = &t->storage.gfi_storage_u.sp;
+  PyObject *scipy_sparse, *csc, *data, *indices, *indptr, *shape, *o = NULL;
+  u_int nnz = sp->ir.ir_len, ncols = sp->jc.jc_len;
+  if (!(scipy_sparse = PyImport_ImportModule("scipy.sparse"))) return NULL;
+  csc = PyObject_GetAttrString(scipy_sparse, "csc_matrix");
+  Py_DECREF(scipy_sparse);
+  if (!csc) return NULL;
+  data = PyArray_from_gfi_buffer(1, &nnz, sp->is_complex ? NPY_CDOUBLE
+                                 : NPY_DOUBLE, sp->pr.pr_val);
+  if (data) sp->pr.pr_val = NULL;
+  indices = PyArray_from_gfi_buffer(1, &nnz, NPY_INT, sp->ir.ir_val);
+  if (indices) sp->ir.ir_val = NULL;
+  indptr = PyArray_from_gfi_buffer(1, &ncols, NPY_INT, sp->jc.jc_val);
+  if (indptr) sp->jc.jc_val = NULL;
+  if (data && indices && indptr) {
+    shape = Py_BuildValue("(II)", t->dim.dim_val[0], t->dim.dim_val[1]);
+    if (shape) {
+      o = PyObject_CallFunction(csc, "(OOO)O", data, indices, indptr, shape);
+      Py_DECREF(shape);
+    }
+  }
+  Py_XDECREF(data); Py_XDECREF(indices); Py_XDECREF(indptr);
+  Py_DECREF(csc);
+  return o;
+}
+
 PyObject*
 gfi_array_to_PyObject(gfi_array *t, int in__init__) {
   PyObject *o = NULL;
@@ -586,50 +643,25 @@ gfi_array_to_PyObject(gfi_array *t, int in__init__) {
     //printf("GFI_INT32\n");
     if (t->dim.dim_len == 0)
       return PyLong_FromLong(TGFISTORE(int32,val)[0]);
-    else {
-      npy_intp *dim = PyDimMem_NEW(t->dim.dim_len);
-      for (u_int i=0; i < t->dim.dim_len; i++)
-        dim[i] = (npy_intp)t->dim.dim_val[i];
-      if (!(o = PyArray_EMPTY(t->dim.dim_len, dim, NPY_INT, 1)))
-        return NULL;
-      PyDimMem_FREE(dim);
-
-      npy_intp itemsize = PyArray_ITEMSIZE((PyArrayObject *)o);
-      npy_intp size = PyArray_Size(o); /* Number of elements. */
-      memcpy(PyArray_DATA((PyArrayObject *)o), TGFISTORE(int32,val),
-             size*itemsize); // new copy
-    }
+    else if ((o = PyArray_from_gfi_buffer(t->dim.dim_len, t->dim.dim_val,
+                                          NPY_INT, TGFISTORE(int32,val))))
+      TGFISTORE(int32,val) = NULL; /* now owned by the numpy array */
   } break;
   case GFI_DOUBLE: {
     // printf("GFI_DOUBLE\n");
     if (!gfi_array_is_complex(t)) {
       if (t->dim.dim_len == 0)
         return PyFloat_FromDouble(TGFISTORE(double,val)[0]);
-      else {
-        npy_intp *dim = PyDimMem_NEW(t->dim.dim_len);
-        for (u_int i=0; i < t->dim.dim_len; i++)
-          dim[i] = (npy_intp)t->dim.dim_val[i];
-        if (!(o = PyArray_EMPTY(t->dim.dim_len, dim, NPY_DOUBLE, 1)))
-          return NULL;
-        PyDimMem_FREE(dim);
-      }
+      o = PyArray_from_gfi_buffer(t->dim.dim_len, t->dim.dim_val, NPY_DOUBLE,
+                                  TGFISTORE(double,val));
     } else {
       if (t->dim.dim_len == 0)
         return PyComplex_FromDoubles(TGFISTORE(double,val)[0],
                                      TGFISTORE(double,val)[1]);
-      else {
-        npy_intp *dim = PyDimMem_NEW(t->dim.dim_len);
-        for (u_int i=0; i < t->dim.dim_len; i++)
-          dim[i] = (npy_intp)t->dim.dim_val[i];
-        if (!(o = PyArray_EMPTY(t->dim.dim_len, dim, NPY_CDOUBLE, 1)))
-          return NULL;
-        PyDimMem_FREE(dim);
-      }
+      o = PyArray_from_gfi_buffer(t->dim.dim_len, t->dim.dim_val, NPY_CDOUBLE,
+                                  TGFISTORE(double,val));
     }
-    npy_intp itemsize = PyArray_ITEMSIZE((PyArrayObject *)o);
-    npy_intp size = PyArray_Size(o); /* Number of elements. */
-    memcpy(PyArray_DATA((PyArrayObject *)o), TGFISTORE(double,val),
-           size*itemsize); // new copy
+    if (o) TGFISTORE(double,val) = NULL; /* now owned by the numpy array */
   } break;
   case GFI_CHAR: {
     //printf("GFI_CHAR\n");
@@ -691,9 +723,7 @@ gfi_array_to_PyObject(gfi_array *t, int in__init__) {
   } break;
   case GFI_SPARSE: {
     //printf("GFI_SPARSE\n");
-    PyErr_SetString(PyExc_RuntimeError,
-                    "Numpy does not have Native sparse matrices. "
-                    "Use getfem sparse objects instead.");
+    o = csc_matrix_from_gfi_sparse(t);
   } break;
   default:  {
     assert(0);
@@ -718,6 +748,9 @@ call_getfem_(PyObject *self, PyObject *args, int in__init__)
   in = build_gfi_array_list(&gc, args, &function_name, &in_cnt);
   if (in) {
     //fprintf(stdout,"  -> function = %s\n", function_name);
+    /* The GIL is released for the whole GetFEM call (assembly, solve,
+       export ...) so that other Python threads can run meanwhile, or
+       call GetFEM concurrently (see 'set num caller threads'). */
     Py_BEGIN_ALLOW_THREADS;
     errmsg = getfem_interface_main(PYTHON_INTERFACE, function_name, in_cnt,
                                    in, &out_cnt, &out, &infomsg,0);
@@ -252,3 +252,21 @@ str = "Diff((Grad_w+Grad_w'-Id(2)*u):Grad(w),u,Norm(v))"; print('\nAssembly stri
 res = gf.asm_expression_analysis(str, mim, 0, md)
 if (res != "((-([[1,0],[0,1]]*Norm(v))):Grad_w)"):
   print("Wrong Diff result"); exit(1)
+
+# Arrays returned by the interface take over the buffers of the interface
+# layer and must stay valid after the object they come from is destroyed
+K = gf.asm('generic', mim, 2, "Grad_u.Grad_Test_u", -1, md)
+Kf = K.full(); U1 = md.variable('u'); U1 += 1.
+if (np.linalg.norm(md.variable('u') + 1. - U1) > 1e-12):
+  print("Variable returned by reference"); exit(1)
+try:
+  import scipy.sparse
+  Kc = K.csc()
+  if (np.linalg.norm(Kc.toarray() - Kf) > 1e-12):
+    print("Wrong csc matrix"); exit(1)
+  del K
+  X = np.arange(Kf.shape[1], dtype=float)
+  if (np.linalg.norm(Kc.dot(X) - np.dot(Kf, X)) > 1e-10):
+    print("Wrong csc matrix"); exit(1)
+except ImportError:
+  pass
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# Python GetFEM interface
+#
+# Copyright (C) 2020 Yves Renard.
+#
+# This file is a part of GetFEM
+#
+# GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+# under  the  terms  of the  GNU  Lesser General Public License as published
+# by  the  Free Software Foundation;  either version 2.1 of the License,  or
+# (at your option) any later version.
+# This program  is  distributed  in  the  hope  that it will be useful,  but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+# License for more details.
+# You  should  have received a copy of the GNU Lesser General Public License
+# along  with  this program;  if not, write to the Free Software Foundation,
+# Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+#
+############################################################################
+"""  Test of the use of the interface from several Python threads.
+
+  Independent models are built and solved in concurrent threads. The
+  results have to be the same as the ones obtained sequentially.
+
+  With 'set num caller threads', the calls of the different threads run
+  concurrently in GetFEM (each one with its own caches), and only share
+  the object workspace. Without OpenMP support, they are run one at a
+  time.
+
+  $Id$
+"""
+import threading
+
+import numpy as np
+
+import getfem as gf
+
+def solve_laplacian(k):
+  NX = 8 + k
+  m = gf.Mesh('cartesian', np.arange(0,1+1./NX,1./NX),
+                           np.arange(0,1+1./NX,1./NX))
+  mfu = gf.MeshFem(m, 1); mfu.set_classical_fem(2)
+  mim = gf.MeshIm(m, 4)
+  md = gf.Model('real')
+  md.add_fem_variable('u', mfu)
+  md.add_Laplacian_brick(mim, 'u')
+  md.add_initialized_data('f', [1. + k])
+  md.add_source_term_brick(mim, 'u', 'f')
+  m.set_region(1, m.outer_faces())
+  md.add_Dirichlet_condition_with_multipliers(mim, 'u', mfu, 1)
+  md.solve()
+  return gf.asm('generic', mim, 0, 'u', -1, md)
+
+NB = 8
+gf.util('set num caller threads', NB)
+ref = [solve_laplacian(k) for k in range(NB)]
+
+res = [None] * NB
+def run(k):
+  for it in range(3):
+    res[k] = solve_laplacian(k)
+
+threads = [threading.Thread(target=run, args=(k,)) for k in range(NB)]
+for t in threads: t.start()
+for t in threads: t.join()
+
+for k in range(NB):
+  if (res[k] is None or abs(res[k] - ref[k]) > 1e-12):
+    print("Wrong result in thread %d" % k); exit(1)
@@ -27,6 +27,9 @@
 #include <limits.h>
 #ifndef _WIN32
 #  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
 #endif
 #include <fstream>
 
@@ -513,4 +516,115 @@ namespace bgeot {
                 << " is not an array");
     return p.array();
   }
+
+  /* ********************************************************************* */
+  /*       Binary native files.                                            */
+  /* ********************************************************************* */
+
+  const char binary_file_writer::magic[8]
+    = {'G', 'E', 'T', 'F', 'E', 'M', 'B', 'N'};
+
+  binary_file_writer::binary_file_writer(std::ostream &os_) : os(os_) {
+    uint32_t v = version, bom = byte_order_mark;
+    os.write(magic, 8);
+    os.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    os.write(reinterpret_cast<const char *>(&bom), sizeof(bom));
+  }
+
+  void binary_file_writer::begin_section(const char *t) {
+    GMM_ASSERT1(strlen(t) == 4, "Section tags have four characters");
+    tag = t; buf.clear();
+  }
+
+  void binary_file_writer::end_section() {
+    uint64_t size = buf.size();
+    os.write(tag.data(), 4);
+    os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    os.write(buf.data(), std::streamsize(buf.size()));
+    GMM_ASSERT1(os.good(), "Error while writing a binary file");
+    buf.clear();
+  }
+
+  struct binary_file_reader::mapping {
+    const char *data = 0;
+    size_t size = 0;
+    std::vector<char> buffer; // used when the file is not memory mapped
+    ~mapping() {
+#ifndef _WIN32
+      if (data && buffer.empty()) munmap(const_cast<char *>(data), size);
+#endif
+    }
+  };
+
+  binary_file_reader::binary_file_reader(const std::string &name)
+    : map(std::make_shared<mapping>()) {
+#ifndef _WIN32
+    int fd = open(name.c_str(), O_RDONLY);
+    GMM_ASSERT1(fd >= 0, "File '" << name << "' does not exist");
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(0, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        map->data = static_cast<const char *>(p);
+        map->size = size_t(st.st_size);
+      }
+    }
+    close(fd);
+#endif
+    if (!map->data) {
+      std::ifstream f(name.c_str(), std::ios::binary);
+      GMM_ASSERT1(f, "File '" << name << "' does not exist");
+      map->buffer.assign(std::istreambuf_iterator<char>(f),
+                         std::istreambuf_iterator<char>());
+      map->data = map->buffer.data(); map->size = map->buffer.size();
+    }
+    cur = map->data; section_end = map->data + map->size;
+    char m[8];
+    get_array(m, 8);
+    GMM_ASSERT1(!memcmp(m, binary_file_writer::magic, 8),
+                "File '" << name << "' is not a GetFEM binary file");
+    uint32_t v = get<uint32_t>(), bom = get<uint32_t>();
+    GMM_ASSERT1(bom == binary_file_writer::byte_order_mark,
+                "Binary file '" << name << "' has a different byte order");
+    GMM_ASSERT1(v <= binary_file_writer::version, "Binary file '" << name
+                << "' has an unsupported format version " << v);
+    version_ = v;
+  }
+
+  bool binary_file_reader::is_binary_file(const std::string &name) {
+    std::ifstream f(name.c_str(), std::ios::binary);
+    char m[8];
+    return f.read(m, 8) && !memcmp(m, binary_file_writer::magic, 8);
+  }
+
+  void binary_file_reader::check(size_t n) const {
+    GMM_ASSERT1(size_t(section_end - cur) >= n,
+                "Unexpected end of section in binary file");
+  }
+
+  bool binary_file_reader::find_section(const char *t) {
+    const char *end = map->data + map->size;
+    cur = map->data + 16;
+    while (size_t(end - cur) >= 12) {
+      uint64_t size;
+      memcpy(&size, cur + 4, sizeof(size));
+      GMM_ASSERT1(size <= uint64_t(end - cur - 12),
+                  "Truncated section in binary file");
+      if (!memcmp(cur, t, 4)) {
+        cur += 12; section_end = cur + size;
+        return true;
+      }
+      cur += 12 + size;
+    }
+    return false;
+  }
+
+  std::string binary_file_reader::get_string() {
+    size_t n = size_t(get<uint64_t>());
+    check(n);
+    std::string st(cur, n);
+    cur += n;
+    return st;
+  }
+
 }
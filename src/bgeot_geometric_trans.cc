@@ -939,12 +939,13 @@ namespace bgeot {
   }
 
   pgeometric_trans pyramid_QK_geotrans(short_type k) {
-    static short_type k_ = -1;
-    static pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC short_type k_ = -1;
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
     if (k != k_) {
       std::stringstream name;
       name << "GT_PYRAMID(" << k << ")";
       pgt = geometric_trans_descriptor(name.str());
+      k_ = k;
     }
     return pgt;
   }
@@ -1010,7 +1011,7 @@ namespace bgeot {
   }
 
   pgeometric_trans pyramid_Q2_incomplete_geotrans() {
-    static pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
     if (!pgt)
       pgt = geometric_trans_descriptor("GT_PYRAMID_Q2_INCOMPLETE");
     return pgt;
@@ -1064,7 +1065,7 @@ namespace bgeot {
   }
 
   pgeometric_trans prism_incomplete_P2_geotrans() {
-    static pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
     if (!pgt)
       pgt = geometric_trans_descriptor("GT_PRISM_INCOMPLETE_P2");
     return pgt;
@@ -1180,9 +1181,9 @@ namespace bgeot {
   /* Fonctions pour la ref. directe.                                     */
 
   pgeometric_trans simplex_geotrans(size_type n, short_type k) {
-    static pgeometric_trans pgt = 0;
-    static size_type d = size_type(-2);
-    static short_type r = short_type(-2);
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC size_type d = size_type(-2);
+    THREAD_SAFE_STATIC short_type r = short_type(-2);
     if (d != n || r != k) {
       std::stringstream name;
       name << "GT_PK(" << n << "," << k << ")";
@@ -1193,9 +1194,9 @@ namespace bgeot {
   }
 
   pgeometric_trans parallelepiped_geotrans(size_type n, short_type k) {
-    static pgeometric_trans pgt = 0;
-    static size_type d = size_type(-2);
-    static short_type r = short_type(-2);
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC size_type d = size_type(-2);
+    THREAD_SAFE_STATIC short_type r = short_type(-2);
     if (d != n || r != k) {
       std::stringstream name;
       name << "GT_QK(" << n << "," << k << ")";
@@ -1215,8 +1216,8 @@ namespace bgeot {
   }
 
   pgeometric_trans parallelepiped_linear_geotrans(size_type n) {
-    static pgeometric_trans pgt = 0;
-    static size_type d = size_type(-2);
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC size_type d = size_type(-2);
     if (d != n) {
       std::stringstream name(name_of_linear_qk_trans(n));
       pgt = geometric_trans_descriptor(name.str());
@@ -1226,8 +1227,8 @@ namespace bgeot {
   }
 
   pgeometric_trans prism_linear_geotrans(size_type n) {
-    static pgeometric_trans pgt = 0;
-    static size_type d = size_type(-2);
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC size_type d = size_type(-2);
     if (d != n) {
       std::stringstream name;
       name << "GT_LINEAR_PRODUCT(GT_PK(" << (n-1) << ", 1), GT_PK(1,1))";
@@ -1246,9 +1247,9 @@ namespace bgeot {
   }
 
   pgeometric_trans prism_geotrans(size_type n, short_type k) {
-    static pgeometric_trans pgt = 0;
-    static size_type d = size_type(-2);
-    static short_type r = short_type(-2);
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC size_type d = size_type(-2);
+    THREAD_SAFE_STATIC short_type r = short_type(-2);
     if (d != n || r != k) {
       std::stringstream name;
       name << "GT_PRISM(" << n << "," << k << ")";
@@ -1260,9 +1261,9 @@ namespace bgeot {
 
   pgeometric_trans product_geotrans(pgeometric_trans pg1,
                                     pgeometric_trans pg2) {
-    static pgeometric_trans pgt = 0;
-    static pgeometric_trans pg1_ = 0;
-    static pgeometric_trans pg2_ = 0;
+    THREAD_SAFE_STATIC pgeometric_trans pgt = 0;
+    THREAD_SAFE_STATIC pgeometric_trans pg1_ = 0;
+    THREAD_SAFE_STATIC pgeometric_trans pg2_ = 0;
     if (pg1 != pg1_ || pg2 != pg2_) {
       std::stringstream name;
       name << "GT_PRODUCT(" << name_of_geometric_trans(pg1) << ","
@@ -53,6 +53,18 @@ namespace bgeot {
       sorters.back().insert(size_type(i));
   }
 
+  void node_tab::update_coordinates(void) const {
+    auto guard = coords_lock.get_lock();
+    if (!coords_valid) {
+      coords.assign(size_type(dim_) * size(), scalar_type(0));
+      for (dal::bv_visitor i(index()); !i.finished(); ++i) {
+        const base_node &P = (*this)[i];
+        std::copy(P.begin(), P.end(), coords.begin() + i*dim_);
+      }
+      coords_valid = true;
+    }
+  }
+
   size_type node_tab::search_node(const base_node &pt,
                                   const scalar_type radius) const {
     if (card() == 0 || radius < 0.)
@@ -88,6 +100,7 @@ namespace bgeot {
 
   void node_tab::clear() {
     dal::dynamic_tas<base_node>::clear();
+    touch();
     sorters = std::vector<sorter>();
     max_radius = scalar_type(1e-60);
     eps = max_radius * prec_factor;
@@ -109,6 +122,7 @@ namespace bgeot {
       id = search_node(pt, radius);
     if (id == size_type(-1)) {
       id = dal::dynamic_tas<base_node>::add(pt);
+      touch();
       for (size_type i = 0; i < sorters.size(); ++i) {
         sorters[i].insert(id);
         GMM_ASSERT3(sorters[i].size() == card(), "internal error");
@@ -125,6 +139,7 @@ namespace bgeot {
         if (existj) sorters[is].erase(j);
       }
       dal::dynamic_tas<base_node>::swap(i, j);
+      touch();
       for (size_type is = 0; is < sorters.size(); ++is) {
         if (existi) sorters[is].insert(j);
         if (existj) sorters[is].insert(i);
@@ -141,7 +156,7 @@ namespace bgeot {
         // if (sorters[is].size()+1 != card()) { resort(); }
       }
       dal::dynamic_tas<base_node>::sup(i);
-
+      touch();
     }
   }
 
@@ -163,7 +178,8 @@ namespace bgeot {
     resort();
   }
 
-  node_tab::node_tab(scalar_type prec_loose) {
+  node_tab::node_tab(scalar_type prec_loose)
+    : dim_(0), coords_valid(false), coords_misses(0) {
     max_radius = scalar_type(1e-60);
     sorters.reserve(5);
     prec_factor = gmm::default_tol(scalar_type()) * prec_loose;
@@ -172,13 +188,15 @@ namespace bgeot {
 
   node_tab::node_tab(const node_tab &t)
     : dal::dynamic_tas<base_node>(t), sorters(), eps(t.eps),
-      prec_factor(t.prec_factor), max_radius(t.max_radius), dim_(t.dim_)  {}
+      prec_factor(t.prec_factor), max_radius(t.max_radius), dim_(t.dim_),
+      coords_valid(false), coords_misses(0) {}
 
   node_tab &node_tab::operator =(const node_tab &t) {
     dal::dynamic_tas<base_node>::operator =(t);
     sorters = std::vector<sorter>();
     eps = t.eps; prec_factor = t.prec_factor;
     max_radius = t.max_radius; dim_ = t.dim_;
+    touch();
     return *this;
   }
 
@@ -31,15 +31,15 @@ namespace bgeot {
 #define STORED 150
   static gmm::dense_matrix<size_type> alpha_M_(STORED, STORED);
   static void alpha_init_() {
-    static bool init = false;
-    if (!init) {
+    static bool init = [] {  // thread-safe initialization of the table
       for (short_type i = 0; i < STORED; ++i) {
         alpha_M_(i, 0) = alpha_M_(0, i) = 1;
         for (short_type j = 1; j <= i; ++j)
           alpha_M_(i,j) = alpha_M_(j,i) = (alpha_M_(i, j-1) * (i+j)) / j;
       }
-      init = true;
-    }
+      return true;
+    }();
+    GMM_ASSERT1(init, "Internal error");
   }
   static inline size_type alpha_(short_type n, short_type d)
   { return alpha_M_(d,n); }
@@ -112,8 +112,8 @@ namespace bgeot {
   static void parse_error(int i)
   { GMM_ASSERT1(false, "Syntax error reading a polynomial " << i); }
 
-  static std::string stored_s;
-  int stored_tokent;
+  THREAD_SAFE_STATIC std::string stored_s;
+  THREAD_SAFE_STATIC int stored_tokent;
 
   static void unget_token(int i, std::string s)
   { std::swap(s, stored_s); stored_tokent = i; }
@@ -404,4 +404,268 @@ namespace bgeot {
     cout << " --- end of tree dump, nb of rectangles: " << boxes.size()
          << ", rectangle ref in tree: " << count << "\n";
   }
+
+  /* ********************************************************************* */
+  /*       flat_rtree                                                      */
+  /* ********************************************************************* */
+
+  size_type flat_rtree::add_box(const base_node &min, const base_node &max,
+                                size_type id) {
+    if (ids.empty()) N = min.size();
+    GMM_ASSERT1(min.size() == N && max.size() == N, "Dimensions mismatch");
+    size_type i = ids.size();
+    box_min.insert(box_min.end(), min.begin(), min.end());
+    box_max.insert(box_max.end(), max.begin(), max.end());
+    ids.push_back((id + 1) ? id : i);
+    tree_built = tree_fitted = false;
+    return i;
+  }
+
+  void flat_rtree::set_box(size_type i, const base_node &min,
+                           const base_node &max) {
+    GMM_ASSERT1(i < ids.size(), "Box index out of range");
+    GMM_ASSERT1(min.size() == N && max.size() == N, "Dimensions mismatch");
+    std::copy(min.begin(), min.end(), box_min.begin() + i*N);
+    std::copy(max.begin(), max.end(), box_max.begin() + i*N);
+    tree_fitted = false;
+  }
+
+  void flat_rtree::resize(size_type nb) {
+    GMM_ASSERT1(nb <= ids.size(), "Cannot add boxes with resize");
+    if (nb < ids.size()) {
+      box_min.resize(nb*N); box_max.resize(nb*N); ids.resize(nb);
+      tree_built = tree_fitted = false;
+    }
+  }
+
+  void flat_rtree::clear() {
+    N = 0;
+    box_min.clear(); box_max.clear(); ids.clear();
+    tnodes.clear(); node_min.clear(); node_max.clear(); perm.clear();
+    tree_built = tree_fitted = false;
+  }
+
+  /* Median split along the direction of largest extent of the box
+     centers. The nodes are numbered in depth first order, the left child
+     of an internal node being the next node. */
+  size_type flat_rtree::build_tree_(size_type first, size_type nb,
+                                    std::vector<scalar_type> &centers) {
+    size_type i = tnodes.size();
+    tnodes.push_back(tree_node{first, nb, 0});
+    if (nb <= BOXES_PER_LEAF) return i;
+
+    unsigned dir = 0;
+    scalar_type ext(-1);
+    for (unsigned k = 0; k < N; ++k) {
+      scalar_type cmin = centers[perm[first]*N+k], cmax = cmin;
+      for (size_type j = first+1; j < first+nb; ++j) {
+        cmin = std::min(cmin, centers[perm[j]*N+k]);
+        cmax = std::max(cmax, centers[perm[j]*N+k]);
+      }
+      if (cmax - cmin > ext) { ext = cmax - cmin; dir = k; }
+    }
+    size_type nb1 = nb / 2;
+    const size_type NN = N;
+    std::nth_element(perm.begin() + first, perm.begin() + first + nb1,
+                     perm.begin() + first + nb,
+                     [&centers, NN, dir](size_type a, size_type b)
+                     { return centers[a*NN+dir] < centers[b*NN+dir]; });
+    tnodes[i].nb = 0;
+    build_tree_(first, nb1, centers);
+    size_type right = build_tree_(first + nb1, nb - nb1, centers);
+    tnodes[i].right = right;
+    return i;
+  }
+
+  void flat_rtree::fit_node_(size_type i) {
+    const tree_node &tn = tnodes[i];
+    scalar_type *nmin = &node_min[i*N], *nmax = &node_max[i*N];
+    if (tn.nb) {
+      std::copy(&box_min[perm[tn.first]*N], &box_min[perm[tn.first]*N]+N,
+                nmin);
+      std::copy(&box_max[perm[tn.first]*N], &box_max[perm[tn.first]*N]+N,
+                nmax);
+      for (size_type j = tn.first+1; j < tn.first+tn.nb; ++j)
+        for (size_type k = 0; k < N; ++k) {
+          nmin[k] = std::min(nmin[k], box_min[perm[j]*N+k]);
+          nmax[k] = std::max(nmax[k], box_max[perm[j]*N+k]);
+        }
+    } else {
+      const scalar_type *lmin = &node_min[(i+1)*N];
+      const scalar_type *lmax = &node_max[(i+1)*N];
+      const scalar_type *rmin = &node_min[tn.right*N];
+      const scalar_type *rmax = &node_max[tn.right*N];
+      for (size_type k = 0; k < N; ++k) {
+        nmin[k] = std::min(lmin[k], rmin[k]);
+        nmax[k] = std::max(lmax[k], rmax[k]);
+      }
+    }
+  }
+
+  /* Fits all the nodes and returns the sum of their extents, which
+     measures the quality of the tree (unlike the volume, it does not
+     vanish for flat boxes). */
+  scalar_type flat_rtree::fit_tree_() {
+    node_min.resize(tnodes.size()*N);
+    node_max.resize(tnodes.size()*N);
+    // children have a greater index than their parent
+    for (size_type i = tnodes.size(); i-- > 0; ) fit_node_(i);
+    scalar_type size(0);
+    for (size_type i = 0; i < node_min.size(); ++i)
+      size += node_max[i] - node_min[i];
+    return size;
+  }
+
+  void flat_rtree::build_tree() {
+    size_type nb = ids.size();
+    tnodes.resize(0);
+    perm.resize(nb);
+    for (size_type i = 0; i < nb; ++i) perm[i] = i;
+    if (nb) {
+      std::vector<scalar_type> centers(nb*N);
+      for (size_type i = 0; i < nb*N; ++i)
+        centers[i] = (box_min[i] + box_max[i]) / scalar_type(2);
+      tnodes.reserve(2*(nb/BOXES_PER_LEAF)+1);
+      build_tree_(0, nb, centers);
+    }
+    built_size = fit_tree_();
+    nb_refits = 0;
+    tree_built = tree_fitted = true;
+  }
+
+  void flat_rtree::refit() {
+    // Growth of the nodes and number of refits beyond which the queries
+    // are expected to cost more than a new build.
+    const scalar_type max_growth(2);
+    const size_type max_nb_refits(100);
+    if (!tree_built) { build_tree(); return; }
+    scalar_type size = fit_tree_();
+    if (size > max_growth * built_size || ++nb_refits > max_nb_refits)
+      build_tree();
+    else
+      tree_fitted = true;
+  }
+
+  namespace {
+    struct flat_has_point_p {
+      const base_node &P;
+      flat_has_point_p(const base_node &P_) : P(P_) {}
+      bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+        for (size_type i = 0; i < P.size(); ++i)
+          if (P[i] < min2[i] || P[i] > max2[i]) return false;
+        return true;
+      }
+    };
+
+    struct flat_intersection_p {
+      const base_node &min, &max;
+      flat_intersection_p(const base_node& min_, const base_node& max_)
+        : min(min_), max(max_) {}
+      bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+        for (size_type i = 0; i < min.size(); ++i)
+          if (max[i] < min2[i] || min[i] > max2[i]) return false;
+        return true;
+      }
+    };
+
+    /* same criterion as intersect_line */
+    struct flat_intersect_line {
+      const base_node &org;
+      const base_small_vector &dirv;
+      flat_intersect_line(const base_node& org_,
+                          const base_small_vector &dirv_)
+        : org(org_), dirv(dirv_) {}
+      bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+        size_type N = org.size();
+        for (size_type i = 0; i < N; ++i)
+          if (dirv[i] != scalar_type(0)) {
+            scalar_type a1 = (min2[i]-org[i])/dirv[i];
+            scalar_type a2 = (max2[i]-org[i])/dirv[i];
+            bool interf1 = true, interf2 = true;
+            for (size_type j = 0; j < N; ++j)
+              if (j != i) {
+                scalar_type y1 = org[j] + a1*dirv[j], y2 = org[j] + a2*dirv[j];
+                if (y1 < min2[j] || y1 > max2[j]) interf1 = false;
+                if (y2 < min2[j] || y2 > max2[j]) interf2 = false;
+              }
+            if (interf1 || interf2) return true;
+          }
+        return false;
+      }
+    };
+
+    struct flat_intersect_line_and_box {
+      flat_intersect_line line;
+      flat_intersection_p box;
+      flat_intersect_line_and_box(const base_node& org_,
+                                  const base_small_vector &dirv_,
+                                  const base_node& min_, const base_node& max_)
+        : line(org_, dirv_), box(min_, max_) {}
+      bool operator()(const scalar_type *min2, const scalar_type *max2) const
+      { return box(min2, max2) && line(min2, max2); }
+    };
+  }
+
+  template <typename Predicate>
+  void flat_rtree::find_matching_boxes_(const Predicate &p,
+                                        std::vector<size_type>& idvec) const {
+    idvec.resize(0);
+    GMM_ASSERT1(tree_fitted, "Boxtree not initialised or not refitted.");
+    if (tnodes.empty()) return;
+    // The depth of the tree is bounded by log2(nb_boxes)+1.
+    size_type stack[64], sp = 0, i = 0;
+    for (;;) {
+      const tree_node &tn = tnodes[i];
+      if (p(&node_min[i*N], &node_max[i*N])) {
+        if (tn.nb == 0) {
+          GMM_ASSERT2(sp < 64, "internal error");
+          stack[sp++] = tn.right; ++i; continue;
+        }
+        for (size_type j = tn.first; j < tn.first + tn.nb; ++j) {
+          size_type b = perm[j];
+          if (tn.nb == 1 || p(&box_min[b*N], &box_max[b*N]))
+            idvec.push_back(ids[b]);
+        }
+      }
+      if (sp == 0) break;
+      i = stack[--sp];
+    }
+    std::sort(idvec.begin(), idvec.end());
+  }
+
+  void flat_rtree::find_intersecting_boxes(const base_node& bmin,
+                                           const base_node& bmax,
+                                           std::vector<size_type>& idvec)
+    const { find_matching_boxes_(flat_intersection_p(bmin, bmax), idvec); }
+
+  void flat_rtree::find_boxes_at_point(const base_node& P,
+                                       std::vector<size_type>& idvec) const
+  { find_matching_boxes_(flat_has_point_p(P), idvec); }
+
+  void flat_rtree::find_line_intersecting_boxes
+  (const base_node& org, const base_small_vector& dirv,
+   std::vector<size_type>& idvec) const
+  { find_matching_boxes_(flat_intersect_line(org, dirv), idvec); }
+
+  void flat_rtree::find_line_intersecting_boxes
+  (const base_node& org, const base_small_vector& dirv,
+   const base_node& bmin, const base_node& bmax,
+   std::vector<size_type>& idvec) const {
+    find_matching_boxes_(flat_intersect_line_and_box(org, dirv, bmin, bmax),
+                         idvec);
+  }
+
+  void flat_rtree::find_boxes_at_points(const std::vector<base_node>& pts,
+                                        std::vector<size_type>& offsets,
+                                        std::vector<size_type>& idvec) const {
+    std::vector<size_type> ids_pt;
+    offsets.resize(pts.size()+1);
+    idvec.resize(0);
+    offsets[0] = 0;
+    for (size_type i = 0; i < pts.size(); ++i) {
+      find_matching_boxes_(flat_has_point_p(pts[i]), ids_pt);
+      idvec.insert(idvec.end(), ids_pt.begin(), ids_pt.end());
+      offsets[i+1] = idvec.size();
+    }
+  }
 }
@@ -139,6 +139,19 @@ namespace dal {
   #define ON_STORED_DEBUG(expression)
 #endif
 
+  // Calls f on the storage of each thread, beginning with the one of the
+  // current thread, until it returns true. Most of the objects involved in
+  // a dependency are created by the current thread, so that this avoids
+  // having all the threads locking the storage of the first one.
+  template <typename FUNC> static bool on_storage_of_object(FUNC f) {
+    size_t nt = singleton<stored_object_tab>::num_threads();
+    size_t t0 = singleton<stored_object_tab>::this_thread();
+    for (size_t i = 0; i != nt; ++i)
+      if (f(singleton<stored_object_tab>::instance((t0 + i) % nt)))
+        return true;
+    return false;
+  }
+
   // Gives a pointer to a key of an object from its pointer, while looking in the storage of
   // a specific thread
   pstatic_stored_object_key key_of_stored_object(pstatic_stored_object o, size_t thread){
@@ -169,21 +182,21 @@ namespace dal {
   }
 
   bool exists_stored_object(pstatic_stored_object o){
-    auto& stored_keys = singleton<stored_object_tab>::instance().stored_keys_;
+    auto& stored_objects = singleton<stored_object_tab>::instance();
     ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return false)
-    return  (stored_keys.find(o) != stored_keys.end());
+    return stored_objects.exists_stored_object(o);
   }
 
   pstatic_stored_object search_stored_object(pstatic_stored_object_key k){
     auto& stored_objects = singleton<stored_object_tab>::instance();
     ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return nullptr)
-    return stored_objects.search_stored_object(k);
+    return stored_objects.search_stored_object_this_thread(k);
   }
 
   pstatic_stored_object search_stored_object_on_all_threads(pstatic_stored_object_key k){
     auto& stored_objects = singleton<stored_object_tab>::instance();
     ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return nullptr)
-    auto p = stored_objects.search_stored_object(k);
+    auto p = stored_objects.search_stored_object_this_thread(k);
     if (p) return p;
     if (singleton<stored_object_tab>::num_threads() == 1) return nullptr;
     for(size_t thread = 0; thread < singleton<stored_object_tab>::num_threads(); ++thread){
@@ -197,14 +210,17 @@ namespace dal {
 
   std::pair<stored_object_tab::iterator, stored_object_tab::iterator>
     iterators_of_object(pstatic_stored_object o){
-    for(size_t thread = 0; thread != singleton<stored_object_tab>::num_threads(); ++thread){
-      auto& stored_objects = singleton<stored_object_tab>::instance(thread);
-      ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) continue;)
+    std::pair<stored_object_tab::iterator, stored_object_tab::iterator> itos
+      {singleton<stored_object_tab>::instance().end(),
+       singleton<stored_object_tab>::instance().end()};
+    ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return itos;)
+    on_storage_of_object([&](stored_object_tab &stored_objects) {
       auto it = stored_objects.iterator_of_object_(o);
-      if (it != stored_objects.end()) return {it, stored_objects.end()};
-    }
-    return {singleton<stored_object_tab>::instance().end(),
-            singleton<stored_object_tab>::instance().end()};
+      if (it == stored_objects.end()) return false;
+      itos = {it, stored_objects.end()};
+      return true;
+    });
+    return itos;
   }
 
 
@@ -229,21 +245,15 @@ namespace dal {
 
   void add_dependency(pstatic_stored_object o1,
                       pstatic_stored_object o2) {
-    bool dep_added = false;
-    for(size_t thread = 0; thread != singleton<stored_object_tab>::num_threads(); ++thread){
-      auto& stored_objects = singleton<stored_object_tab>::instance(thread);
-      ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return)
-      if ((dep_added = stored_objects.add_dependency_(o1,o2))) break;
-    }
+    ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return)
+    bool dep_added = on_storage_of_object([&](stored_object_tab &tab)
+                                          { return tab.add_dependency_(o1,o2); });
     GMM_ASSERT1(dep_added, "Failed to add dependency between " << o1
                 << " of type " << typeid(*o1).name() << " and " << o2
                 << " of type "  << typeid(*o2).name() << ". ");
 
-    bool dependent_added = false;
-    for(size_t thread = 0; thread != singleton<stored_object_tab>::num_threads(); ++thread){
-      auto& stored_objects = singleton<stored_object_tab>::instance(thread);
-      if ((dependent_added = stored_objects.add_dependent_(o1,o2))) break;
-    }
+    bool dependent_added = on_storage_of_object([&](stored_object_tab &tab)
+                                                { return tab.add_dependent_(o1,o2); });
     GMM_ASSERT1(dependent_added, "Failed to add dependent between " << o1
                 << " of type " << typeid(*o1).name() << " and " << o2
                 << " of type "  << typeid(*o2).name() << ". ");
@@ -254,26 +264,19 @@ namespace dal {
   /*remove a dependency (from storages of all threads).
   Return true if o2 has no more dependent object. */
   bool del_dependency(pstatic_stored_object o1, pstatic_stored_object o2){
-    bool dep_deleted = false;
-    for(size_t thread = 0; thread != singleton<stored_object_tab>::num_threads(); ++thread){
-      auto& stored_objects = singleton<stored_object_tab>::instance(thread);
-      ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return false)
-      if ((dep_deleted = stored_objects.del_dependency_(o1,o2))) break;
-    }
+    ON_STORED_DEBUG(if (!dal_static_stored_tab_valid__) return false)
+    bool dep_deleted = on_storage_of_object([&](stored_object_tab &tab)
+                                            { return tab.del_dependency_(o1,o2); });
     GMM_ASSERT1(dep_deleted, "Failed to delete dependency between " << o1 << " of type "
                 << typeid(*o1).name() << " and " << o2 << " of type "
                 << typeid(*o2).name() << ". ");
 
-    bool dependent_deleted = false;
     bool dependent_empty = false;
-    for(size_t thread = 0; thread != singleton<stored_object_tab>::num_threads(); ++thread){
-      auto& stored_objects = singleton<stored_object_tab>::instance(thread);
-      dependent_deleted = stored_objects.del_dependent_(o1,o2);
-      if (dependent_deleted){
-        dependent_empty = stored_objects.has_dependent_objects(o2);
-        break;
-      }
-    }
+    bool dependent_deleted = on_storage_of_object([&](stored_object_tab &tab) {
+      if (!tab.del_dependent_(o1,o2)) return false;
+      dependent_empty = tab.has_dependent_objects(o2);
+      return true;
+    });
     GMM_ASSERT1(dependent_deleted, "Failed to delete dependent between " << o1 << " of type "
                 << typeid(*o1).name() << " and " << o2 << " of type "
                 << typeid(*o2).name() << ". ");
@@ -414,7 +417,8 @@ namespace dal {
 */
   stored_object_tab::stored_object_tab()
     : std::map<enr_static_stored_object_key, enr_static_stored_object>(),
-      locks_{}, stored_keys_{}{
+      locks_{}, stored_keys_{}, cache_{}, cache_next_(0),
+      cache_generation_(0), generation_(0) {
       ON_STORED_DEBUG(dal_static_stored_tab_valid__ = true;)
     }
 
@@ -424,14 +428,34 @@ namespace dal {
 
   pstatic_stored_object
   stored_object_tab::search_stored_object(pstatic_stored_object_key k) const{
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_read_lock();
     auto it = find(enr_static_stored_object_key(k));
     return (it != end()) ? it->second.p : nullptr;
   }
 
+  pstatic_stored_object stored_object_tab::search_stored_object_this_thread
+  (pstatic_stored_object_key k) const {
+    auto guard = locks_.get_read_lock();
+    if (cache_generation_ != generation_) {
+      std::fill(cache_, cache_ + NB_CACHED_LOOKUPS, cached_lookup{});
+      cache_generation_ = generation_;
+    }
+    for (size_t i = 1; i <= NB_CACHED_LOOKUPS; ++i) {
+      const cached_lookup &c
+        = cache_[(cache_next_ + NB_CACHED_LOOKUPS - i) % NB_CACHED_LOOKUPS];
+      if (!c.k) break;
+      if (*(c.k) == *k) return c.o->p;
+    }
+    auto it = find(enr_static_stored_object_key(k));
+    if (it == end()) return nullptr;
+    cache_[cache_next_] = cached_lookup{it->first.p.get(), &(it->second)};
+    cache_next_ = (cache_next_ + 1) % NB_CACHED_LOOKUPS;
+    return it->second.p;
+  }
+
   bool stored_object_tab::add_dependency_(pstatic_stored_object o1,
                                           pstatic_stored_object o2){
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_write_lock();
     auto it = stored_keys_.find(o1);
     if (it == stored_keys_.end()) return false;
     auto ito1 = find(it->second);
@@ -443,7 +467,7 @@ namespace dal {
   void stored_object_tab::add_stored_object(pstatic_stored_object_key k,
     pstatic_stored_object o,  permanence perm){
     DAL_STORED_OBJECT_DEBUG_ADDED(o.get());
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_write_lock();
     GMM_ASSERT1(stored_keys_.find(o) == stored_keys_.end(),
       "This object has already been stored, possibly with another key");
     stored_keys_[o] = k;
@@ -456,7 +480,7 @@ namespace dal {
 
   bool stored_object_tab::add_dependent_(pstatic_stored_object o1,
     pstatic_stored_object o2){
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_write_lock();
     auto it = stored_keys_.find(o2);
     if (it == stored_keys_.end()) return false;
     auto ito2 = find(it->second);
@@ -467,7 +491,7 @@ namespace dal {
 
   bool stored_object_tab::del_dependency_(pstatic_stored_object o1,
                                           pstatic_stored_object o2){
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_write_lock();
     auto it1 = stored_keys_.find(o1);
     if (it1 == stored_keys_.end()) return false;
     auto ito1 = find(it1->second);
@@ -487,7 +511,7 @@ namespace dal {
 
   bool stored_object_tab::del_dependent_(pstatic_stored_object o1,
                                          pstatic_stored_object o2){
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_write_lock();
     auto it2 = stored_keys_.find(o2);
     if (it2 == stored_keys_.end()) return false;
     auto ito2 = find(it2->second);
@@ -497,12 +521,12 @@ namespace dal {
   }
 
   bool stored_object_tab::exists_stored_object(pstatic_stored_object o) const{
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_read_lock();
     return (stored_keys_.find(o) != stored_keys_.end());
   }
 
   bool stored_object_tab::has_dependent_objects(pstatic_stored_object o) const{
-    auto guard = locks_.get_lock();
+    auto guard = locks_.get_read_lock();
     auto it = stored_keys_.find(o);
     GMM_ASSERT1(it != stored_keys_.end(), "Object is not stored");
     auto ito = find(it->second);
@@ -511,16 +535,27 @@ namespace dal {
   }
 
   void stored_object_tab::basic_delete_(std::list<pstatic_stored_object> &to_delete){
-    auto guard = locks_.get_lock();
+    // The erased objects and keys are released all together once the lock
+    // is released, their destructors being allowed to use the storage.
+    std::vector<pstatic_stored_object> released_objects;
+    std::vector<pstatic_stored_object_key> released_keys;
+    auto guard = locks_.get_write_lock();
+    ++generation_;
     for (auto it = to_delete.begin(); it != to_delete.end();){
       DAL_STORED_OBJECT_DEBUG_DELETED(it->get());
       auto itk = stored_keys_.find(*it);
       auto ito = end();
       if (itk != stored_keys_.end()){
           ito = find(itk->second);
+          released_keys.push_back(itk->second);
           stored_keys_.erase(itk);
       }
       if (ito != end()){
+        released_objects.push_back(ito->second.p);
+        for (auto &&pdep : ito->second.dependencies)
+          released_objects.push_back(pdep);
+        for (auto &&pdep : ito->second.dependent_object)
+          released_objects.push_back(pdep);
         erase(ito);
         it = to_delete.erase(it);
       } else ++it;
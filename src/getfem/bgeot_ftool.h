@@ -39,7 +39,10 @@
 #define BGEOT_FTOOL_H
 
 #include <iostream>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace bgeot
@@ -201,6 +204,66 @@ namespace bgeot
     void read_command_line(int argc, char *argv[]);
   };
 
+  /* ********************************************************************* */
+  /*       Binary native files.                                            */
+  /* ********************************************************************* */
+
+  /** Writer of the binary native file format of GetFEM. The file is made
+   *  of a header (magic string, format version and byte order mark)
+   *  followed by tagged sections (a four characters tag, the size of the
+   *  section and its content). The content of a section is accumulated
+   *  with the put functions and written by end_section().
+   */
+  class binary_file_writer {
+    std::ostream &os;
+    std::string tag, buf;
+
+  public :
+    static const char magic[8];
+    static const unsigned version = 2;
+    static const unsigned byte_order_mark = 0x01020304;
+
+    void begin_section(const char *t);
+    void end_section();
+    template <typename T> void put(const T &x)
+    { buf.append(reinterpret_cast<const char *>(&x), sizeof(T)); }
+    template <typename T> void put_array(const T *p, size_t n)
+    { buf.append(reinterpret_cast<const char *>(p), n*sizeof(T)); }
+    void put_string(const std::string &st)
+    { put(uint64_t(st.size())); buf.append(st); }
+
+    explicit binary_file_writer(std::ostream &os_);
+  };
+
+  /** Reader of the binary native file format of GetFEM. The file is
+   *  memory mapped when the system allows it and fully read otherwise.
+   *  The data of a section is read sequentially with the get functions.
+   */
+  class binary_file_reader {
+    struct mapping;
+    std::shared_ptr<mapping> map;
+    const char *section_end, *cur;
+    unsigned version_;
+
+    void check(size_t n) const;
+
+  public :
+    /// Format version of the file.
+    unsigned version() const { return version_; }
+    /// Test if a file is in the binary native format.
+    static bool is_binary_file(const std::string &name);
+    /// Go to the first section having the tag t. Return false if none.
+    bool find_section(const char *t);
+    template <typename T> T get()
+    { T x; get_array(&x, 1); return x; }
+    template <typename T> void get_array(T *p, size_t n)
+    { check(n*sizeof(T)); if (n) std::memcpy(p, cur, n*sizeof(T));
+      cur += n*sizeof(T); }
+    std::string get_string();
+
+    explicit binary_file_reader(const std::string &name);
+  };
+
 }
 
 
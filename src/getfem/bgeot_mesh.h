@@ -96,11 +96,7 @@ namespace bgeot {
       const ind_set &rct = ind_points_of_convex(ic);
       size_type N = dim(), Np = rct.size();
       G.base_resize(N, Np);
-      auto it = G.begin();
-      for (size_type i = 0; i < Np; ++i, it += N) {
-        const base_node &P = pts[rct[i]];
-        std::copy(P.begin(),  P.end(), it);
-      }
+      if (Np) pts.gather_points(rct.begin(), rct.end(), &(G[0]));
     }
 
     /** Add the point pt to the mesh and return the index of the
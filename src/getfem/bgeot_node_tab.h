@@ -42,12 +42,19 @@
 #include "bgeot_small_vector.h"
 #include "dal_tree_sorted.h"
 #include "set"
+#include <atomic>
 
 namespace bgeot {
 
 
   /** Store a set of points, identifying points
       that are nearer than a certain very small distance.
+
+      Besides the base_node of each point, a contiguous copy of all the
+      coordinates (dim() x size(), point by point) is kept, so that the
+      points of an element can be gathered without following one pointer
+      per point. This copy is rebuilt lazily after any modification,
+      including through the non-const accessors.
   */
   class APIDECL node_tab : public dal::dynamic_tas<base_node> {
 
@@ -69,7 +76,22 @@ namespace bgeot {
     scalar_type eps, prec_factor, max_radius;
     unsigned dim_;
 
+    mutable std::vector<scalar_type> coords;
+    mutable std::atomic<bool> coords_valid;
+    mutable std::atomic<size_type> coords_misses;
+    getfem::lock_factory coords_lock;
+
     void add_sorter(void) const;
+    void touch(void) { coords_valid = false; coords_misses = 0; }
+    void update_coordinates(void) const;
+    const scalar_type *coordinates_if_worth(void) const {
+      if (coords_valid) return coords.data();
+      // The rebuild is postponed until it is paid back by the number of
+      // gathers done the slow way, to avoid a rebuild per element when
+      // the points are accessed through the non-const accessors.
+      if (++coords_misses * 16 < card()) return nullptr;
+      return coordinates();
+    }
 
   public :
 
@@ -99,6 +121,51 @@ namespace bgeot {
 
     void swap_points(size_type i, size_type j);
     void swap(size_type i, size_type j) { swap_points(i,j); }
+    void compact(void)
+    { dal::dynamic_tas<base_node>::compact(); resort(); touch(); }
+
+    /* Non-const accessors, the points may be modified through them. */
+    base_node &operator[](size_type i)
+    { touch(); return dal::dynamic_tas<base_node>::operator[](i); }
+    const base_node &operator[](size_type i) const
+    { return dal::dynamic_tas<base_node>::operator[](i); }
+    iterator begin(void)
+    { touch(); return dal::dynamic_tas<base_node>::begin(); }
+    const_iterator begin(void) const
+    { return dal::dynamic_tas<base_node>::begin(); }
+    iterator end(void)
+    { touch(); return dal::dynamic_tas<base_node>::end(); }
+    const_iterator end(void) const
+    { return dal::dynamic_tas<base_node>::end(); }
+    tas_iterator tas_begin(void)
+    { touch(); return dal::dynamic_tas<base_node>::tas_begin(); }
+    const_tas_iterator tas_begin(void) const
+    { return dal::dynamic_tas<base_node>::tas_begin(); }
+    tas_iterator tas_end(void)
+    { touch(); return dal::dynamic_tas<base_node>::tas_end(); }
+    const_tas_iterator tas_end(void) const
+    { return dal::dynamic_tas<base_node>::tas_end(); }
+
+    /** Contiguous array of the coordinates, the point i being stored at
+        coordinates() + i*dim(). Invalidated by any modification. */
+    const scalar_type *coordinates(void) const {
+      if (!coords_valid) update_coordinates();
+      return coords.data();
+    }
+
+    /** Copy the coordinates of the points of indices [b, e) into the
+        columns of G, which should have room for dim()*(e-b) values. */
+    template <typename ITER>
+    void gather_points(ITER b, ITER e, scalar_type *G) const {
+      const scalar_type *X = coordinates_if_worth();
+      if (X)
+        for (; b != e; ++b, G += dim_) std::copy_n(X + (*b)*dim_, dim_, G);
+      else
+        for (; b != e; ++b) {
+          const base_node &P = (*this)[*b];
+          G = std::copy(P.begin(), P.end(), G);
+        }
+    }
 
     node_tab(scalar_type prec_loose = scalar_type(10000));
     node_tab(const node_tab &t);
@@ -182,6 +182,90 @@ namespace bgeot {
     getfem::lock_factory locks_;
   };
 
+  /** Flat bounding volume hierarchy of n-dimensional rectangles.
+   *
+   * Boxes and tree nodes are stored in contiguous arrays (no per box
+   * allocation). Each box keeps the index given by add_box, so that the
+   * boxes of a deforming structure can be moved with set_box and the
+   * bounds of the tree nodes updated with refit, without rebuilding the
+   * topology of the tree as long as the boxes do not move too much.
+   * Queries fill vectors of box ids sorted in increasing order.
+   */
+  class flat_rtree {
+  public:
+    enum { BOXES_PER_LEAF=4 };
+
+    flat_rtree()
+      : N(0), tree_built(false), tree_fitted(false), built_size(0),
+        nb_refits(0) {}
+
+    size_type add_box(const base_node &min, const base_node &max,
+                      size_type id=size_type(-1));
+    /** Change the bounds of the box of index i. The tree is then unusable
+        until refit() (or build_tree()) is called. */
+    void set_box(size_type i, const base_node &min, const base_node &max);
+    size_type nb_boxes() const { return ids.size(); }
+    size_type id_of_box(size_type i) const { return ids[i]; }
+    const scalar_type *min_of_box(size_type i) const { return &box_min[i*N]; }
+    const scalar_type *max_of_box(size_type i) const { return &box_max[i*N]; }
+    /** Keep only the nb first boxes. The tree is rebuilt at the next
+        refit() if some boxes are removed. */
+    void resize(size_type nb);
+    void clear();
+
+    /** Build the tree topology from the current boxes. */
+    void build_tree();
+    /** Recompute the bounds of the tree nodes from the current boxes,
+        keeping the topology. Build the tree if it was not already built,
+        and build it again if the refitted nodes have grown too much
+        compared to the ones of the last build (the boxes having moved
+        away from their neighbours of that time) or after many refits. */
+    void refit();
+    bool is_built() const { return tree_built; }
+
+    void find_intersecting_boxes(const base_node& bmin, const base_node& bmax,
+                                 std::vector<size_type>& idvec) const;
+    void find_boxes_at_point(const base_node& P,
+                             std::vector<size_type>& idvec) const;
+    void find_line_intersecting_boxes(const base_node& org,
+                                      const base_small_vector& dirv,
+                                      std::vector<size_type>& idvec) const;
+    void find_line_intersecting_boxes(const base_node& org,
+                                      const base_small_vector& dirv,
+                                      const base_node& bmin,
+                                      const base_node& bmax,
+                                      std::vector<size_type>& idvec) const;
+    /** Batch version of find_boxes_at_point. The ids of the boxes
+        containing pts[i] are idvec[offsets[i]] ... idvec[offsets[i+1]-1]. */
+    void find_boxes_at_points(const std::vector<base_node>& pts,
+                              std::vector<size_type>& offsets,
+                              std::vector<size_type>& idvec) const;
+
+  private:
+    struct tree_node {
+      size_type first, nb; // range in perm for leaves (nb > 0)
+      size_type right;     // right child of internal nodes (left is next)
+    };
+
+    template <typename Predicate>
+    void find_matching_boxes_(const Predicate &p,
+                              std::vector<size_type>& idvec) const;
+    size_type build_tree_(size_type first, size_type nb,
+                          std::vector<scalar_type> &centers);
+    void fit_node_(size_type i);
+    scalar_type fit_tree_();
+
+    size_type N;
+    std::vector<scalar_type> box_min, box_max;   // N values per box
+    std::vector<size_type> ids;
+    std::vector<tree_node> tnodes;               // depth first order
+    std::vector<scalar_type> node_min, node_max; // N values per node
+    std::vector<size_type> perm;                 // boxes sorted by leaves
+    bool tree_built, tree_fitted;
+    scalar_type built_size; // sum of the node extents after the last build
+    size_type nb_refits;    // number of refits since the last build
+  };
+
 }
 
 #endif
@@ -38,7 +38,8 @@ Singleton was made thread safe for OpenMP
 However, now there is a singleton instance for every
 thread (singleton is thread local). This replicates
 the behaviour of singletons in distributed MPI-like
-environment;
+environment; Each caller thread (see getfem::caller_thread)
+has its own instances as well.
 */
 
 #pragma once
@@ -60,7 +61,8 @@ namespace dal {
   };
 
   class singletons_manager {
-    getfem::omp_distribute<std::vector<singleton_instance_base *>> lst;
+    getfem::omp_distribute<std::vector<singleton_instance_base *>,
+                           getfem::caller_thread_policy> lst;
     size_type nb_partitions;
     static singletons_manager& manager();
 
@@ -80,10 +82,13 @@ namespace dal {
   template <typename T, int LEV>
   class singleton_instance : public singleton_instance_base {
 
-    static getfem::omp_distribute<T*>* initializing_pointer;
+    using distribute = getfem::omp_distribute<T*,
+                                              getfem::caller_thread_policy>;
 
-    static getfem::omp_distribute<T*>*& pointer() {
-      static auto p = new getfem::omp_distribute<T*>{};
+    static distribute* initializing_pointer;
+
+    static distribute*& pointer() {
+      static auto p = new distribute{};
       return p;
     }
 
@@ -97,14 +102,18 @@ namespace dal {
 
   public:
 
-    /**Instance from thread ithread*/
+    /**Instance from thread ithread, the threads of all the caller
+       threads being numbered as by getfem::caller_thread_policy*/
     inline static T& instance(size_t ithread) {
       pointer()->on_thread_update();
       T*& tinstance_ = instance_pointer(ithread);
       if (!tinstance_) {
-        tinstance_ = new T();
-        singletons_manager::register_new_singleton(
-          new singleton_instance<T,LEV>(), ithread);
+        GLOBAL_OMP_GUARD
+        if (!tinstance_) {
+          tinstance_ = new T();
+          singletons_manager::register_new_singleton(
+            new singleton_instance<T,LEV>(), ithread);
+        }
       }
       return *instance_pointer(ithread);
     }
@@ -128,6 +137,7 @@ namespace dal {
 
     ~singleton_instance() {
       if (!pointer()) return;
+      pointer()->on_thread_update(); // partitions may have been added since
       for(size_t i = 0; i != pointer()->num_threads(); ++i) {
         auto &p_singleton = (*pointer())(i);
         if(p_singleton){
@@ -141,7 +151,8 @@ namespace dal {
     }
   };
 
-  template<typename T, int LEV> getfem::omp_distribute<T*>*
+  template<typename T, int LEV>
+  typename singleton_instance<T, LEV>::distribute*
   singleton_instance<T, LEV>::initializing_pointer = singleton_instance<T, LEV>::pointer();
 
   /** singleton class.
@@ -316,7 +316,9 @@ namespace dal {
 
 
 
-  /** Table of stored objects. Thread safe, uses thread specific mutexes. */
+  /** Table of stored objects. Each thread has its own table, protected by
+      a read/write lock, so that the lookups of a thread do not wait for the
+      ones of the other threads. */
   struct stored_object_tab :
     public std::map<enr_static_stored_object_key, enr_static_stored_object> {
 
@@ -327,6 +329,10 @@ namespace dal {
     ~stored_object_tab();
     pstatic_stored_object
       search_stored_object(pstatic_stored_object_key k) const;
+    //same, from the thread owning the table, trying the last
+    //successful lookups first
+    pstatic_stored_object
+      search_stored_object_this_thread(pstatic_stored_object_key k) const;
     bool has_dependent_objects(pstatic_stored_object o) const;
     bool exists_stored_object(pstatic_stored_object o) const;
     //adding the object to the storage on the current thread
@@ -356,8 +362,20 @@ namespace dal {
     pstatic_stored_object o2);
     void basic_delete_(std::list<pstatic_stored_object> &to_delete);
 
-    getfem::lock_factory locks_;
+    getfem::shared_lock_factory locks_;
     stored_key_tab stored_keys_;
+
+  private:
+    //last successful lookups of the owning thread, pointing into the
+    //table. They are forgotten as soon as an object is deleted.
+    enum { NB_CACHED_LOOKUPS = 8 };
+    struct cached_lookup {
+      const static_stored_object_key *k;
+      const enr_static_stored_object *o;
+    };
+    mutable cached_lookup cache_[NB_CACHED_LOOKUPS];
+    mutable size_t cache_next_, cache_generation_;
+    size_t generation_;
   };
 
 
@@ -40,6 +40,7 @@
 
 #include "getfem_interpolation.h"
 #include "getfem_mesh_slice.h"
+#include <cstdio>
 #include <list>
 
 namespace getfem {
@@ -64,8 +65,21 @@ namespace getfem {
       legacy and serial vtkUnstructuredGrid)
 
       A vtk_export can store multiple scalar/vector fields.
+
+      In binary vtu mode, the data arrays are base64 encoded inline by
+      default. With set_appended_data(), they are instead stored raw (and
+      possibly zlib compressed) in the AppendedData section of the file,
+      which is smaller and faster to write.
   */
   class vtk_export {
+  public:
+    /** description of a data array written in a vtu file. */
+    struct data_array_info {
+      std::string name;
+      size_type nb_comp;
+      bool cell_data;
+    };
+
   protected:
     std::ostream &os;
     char header[256]; // hard limit in vtk/vtu
@@ -79,6 +93,10 @@ namespace getfem {
     dim_type dim_;
     bool reverse_endian;
     std::vector<unsigned char> vals;
+    bool appended, compressed;  // vtu only: data in the AppendedData section
+    std::FILE *appended_data;   // temporary storage of the appended data
+    std::uint64_t appended_size;
+    std::vector<data_array_info> arrays;
     enum { EMPTY, HEADER_WRITTEN, STRUCTURE_WRITTEN, IN_CELL_DATA,
            IN_POINT_DATA } state;
 
@@ -88,6 +106,8 @@ namespace getfem {
     void write_separ();
     void clear_vals();
     void write_vals();
+    void write_appended_block();
+    std::string data_format() const;
 
   public:
     vtk_export(const std::string& fname, bool ascii_ = false, bool vtk_= true);
@@ -97,6 +117,19 @@ namespace getfem {
     void exporting(const mesh& m);
     void exporting(const mesh_fem& mf);
     void exporting(const stored_mesh_slice& sl);
+    /** export only the convexes of the region rg (a partition of the mesh
+        for instance). */
+    void exporting(const mesh& m, const mesh_region &rg);
+    void exporting(const mesh_fem& mf, const mesh_region &rg);
+
+    /** vtu binary format only: store the data arrays raw in an appended
+        section instead of base64 encoding them. If compress is true, each
+        data array is compressed with zlib (GetFEM has to be built with zlib).
+        Should be called before anything is written. */
+    void set_appended_data(bool compress = false);
+    /** the data arrays written so far (vtu only). */
+    const std::vector<data_array_info> &data_arrays() const
+    { return arrays; }
 
     /** the header is the second line of text in the exported file,
        you can put whatever you want -- call this before any write_dataset
@@ -144,6 +177,7 @@ namespace getfem {
     const mesh_fem& get_exported_mesh_fem() const;
   private:
     void init();
+    void exporting_(const mesh_fem& mf, const dal::bit_vector &cvlst);
     void check_header();
     void write_mesh_structure_from_slice();
     void write_mesh_structure_from_mesh_fem();
@@ -165,10 +199,8 @@ namespace getfem {
             std::swap(p[i], p[sizeof(v)-i-1]);
         os.write(p, sizeof(T));
       } else {
-        union { T value; unsigned char bytes[sizeof(T)]; } UNION;
-        UNION.value = v;
-        for (size_type i=0; i < sizeof(T); i++)
-          vals.push_back(UNION.bytes[i]);
+        const unsigned char *b = reinterpret_cast<const unsigned char *>(&v);
+        vals.insert(vals.end(), b, b + sizeof(T));
       }
     }
   }
@@ -244,7 +276,7 @@ namespace getfem {
     if (cell_data) {
       switch_to_cell_data();
       nb_val = psl ? psl->linked_mesh().convex_index().card()
-                   : pmf->linked_mesh().convex_index().card();
+                   : pmf->convex_index().card();
     } else {
       switch_to_point_data();
       nb_val = psl ? psl->nb_points() : pmf_dof_used.card();
@@ -255,14 +287,19 @@ namespace getfem {
                 "inconsistency in the size of the dataset: "
                 << gmm::vect_size(U) << " != " << nb_val << "*" << Q);
     if (vtk) write_separ();
-    if (!vtk && !ascii) write_val(float(gmm::vect_size(U)));
+    if (!vtk) {
+      size_type nb_comp = (Q == 1) ? 1 : ((Q <= 3) ? 3 : 9);
+      arrays.push_back(data_array_info{remove_spaces(name), nb_comp,
+                                       cell_data});
+      if (!ascii) vals.reserve(vals.size() + nb_val*nb_comp*sizeof(float));
+    }
     if (Q == 1) {
       if (vtk)
         os << "SCALARS " << remove_spaces(name) << " float 1\n"
            << "LOOKUP_TABLE default\n";
       else
         os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name) << "\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+           << data_format();
       for (size_type i=0; i < nb_val; ++i)
         write_val(float(U[i]));
     } else if (Q <= 3) {
@@ -271,7 +308,7 @@ namespace getfem {
       else
         os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name) << "\" "
            << "NumberOfComponents=\"3\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+           << data_format();
       for (size_type i=0; i < nb_val; ++i)
         write_vec(U.begin() + i*Q, Q);
     } else if (Q == gmm::sqr(dim_)) {
@@ -283,7 +320,7 @@ namespace getfem {
       else
         os << "<DataArray type=\"Float32\" Name=\"" << remove_spaces(name)
            << "\" NumberOfComponents=\"9\" "
-           << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
+           << data_format();
       for (size_type i=0; i < nb_val; ++i)
         write_3x3tensor(U.begin() + i*Q);
     } else
@@ -301,6 +338,32 @@ namespace getfem {
     vtu_export(std::ostream &os_, bool ascii_ = false) : vtk_export(os_, ascii_, false) {}
   };
 
+  /** @brief Partitioned VTU export.
+
+      The data is split into pieces, each one written in its own vtu file
+      by an independent vtu_export (typically one per thread or per MPI
+      process, exporting its own region with exporting(mf, rg)), and a
+      pvtu file gathering the pieces. The pieces of "name.pvtu" are
+      "name_0.vtu", "name_1.vtu", ... and store their data appended.
+  */
+  class pvtu_export {
+    std::string basename;
+    size_type nb_pieces;
+    bool compress;
+  public:
+    /** fname is the name of the pvtu file (with or without extension). */
+    pvtu_export(const std::string& fname, size_type nb_pieces_,
+                bool compress_ = false);
+    size_type nb_piece() const { return nb_pieces; }
+    std::string piece_file_name(size_type i) const;
+    /** return an exporter on the vtu file of the i-th piece. */
+    std::unique_ptr<vtu_export> piece(size_type i) const;
+    /** write the pvtu file, the data arrays being the ones written in the
+        pieces (which should all have the same data arrays). */
+    void write_pvtu_file
+    (const std::vector<vtk_export::data_array_info> &arrays) const;
+  };
+
   /** @brief A (quite large) class for exportation of data to IBM OpenDX.
 
                      http://www.opendx.org/
@@ -511,7 +574,7 @@ namespace getfem {
     size_type nb_val = 0;
     if (cell_data) {
       nb_val = psl ? psl->linked_mesh().convex_index().card()
-                   : pmf->linked_mesh().convex_index().card();
+                   : pmf->convex_index().card();
     } else {
       nb_val = psl ? (psl_use_merged ? psl->nb_merged_nodes() : psl->nb_points())
                    : pmf_dof_used.card();
@@ -617,6 +680,7 @@ namespace getfem {
 
   private:
     void init();
+    void exporting_(const mesh_fem& mf, const dal::bit_vector &cvlst);
     void check_header();
 
     template <class VECT>
@@ -331,8 +331,11 @@ namespace getfem {
     std::string &debug_name() { return debug_name_; }
     virtual bgeot::pstored_point_tab node_tab(size_type) const {
       if (!pspt_valid) {
-        pspt = bgeot::store_point_tab(cv_node.points());
-        pspt_valid = true;
+        GLOBAL_OMP_GUARD
+        if (!pspt_valid) {
+          pspt = bgeot::store_point_tab(cv_node.points());
+          pspt_valid = true;
+        }
       }
       return pspt;
     }
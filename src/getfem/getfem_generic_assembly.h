@@ -57,6 +57,7 @@ namespace getfem {
   struct ga_tree;
   class model;
   class ga_workspace;
+  struct ga_instruction_set;
 
   typedef gmm::rsvector<scalar_type> model_real_sparse_vector;
   typedef gmm::rsvector<complex_type> model_complex_sparse_vector;
@@ -223,6 +224,24 @@ namespace getfem {
     virtual void second_derivative(const arg_list &args, size_type i,
                                    size_type j, base_tensor &result) const = 0;
 
+    // Optional evaluation on a batch of nbpt points (all the integration
+    // points of an element). Each argument and the result are stored with
+    // an additional last index, the point, so that the components of a
+    // point are contiguous. The default implementations call the above
+    // methods point by point. An operator overriding them has to return
+    // true in has_batched_evaluation() for the compiler to use them.
+    virtual bool has_batched_evaluation() const { return false; }
+
+    virtual void batched_value(const arg_list &args, size_type nbpt,
+                               base_tensor &result) const;
+
+    virtual void batched_derivative(const arg_list &args, size_type i,
+                                    size_type nbpt, base_tensor &result) const;
+
+    virtual void batched_second_derivative(const arg_list &args, size_type i,
+                                           size_type j, size_type nbpt,
+                                           base_tensor &result) const;
+
     virtual ~ga_nonlinear_operator() {}
   };
 
@@ -255,6 +274,78 @@ namespace getfem {
   void ga_undefine_function(const std::string &name);
   bool ga_function_exists(const std::string &name);
 
+  //=========================================================================
+  // Native code backend of the assembly.
+  //=========================================================================
+
+  /** Enables or disables (default) the native code backend of the
+      assemblies compiled from now on. The sequences of tensor operations
+      executed on each integration point (values and gradients of the
+      variables, algebraic operations, contractions, scalar functions) are
+      then translated into C++ with the sizes of the tensors as constants,
+      compiled with the system compiler into shared objects cached on disk
+      and loaded instead of being interpreted. The other instructions, and
+      any sequence whose kernel cannot be built, remain interpreted.
+      Available only if GetFEM has been built with dlopen support, and not
+      used for the profiled assemblies. */
+  void ga_enable_native_code(bool enable = true);
+  bool ga_native_code_enabled();
+  /** Command compiling a source file into a shared object, the source and
+      the object file being appended as "-o object source". Default:
+      "c++ -O3 -march=native -fPIC -shared". The kernels are cached under
+      the hash of their source, of this command and of the identity of the
+      processor (machine, model and instruction set extensions), so that a
+      cache shared by different hosts does not mix their kernels. */
+  void ga_set_native_code_compiler(const std::string &command);
+  /** Directory in which the kernels are kept (created with mode 0700 if
+      needed). It has to belong to the user and not be writable by the
+      others, otherwise no kernel is loaded. Default: getfem_native_code in
+      $XDG_CACHE_HOME or ~/.cache, or /tmp/getfem_native_code-<uid>. */
+  void ga_set_native_code_cache(const std::string &directory);
+  /** Number of native code kernels loaded so far. */
+  size_type ga_nb_native_code_kernels();
+
+  //=========================================================================
+  // Profiling of the assembly.
+  //=========================================================================
+
+  /** Number of calls and cumulated time (in seconds) of a part of the
+      assembly. */
+  struct ga_profile_counters {
+    size_type nb_calls = 0;
+    scalar_type time = scalar_type(0);
+    ga_profile_counters &operator +=(const ga_profile_counters &c)
+    { nb_calls += c.nb_calls; time += c.time; return *this; }
+  };
+
+  /** Profile of the compiled instructions coming from one expression. The
+      instructions shared by several expressions are counted for the first
+      one. */
+  struct ga_expression_profile {
+    size_type nb_elements = 0;     // Elements (or faces) visited
+    size_type nb_gauss_points = 0; // Integration points processed
+    ga_profile_counters instructions;
+    ga_expression_profile &operator +=(const ga_expression_profile &e);
+  };
+
+  /** Profile of the assemblies done by a ga_workspace (or a model) with
+      the profiling enabled. */
+  struct ga_assembly_profile {
+    size_type nb_assemblies = 0;
+    size_type nb_elements = 0;     // Elements (or faces) visited
+    size_type nb_gauss_points = 0; // Integration points processed
+    scalar_type compile_time = scalar_type(0), exec_time = scalar_type(0);
+    ga_profile_counters scatter;   // Additions of the element matrices
+                                   // into the global matrix
+    std::map<std::string, ga_profile_counters> instructions; // by type
+    std::map<std::string, ga_expression_profile> expressions;
+
+    void clear() { *this = ga_assembly_profile(); }
+    ga_assembly_profile &operator +=(const ga_assembly_profile &p);
+  };
+
+  std::ostream &operator <<(std::ostream &o, const ga_assembly_profile &p);
+
   //=========================================================================
   // Structure dealing with user defined environment : constant, variables,
   // functions, operators.
@@ -374,12 +465,47 @@ namespace getfem {
     base_vector unreduced_V, cached_V;
     base_tensor assemb_t;
     bool include_empty_int_pts = false;
+    bool batched_int_pts = false;
+    const column_locks *K_locks = nullptr;
+    // The copy of a profiled workspace is profiled with an empty profile
+    struct profile_holder : public std::unique_ptr<ga_assembly_profile> {
+      profile_holder() {}
+      profile_holder(const profile_holder &ph)
+      { if (ph) reset(new ga_assembly_profile()); }
+      profile_holder &operator =(const profile_holder &ph)
+      { reset(ph ? new ga_assembly_profile() : nullptr); return *this; }
+    };
+    profile_holder profile_;
+    // Instructions compiled by assembly() for each order and condensation
+    // option, kept for the next calls if required. Not copied with the
+    // workspace, since they refer to it.
+    struct compiled_holder
+      : public std::map<std::pair<size_type, bool>,
+                        std::shared_ptr<ga_instruction_set>> {
+      compiled_holder() {}
+      compiled_holder(const compiled_holder &) {}
+      compiled_holder &operator =(const compiled_holder &)
+      { clear(); return *this; }
+    };
+    bool keep_compiled = false;
+    compiled_holder compiled_gis;
 
   public:
     // setter functions
     void set_assembled_matrix(model_real_sparse_matrix &K_) {
       K = std::shared_ptr<model_real_sparse_matrix>
           (std::shared_ptr<model_real_sparse_matrix>(), &K_); // alias
+      K_locks = nullptr;
+    }
+    /** Set a matrix shared by the threads of a parallel assembly as the
+        assembled matrix. The additions of the element matrices are
+        protected column-wise by the given locks, so that no per-thread
+        copy of the matrix is necessary. The locks are ignored if only one
+        thread is available. */
+    void set_assembled_matrix(model_real_sparse_matrix &K_,
+                              const column_locks &locks) {
+      set_assembled_matrix(K_);
+      if (!not_multithreaded()) K_locks = &locks;
     }
     void set_assembled_vector(base_vector &V_) {
       V = std::shared_ptr<base_vector>
@@ -388,6 +514,7 @@ namespace getfem {
     // getter functions
     const model_real_sparse_matrix &assembled_matrix() const { return *K; }
     model_real_sparse_matrix &assembled_matrix() { return *K; }
+    const column_locks *assembled_matrix_locks() const { return K_locks; }
     const base_vector &assembled_vector() const { return *V; }
     base_vector &assembled_vector() { return *V; }
     const base_vector &cached_vector() const { return cached_V; }
@@ -565,9 +692,39 @@ namespace getfem {
 
     void assembly(size_type order, bool condensation=false);
 
+    /** Keep the instructions compiled by assembly() for the next calls with
+        the same order, which then only update the values of the variables
+        defined on reduced fems before the execution. Between two calls,
+        only the values of the variables may change (the fixed size ones
+        are then read at each execution instead of being evaluated at the
+        compilation): not the expressions, the assembled matrix and
+        vector, the variables, their size or their fems. */
+    void keep_compiled_instructions(bool keep = true)
+    { keep_compiled = keep; if (!keep) compiled_gis.clear(); }
+    bool keeps_compiled_instructions() const { return keep_compiled; }
+
     void set_include_empty_int_points(bool include);
     bool include_empty_int_points() const;
 
+    /** If set, the bilinear terms of the form Ani Bmi -> Cmn are compiled
+        so that the contraction is performed once per element on all its
+        integration points (point-major storage of A and B and a single
+        matrix-matrix product) instead of once per integration point. */
+    void set_batched_int_points(bool batched);
+    bool batched_int_points() const;
+
+    /** Enable the profiling of the assemblies: number of calls and time
+        spent per type of compiled instruction and per expression, elements
+        and integration points visited, time spent in the addition of the
+        element matrices. A workspace built on a model with the assembly
+        profiling enabled is profiled and adds its profile to the one of
+        the model when destroyed. */
+    void enable_profiling(bool enable = true);
+    bool profiling_enabled() const { return bool(profile_); }
+    const ga_assembly_profile &profile() const;
+    ga_assembly_profile &profile();
+    void clear_profile() { if (profile_) profile_->clear(); }
+
     size_type nb_primary_dof() const { return nb_prim_dof; }
     size_type nb_internal_dof() const { return nb_intern_dof; }
     size_type first_internal_dof() const { return first_intern_dof; }
@@ -63,13 +63,48 @@ namespace getfem {
   };
 
 
+  struct ga_native_code;
+
   struct ga_instruction {
     virtual int exec() = 0;
+    // Writes the operation in native code (see ga_native_code), if the
+    // instruction is supported by the native code backend.
+    virtual bool emit(ga_native_code &) const { return false; }
     virtual ~ga_instruction() {};
   };
 
   typedef std::shared_ptr<ga_instruction> pga_instruction;
 
+  /* Source of a native code kernel executing a sequence of instructions.
+     The instructions designate their operands with the following functions
+     which return their names in the code and write their operation in
+     body. The current sizes of the tensors and vectors are constants of
+     the code: a kernel is only valid for these sizes. */
+  struct ga_native_code {
+    struct operand {
+      char kind;            // 'T' tensor, 'V' vector, 'S' scalar, 'F' function
+      const base_tensor *t; // data pointer taken at each call
+      const base_vector *v; // data pointer taken at each call
+      void *p;              // fixed pointer (scalars and functions)
+    };
+    std::vector<operand> operands;
+    std::ostringstream body;
+
+    std::string tensor(const base_tensor &t);
+    std::string vector(const base_vector &v);
+    std::string scalar(const scalar_type &s);
+    std::string function(pscalar_func_onearg f);
+    std::string source() const;
+  private:
+    std::map<const void *, std::string> names;
+    std::string add_operand(const void *key, const operand &o);
+  };
+
+  /** Replaces the sequences of instructions supported by the native code
+      backend by the execution of kernels compiled on the fly for the
+      sizes met at the execution (see ga_enable_native_code). */
+  void ga_native_code_segments(std::vector<pga_instruction> &instructions);
+
   struct gauss_pt_corresp { // For neighbor interpolation transformation
     bgeot::pgeometric_trans pgt1, pgt2;
     papprox_integration pai;
@@ -90,6 +125,9 @@ namespace getfem {
     bool need_elt_size;
     scalar_type coeff;             // Coefficient for the Gauss point
     size_type nbpt, ipt;           // Number and index of Gauss point
+    size_type batch_sweep;         // Current sweep of the Gauss points for
+                                   // the batched operators (0 for the
+                                   // last one, see ga_exec)
     bgeot::geotrans_precomp_pool gp_pool;
     fem_precomp_pool fp_pool;
     std::map<gauss_pt_corresp, bgeot::pstored_point_tab> neighbor_corresp;
@@ -194,9 +232,29 @@ namespace getfem {
         elt_instructions,    // Instructions executed once per element
         instructions;        // Instructions executed on each
                              // integration/interpolation point
+      std::vector<size_type> // For the profiling only: index in
+        begin_instructions_expr, // gis.expressions of the expression each
+        elt_instructions_expr,   // instruction has been compiled from
+        instructions_expr;
       std::map<scalar_type, std::list<pga_tree_node> > node_list;
 
-      region_mim_instructions(): m(0), im(0) {}
+      struct contraction_info { // Contraction Ani Bmi -> Cmn of a node
+        const base_tensor *tc1, *tc2;
+        size_type n;   // Contracted size
+        size_type ind; // Index of the instruction in instructions
+      };
+      std::map<const ga_tree_node *, contraction_info> contractions;
+
+      // Evaluation of the nonlinear operators on all the Gauss points of an
+      // element at once. Before the normal sweep of the Gauss points, a
+      // sweep per level of nesting of the batched operators collects their
+      // arguments, executing the instructions up to batch_ends[level-1]
+      // except the ones marked in batch_skip (assembly and output).
+      bool batched_operators; // Batched operators allowed at compile time
+      std::vector<size_type> batch_ends;
+      std::vector<bool> batch_skip;
+
+      region_mim_instructions(): m(0), im(0), batched_operators(false) {}
     };
 
     std::list<ga_tree> trees; // The trees are stored mainly because they
@@ -204,15 +262,19 @@ namespace getfem {
     std::list<ga_tree> interpolation_trees;
 
     std::map<region_mim, region_mim_instructions> all_instructions;
+    std::vector<std::string> expressions; // Compiled expressions (profiling)
 
     // storage of intermediary tensors for condensation of variables
     std::list<std::shared_ptr<base_tensor>> condensation_tensors;
 
-    ga_instruction_set() : need_elt_size(false), nbpt(0), ipt(0) {}
+    ga_instruction_set()
+      : need_elt_size(false), nbpt(0), ipt(0), batch_sweep(0) {}
   };
 
   
   void ga_exec(ga_instruction_set &gis, ga_workspace &workspace);
+  void ga_update_extended_variables(const ga_workspace &workspace,
+                                    ga_instruction_set &gis);
   void ga_function_exec(ga_instruction_set &gis);
   void ga_compile(ga_workspace &workspace, ga_instruction_set &gis,
                   size_type order, bool condensation=false);
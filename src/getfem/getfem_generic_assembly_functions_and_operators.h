@@ -43,7 +43,10 @@
 namespace getfem {
 
   struct ga_instruction_set;
-  using instruction_set = omp_distribute<ga_instruction_set>;
+  // Distributed over the threads of all the caller threads, since the
+  // predefined functions are shared by them.
+  using instruction_set = omp_distribute<ga_instruction_set,
+                                         caller_thread_policy>;
   
   class ga_predef_function {
     size_type ftype_; // 0 : C++ function with C++ derivative(s)
@@ -58,8 +61,8 @@ namespace getfem {
     pscalar_func_twoargs f2_;  // Function pointer for a two arguments function
     std::string expr_;
     std::string derivative1_, derivative2_;
-    mutable omp_distribute<base_vector> t, u;
-    mutable omp_distribute<ga_workspace> workspace;
+    mutable omp_distribute<base_vector, caller_thread_policy> t, u;
+    mutable omp_distribute<ga_workspace, caller_thread_policy> workspace;
     copyable_ptr<instruction_set> gis;
 
     friend void ga_define_function(const std::string &name, size_type nbargs,
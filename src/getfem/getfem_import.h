@@ -80,6 +80,10 @@ namespace getfem {
        in Gmsh, that which does not occur in GetFEM since there is
        only one "type of region".
 
+       The version 4.1 of the format can be read either in text or in
+       binary mode (gmsh option -bin), the latter being much faster
+       to import for large meshes.
+
 
       - "cdb" for meshes generated by ANSYS (in blocked format).
 
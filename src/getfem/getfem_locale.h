@@ -48,8 +48,8 @@ namespace getfem {
      change std::locale in multi-threaded sections
      of the code, which is not thread-safe*/
   class standard_locale {
-    std::string cloc;
-    std::locale cinloc;
+    std::string cloc;     // Saved locales, only used on Windows where
+    std::locale cinloc;   // the locale is saved by each instance.
   public :
     standard_locale();
     ~standard_locale();
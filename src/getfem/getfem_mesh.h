@@ -122,6 +122,8 @@ namespace getfem {
     mutable bool cuthill_mckee_uptodate;
     dal::dynamic_array<gmm::uint64_type> cvs_v_num;
     mutable std::vector<size_type> cmk_order; // cuthill-mckee
+    mutable bool colors_uptodate = false;
+    mutable std::vector<dal::bit_vector> cv_colors; // convex coloring
     void init();
 
 #if GETFEM_PARA_LEVEL > 1
@@ -133,7 +135,7 @@ namespace getfem {
 
     void touch() {
       modified = true; cuthill_mckee_uptodate = false;
-      context_dependencies::touch();
+      colors_uptodate = false; context_dependencies::touch();
     }
     void compute_mpi_region() const ;
     void compute_mpi_sub_region(size_type) const;
@@ -150,8 +152,10 @@ namespace getfem {
     }
     void intersect_with_mpi_region(mesh_region &rg) const;
 #else
-    void touch()
-    { cuthill_mckee_uptodate = false; context_dependencies::touch(); }
+    void touch() {
+      cuthill_mckee_uptodate = false; colors_uptodate = false;
+      context_dependencies::touch();
+    }
   public :
     const mesh_region get_mpi_region() const
     { return mesh_region::all_convexes(); }
@@ -232,6 +236,22 @@ namespace getfem {
       return i;
     }
 
+    /** Add a convex to the mesh, without checking whether a convex with
+        the same points already exists (bulk insertion of convexes known
+        to be distinct, by mesh readers for instance).
+        @param pgt the geometric transformation of the convex.
+        @param ipts an iterator to a set of point index.
+        @return the number of the new convex.
+     */
+    template<class ITER>
+    size_type add_convex_noverif(bgeot::pgeometric_trans pgt, ITER ipts) {
+      size_type i = bgeot::mesh_structure::add_convex_noverif(pgt->structure(),
+                                                              ipts);
+      gtab[i] = pgt; trans_exists[i] = true;
+      cvs_v_num[i] = act_counter(); touch();
+      return i;
+    }
+
     /** Add a convex to the mesh, given a geometric transformation and a
         list of point coordinates.
 
@@ -456,6 +476,13 @@ namespace getfem {
     void optimize_structure(bool with_renumbering = true);
     /// Return the list of convex IDs for a Cuthill-McKee ordering
     const std::vector<size_type> &cuthill_mckee_ordering() const;
+    /** Return a coloring of the convexes of the mesh: two convexes of the
+        same color never share a point. Assembling on the convexes of one
+        color thus never adds twice to the same degree of freedom of a
+        Lagrange-like fem, which allows concurrent writes in the same
+        vector or matrix. The coloring is computed once for the current
+        state of the mesh. */
+    const std::vector<dal::bit_vector> &convex_colors() const;
     /// Erase the mesh.
     void clear();
     /** Write the mesh to a file. The format is getfem-specific.
@@ -476,6 +503,15 @@ namespace getfem {
         @see getfem::import_mesh.
     */
     void read_from_file(std::istream &ist);
+    /** Write the mesh to a file in the binary native format. The file
+        is recognized and bulk loaded by read_from_file.
+        @param name the file name.
+    */
+    void write_to_binary_file(const std::string &name) const;
+    /* internal usage. */
+    void write_to_binary(bgeot::binary_file_writer &w) const;
+    /* internal usage. */
+    void read_from_binary(bgeot::binary_file_reader &r);
     /** Clone a mesh */
     void copy_from(const mesh& m); /* might be the copy constructor */
     size_type memsize() const;
@@ -483,6 +519,7 @@ namespace getfem {
     friend class mesh_region;
   private:
     void swap_convex_in_regions(size_type c1, size_type c2);
+    void swap_convex_except_regions(size_type i, size_type j);
     void touch_from_region(size_type /*id*/) { touch(); }
     void to_edges() {} /* to be done, the to_edges of mesh_structure does   */
                        /* not handle geotrans */
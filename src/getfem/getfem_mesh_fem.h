@@ -156,6 +156,9 @@ namespace getfem {
 
     void copy_from(const mesh_fem &mf); /* Remember to change copy_from if
                                            adding components to mesh_fem */
+    /* Topological and parallel enumeration of the dofs. Returns false
+       if some fems need the geometric matching of enumerate_dof. */
+    bool enumerate_dof_para() const;
 
     std::vector<pfem> f_elems;
     dal::bit_vector fe_convex;
@@ -551,9 +554,6 @@ namespace getfem {
      * to call this function, as it is done automatically */
     virtual void enumerate_dof() const;
 
-#if GETFEM_PARA_LEVEL > 1
-    void enumerate_dof_para()const;
-#endif
 
     /** Return the total number of basic degrees of freedom (before the
      * optional reduction). */
@@ -636,6 +636,20 @@ namespace getfem {
         saved to the file.
     */
     void write_to_file(const std::string &name, bool with_mesh=false) const;
+    /** Write the mesh_fem to a file in the binary native format. The
+        file is recognized and bulk loaded by read_from_file.
+
+        @param name the file name
+
+        @param with_mesh if set, then the linked_mesh() will also be
+        saved to the file.
+    */
+    void write_to_binary_file(const std::string &name,
+                              bool with_mesh=false) const;
+    /* internal usage. */
+    void write_to_binary(bgeot::binary_file_writer &w) const;
+    /* internal usage. */
+    void read_from_binary(bgeot::binary_file_reader &r);
   };
 
   /** Gives the descriptor of a classical finite element method of degree K
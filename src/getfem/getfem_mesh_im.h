@@ -146,6 +146,20 @@ namespace getfem {
         saved to the file.
     */
     void write_to_file(const std::string &name, bool with_mesh=false) const;
+    /** Write the mesh_im to a file in the binary native format. The
+        file is recognized and bulk loaded by read_from_file.
+
+        @param name the file name
+
+        @param with_mesh if set, then the linked_mesh() will also be
+        saved to the file.
+    */
+    void write_to_binary_file(const std::string &name,
+                              bool with_mesh=false) const;
+    /* internal usage. */
+    void write_to_binary(bgeot::binary_file_writer &w) const;
+    /* internal usage. */
+    void read_from_binary(bgeot::binary_file_reader &r);
   };
 
   /** Dummy mesh_im for default parameter of functions. */
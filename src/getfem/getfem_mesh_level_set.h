@@ -81,6 +81,11 @@ namespace getfem {
 
     mutable dal::bit_vector crack_tip_convexes_;
 
+    // level sets and their values at the last call to adapt, used to
+    // detect the convexes to be cut again by an incremental adapt.
+    std::vector<plevel_set> adapted_level_sets;
+    std::vector<std::vector<scalar_type>> adapted_values;
+
   public :
     /// Get number of level-sets referenced in this object.
     size_type nb_level_sets(void) const { return level_sets.size(); }
@@ -131,8 +136,15 @@ namespace getfem {
 
     /** fill m with the (non-conformal) "cut" mesh. */
     void global_cut_mesh(mesh &m) const;
-    /** do all the work (cut the convexes wrt the levelsets) */
-    void adapt(void);
+    /** do all the work (cut the convexes wrt the levelsets).
+
+        The cut elements are processed in parallel when GetFEM is
+        compiled with OpenMP. If incremental is true and the object has
+        already been adapted with the same level sets on an unchanged
+        mesh, only the convexes on which the values of a level set have
+        changed since the last call are cut again.
+    */
+    void adapt(bool incremental = false);
     void merge_zoneset(zoneset &zones1, const zoneset &zones2) const;
     void merge_zoneset(zoneset &zones1, const std::string &subz) const;
     const std::string &primary_zone_of_convex(size_type cv) const
@@ -164,13 +176,20 @@ namespace getfem {
 
   private:
     void cut_element(size_type cv, const dal::bit_vector &primary,
-		     const dal::bit_vector &secondary, scalar_type radius);
+		     const dal::bit_vector &secondary, scalar_type radius,
+		     convex_info &cvi) const;
     int is_not_crossed_by(size_type c, plevel_set ls, unsigned lsnum,
-			  scalar_type radius);
-    int sub_simplex_is_not_crossed_by(size_type cv, plevel_set ls,
-				      size_type sub_cv, scalar_type radius);
-    void find_zones_of_element(size_type cv, std::string &prezone,
-			       scalar_type radius);
+			  scalar_type radius) const;
+    int sub_simplex_is_not_crossed_by(size_type cv, const convex_info &cvi,
+				      plevel_set ls, size_type sub_cv,
+				      scalar_type radius) const;
+    /** Refine the zone prezone of the whole convex for each sub-convex
+	of the cut element. Gives one string per sub-convex, to be merged
+	into cvi.zones with merge_zoneset. */
+    void find_zones_of_element(size_type cv, const convex_info &cvi,
+			       const std::string &prezone, scalar_type radius,
+			       std::vector<std::string> &subzones) const;
+    bool level_set_values_changed(size_type cv) const;
 
     /** For each levelset, if the convex cv is crossed, add the levelset number
 	into 'prim' (and 'sec' is the levelset has a secondary part).
@@ -179,10 +198,11 @@ namespace getfem {
     void find_crossing_level_set(size_type cv, 
 				 dal::bit_vector &prim, 
 				 dal::bit_vector &sec, std::string &zone,
-				 scalar_type radius);
+				 scalar_type radius) const;
     void run_delaunay(std::vector<base_node> &fixed_points,
 		      gmm::dense_matrix<size_type> &simplexes,
-		      std::vector<dal::bit_vector> &fixed_points_constraints);
+		      std::vector<dal::bit_vector> &fixed_points_constraints)
+      const;
     
     void update_crack_tip_convexes();
   };
@@ -39,13 +39,19 @@
 
 #include <atomic>
 #include <bitset>
+#include <functional>
 #include <iostream>
-#include <map>
+#include <vector>
 
 #include "dal_bit_vector.h"
 #include "bgeot_convex_structure.h"
 #include "getfem_config.h"
 
+namespace bgeot {
+  class binary_file_writer;
+  class binary_file_reader;
+}
+
 namespace getfem {
   class mesh;
 
@@ -55,16 +61,34 @@ namespace getfem {
   class APIDECL mesh_region {
   public:
     using face_bitset = std::bitset<MAX_FACES_PER_CV+1>;
-    using map_t = std::map<size_type, face_bitset>;
+    /** An entry of the region: a convex and the mask of its faces in the
+        region (bit 0 for the convex itself, bit f+1 for its face f). */
+    using entry = std::pair<size_type, face_bitset>;
+    using entries_t = std::vector<entry>;
+    /** Estimated cost of the computations on the convex cv (f = -1) or on
+        its face f, used to balance the partitions between the threads. */
+    using entry_cost = std::function<scalar_type(size_type, short_type)>;
 
   private:
 
-    using const_iterator = map_t::const_iterator;
+    using const_iterator = entries_t::const_iterator;
 
+    /* The entries are stored in a vector sorted by convex number. The ones
+       added out of order are appended, and the vector is sorted again at
+       the next access (see rp() and wp()). The entries emptied by sup() are
+       kept, so that sup() does not invalidate the iterators on the region,
+       until the vector is sorted again or clean() is called. */
     struct impl {
-      mutable map_t m;
+      mutable entries_t m;
+      mutable std::atomic_bool sorted;
       mutable omp_distribute<dal::bit_vector> index_;
       mutable dal::bit_vector serial_index_;
+
+      void sort() const;
+      void compact() const;
+      impl() : sorted(true) {}
+      impl(const impl &other) : impl() { *this = other; }
+      impl &operator=(const impl &other);
     };
     std::shared_ptr<impl> p;  /* the real region data */
 
@@ -82,36 +106,37 @@ namespace getfem {
     mesh *parent_mesh; /* used for mesh_region "extracted" from
                           a mesh (to provide feedback) */
 
-
-    //caching iterators for partitions
-    mutable omp_distribute<const_iterator> itbegin;
-    mutable omp_distribute<const_iterator> itend;
-
     //flags for all the caches
     mutable omp_distribute<bool> index_updated;
-    mutable omp_distribute<bool> partitions_updated;
     mutable bool serial_index_updated;
 
     void mark_region_changed() const;
 
     void update_index() const;
 
-    void update_partition_iterators() const;
-
-    impl &wp() { return *p.get(); }
-    const impl &rp() const { return *p.get(); }
+    impl &wp() { if (!p->sorted) p->sort(); return *p.get(); }
+    const impl &rp() const { if (!p->sorted) p->sort(); return *p.get(); }
+    entries_t::iterator find(size_type cv);
+    entries_t::const_iterator find(size_type cv) const;
     void clean();
     /** tells the owner mesh that the region is valid */
     void touch_parent_mesh();
 
     /**when running while multithreaded, gives the iterator
-    for the beginning of the region partition for the current thread*/
+    for the beginning of the region partition for the current thread
+    (the partitions are slices of equal number of entries)*/
     const_iterator partition_begin() const;
 
     /**when running while multithreaded, gives the iterator
     for the end of the region partition for the current thread*/
     const_iterator partition_end() const;
 
+    /**when running while multithreaded, gives the iterators for the
+    partition of the current thread, the partitions being contiguous
+    ranges of the region of (approximately) equal total cost*/
+    std::pair<const_iterator, const_iterator>
+    balanced_partition(const entry_cost &cost) const;
+
     /**begin iterator of the region depending if its partitioned or not*/
     const_iterator begin() const;
 
@@ -204,6 +229,10 @@ namespace getfem {
     void sup_all(size_type cv);
     void clear();
     void swap_convex(size_type cv1, size_type cv2);
+    /** Renumber the convexes, cv becoming new_numbers[cv] (new_numbers has
+        to be a permutation). Cheaper than successive calls to
+        swap_convex(). */
+    void renumber_convexes(const std::vector<size_type> &new_numbers);
     bool is_in(size_type cv, short_type f = short_type(-1)) const;
     bool is_in(size_type cv, short_type f, const mesh &m) const;
 
@@ -229,6 +258,13 @@ namespace getfem {
     const mesh *get_parent_mesh(void) const { return parent_mesh; }
     void set_parent_mesh(mesh *pm) { parent_mesh = pm; }
 
+    /** Compact binary form of the entries: the convex numbers (the first
+        one and the differences between the next ones) and the face masks,
+        each in the smallest of the sizes sufficient for the region. */
+    void write_to_binary(bgeot::binary_file_writer &w) const;
+    /** Add the entries read from their binary form. */
+    void read_from_binary(bgeot::binary_file_reader &r);
+
     /** "iterator" class for regions. Usage similar to bv_visitor:
     for (mr_visitor i(region); !i.finished(); ++i) {
     ...
@@ -236,7 +272,7 @@ namespace getfem {
     */
     class visitor {
 
-      typedef mesh_region::map_t::const_iterator const_iterator;
+      typedef mesh_region::entries_t::const_iterator const_iterator;
       bool whole_mesh;
       dal::bit_const_iterator itb, iteb;
       const_iterator it, ite;
@@ -254,6 +290,12 @@ namespace getfem {
       visitor(const mesh_region &s);
       visitor(const mesh_region &s, const mesh &m,
         bool intersect_with_mpi = false);
+      /** Same as above, but when the region is partitioned, the partition
+          of the current thread is chosen so that the total cost of its
+          entries is balanced with the ones of the other threads, instead
+          of their number. */
+      visitor(const mesh_region &s, const mesh &m, bool intersect_with_mpi,
+        const entry_cost &cost);
       size_type cv() const { return cv_; }
       size_type is_face() const { return f_ != 0; }
       short_type f() const { return short_type(f_-1); }
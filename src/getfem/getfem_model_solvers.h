@@ -82,8 +82,17 @@ namespace getfem {
   struct abstract_linear_solver {
     typedef MAT MATRIX;
     typedef VECT VECTOR;
+    typedef gmm::csc_matrix_cache<typename gmm::linalg_traits<MAT>::value_type>
+    CSC_CACHE;
     virtual void operator ()(const MAT &, VECT &, const VECT &,
                              gmm::iteration &) const = 0;
+    /** Same as operator(), with a compressed copy of M kept by the caller
+        from one solve to the next (see gmm::csc_matrix_cache). Redefined
+        by the direct solvers, which then only refresh its values as long
+        as the sparsity pattern of M does not change. */
+    virtual void solve_with_cache(const MAT &M, CSC_CACHE &, VECT &x,
+                                  const VECT &b, gmm::iteration &iter) const
+    { (*this)(M, x, b, iter); }
     virtual ~abstract_linear_solver() {}
   };
 
@@ -156,6 +165,15 @@ namespace getfem {
       iter.enforce_converged(info == 0);
       if (iter.get_noisy()) cout << "condition number: " << 1.0/rcond<< endl;
     }
+    void solve_with_cache(const MAT &M,
+                          typename abstract_linear_solver<MAT, VECT>::CSC_CACHE
+                          &cache, VECT &x, const VECT &b,
+                          gmm::iteration &iter) const {
+      double rcond;
+      int info = gmm::SuperLU_csc_solve(cache.update(M), x, b, rcond);
+      iter.enforce_converged(info == 0);
+      if (iter.get_noisy()) cout << "condition number: " << 1.0/rcond<< endl;
+    }
   };
 #endif
 
@@ -172,6 +190,42 @@ namespace getfem {
   };
 
 #if defined(GMM_USES_MUMPS)
+  /* MUMPS factorization kept with the compressed copy of a matrix. */
+  template <typename T>
+  struct mumps_cached_factor : public gmm::csc_matrix_cache_data {
+    gmm::MUMPS_factor<T> F;
+    bool sym;
+    size_type pattern_version, values_version;
+    mumps_cached_factor(bool sym_)
+      : sym(sym_), pattern_version(0), values_version(0) {}
+  };
+
+  /* Solve with MUMPS, analyzing again the matrix only when its sparsity
+     pattern changes and factorizing it again only when its values change. */
+  template <typename MAT, typename VECT>
+  bool MUMPS_cached_solve(const MAT &M, gmm::csc_matrix_cache<typename
+                          gmm::linalg_traits<MAT>::value_type> &cache,
+                          VECT &x, const VECT &b, bool sym) {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    const gmm::csc_matrix<T> &A = cache.update(M);
+    std::shared_ptr<mumps_cached_factor<T>> p
+      = std::dynamic_pointer_cast<mumps_cached_factor<T>>(cache.solver_data());
+    if (!p || p->sym != sym) {
+      p = std::make_shared<mumps_cached_factor<T>>(sym);
+      cache.solver_data() = p;
+    }
+    if (!(p->F.is_analyzed()) || p->pattern_version != cache.pattern_version()) {
+      p->F.analyze(A, sym);
+      if (!(p->F.is_analyzed())) return false;
+      p->pattern_version = cache.pattern_version();
+    }
+    if (!(p->F.is_factorized()) || p->values_version != cache.values_version()) {
+      if (!(p->F.factorize(A))) return false;
+      p->values_version = cache.values_version();
+    }
+    return p->F.solve(x, b);
+  }
+
   template <typename MAT, typename VECT>
   struct linear_solver_mumps : public abstract_linear_solver<MAT, VECT> {
     void operator ()(const MAT &M, VECT &x, const VECT &b,
@@ -179,6 +233,13 @@ namespace getfem {
       bool ok = gmm::MUMPS_solve(M, x, b, false);
       iter.enforce_converged(ok);
     }
+    void solve_with_cache(const MAT &M,
+                          typename abstract_linear_solver<MAT, VECT>::CSC_CACHE
+                          &cache, VECT &x, const VECT &b,
+                          gmm::iteration &iter) const {
+      bool ok = MUMPS_cached_solve(M, cache, x, b, false);
+      iter.enforce_converged(ok);
+    }
   };
   template <typename MAT, typename VECT>
   struct linear_solver_mumps_sym : public abstract_linear_solver<MAT, VECT> {
@@ -187,6 +248,13 @@ namespace getfem {
       bool ok = gmm::MUMPS_solve(M, x, b, true);
       iter.enforce_converged(ok);
     }
+    void solve_with_cache(const MAT &M,
+                          typename abstract_linear_solver<MAT, VECT>::CSC_CACHE
+                          &cache, VECT &x, const VECT &b,
+                          gmm::iteration &iter) const {
+      bool ok = MUMPS_cached_solve(M, cache, x, b, true);
+      iter.enforce_converged(ok);
+    }
   };
 #endif
 
@@ -125,12 +125,21 @@ namespace getfem {
       rTM,          // tangent matrix (only primary variables), real version
       internal_rTM; // coupling matrix between internal and primary vars (no empty rows)
     mutable model_complex_sparse_matrix cTM; // tangent matrix, complex version
+    // Compressed copies of rTM and cTM for the direct linear solvers
+    mutable gmm::csc_matrix_cache<scalar_type> rTM_csc;
+    mutable gmm::csc_matrix_cache<complex_type> cTM_csc;
     mutable model_real_plain_vector
       rrhs,         // residual vector of primary variables (after condensation)
       full_rrhs,    // residual vector of primary and internal variables (pre-condensation)
       internal_sol; // partial solution for internal variables (after condensation)
     mutable model_complex_plain_vector crhs;
     mutable bool act_size_to_be_done;
+    mutable bool rTM_pattern_valid; // rTM holds the pattern of the last
+                                    // assembly, still valid for the next one
+    bool reuse_rTM_pattern;
+    bool colored_residual; // residual assembled color by color
+    // Cumulated profile of the generic assemblies (if enabled)
+    mutable std::shared_ptr<ga_assembly_profile> assembly_profile_;
     dim_type leading_dim;
     getfem::lock_factory locks_;
 
@@ -384,6 +393,45 @@ namespace getfem {
 
     mutable std::list<gen_expr> generic_expressions;
 
+    // Workspaces of the generic expressions of the last assembly (one per
+    // order), kept with their compiled instructions for the next ones as
+    // long as the expressions and the structure of the model do not change.
+    struct compiled_expressions {
+      std::list<gen_expr> expressions;
+      std::list<assignement_desc> assignments;
+      std::unique_ptr<ga_workspace> workspace[2];
+      model_real_plain_vector V; // residual assembled by workspace[0]
+      // residual assembled color by color (see colored_residual_info)
+      std::vector<std::unique_ptr<ga_workspace>> colored_workspaces;
+    };
+    bool keep_compiled_exprs;
+    mutable std::unique_ptr<omp_distribute<compiled_expressions>>
+      compiled_exprs; // one per thread
+    mutable std::unique_ptr<column_locks> compiled_rTM_locks;
+    mutable size_type compiled_nb_threads;
+    // Addresses of the vectors of values the kept workspaces are bound to,
+    // and values read at the compilation of the expressions (sizes of the
+    // fixed size data, factors of the affine dependent variables, disabled
+    // variables).
+    mutable std::vector<const void *> compiled_values;
+    mutable std::vector<scalar_type> compiled_constants;
+    // Colored assembly of the residual: whether the residual terms allow
+    // it, the regions of the generic expressions restricted to each color
+    // and the vector the threads assemble into. Kept with the compiled
+    // expressions.
+    struct colored_residual_info {
+      bool is_local = false;
+      std::vector<std::vector<mesh_region>> regions; // per color
+      model_real_plain_vector V;
+    };
+    mutable std::unique_ptr<colored_residual_info> compiled_colored;
+    void reset_compiled_expressions() const
+    { compiled_exprs.reset(); compiled_colored.reset(); }
+    void check_compiled_expressions() const;
+    ga_workspace &compiled_workspace(size_type order) const;
+    void init_colored_residual(colored_residual_info &cr) const;
+    ga_workspace &compiled_colored_workspace(size_type color) const;
+
     // Groups of variables for interpolation on different meshes
     // generic assembly
     std::map<std::string, std::vector<std::string> > variable_groups;
@@ -396,7 +444,12 @@ namespace getfem {
     void brick_init(size_type ib, build_version version,
                     size_type rhs_ind = 0) const;
 
-    void init() { complex_version = false; act_size_to_be_done = false; }
+    void init() {
+      complex_version = false; act_size_to_be_done = false;
+      rTM_pattern_valid = false; reuse_rTM_pattern = true;
+      colored_residual = false; keep_compiled_exprs = true;
+      compiled_nb_threads = 0;
+    }
 
     void resize_global_system() const;
 
@@ -580,6 +633,53 @@ namespace getfem {
     /** Return true if all the model terms are linear. */
     bool is_linear() const { return is_linear_; }
 
+    /** Allows (default) or forbids the reuse of the sparsity pattern of the
+        real tangent matrix from one assembly to the next. When allowed, and
+        as long as the variables and the bricks of the model do not change,
+        the assembly only resets the values of the tangent matrix and fills
+        them again, without inserting new entries in the sparse columns.
+        Some entries may then be explicitly stored zeros. */
+    void set_reuse_tangent_matrix_pattern(bool reuse) {
+      reuse_rTM_pattern = reuse;
+      if (!reuse) rTM_pattern_valid = false;
+    }
+    bool reuse_tangent_matrix_pattern() const { return reuse_rTM_pattern; }
+
+    /** Allows or forbids (default) the assembly of the residual alone
+        (explicit schemes, residual evaluations) color by color using
+        mesh::convex_colors(): the threads then add their contributions
+        directly in the residual vector, with no per-thread copy to sum.
+        This is used only for the generic assembly terms which add their
+        contributions on the current element only, for fem variables. */
+    void set_colored_residual_assembly(bool colored)
+    { colored_residual = colored; }
+    bool colored_residual_assembly() const { return colored_residual; }
+
+    /** Allows (default) or forbids keeping the generic assembly terms of
+        the bricks compiled from one assembly to the next. When allowed, the
+        expressions are analysed, derived and compiled again only when they
+        change or when the variables, their fems or the integration methods
+        change. The next assemblies only read the new values of the
+        variables. This is not used when the model has internal variables
+        to be condensed. */
+    void set_keep_compiled_expressions(bool keep) {
+      keep_compiled_exprs = keep;
+      if (!keep) reset_compiled_expressions();
+    }
+    bool keep_compiled_expressions() const { return keep_compiled_exprs; }
+
+    /** Enables or disables (default) the profiling of the generic
+        assemblies of the model (see ga_workspace::enable_profiling). The
+        profiles of all the workspaces built on the model, including the
+        ones of the different threads, are cumulated. */
+    void enable_assembly_profiling(bool enable = true);
+    bool assembly_profiling_enabled() const
+    { return bool(assembly_profile_); }
+    const ga_assembly_profile &assembly_profile() const;
+    void clear_assembly_profile()
+    { if (assembly_profile_) assembly_profile_->clear(); }
+    void add_to_assembly_profile(const ga_assembly_profile &p) const;
+
     /** Total number of degrees of freedom in the model. */
     size_type nb_dof(bool with_internal=false) const;
 
@@ -928,6 +1028,23 @@ namespace getfem {
       return cTM;
     }
 
+    /** Compressed sparse column copy of the real tangent matrix, kept from
+        one linear solve to the next for the direct solvers (SuperLU, MUMPS).
+        Only its values are refreshed as long as the pattern of the tangent
+        matrix is unchanged. It is invalidated when the sizes are actualized
+        and when a brick is added, deleted or changes its terms, variables
+        or integration methods. */
+    gmm::csc_matrix_cache<scalar_type> &real_tangent_matrix_csc() const {
+      GMM_ASSERT1(!complex_version, "This model is a complex one");
+      return rTM_csc;
+    }
+
+    /** Compressed sparse column copy of the complex tangent matrix. */
+    gmm::csc_matrix_cache<complex_type> &complex_tangent_matrix_csc() const {
+      GMM_ASSERT1(complex_version, "This model is a real one");
+      return cTM_csc;
+    }
+
     /** Gives access to the right hand side of the tangent linear system.
         For the real version. An assembly of the rhs has to be done first. */
     const model_real_plain_vector &real_rhs(bool with_internal=false) const {
@@ -1110,6 +1227,7 @@ namespace getfem {
         GMM_ASSERT1(name.compare("neighbor_element"), "neighbor_element is a "
                     "reserved interpolate transformation name");
        transformations[name] = ptrans;
+       reset_compiled_expressions();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
@@ -1133,6 +1251,7 @@ namespace getfem {
     void add_elementary_transformation(const std::string &name,
                                        pelementary_transformation ptrans) {
        elem_transformations[name] = ptrans;
+       reset_compiled_expressions();
     }
 
     /** Get a pointer to the elementary transformation `name`.
@@ -1160,6 +1279,7 @@ namespace getfem {
       if (interpolate_transformation_exists(name))
         GMM_ASSERT1(false, "An interpolate transformation with the same "
                     "name already exists");secondary_domains[name] = ptrans;
+      reset_compiled_expressions();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
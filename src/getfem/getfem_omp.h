@@ -47,6 +47,7 @@ This is the kernel of getfem.
 
 #ifdef GETFEM_HAS_OPENMP
   #include <mutex>
+  #include <shared_mutex>
 #endif
 
 namespace getfem
@@ -95,6 +96,66 @@ namespace getfem
 
   #define GLOBAL_OMP_GUARD getfem::omp_guard g; GMM_NOPERATION_(abs(&(g) != &(g)));
 
+  /** Like lock_factory, for read-mostly data: several readers may hold
+      the lock at the same time. Not recursive. */
+  class shared_lock_factory
+  {
+  public:
+    std::shared_lock<std::shared_timed_mutex> get_read_lock() const
+    { return std::shared_lock<std::shared_timed_mutex>(mutex); }
+    std::unique_lock<std::shared_timed_mutex> get_write_lock() const
+    { return std::unique_lock<std::shared_timed_mutex>(mutex); }
+  private:
+    mutable std::shared_timed_mutex mutex;
+  };
+
+  /** Set of mutexes protecting the columns of a sparse matrix in which
+      several threads assemble concurrently. The column j is protected by
+      the mutex j modulo the number of mutexes, so that the memory used
+      does not depend on the size of the matrix nor on the number of
+      threads. */
+  class column_locks
+  {
+  public:
+    explicit column_locks(size_type nb_mutexes = 4096);
+    std::mutex &operator()(size_type j) const { return mutexes[j % nb]; }
+    void lock_all() const;
+    void unlock_all() const;
+
+  private:
+    size_type nb;
+    std::unique_ptr<std::mutex[]> mutexes;
+  };
+
+  /** Scoped lock of the column j of a shared matrix. Does nothing if no
+      column_locks is given (matrix owned by a single thread). */
+  class column_guard
+  {
+  public:
+    column_guard(const column_locks *locks, size_type j)
+      : pm(locks ? &((*locks)(j)) : nullptr) { if (pm) pm->lock(); }
+    ~column_guard() { if (pm) pm->unlock(); }
+    column_guard(const column_guard &) = delete;
+    column_guard &operator =(const column_guard &) = delete;
+
+  private:
+    std::mutex *pm;
+  };
+
+  /** Scoped lock of all the columns of a shared matrix. */
+  class all_columns_guard
+  {
+  public:
+    all_columns_guard(const column_locks *locks_)
+      : locks(locks_) { if (locks) locks->lock_all(); }
+    ~all_columns_guard() { if (locks) locks->unlock_all(); }
+    all_columns_guard(const all_columns_guard &) = delete;
+    all_columns_guard &operator =(const all_columns_guard &) = delete;
+
+  private:
+    const column_locks *locks;
+  };
+
 #else
 
   class omp_guard{};
@@ -103,8 +164,27 @@ namespace getfem
   {
     inline local_guard get_lock() const {return local_guard();}
   };
+  struct shared_lock_factory
+  {
+    inline local_guard get_read_lock() const {return local_guard();}
+    inline local_guard get_write_lock() const {return local_guard();}
+  };
   #define GLOBAL_OMP_GUARD
 
+  class column_locks
+  {
+  public:
+    explicit column_locks(size_type = 0) {}
+  };
+  struct column_guard
+  {
+    column_guard(const column_locks *, size_type) {}
+  };
+  struct all_columns_guard
+  {
+    all_columns_guard(const column_locks *) {}
+  };
+
 #endif
 
   /**set maximum number of OpenMP threads*/
@@ -132,6 +212,48 @@ namespace getfem
     static size_type num_threads();
   };
 
+  /** Sets the maximal number of threads of the program calling GetFEM at
+      the same time, each one holding a caller_thread (1 by default). Like
+      set_num_threads, to be called before these threads are started. The
+      number is never reduced, and stays 1 without OpenMP support. */
+  void set_nb_caller_threads(size_type n);
+
+  /** Maximal number of threads calling GetFEM at the same time. */
+  size_type nb_caller_threads();
+
+  /** Registers the current thread, for its lifetime, as a thread of the
+      program calling GetFEM. Each caller thread has its own instances of
+      the singletons (see dal_singleton.h) and runs the parallel sections
+      with its own team of set_num_threads threads, so that several of them
+      can work at the same time on distinct objects (models, meshes ...).
+      The constructor waits while nb_caller_threads() threads already hold
+      a caller_thread. A thread calling GetFEM without caller_thread uses
+      the instances of the first one, so that all the threads calling GetFEM
+      at the same time should hold one. */
+  class caller_thread
+  {
+  public:
+    caller_thread();
+    ~caller_thread();
+    caller_thread(const caller_thread &) = delete;
+    caller_thread &operator =(const caller_thread &) = delete;
+
+  private:
+    bool owner;
+    size_type slot;
+    int nb_threads_before;
+  };
+
+  /** Thread policy of the data global to the program (singletons): the
+      partitions of each caller thread have their own indices, the ones of
+      the current caller thread starting from first_thread(). Equivalent to
+      global_thread_policy for a single caller thread. */
+  struct caller_thread_policy{
+    static size_type this_thread();
+    static size_type num_threads();
+    static size_type first_thread();
+  };
+
   //implementation classes for omp_distribute
   namespace detail{
 
@@ -427,7 +549,11 @@ namespace getfem
     void update_partitions();
 
     omp_distribute<std::set<size_type>, true_thread_policy> partitions;
-    omp_distribute<size_type, true_thread_policy> current_partition;
+    // The current partition is kept by each thread (see
+    // get_current_partition), the teams of the caller threads sharing the
+    // same OpenMP thread numbers. It is recomputed after an update of the
+    // partitions, which changes their generation.
+    std::atomic<size_type> generation{0};
     std::atomic<size_type> nb_user_threads;
     thread_behaviour behaviour = thread_behaviour::partition_threads;
     std::atomic<bool> partitions_updated{false};
@@ -445,6 +571,7 @@ namespace getfem
   {
     std::unique_ptr<standard_locale> plocale;
     std::unique_ptr<thread_exception> pexception;
+    size_type caller; // caller thread running the section
 
   public:
     parallel_boilerplate();
@@ -200,7 +200,7 @@ namespace getfem {
   void multi_contact_frame::clear_aux_info() {
     boundary_points = std::vector<base_node>();
     boundary_points_info = std::vector<boundary_point>();
-    element_boxes.clear();
+    // element_boxes is kept to be refitted by the next computation
     element_boxes_info = std::vector<influence_box>();
     potential_pairs = std::vector<std::vector<face_info> >();
   }
@@ -644,12 +644,20 @@ namespace getfem {
             { bmin[k] -= release_distance; bmax[k] += release_distance; }
 
           // Store the influence box and additional information.
-          element_boxes.add_box(bmin, bmax, element_boxes_info.size());
+          size_type ibox = element_boxes_info.size();
+          if (ibox < element_boxes.nb_boxes())
+            element_boxes.set_box(ibox, bmin, bmax);
+          else
+            element_boxes.add_box(bmin, bmax, ibox);
           n_mean /= gmm::vect_norm2(n_mean);
           element_boxes_info.push_back(influence_box(i, cv, v.f(), n_mean));
         }
       }
-    element_boxes.build_tree();
+    // Same number of boxes as for the previous computation: the tree
+    // topology is kept and only the node bounds are updated, unless the
+    // boxes have moved too much since the tree was built (see refit).
+    element_boxes.resize(element_boxes_info.size());
+    element_boxes.refit();
   }
 
   void multi_contact_frame::compute_potential_contact_pairs_influence_boxes() {
@@ -659,17 +667,16 @@ namespace getfem {
     potential_pairs = std::vector<std::vector<face_info> >();
     potential_pairs.resize(boundary_points.size());
 
+    std::vector<size_type> boxids;
     for (size_type ip = 0; ip < boundary_points.size(); ++ip) {
 
-      bgeot::rtree::pbox_set bset;
-      element_boxes.find_boxes_at_point(boundary_points[ip], bset);
+      element_boxes.find_boxes_at_point(boundary_points[ip], boxids);
       boundary_point *pt_info = &(boundary_points_info[ip]);
       const mesh_fem &mf1 = mfdisp_of_boundary(pt_info->ind_boundary);
       size_type ib1 = pt_info->ind_boundary;
 
-      bgeot::rtree::pbox_set::iterator it = bset.begin();
-      for (; it != bset.end(); ++it) {
-        influence_box &ibx = element_boxes_info[(*it)->id];
+      for (size_type ibox : boxids) {
+        influence_box &ibx = element_boxes_info[ibox];
         size_type ib2 = ibx.ind_boundary;
         const mesh_fem &mf2 = mfdisp_of_boundary(ib2);
 
@@ -1374,7 +1381,7 @@ namespace getfem {
 
     std::vector<obstacle> obstacles;
         
-    mutable bgeot::rtree face_boxes;
+    mutable bgeot::flat_rtree face_boxes;
     mutable std::vector<face_box_info> face_boxes_info;
 
 
@@ -1382,7 +1389,6 @@ namespace getfem {
       fem_precomp_pool fppool;
       base_matrix G;
       model_real_plain_vector coeff;
-      face_boxes.clear();
       face_boxes_info.resize(0);
 
       for (size_type i = 0; i < contact_boundaries.size(); ++i) {
@@ -1453,13 +1459,21 @@ namespace getfem {
               { bmin[k] -= h * 0.15; bmax[k] += h * 0.15; }
             
             // Store the bounding box and additional information.
-            face_boxes.add_box(bmin, bmax, face_boxes_info.size());
+            size_type ibox = face_boxes_info.size();
+            if (ibox < face_boxes.nb_boxes())
+              face_boxes.set_box(ibox, bmin, bmax);
+            else
+              face_boxes.add_box(bmin, bmax, ibox);
             n_mean /= gmm::vect_norm2(n_mean);
             face_boxes_info.push_back(face_box_info(i, cv, v.f(), n_mean));
           }
         }
       }
-      face_boxes.build_tree();
+      // The tree of the previous assembly is only refitted if the
+      // number of faces is unchanged and the faces have not moved too
+      // much since it was built.
+      face_boxes.resize(face_boxes_info.size());
+      face_boxes.refit();
     }
 
   public:
@@ -1567,7 +1581,6 @@ namespace getfem {
     };
 
     void finalize() const {
-      face_boxes.clear();
       face_boxes_info = std::vector<face_box_info>();
       for (const contact_boundary &cb : contact_boundaries)
         cb.U_unred = model_real_plain_vector();
@@ -1700,19 +1713,19 @@ namespace getfem {
       //
       // Determine the potential contact pairs with deformable bodies
       //
-      bgeot::rtree::pbox_set bset;
+      std::vector<size_type> boxids;
       base_node bmin(pt_x), bmax(pt_x);
       for (size_type i = 0; i < N; ++i)
         { bmin[i] -= release_distance; bmax[i] += release_distance; }
 
-      face_boxes.find_line_intersecting_boxes(pt_x, n_x, bmin, bmax, bset);
+      face_boxes.find_line_intersecting_boxes(pt_x, n_x, bmin, bmax, boxids);
 
       //
       // Iteration on potential contact pairs and application
       // of selection criteria
       //
-      for (const auto &pbox : bset) {
-        face_box_info &fbox_y = face_boxes_info[pbox->id];
+      for (size_type ibox : boxids) {
+        face_box_info &fbox_y = face_boxes_info[ibox];
         size_type ib_y = fbox_y.ind_boundary;
         const contact_boundary &cb_y = contact_boundaries[ib_y];
         const mesh_fem &mfu_y = *(cb_y.mfu);
@@ -2131,18 +2144,18 @@ namespace getfem {
       //
       // Determine the potential contact pairs with deformable bodies
       //
-      bgeot::rtree::pbox_set bset;
+      std::vector<size_type> boxids;
       base_node bmin(pt_x), bmax(pt_x);
       for (size_type i = 0; i < N; ++i)
         { bmin[i] -= release_distance; bmax[i] += release_distance; }
 
-      face_boxes.find_line_intersecting_boxes(pt_x, n_x, bmin, bmax, bset);
+      face_boxes.find_line_intersecting_boxes(pt_x, n_x, bmin, bmax, boxids);
             //
       // Iteration on potential contact pairs and application
       // of selection criteria
       //
-      for (const auto &pbox : bset) {
-        face_box_info &fbox_y = face_boxes_info[pbox->id];
+      for (size_type ibox : boxids) {
+        face_box_info &fbox_y = face_boxes_info[ibox];
         size_type ib_y = fbox_y.ind_boundary;
         const contact_boundary &cb_y =  contact_boundaries[ib_y];
         const mesh_fem &mfu_y = *(cb_y.mfu);
@@ -1356,7 +1356,7 @@ namespace getfem {
     contact_frame &cf;   // contact frame description.
 
     // list des enrichissements pour ses points : y0, d0, element ...
-    bgeot::rtree element_boxes;  // influence regions of boundary elements
+    bgeot::flat_rtree element_boxes; // influence regions of boundary elements
     // list des enrichissements of boundary elements
     std::vector<size_type> boundary_of_elements;
     std::vector<size_type> ind_of_elements;
@@ -1535,26 +1535,25 @@ namespace getfem {
     // Selection of influence boxes
     // ----------------------------------------------------------
 
-    bgeot::rtree::pbox_set bset;
-    element_boxes.find_boxes_at_point(x, bset);
+    std::vector<size_type> boxids;
+    element_boxes.find_boxes_at_point(x, boxids);
 
-    if (noisy) cout << "Number of boxes found : " << bset.size() << endl;
+    if (noisy) cout << "Number of boxes found : " << boxids.size() << endl;
 
     // ----------------------------------------------------------
     // Eliminates some influence boxes with the mean normal
     // criterion : should at least eliminate the original element.
     // ----------------------------------------------------------
 
-    bgeot::rtree::pbox_set::iterator it = bset.begin(), itnext;
-    for (; it != bset.end(); it = itnext) {
-      itnext = it; ++itnext;
-      if (gmm::vect_sp(unit_normal_of_elements[(*it)->id], n)
-          >= -scalar_type(1)/scalar_type(20)) bset.erase(it);
-    }
+    size_type nb_kept = 0;
+    for (size_type ibox : boxids)
+      if (gmm::vect_sp(unit_normal_of_elements[ibox], n)
+          < -scalar_type(1)/scalar_type(20)) boxids[nb_kept++] = ibox;
+    boxids.resize(nb_kept);
 
     if (noisy)
       cout << "Number of boxes satisfying the unit normal criterion : "
-           << bset.size() << endl;
+           << boxids.size() << endl;
 
 
     // ----------------------------------------------------------
@@ -1563,17 +1562,16 @@ namespace getfem {
     // situations with a test on |x0-y0|
     // ----------------------------------------------------------
 
-    it = bset.begin();
     std::vector<base_node> y0s;
     std::vector<base_small_vector> n0_y0s;
     std::vector<scalar_type> d0s;
     std::vector<scalar_type> d1s;
     std::vector<size_type> elt_nums;
     std::vector<fem_interpolation_context> ctx_y0s;
-    for (; it != bset.end(); ++it) {
-      size_type boundary_num_y0 = boundary_of_elements[(*it)->id];
-      size_type cv_y0 = ind_of_elements[(*it)->id];
-      short_type face_y0 = short_type(face_of_elements[(*it)->id]);
+    for (size_type ibox : boxids) {
+      size_type boundary_num_y0 = boundary_of_elements[ibox];
+      size_type cv_y0 = ind_of_elements[ibox];
+      short_type face_y0 = short_type(face_of_elements[ibox]);
       const mesh_fem &mfu_y0 = cf.mfu_of_boundary(boundary_num_y0);
       pfem pf_s_y0 = mfu_y0.fem_of_element(cv_y0);
       const model_real_plain_vector &U_y0
@@ -1677,7 +1675,7 @@ namespace getfem {
       if (noisy) cout << "gmm::vect_norm2(n0_y0) = " << gmm::vect_norm2(n0_y0) << endl;
       // Eliminates wrong auto-contact situations
       if (noisy) cout << "autocontact status : x0 = " << x0 << " y0 = " << y0 << "  " <<  gmm::vect_dist2(y0, x0) << " : " << d0*0.75 << " : " << d1*0.75 << endl;
-      if (noisy) cout << "n = " << n << " unit_normal_of_elements[(*it)->id] = " << unit_normal_of_elements[(*it)->id] << endl;
+      if (noisy) cout << "n = " << n << " unit_normal_of_elements[ibox] = " << unit_normal_of_elements[ibox] << endl;
 
       if (d0 < scalar_type(0)
           && ((&U_y0 == &U
@@ -1697,7 +1695,7 @@ namespace getfem {
 //       }
 
       y0s.push_back(ctx_y0.xreal()); // useful ?
-      elt_nums.push_back((*it)->id);
+      elt_nums.push_back(ibox);
       d0s.push_back(d0);
       d1s.push_back(d1);
       ctx_y0s.push_back(ctx_y0);
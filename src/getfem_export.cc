@@ -23,6 +23,9 @@
 #include "getfem/dal_singleton.h"
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/getfem_export.h"
+#ifdef GETFEM_HAVE_ZLIB_H
+# include <zlib.h>
+#endif
 
 namespace getfem
 {
@@ -214,6 +217,15 @@ namespace getfem
       if (state == IN_POINT_DATA) os << "</PointData>\n";
       os << "</Piece>\n";
       os << "</UnstructuredGrid>\n";
+      if (appended_data) {
+        os << "<AppendedData encoding=\"raw\">\n_";
+        std::rewind(appended_data);
+        char buf[65536];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), appended_data)); )
+          os.write(buf, n);
+        std::fclose(appended_data);
+        os << "\n</AppendedData>\n";
+      }
       os << "</VTKFile>\n";
     }
   }
@@ -224,6 +236,25 @@ namespace getfem
     static int test_endian = 0x01234567;
     reverse_endian = (*((char*)&test_endian) == 0x67);
     state = EMPTY;
+    appended = compressed = false;
+    appended_data = 0; appended_size = 0;
+    clear_vals();
+  }
+
+  void vtk_export::set_appended_data(bool compress) {
+    GMM_ASSERT1(!vtk && !ascii, "appended data is only available for the "
+                "binary vtu format");
+    GMM_ASSERT1(state == EMPTY, "set_appended_data should be called before "
+                "anything is written");
+#ifndef GETFEM_HAVE_ZLIB_H
+    GMM_ASSERT1(!compress, "GetFEM has been built without zlib, "
+                "compression is not available");
+#endif
+    if (!appended_data) {
+      appended_data = std::tmpfile();
+      GMM_ASSERT1(appended_data, "unable to create a temporary file");
+    }
+    appended = true; compressed = compress;
     clear_vals();
   }
 
@@ -266,20 +297,36 @@ namespace getfem
               << "D slice (not supported)");
   }
 
-  void vtk_export::exporting(const mesh& m) {
+  void vtk_export::exporting(const mesh& m)
+  { exporting(m, mesh_region::all_convexes()); }
+
+  void vtk_export::exporting(const mesh& m, const mesh_region &rg) {
     dim_ = m.dim();
     GMM_ASSERT1(dim_ <= 3, "attempt to export a " << int(dim_)
                 << "D mesh (not supported)");
+    mesh_region r(rg); r.from_mesh(m);
+    dal::bit_vector cvlst = r.index();
     pmf = std::make_unique<mesh_fem>(const_cast<mesh&>(m), dim_type(1));
-    for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    for (dal::bv_visitor cv(cvlst); !cv.finished(); ++cv) {
       bgeot::pgeometric_trans pgt = m.trans_of_convex(cv);
       pfem pf = getfem::classical_fem(pgt, pgt->complexity() > 1 ? 2 : 1);
       pmf->set_finite_element(cv, pf);
     }
-    exporting(*pmf);
+    exporting_(*pmf, cvlst);
+  }
+
+  void vtk_export::exporting(const mesh_fem& mf)
+  { exporting_(mf, mf.convex_index()); }
+
+  void vtk_export::exporting(const mesh_fem& mf, const mesh_region &rg) {
+    mesh_region r(rg); r.from_mesh(mf.linked_mesh());
+    dal::bit_vector cvlst = r.index();
+    cvlst &= mf.convex_index();
+    exporting_(mf, cvlst);
   }
 
-  void vtk_export::exporting(const mesh_fem& mf) {
+  void vtk_export::exporting_(const mesh_fem& mf,
+                              const dal::bit_vector &cvlst) {
     dim_ = mf.linked_mesh().dim();
     GMM_ASSERT1(dim_ <= 3, "attempt to export a " << int(dim_)
                 << "D mesh_fem (not supported)");
@@ -287,7 +334,7 @@ namespace getfem
       pmf = std::make_unique<mesh_fem>(mf.linked_mesh());
     /* initialize pmf with finite elements suitable for VTK (which only knows
        isoparametric FEMs of order 1 and 2) */
-    for (dal::bv_visitor cv(mf.convex_index()); !cv.finished(); ++cv) {
+    for (dal::bv_visitor cv(cvlst); !cv.finished(); ++cv) {
       bgeot::pgeometric_trans pgt = mf.linked_mesh().trans_of_convex(cv);
       pfem pf = mf.fem_of_element(cv);
 
@@ -398,7 +445,12 @@ namespace getfem
       os << (ascii ? "ASCII\n" : "BINARY\n");
     } else {
       os << "<?xml version=\"1.0\"?>\n";
-      os << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" ";
+      os << "<VTKFile type=\"UnstructuredGrid\" ";
+      if (appended) // 64 bits headers for large appended data arrays
+        os << "version=\"1.0\" header_type=\"UInt64\" ";
+      else
+        os << "version=\"0.1\" ";
+      if (compressed) os << "compressor=\"vtkZLibDataCompressor\" ";
       os << "byte_order=\"" << (reverse_endian ? "LittleEndian" : "BigEndian") << "\">\n";
       os << "<!--" << header << "-->\n";
       os << "<UnstructuredGrid>\n";
@@ -409,16 +461,72 @@ namespace getfem
   void vtk_export::write_separ()
   { if (ascii) os << "\n"; }
 
-  void vtk_export::clear_vals()
-  { if (!vtk && !ascii) vals.clear(); }
+  /* In inline binary mode, vals begins with the 32 bits header giving the
+     size of the data array, filled by write_vals. */
+  void vtk_export::clear_vals() {
+    if (!vtk && !ascii) vals.assign(appended ? 0 : sizeof(std::uint32_t), 0);
+  }
 
   void vtk_export::write_vals() {
     if (!vtk && !ascii) {
-      os << base64_encode(vals);
+      if (appended)
+        write_appended_block();
+      else {
+        std::uint32_t nb_bytes = std::uint32_t(vals.size()-sizeof(nb_bytes));
+        memcpy(&vals[0], &nb_bytes, sizeof(nb_bytes));
+        os << base64_encode(vals);
+      }
       clear_vals();
     }
   }
 
+  /* Append the content of vals to the AppendedData section, preceded by
+     the 64 bits header giving its size or, when compressed, by the header
+     of the vtkZLibDataCompressor format: number of blocks, uncompressed
+     size of the blocks, uncompressed size of the last block (0 if it is
+     complete) and the compressed size of each block. */
+  void vtk_export::write_appended_block() {
+    std::vector<std::uint64_t> head(1, vals.size());
+    const unsigned char *data = vals.data();
+    size_type nb_bytes = vals.size();
+#ifdef GETFEM_HAVE_ZLIB_H
+    std::vector<unsigned char> zvals;
+    if (compressed) {
+      const size_type block_size = 32768;
+      size_type nb_blocks = (nb_bytes + block_size - 1) / block_size;
+      head.assign(3, 0);
+      head[0] = nb_blocks; head[1] = block_size;
+      head[2] = nb_bytes % block_size;
+      zvals.resize(nb_blocks ? nb_blocks * compressBound(block_size) : 0);
+      size_type zsize = 0;
+      for (size_type i = 0; i < nb_blocks; ++i) {
+        size_type bsize = std::min(block_size, nb_bytes - i*block_size);
+        uLongf zbsize = uLongf(zvals.size() - zsize);
+        int err = compress2(&zvals[zsize], &zbsize, data + i*block_size,
+                            uLong(bsize), Z_DEFAULT_COMPRESSION);
+        GMM_ASSERT1(err == Z_OK, "zlib compression error " << err);
+        head.push_back(zbsize);
+        zsize += zbsize;
+      }
+      data = zvals.data(); nb_bytes = zsize;
+    }
+#endif
+    size_type head_size = head.size() * sizeof(std::uint64_t);
+    GMM_ASSERT1(std::fwrite(head.data(), 1, head_size, appended_data)
+                == head_size
+                && std::fwrite(data, 1, nb_bytes, appended_data) == nb_bytes,
+                "error while writing the appended data");
+    appended_size += head_size + nb_bytes;
+  }
+
+  std::string vtk_export::data_format() const {
+    if (ascii) return "format=\"ascii\">\n";
+    if (appended)
+      return "format=\"appended\" offset=\""
+        + std::to_string(appended_size) + "\">\n";
+    return "format=\"binary\">\n";
+  }
+
   void vtk_export::write_mesh() {
     if (psl) write_mesh_structure_from_slice();
     else write_mesh_structure_from_mesh_fem();
@@ -447,8 +555,7 @@ namespace getfem
       os << "<Points>\n";
       os << "<DataArray type=\"Float32\" Name=\"Points\" ";
       os << "NumberOfComponents=\"3\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) write_val(int(sizeof(float)*psl->nb_points()*3));
+      os << data_format();
     }
     /*
        points are not merge, vtk is mostly fine with that (except for
@@ -473,15 +580,7 @@ namespace getfem
     } else {
       os << "<Cells>\n";
       os << "<DataArray type=\"Int32\" Name=\"connectivity\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
-          for (const slice_simplex &s : psl->simplexes(ic))
-            size += int((s.dim()+1)*sizeof(int));
-        }
-        write_val(size);
-      }
+      os << data_format();
     }
     for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
       for (const slice_simplex &s : psl->simplexes(ic)) {
@@ -500,13 +599,7 @@ namespace getfem
     } else {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"offsets\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic)
-          size += int(psl->simplexes(ic).size()*sizeof(int));
-        write_val(size);
-      }
+      os << data_format();
     }
     int cnt = 0;
     for (size_type ic=0; ic < psl->nb_convex(); ++ic) {
@@ -525,13 +618,7 @@ namespace getfem
     if (!vtk) {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"types\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (size_type ic=0; ic < psl->nb_convex(); ++ic)
-          size += int(psl->simplexes(ic).size()*sizeof(int));
-        write_val(size);
-      }
+      os << data_format();
       for (size_type ic=0; ic < psl->nb_convex(); ++ic)
         for (const slice_simplex &s : psl->simplexes(ic))
           write_val(int(vtk_simplex_code[s.dim()]));
@@ -556,8 +643,7 @@ namespace getfem
       os << "<Points>\n";
       os << "<DataArray type=\"Float32\" Name=\"Points\" ";
       os << "NumberOfComponents=\"3\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) write_val(int(sizeof(float)*pmf_dof_used.card()*3));
+      os << data_format();
     }
     std::vector<int> dofmap(pmf->nb_dof());
     int cnt = 0;
@@ -581,15 +667,7 @@ namespace getfem
       os << "</Points>\n";
       os << "<Cells>\n";
       os << "<DataArray type=\"Int32\" Name=\"connectivity\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii) {
-        int size = 0;
-        for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
-          const std::vector<unsigned> &dmap = select_vtk_dof_mapping(pmf_mapping_type[cv]);
-          size += int(sizeof(int)*dmap.size());
-        }
-        write_val(size);
-      }
+      os << data_format();
     }
 
     for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
@@ -607,9 +685,7 @@ namespace getfem
     } else {
       os << (ascii ? "" : "\n") << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"offsets\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii)
-        write_val(int(pmf->convex_index().card()*sizeof(int)));
+      os << data_format();
       cnt = 0;
       for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
         const std::vector<unsigned> &dmap = select_vtk_dof_mapping(pmf_mapping_type[cv]);
@@ -619,9 +695,7 @@ namespace getfem
       write_vals();
       os << "\n" << "</DataArray>\n";
       os << "<DataArray type=\"Int32\" Name=\"types\" ";
-      os << (ascii ? "format=\"ascii\">\n" : "format=\"binary\">\n");
-      if (!ascii)
-        write_val(int(pmf->convex_index().card()*sizeof(int)));
+      os << data_format();
     }
     for (dal::bv_visitor cv(pmf->convex_index()); !cv.finished(); ++cv) {
       write_val(int(select_vtk_type(pmf_mapping_type[cv])));
@@ -652,6 +726,65 @@ namespace getfem
   }
 
 
+  /* -------------------------------------------------------------
+   * Partitioned VTU export
+   * ------------------------------------------------------------- */
+
+  pvtu_export::pvtu_export(const std::string& fname, size_type nb_pieces_,
+                           bool compress_)
+    : basename(fname), nb_pieces(nb_pieces_), compress(compress_) {
+    if (basename.size() > 5
+        && basename.compare(basename.size()-5, 5, ".pvtu") == 0)
+      basename.resize(basename.size()-5);
+  }
+
+  std::string pvtu_export::piece_file_name(size_type i) const
+  { return basename + "_" + std::to_string(i) + ".vtu"; }
+
+  std::unique_ptr<vtu_export> pvtu_export::piece(size_type i) const {
+    GMM_ASSERT1(i < nb_pieces, "piece " << i << " out of range");
+    auto exp = std::make_unique<vtu_export>(piece_file_name(i));
+    exp->set_appended_data(compress);
+    return exp;
+  }
+
+  void pvtu_export::write_pvtu_file
+  (const std::vector<vtk_export::data_array_info> &arrays) const {
+    std::ofstream os(basename + ".pvtu");
+    GMM_ASSERT1(os, "impossible to write to file '" << basename
+                << ".pvtu'");
+    static int test_endian = 0x01234567;
+    bool little_endian = (*((char*)&test_endian) == 0x67);
+    os << "<?xml version=\"1.0\"?>\n";
+    os << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" ";
+    os << "byte_order=\"" << (little_endian ? "LittleEndian" : "BigEndian")
+       << "\">\n";
+    os << "<PUnstructuredGrid GhostLevel=\"0\">\n";
+    os << "<PPoints>\n";
+    os << "<PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>\n";
+    os << "</PPoints>\n";
+    for (bool cell_data : {false, true}) {
+      bool opened = false;
+      for (const vtk_export::data_array_info &a : arrays) {
+        if (a.cell_data != cell_data) continue;
+        if (!opened) os << (cell_data ? "<PCellData>\n" : "<PPointData>\n");
+        opened = true;
+        os << "<PDataArray type=\"Float32\" Name=\"" << a.name
+           << "\" NumberOfComponents=\"" << a.nb_comp << "\"/>\n";
+      }
+      if (opened) os << (cell_data ? "</PCellData>\n" : "</PPointData>\n");
+    }
+    // pieces are referenced relatively to the location of the pvtu file
+    std::string::size_type pos = basename.find_last_of("/\\");
+    for (size_type i = 0; i < nb_pieces; ++i)
+      os << "<Piece Source=\""
+         << piece_file_name(i).substr(pos == std::string::npos ? 0 : pos+1)
+         << "\"/>\n";
+    os << "</PUnstructuredGrid>\n";
+    os << "</VTKFile>\n";
+  }
+
+
   /* -------------------------------------------------------------
    * OPENDX export
    * ------------------------------------------------------------- */
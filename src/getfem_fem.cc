@@ -427,7 +427,7 @@ namespace getfem {
   }
 
   size_type reserve_xfem_index() {
-    static size_type ind = 100;
+    static std::atomic<size_type> ind{100};
     return ind += 1000;
   }
 
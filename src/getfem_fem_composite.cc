@@ -325,7 +325,7 @@ namespace getfem {
     }
 
     // take the normal derivatives into account
-    static base_matrix W(3, 12);
+    THREAD_SAFE_STATIC base_matrix W(3, 12);
     base_small_vector norient(M_PI, M_PI * M_PI);
     if (pgt->is_linear()) gmm::lu_inverse(K); 
     for (unsigned i = 9; i < 12; ++i) {
@@ -349,8 +349,8 @@ namespace getfem {
 	W(i-9, j) = t(j, 0, 0) * v[0] + t(j, 0, 1) * v[1];
     }
     
-    static base_matrix A(3, 3);
-    static bgeot::base_vector w(3), coeff(3);
+    THREAD_SAFE_STATIC base_matrix A(3, 3);
+    THREAD_SAFE_STATIC bgeot::base_vector w(3), coeff(3);
     static gmm::sub_interval SUBI(9, 3), SUBJ(0, 3);
     gmm::copy(gmm::sub_matrix(W, SUBJ, SUBI), A);
     gmm::lu_inverse(A);
@@ -564,7 +564,7 @@ namespace getfem {
     }
 
     // take the normal derivatives into account
-    static base_matrix W(4, 16);
+    THREAD_SAFE_STATIC base_matrix W(4, 16);
     base_small_vector norient(M_PI, M_PI * M_PI);
     if (pgt->is_linear()) gmm::lu_inverse(K); 
     for (unsigned i = 12; i < 16; ++i) {
@@ -586,8 +586,8 @@ namespace getfem {
 	W(i-12, j) = t(j, 0, 0) * v[0] + t(j, 0, 1) * v[1];
     }
     
-    static base_matrix A(4, 4);
-    static bgeot::base_vector w(4), coeff(4);
+    THREAD_SAFE_STATIC base_matrix A(4, 4);
+    THREAD_SAFE_STATIC bgeot::base_vector w(4), coeff(4);
     static gmm::sub_interval SUBI(12, 4), SUBJ(0, 4);
     gmm::copy(gmm::sub_matrix(W, SUBJ, SUBI), A);
     gmm::lu_inverse(A);
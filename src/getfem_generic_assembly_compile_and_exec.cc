@@ -24,6 +24,8 @@
 #include "getfem/getfem_generic_assembly_semantic.h"
 #include "getfem/getfem_generic_assembly_compile_and_exec.h"
 #include "getfem/getfem_generic_assembly_functions_and_operators.h"
+#include "getfem/dal_backtrace.h"
+#include <chrono>
 
 #if defined(GMM_USES_BLAS)
 #define GA_USES_BLAS
@@ -128,6 +130,94 @@ namespace getfem {
     return (rm1.psd() < rm2.psd());
   }
 
+  //=========================================================================
+  // Native code of the instructions (see ga_native_code). The sizes may be
+  // inconsistent when an instruction is only tested for support.
+  //=========================================================================
+
+  static size_type ga_nc_div(size_type a, size_type b) { return b ? a/b : 0; }
+
+  static size_type ga_nc_dim(const base_tensor &t, size_type i)
+  { return (i < t.sizes().size()) ? t.sizes()[i] : 1; }
+
+  // Writes "for (long i = 0; i < n; ++i) stmt;", stmt being a function of i
+  static void ga_nc_loop(ga_native_code &nc, size_type n,
+                         const std::string &stmt) {
+    if (n) nc.body << "for (long i = 0; i < " << n << "; ++i) "
+                   << stmt << ";\n";
+  }
+
+  // Ani Bmi -> Cmn
+  static void ga_nc_contraction(ga_native_code &nc, const base_tensor &t,
+                                const base_tensor &tc1,
+                                const base_tensor &tc2, size_type I) {
+    std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+    size_type N = ga_nc_div(tc1.size(), I), M = ga_nc_div(tc2.size(), I);
+    if (!N || !M) return;
+    nc.body << "for (long n = 0; n < " << N << "; ++n)\n"
+            << " for (long m = 0; m < " << M << "; ++m) {\n"
+            << "  double a = 0.;\n"
+            << "  for (long i = 0; i < " << I << "; ++i) a += "
+            << A << "[n+" << N << "*i] * " << B << "[m+" << M << "*i];\n"
+            << "  " << T << "[m+" << M << "*n] = a;\n }\n";
+  }
+
+  // Ani Bmi -> Cmn, B being vectorized of type 2 with n*q = I
+  static void ga_nc_contraction_opt0_2(ga_native_code &nc,
+                                       const base_tensor &t,
+                                       const base_tensor &tc1,
+                                       const base_tensor &tc2,
+                                       size_type n, size_type q) {
+    std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+    size_type s1 = ga_nc_div(tc1.size(), n*q), s2 = ga_nc_div(tc2.size(), n*q);
+    size_type s2_q = ga_nc_div(s2, q);
+    if (!s1 || !s2_q) return;
+    nc.body << "for (long i = 0; i < " << s1 << "; ++i)\n"
+            << " for (long j = 0; j < " << s2_q << "; ++j)\n"
+            << "  for (long l = 0; l < " << q << "; ++l) {\n"
+            << "   double a = 0.;\n"
+            << "   for (long m = 0; m < " << n << "; ++m) a += "
+            << A << "[i+l*" << s1 << "+m*" << s1*q << "] * "
+            << B << "[j*" << q << "+m*" << s2*q << "];\n"
+            << "   " << T << "[i*" << s2 << "+j*" << q << "+l] = a;\n  }\n";
+  }
+
+  // Ani Bmi -> Cmn, A being vectorized of type 2 with n*q = I
+  static void ga_nc_contraction_opt2_0(ga_native_code &nc,
+                                       const base_tensor &t,
+                                       const base_tensor &tc1,
+                                       const base_tensor &tc2,
+                                       size_type n, size_type q) {
+    std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+    size_type s1 = ga_nc_div(tc1.size(), n*q), s2 = ga_nc_div(tc2.size(), n*q);
+    size_type s1_q = ga_nc_div(s1, q);
+    if (!s1_q || !s2) return;
+    nc.body << "for (long i = 0; i < " << s1_q << "; ++i)\n"
+            << " for (long l = 0; l < " << q << "; ++l)\n"
+            << "  for (long j = 0; j < " << s2 << "; ++j) {\n"
+            << "   double a = 0.;\n"
+            << "   for (long m = 0; m < " << n << "; ++m) a += "
+            << A << "[i*" << q << "+m*" << s1*q << "] * "
+            << B << "[l*" << s2 << "+j+m*" << s2*q << "];\n"
+            << "   " << T << "[(i*" << q << "+l)*" << s2 << "+j] = a;\n  }\n";
+  }
+
+  // Ani Bmi -> Cmn, B being vectorized of type 1 with nn = I
+  static void ga_nc_contraction_opt0_1(ga_native_code &nc,
+                                       const base_tensor &t,
+                                       const base_tensor &tc1,
+                                       const base_tensor &tc2, size_type nn) {
+    std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+    size_type s1 = ga_nc_div(tc1.size(), nn), s2 = ga_nc_div(tc2.size(), nn);
+    size_type s2_n = ga_nc_div(s2, nn);
+    if (!s1 || !s2_n) return;
+    nc.body << "for (long i = 0; i < " << s1 << "; ++i)\n"
+            << " for (long j = 0; j < " << s2_n << "; ++j)\n"
+            << "  for (long k = 0; k < " << nn << "; ++k) "
+            << T << "[(i*" << s2_n << "+j)*" << nn << "+k] = "
+            << A << "[i+k*" << s1 << "] * " << B << "[j*" << nn << "];\n";
+  }
+
   //=========================================================================
   // Instructions for compilation: basic optimized operations on tensors
   //=========================================================================
@@ -685,6 +775,23 @@ namespace getfem {
       return 0;
     }
 
+    virtual bool emit(ga_native_code &nc) const {
+      if (typeid(*this) != typeid(ga_instruction_val)) return false;
+      std::string T = nc.tensor(t), ZZ = nc.tensor(Z), C = nc.vector(coeff);
+      size_type ndof = ga_nc_dim(Z, 0);
+      size_type target_dim = (qdim == 1) ? 1 : ga_nc_dim(Z, 1);
+      size_type Qmult = ga_nc_div(qdim, target_dim);
+      if (!ndof) { ga_nc_loop(nc, t.size(), T+"[i] = 0."); return true; }
+      if (!Qmult) return true;
+      nc.body << "for (long q = 0; q < " << Qmult << "; ++q)\n"
+              << " for (long r = 0; r < " << target_dim << "; ++r) {\n"
+              << "  double a = 0.;\n"
+              << "  for (long j = 0; j < " << ndof << "; ++j) a += "
+              << C << "[j*" << Qmult << "+q] * " << ZZ << "[j+r*" << ndof
+              << "];\n  " << T << "[r+q*" << target_dim << "] = a;\n }\n";
+      return true;
+    }
+
     ga_instruction_val(base_tensor &tt, const base_tensor &Z_,
                        const base_vector &co, size_type q)
       : a(tt[0]), t(tt), Z(Z_), coeff(co), qdim(q) {}
@@ -740,6 +847,25 @@ namespace getfem {
       return 0;
     }
 
+    virtual bool emit(ga_native_code &nc) const {
+      if (typeid(*this) != typeid(ga_instruction_grad)) return false;
+      std::string T = nc.tensor(t), ZZ = nc.tensor(Z), C = nc.vector(coeff);
+      size_type ndof = ga_nc_dim(Z, 0), N = ga_nc_dim(Z, 2);
+      size_type target_dim = (qdim == 1) ? 1 : ga_nc_dim(Z, 1);
+      size_type Qmult = ga_nc_div(qdim, target_dim);
+      if (!ndof) { ga_nc_loop(nc, t.size(), T+"[i] = 0."); return true; }
+      if (!Qmult) return true;
+      nc.body << "for (long q = 0; q < " << Qmult << "; ++q)\n"
+              << " for (long k = 0; k < " << N << "; ++k)\n"
+              << "  for (long r = 0; r < " << target_dim << "; ++r) {\n"
+              << "   double a = 0.;\n"
+              << "   for (long j = 0; j < " << ndof << "; ++j) a += "
+              << C << "[j*" << Qmult << "+q] * " << ZZ << "[j+r*" << ndof
+              << "+k*" << ndof*target_dim << "];\n   " << T << "[r+q*"
+              << target_dim << "+k*" << qdim << "] = a;\n  }\n";
+      return true;
+    }
+
     ga_instruction_grad(base_tensor &tt, const base_tensor &Z_,
                         const base_vector &co, size_type q)
     : ga_instruction_val(tt, Z_, co, q)
@@ -1672,6 +1798,11 @@ namespace getfem {
       gmm::add(tc1.as_vector(), tc2.as_vector(), t.as_vector());
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      ga_nc_loop(nc, t.size(), T+"[i] = "+A+"[i] + "+B+"[i]");
+      return true;
+    }
     ga_instruction_add(base_tensor &t_,
                        const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -1687,6 +1818,11 @@ namespace getfem {
       gmm::add(tc1.as_vector(), t.as_vector());
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1);
+      ga_nc_loop(nc, t.size(), T+"[i] += "+A+"[i]");
+      return true;
+    }
     ga_instruction_add_to(base_tensor &t_, const base_tensor &tc1_)
       : t(t_), tc1(tc1_) {}
   };
@@ -1718,6 +1854,11 @@ namespace getfem {
                t.as_vector());
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      ga_nc_loop(nc, t.size(), T+"[i] = "+A+"[i] - "+B+"[i]");
+      return true;
+    }
     ga_instruction_sub(base_tensor &t_,
                        const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -1730,6 +1871,11 @@ namespace getfem {
       gmm::scale(t.as_vector(), scalar_type(-1));
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t);
+      ga_nc_loop(nc, t.size(), T+"[i] = -"+T+"[i]");
+      return true;
+    }
     ga_instruction_opposite(base_tensor &t_) : t(t_) {}
   };
 
@@ -1760,6 +1906,11 @@ namespace getfem {
       // gmm::copy(tc1.as_vector(), t.as_vector());
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1);
+      ga_nc_loop(nc, tc1.size(), T+"[i] = "+A+"[i]");
+      return true;
+    }
     ga_instruction_copy_tensor(base_tensor &t_, const base_tensor &tc1_)
       : t(t_), tc1(tc1_) {}
   };
@@ -1771,6 +1922,11 @@ namespace getfem {
       std::fill(t.begin(), t.end(), scalar_type(0));
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t);
+      ga_nc_loop(nc, t.size(), T+"[i] = 0.");
+      return true;
+    }
     ga_instruction_clear_tensor(base_tensor &t_) : t(t_) {}
   };
 
@@ -1797,6 +1953,10 @@ namespace getfem {
       t = t1;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.scalar(t1) << ";\n";
+      return true;
+    }
     ga_instruction_copy_scalar(scalar_type &t_, const scalar_type &t1_)
       : t(t_), t1(t1_) {}
   };
@@ -1809,6 +1969,11 @@ namespace getfem {
       gmm::copy(t1, t);
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string V = nc.vector(t), V1 = nc.vector(t1);
+      ga_nc_loop(nc, t.size(), V+"[i] = "+V1+"[i]");
+      return true;
+    }
     ga_instruction_copy_vect(base_vector &t_, const base_vector &t1_)
       : t(t_), t1(t1_) {}
   };
@@ -1832,6 +1997,15 @@ namespace getfem {
       return 0;
     }
 
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1);
+      std::stringstream stmt;
+      stmt << "{ double a = 0.; for (long k = 0; k < " << n << "; ++k) a += "
+           << A << "[i+k*" << t.size()*(n+1) << "]; " << T << "[i] = a; }";
+      ga_nc_loop(nc, t.size(), stmt.str());
+      return true;
+    }
+
     ga_instruction_trace(base_tensor &t_, const base_tensor &tc1_, size_type n_)
       : t(t_), tc1(tc1_), n(n_) {}
   };
@@ -2015,6 +2189,20 @@ namespace getfem {
         }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1);
+      size_type order = t.sizes().size();
+      size_type s1 = ga_nc_dim(t, order-2), s2 = ga_nc_dim(t, order-1);
+      size_type s = ga_nc_div(t.size(), s1*s2);
+      if (order < 2 || !s) return true;
+      nc.body << "for (long i = 0; i < " << s1 << "; ++i)\n"
+              << " for (long j = 0; j < " << s2 << "; ++j)\n"
+              << "  for (long k = 0; k < " << s << "; ++k) " << T << "[" << s
+              << "*(i+" << s1 << "*j)+k] = 0.5*(" << A << "[" << s << "*(i+"
+              << s1 << "*j)+k] + " << A << "[" << s << "*(j+" << s2
+              << "*i)+k]);\n";
+      return true;
+    }
     ga_instruction_sym(base_tensor &t_, const base_tensor &tc1_)
       : t(t_), tc1(tc1_) {}
   };
@@ -2037,6 +2225,20 @@ namespace getfem {
         }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1);
+      size_type order = t.sizes().size();
+      size_type s1 = ga_nc_dim(t, order-2), s2 = ga_nc_dim(t, order-1);
+      size_type s = ga_nc_div(t.size(), s1*s2);
+      if (order < 2 || !s) return true;
+      nc.body << "for (long i = 0; i < " << s1 << "; ++i)\n"
+              << " for (long j = 0; j < " << s2 << "; ++j)\n"
+              << "  for (long k = 0; k < " << s << "; ++k) " << T << "[" << s
+              << "*(i+" << s1 << "*j)+k] = 0.5*(" << A << "[" << s << "*(i+"
+              << s1 << "*j)+k] - " << A << "[" << s << "*(j+" << s2
+              << "*i)+k]);\n";
+      return true;
+    }
     ga_instruction_skew(base_tensor &t_, const base_tensor &tc1_)
       : t(t_), tc1(tc1_) {}
   };
@@ -2049,6 +2251,11 @@ namespace getfem {
       t = c + d;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.scalar(c) << " + "
+              << nc.scalar(d) << ";\n";
+      return true;
+    }
     ga_instruction_scalar_add(scalar_type &t_, const scalar_type &c_,
                               const  scalar_type &d_)
       : t(t_), c(c_), d(d_) {}
@@ -2062,6 +2269,11 @@ namespace getfem {
       t = c - d;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.scalar(c) << " - "
+              << nc.scalar(d) << ";\n";
+      return true;
+    }
     ga_instruction_scalar_sub(scalar_type &t_, const scalar_type &c_,
                               const  scalar_type &d_)
       : t(t_), c(c_), d(d_) {}
@@ -2075,6 +2287,11 @@ namespace getfem {
       t = c * d;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.scalar(c) << " * "
+              << nc.scalar(d) << ";\n";
+      return true;
+    }
     ga_instruction_scalar_scalar_mult(scalar_type &t_, const scalar_type &c_,
                                       const  scalar_type &d_)
       : t(t_), c(c_), d(d_) {}
@@ -2088,6 +2305,11 @@ namespace getfem {
       t = c / d;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.scalar(c) << " / "
+              << nc.scalar(d) << ";\n";
+      return true;
+    }
     ga_instruction_scalar_scalar_div(scalar_type &t_, const scalar_type &c_,
                                      const  scalar_type &d_)
       : t(t_), c(c_), d(d_) {}
@@ -2283,6 +2505,11 @@ namespace getfem {
       gmm::copy(gmm::scaled(tc1.as_vector(), c), t.as_vector());
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), a = nc.scalar(c);
+      ga_nc_loop(nc, tc1.size(), T+"[i] = "+A+"[i] * "+a);
+      return true;
+    }
     ga_instruction_scalar_mult(base_tensor &t_,
                                const base_tensor &tc1_, const scalar_type &c_)
       : t(t_), tc1(tc1_), c(c_) {}
@@ -2300,6 +2527,11 @@ namespace getfem {
       for (; it != t.end(); ++it, ++it1) *it = *it1/c;
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), a = nc.scalar(c);
+      ga_nc_loop(nc, t.size(), T+"[i] = "+A+"[i] / "+a);
+      return true;
+    }
     ga_instruction_scalar_div(base_tensor &t_,
                               const base_tensor &tc1_, const scalar_type &c_)
       : t(t_), tc1(tc1_), c(c_) {}
@@ -2380,6 +2612,16 @@ namespace getfem {
           *it = tc1[m+s1_1*i] * tc2[i];
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      size_type s2 = tc2.size(), s1_1 = ga_nc_div(tc1.size(), s2);
+      if (!s1_1) return true;
+      nc.body << "for (long i = 0; i < " << s2 << "; ++i)\n"
+              << " for (long m = 0; m < " << s1_1 << "; ++m) " << T << "[m+"
+              << s1_1 << "*i] = " << A << "[m+" << s1_1 << "*i] * " << B
+              << "[i];\n";
+      return true;
+    }
     ga_instruction_dotmult(base_tensor &t_,
                            const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -2399,6 +2641,16 @@ namespace getfem {
           *it = tc1[m+s1_1*i] / tc2[i];
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      size_type s2 = tc2.size(), s1_1 = ga_nc_div(tc1.size(), s2);
+      if (!s1_1) return true;
+      nc.body << "for (long i = 0; i < " << s2 << "; ++i)\n"
+              << " for (long m = 0; m < " << s1_1 << "; ++m) " << T << "[m+"
+              << s1_1 << "*i] = " << A << "[m+" << s1_1 << "*i] / " << B
+              << "[i];\n";
+      return true;
+    }
     ga_instruction_dotdiv(base_tensor &t_,
                           const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -2827,6 +3079,10 @@ namespace getfem {
       //   }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction(nc, t, tc1, tc2, I);
+      return true;
+    }
     ga_instruction_contraction(base_tensor &t_,
                                const base_tensor &tc1_,
                                const base_tensor &tc2_, size_type I_)
@@ -2868,6 +3124,10 @@ namespace getfem {
       // GMM_ASSERT1(gmm::vect_dist2(t.as_vector(), u.as_vector()) < 1E-9, "Erroneous");
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt0_2(nc, t, tc1, tc2, n, q);
+      return true;
+    }
     ga_instruction_contraction_opt0_2(base_tensor &t_,
                                       const base_tensor &tc1_,
                                       const base_tensor &tc2_,
@@ -2907,6 +3167,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt0_2(nc, t, tc1, tc2, N, q);
+      return true;
+    }
     ga_instruction_contraction_opt0_2_unrolled(base_tensor &t_,
                                                const base_tensor &tc1_,
                                                const base_tensor &tc2_,
@@ -2945,6 +3209,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt0_2(nc, t, tc1, tc2, N, Q);
+      return true;
+    }
     ga_instruction_contraction_opt0_2_dunrolled(base_tensor &t_,
                                                 const base_tensor &tc1_,
                                                 const base_tensor &tc2_)
@@ -2979,6 +3247,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt2_0(nc, t, tc1, tc2, n, q);
+      return true;
+    }
     ga_instruction_contraction_opt2_0(base_tensor &t_,
                                       const base_tensor &tc1_,
                                       const base_tensor &tc2_,
@@ -3015,6 +3287,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt2_0(nc, t, tc1, tc2, N, q);
+      return true;
+    }
     ga_instruction_contraction_opt2_0_unrolled(base_tensor &t_,
                                                const base_tensor &tc1_,
                                                const base_tensor &tc2_,
@@ -3050,6 +3326,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt2_0(nc, t, tc1, tc2, N, Q);
+      return true;
+    }
     ga_instruction_contraction_opt2_0_dunrolled(base_tensor &t_,
                                                 const base_tensor &tc1_,
                                                 const base_tensor &tc2_)
@@ -3080,6 +3360,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt0_1(nc, t, tc1, tc2, nn);
+      return true;
+    }
     ga_instruction_contraction_opt0_1(base_tensor &t_,
                                       const base_tensor &tc1_,
                                       const base_tensor &tc2_,
@@ -3116,6 +3400,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction_opt0_1(nc, t, tc1, tc2, N);
+      return true;
+    }
     ga_instruction_contraction_opt0_1_unrolled(base_tensor &t_,
                                                const base_tensor &tc1_,
                                                const base_tensor &tc2_)
@@ -3150,6 +3438,20 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      // Only the nonzero components are written, as in exec()
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      size_type s1 = ga_nc_div(tc1.size(), nn), s2 = ga_nc_div(tc2.size(), nn);
+      size_type ss1 = ga_nc_div(s1, nn), ss2 = ga_nc_div(s2, nn);
+      if (!ss1 || !ss2) return true;
+      nc.body << "for (long j = 0; j < " << ss2 << "; ++j)\n"
+              << " for (long i = 0; i < " << ss1 << "; ++i) {\n"
+              << "  double a = " << A << "[i*" << nn << "] * " << B << "[j*"
+              << nn << "];\n"
+              << "  for (long k = 0; k < " << nn << "; ++k) " << T << "[j*"
+              << nn << "+i*" << s2*nn << "+k*" << s2+1 << "] = a;\n }\n";
+      return true;
+    }
     ga_instruction_contraction_opt1_1(base_tensor &t_,
                                       const base_tensor &tc1_,
                                       const base_tensor &tc2_, size_type n_)
@@ -3176,6 +3478,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction(nc, t, tc1, tc2, I);
+      return true;
+    }
     ga_instruction_contraction_unrolled(base_tensor &t_,
                                         const base_tensor &tc1_,
                                         const base_tensor &tc2_)
@@ -3231,6 +3537,10 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction(nc, t, tc1, tc2, 1);
+      return true;
+    }
     ga_instruction_contraction_unrolled(base_tensor &t_,
                                         const base_tensor &tc1_,
                                         const base_tensor &tc2_)
@@ -3319,6 +3629,10 @@ namespace getfem {
       GA_DEBUG_ASSERT(it == t.end(), "Internal error");
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      ga_nc_contraction(nc, t, tc1, tc2, I);
+      return true;
+    }
     ga_ins_red_d_unrolled(base_tensor &t_,
                           const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -3771,6 +4085,67 @@ namespace getfem {
     }
   }
 
+  // Performs Ani Bmi -> Cmn summed on all the Gauss points of the element,
+  // each one being weighted by coeff. The tensors A and B are stored point
+  // after point and the contraction is done at the last Gauss point in a
+  // single matrix-matrix product with a contracted size n*nbpt.
+  // Returns 1 to skip the following assembly instruction on the other points.
+  struct ga_instruction_contraction_batched : public ga_instruction {
+    base_tensor &t;
+    const base_tensor &tc1, &tc2;
+    const size_type n;
+    const scalar_type &coeff;
+    const size_type &nbpt, &ipt;
+    base_vector A, B;
+    size_type nbstored;
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: contraction operation of size " << n <<
+                    " batched on the Gauss points");
+      size_type N = tc1.size()/n, M = tc2.size()/n;
+      GA_DEBUG_ASSERT(t.size() == N*M, "Internal error");
+      if (ipt == 0) nbstored = 0;
+      if (coeff != scalar_type(0)) {
+        size_type s1 = N*n, s2 = M*n;
+        if (A.size() < s1*nbpt) A.resize(s1*nbpt);
+        if (B.size() < s2*nbpt) B.resize(s2*nbpt);
+        auto ita = A.begin() + s1*nbstored;
+        for (const auto &val : tc1.as_vector()) *ita++ = coeff*val;
+        std::copy(tc2.begin(), tc2.end(), B.begin() + s2*nbstored);
+        ++nbstored;
+      }
+      if (ipt+1 < nbpt) return 1;
+
+      size_type K = n*nbstored;
+      if (K == 0) { gmm::clear(t.as_vector()); return 0; }
+#if defined(GA_USES_BLAS)
+      BLAS_INT N_ = BLAS_INT(N), K_ = BLAS_INT(K), M_ = BLAS_INT(M);
+      constexpr char notrans = 'N', trans = 'T';
+      constexpr scalar_type one(1), zero(0);
+      gmm::dgemm_(&notrans, &trans, &M_, &N_, &K_, &one,
+                  &(B[0]), &M_, &(A[0]), &N_, &zero, &(t[0]), &M_);
+#else
+      gmm::clear(t.as_vector());
+      for (size_type k = 0; k < K; ++k) {
+        auto it = t.begin();
+        auto it2 = B.cbegin() + M*k;
+        for (size_type i = 0; i < N; ++i) {
+          scalar_type a = A[i+N*k];
+          for (size_type j = 0; j < M; ++j, ++it) *it += a * it2[j];
+        }
+      }
+#endif
+      return 0;
+    }
+    ga_instruction_contraction_batched(base_tensor &t_,
+                                       const base_tensor &tc1_,
+                                       const base_tensor &tc2_, size_type n_,
+                                       const scalar_type &coeff_,
+                                       const size_type &nbpt_,
+                                       const size_type &ipt_)
+      : t(t_), tc1(tc1_), tc2(tc2_), n(n_), coeff(coeff_), nbpt(nbpt_),
+        ipt(ipt_), nbstored(0) {}
+  };
+
 
   // Performs Amij Bnj -> Cmni. To be optimized.
   struct ga_instruction_spec_contraction : public ga_instruction {
@@ -3842,6 +4217,15 @@ namespace getfem {
       }
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      size_type s1 = tc1.size(), s2 = tc2.size();
+      if (!s1) return true;
+      nc.body << "for (long j = 0; j < " << s2 << "; ++j)\n"
+              << " for (long i = 0; i < " << s1 << "; ++i) " << T << "[i+"
+              << s1 << "*j] = " << A << "[i] * " << B << "[j];\n";
+      return true;
+    }
     ga_instruction_simple_tmult(base_tensor &t_,
                                 const base_tensor &tc1_, const base_tensor &tc2_)
       : t(t_), tc1(tc1_), tc2(tc2_) {}
@@ -3877,6 +4261,15 @@ namespace getfem {
 #endif
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), B = nc.tensor(tc2);
+      size_type s1 = tc1.size(), s2 = tc2.size();
+      if (!s1) return true;
+      nc.body << "for (long j = 0; j < " << s2 << "; ++j)\n"
+              << " for (long i = 0; i < " << s1 << "; ++i) " << T << "[i+"
+              << s1 << "*j] = " << A << "[i] * " << B << "[j];\n";
+      return true;
+    }
     ga_instruction_simple_tmult_unrolled(base_tensor &t_,
                                          const base_tensor &tc1_,
                                          const base_tensor &tc2_)
@@ -4183,6 +4576,11 @@ namespace getfem {
       t = (*f1)(c);
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      nc.body << nc.scalar(t) << " = " << nc.function(f1) << "("
+              << nc.scalar(c) << ");\n";
+      return true;
+    }
     ga_instruction_eval_func_1arg_1res(scalar_type &t_, const scalar_type &c_,
                                        pscalar_func_onearg f1_)
       : t(t_), c(c_), f1(f1_) {}
@@ -4216,6 +4614,11 @@ namespace getfem {
         t[i] = (*f1)(tc1[i]);
       return 0;
     }
+    virtual bool emit(ga_native_code &nc) const {
+      std::string T = nc.tensor(t), A = nc.tensor(tc1), F = nc.function(f1);
+      ga_nc_loop(nc, t.size(), T+"[i] = "+F+"("+A+"[i])");
+      return true;
+    }
     ga_instruction_eval_func_1arg(base_tensor &t_,
                                   const base_tensor &c_, pscalar_func_onearg f1_)
       : t(t_), tc1(c_), f1(f1_) {}
@@ -4436,6 +4839,87 @@ namespace getfem {
       : t(t_), OP(OP_), args(args_), der1(der1_), der2(der2_) {}
   };
 
+  // Evaluation of an operator (or of one of its derivatives) on all the
+  // Gauss points of the element at once. During the sweep of its level
+  // (see ga_exec), the arguments are stored point after point and the
+  // operator is evaluated at the last point. The results are then read
+  // point after point in the following sweeps. In the other sweeps, the
+  // result of the same point on the previous element is left in t, so that
+  // the instructions depending on it work on admissible values.
+  // A level 0 means an evaluation point by point.
+  struct ga_instruction_eval_OP_batched : public ga_instruction {
+    base_tensor &t;
+    const ga_nonlinear_operator &OP;
+    ga_nonlinear_operator::arg_list args;
+    size_type der1, der2, level;
+    const size_type &sweep, &nbpt, &ipt;
+    std::vector<base_tensor> bargs;
+    ga_nonlinear_operator::arg_list pbargs;
+    std::vector<bool> stored;
+    base_tensor result;
+
+    void evaluate() {
+      if (der2) OP.second_derivative(args, der1, der2, t);
+      else if (der1) OP.derivative(args, der1, t);
+      else OP.value(args, t);
+    }
+
+    bool read_result() {
+      size_type s = t.size();
+      if (result.size() < (ipt+1)*s) return false;
+      auto it = result.begin() + ipt*s;
+      std::copy(it, it + s, t.begin());
+      return true;
+    }
+
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: batched operator evaluation");
+      if (level == 0) { evaluate(); return 0; }
+      if (sweep != level) {
+        if (!read_result()) evaluate();
+        return 0;
+      }
+      if (ipt == 0) {
+        for (size_type k = 0; k < args.size(); ++k) {
+          bgeot::multi_index mi = args[k]->sizes(); mi.push_back(nbpt);
+          bargs[k].adjust_sizes(mi);
+        }
+        stored.assign(nbpt, false);
+      }
+      for (size_type k = 0; k < args.size(); ++k)
+        std::copy(args[k]->begin(), args[k]->end(),
+                  bargs[k].begin() + ipt*args[k]->size());
+      stored[ipt] = true;
+      if (!read_result()) evaluate();
+      if (ipt+1 == nbpt) {
+        for (size_type p = 1; p < nbpt; ++p)
+          if (!stored[p]) // Skipped point, the arguments of the first one
+            for (size_type k = 0; k < args.size(); ++k) {
+              size_type sa = args[k]->size();
+              std::copy(bargs[k].begin(), bargs[k].begin() + sa,
+                        bargs[k].begin() + p*sa);
+            }
+        bgeot::multi_index mi = t.sizes(); mi.push_back(nbpt);
+        result.adjust_sizes(mi);
+        if (der2) OP.batched_second_derivative(pbargs, der1, der2, nbpt,
+                                               result);
+        else if (der1) OP.batched_derivative(pbargs, der1, nbpt, result);
+        else OP.batched_value(pbargs, nbpt, result);
+      }
+      return 0;
+    }
+    ga_instruction_eval_OP_batched
+    (base_tensor &t_, const ga_nonlinear_operator &OP_,
+     ga_nonlinear_operator::arg_list &args_, size_type der1_, size_type der2_,
+     size_type level_, const size_type &sweep_, const size_type &nbpt_,
+     const size_type &ipt_)
+      : t(t_), OP(OP_), args(args_), der1(der1_), der2(der2_), level(level_),
+        sweep(sweep_), nbpt(nbpt_), ipt(ipt_), bargs(args_.size()),
+        pbargs(args_.size()) {
+      for (size_type k = 0; k < args.size(); ++k) pbargs[k] = &(bargs[k]);
+    }
+  };
+
   struct ga_instruction_tensor_slice : public ga_instruction {
     base_tensor &t;
     const base_tensor &tc1;
@@ -4829,19 +5313,53 @@ namespace getfem {
   };
 
 
+  // Scatter counters of the assembly profiled by the current thread (set by
+  // ga_exec when the profiling is enabled), null otherwise.
+  static ga_profile_counters *&ga_scatter_profile() {
+    THREAD_SAFE_STATIC ga_profile_counters *p = nullptr;
+    return p;
+  }
+
+  struct ga_scatter_timer {
+    ga_profile_counters *p;
+    std::chrono::steady_clock::time_point t0;
+    ga_scatter_timer() : p(ga_scatter_profile())
+    { if (p) t0 = std::chrono::steady_clock::now(); }
+    ~ga_scatter_timer() {
+      if (p) {
+        p->nb_calls++;
+        p->time += std::chrono::duration<scalar_type>
+          (std::chrono::steady_clock::now() - t0).count();
+      }
+    }
+  };
+
+  struct ga_scatter_profile_guard {
+    ga_profile_counters *previous;
+    ga_scatter_profile_guard(ga_profile_counters *p)
+      : previous(ga_scatter_profile()) { ga_scatter_profile() = p; }
+    ~ga_scatter_profile_guard() { ga_scatter_profile() = previous; }
+  };
+
+  // The optional column locks protect the columns of a matrix shared by
+  // several threads (see ga_workspace::set_assembled_matrix).
   template <class MAT>
   inline void add_elem_matrix
   (MAT &K, const std::vector<size_type> &dofs1,
    const std::vector<size_type> &dofs2, std::vector<size_type> &/*dofs1_sort*/,
-   const base_vector &elem, scalar_type threshold, size_type /* N */) {
+   const base_vector &elem, scalar_type threshold, size_type /* N */,
+   const column_locks *locks) {
 
+    ga_scatter_timer timer;
     base_vector::const_iterator it = elem.cbegin();
-    for (const size_type &dof2 : dofs2)
+    for (const size_type &dof2 : dofs2) {
+      column_guard g(locks, dof2);
       for (const size_type &dof1 : dofs1) {
         if (gmm::abs(*it) > threshold)
           K(dof1, dof2) += *it;
         ++it;
       }
+    }
   }
 
   // static const std::vector<size_type> *the_indto_sort;
@@ -4855,8 +5373,10 @@ namespace getfem {
   (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
    const std::vector<size_type> &dofs1, const std::vector<size_type> &dofs2,
    std::vector<size_type> &dofs1_sort,
-   const base_vector &elem, scalar_type threshold, size_type N) {
+   const base_vector &elem, scalar_type threshold, size_type N,
+   const column_locks *locks) {
 
+    ga_scatter_timer timer;
     size_type s1 = dofs1.size();
 
     dofs1_sort.resize(s1);
@@ -4880,6 +5400,7 @@ namespace getfem {
     for (const size_type &dof2 : dofs2) { // Iteration on columns
       if (first) first = false;
       else it += s1;
+      column_guard g(locks, dof2);
       std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
       size_type nb = col.size();
 
@@ -4941,8 +5462,10 @@ namespace getfem {
   (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
    const size_type &i1, const size_type &s1,
    const std::vector<size_type> &dofs2,
-   const base_vector &elem, scalar_type threshold) {
+   const base_vector &elem, scalar_type threshold,
+   const column_locks *locks) {
 
+    ga_scatter_timer timer;
     gmm::elt_rsvector_<scalar_type> ev;
 
     base_vector::const_iterator it = elem.cbegin();
@@ -4950,6 +5473,7 @@ namespace getfem {
     for (const size_type &dof2 : dofs2) { // Iteration on columns
       if (first) first = false;
       else it += s1;
+      column_guard g(locks, dof2);
       std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
       size_type nb = col.size();
 
@@ -5045,6 +5569,11 @@ namespace getfem {
     base_vector elem;
     bool interpolate;
     std::vector<size_type> dofs1, dofs2, dofs1_sort;
+    // Matrix shared by several threads and the locks protecting its columns
+    const model_real_sparse_matrix *Kshared = nullptr;
+    const column_locks *Klocks = nullptr;
+    const column_locks *locks_of(const model_real_sparse_matrix &K) const
+    { return (&K == Kshared) ? Klocks : nullptr; }
     void add_tensor_to_element_matrix(bool initialize, bool empty_weight) {
       if (initialize) {
         if (empty_weight) elem.resize(0);
@@ -5106,10 +5635,12 @@ namespace getfem {
                              mf1->ind_scalar_basic_dof_of_element(cv1));
         if (mf1 == mf2 && cv1 == cv2) {
           if (ifirst1 == ifirst2) {
-            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N,
+                            locks_of(K));
           } else {
             populate_dofs_vector(dofs2, dofs1.size(), ifirst2 - ifirst1, dofs1);
-            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N,
+                            locks_of(K));
           }
         } else {
           N = std::max(N, ctx2.N());
@@ -5117,7 +5648,8 @@ namespace getfem {
           if (qmult2 > 1) qmult2 /= mf2->fem_of_element(cv2)->target_dim();
           populate_dofs_vector(dofs2, s2, ifirst2, qmult2,        // --> dofs2
                                mf2->ind_scalar_basic_dof_of_element(cv2));
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N,
+                          locks_of(K));
         }
       }
       return 0;
@@ -5221,7 +5753,8 @@ namespace getfem {
       if (qmult2 > 1) qmult2 /= mf2->fem_of_element(cv2)->target_dim();
       populate_dofs_vector(dofs2, s2, ifirst2, qmult2,     // --> dofs2
                            mf2->ind_scalar_basic_dof_of_element(cv2));
-      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx2.N());
+      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx2.N(),
+                      locks_of(K));
       return 0;
     }
 
@@ -5283,7 +5816,8 @@ namespace getfem {
       populate_dofs_vector(dofs1, s1, ifirst1, qmult1,     // --> dofs1
                            mf1->ind_scalar_basic_dof_of_element(cv1));
       populate_contiguous_dofs_vector(dofs2, s2, ifirst2); // --> dofs2
-      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx1.N());
+      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx1.N(),
+                      locks_of(K));
       return 0;
     }
 
@@ -5341,7 +5875,8 @@ namespace getfem {
         ifirst2 += s2 * imd2->filtered_index_of_point(ctx2.convex_num(), ctx2.ii());
 
       populate_contiguous_dofs_vector(dofs2, s2, ifirst2);
-      add_elem_matrix_contiguous_rows(K, ifirst1, s1, dofs2, elem, ninf*1E-14);
+      add_elem_matrix_contiguous_rows(K, ifirst1, s1, dofs2, elem, ninf*1E-14,
+                                      locks_of(K));
       return 0;
     }
     ga_instruction_matrix_assembly_imd_imd
@@ -5389,18 +5924,21 @@ namespace getfem {
 
         if (pmf2 == pmf1 && cv1 == cv2) {
           if (I1.first() == I2.first()) {
-            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N,
+                            locks_of(K));
           } else {
             populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
                                  dofs1);
-            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N,
+                            locks_of(K));
           }
         } else {
           if (cv2 == size_type(-1)) return 0;
           auto &ct2 = pmf2->ind_scalar_basic_dof_of_element(cv2);
           GA_DEBUG_ASSERT(ct2.size() == t.sizes()[1], "Internal error");
           populate_dofs_vector(dofs2, ct2.size(), I2.first(), ct2);
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N,
+                          locks_of(K));
         }
       }
       return 0;
@@ -5451,7 +5989,8 @@ namespace getfem {
                              pmf1->ind_scalar_basic_dof_of_element(cv1));
 
         if (pmf2 == pmf1 && cv1 == cv2 && I1.first() == I2.first()) {
-          add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N,
+                          locks_of(K));
         } else {
           if (pmf2 == pmf1 && cv1 == cv2) {
             populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
@@ -5463,7 +6002,8 @@ namespace getfem {
             populate_dofs_vector(dofs2, s2, I2.first(), qmult2,      // --> dofs2
                                  pmf2->ind_scalar_basic_dof_of_element(cv2));
           }
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N,
+                          locks_of(K));
         }
       }
       return 0;
@@ -5529,14 +6069,17 @@ namespace getfem {
                                pmf2->ind_scalar_basic_dof_of_element(cv2));
         }
         std::vector<size_type> &dofs2_ = same_dofs ? dofs1 : dofs2;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N,
+                        locks_of(K));
         for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
         if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N,
+                        locks_of(K));
         if (QQ >= 3) {
           for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
           if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-          add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+          add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N,
+                          locks_of(K));
         }
       }
       return 0;
@@ -5810,6 +6353,34 @@ namespace getfem {
     }
   }
 
+  // Extended values of the variables defined on reduced fems, to be updated
+  // before any new execution of already compiled instructions.
+  void ga_update_extended_variables(const ga_workspace &workspace,
+                                    ga_instruction_set &gis) {
+    for (auto &&v : gis.really_extended_vars)
+      workspace.associated_mf(v.first)->extend_vector
+        (workspace.value(v.first), v.second);
+  }
+
+  // Number of nested operators having a batched evaluation in the subtree,
+  // which gives the sweep of the Gauss points in which the arguments of the
+  // operator of the node are all available.
+  static size_type ga_batched_operator_level(const pga_tree_node pnode) {
+    size_type level = 0;
+    for (const pga_tree_node &child : pnode->children)
+      level = std::max(level, ga_batched_operator_level(child));
+    if (pnode->node_type == GA_NODE_PARAMS
+        && pnode->children[0]->node_type == GA_NODE_OPERATOR) {
+      ga_predef_operator_tab &PREDEF_OPERATORS
+        = dal::singleton<ga_predef_operator_tab>::instance(0);
+      auto it = PREDEF_OPERATORS.tab.find(pnode->children[0]->name);
+      if (it != PREDEF_OPERATORS.tab.end()
+          && it->second->has_batched_evaluation())
+        ++level;
+    }
+    return level;
+  }
+
   static void ga_clear_node_list
   (pga_tree_node pnode, std::map<scalar_type,
    std::list<pga_tree_node> > &node_list) {
@@ -6198,7 +6769,16 @@ namespace getfem {
                         << "integration method or interpolation used");
           }
           
-          if (imd) {
+          if (!mf && !imd) { // fixed size variable read at each execution
+            GMM_ASSERT1(pnode->node_type == GA_NODE_VAL, "Internal error");
+            if (gmm::vect_size(workspace.value(pnode->name)) == 1)
+              pgai = std::make_shared<ga_instruction_copy_scalar>
+                (pnode->tensor()[0], (workspace.value(pnode->name))[0]);
+            else
+              pgai = std::make_shared<ga_instruction_copy_vect>
+                (pnode->tensor().as_vector(), workspace.value(pnode->name));
+            rmi.instructions.push_back(std::move(pgai));
+          } else if (imd) {
             GMM_ASSERT1(pnode->node_type == GA_NODE_VAL,
                         "Only values can be extracted on im_data (no " <<
                         "gradient, Hessian, xfem or elementary tranformation" <<
@@ -7134,6 +7714,19 @@ namespace getfem {
            size_type s1 = (tps0 * tps1) / pnode->tensor_proper_size();
            size_type s2 = size_type(round(sqrt(scalar_type(s1))));
 
+           // Contraction Ani Bmi -> Cmn. Recorded for a possible execution
+           // batched on the Gauss points (see ga_compile).
+           auto contraction = [&](const pga_tree_node c1,
+                                  const pga_tree_node c2, bool uniform) {
+             rmi.contractions[pnode] = {&(c1->tensor()), &(c2->tensor()),
+                                        s2, rmi.instructions.size()};
+             return uniform
+               ? ga_uniform_instruction_contraction_switch
+                 (pnode->t, c1->t, c2->t, s2, tensor_to_clear)
+               : ga_instruction_contraction_switch
+                 (pnode->t, c1->t, c2->t, s2, tensor_to_clear);
+           };
+
            pgai = pga_instruction();
            if ((pnode->op_type == GA_DOT && dim1 <= 1) ||
                (pnode->op_type == GA_COLON && dim1 <= 2) ||
@@ -7171,12 +7764,8 @@ namespace getfem {
                    else
                      pgai = std::make_shared<ga_instruction_simple_tmult>
                        (pnode->tensor(), child1->tensor(), child0->tensor());
-                 } else if (is_uniform) // Unrolled instruction
-                   pgai = ga_uniform_instruction_contraction_switch
-                     (pnode->t, child0->t, child1->t, s2, tensor_to_clear);
-                 else // Unrolled instruction
-                   pgai = ga_instruction_contraction_switch
-                     (pnode->t, child0->t, child1->t, s2, tensor_to_clear);
+                 } else // Unrolled instruction
+                   pgai = contraction(child0, child1, is_uniform);
                }
              } else {
                if (child1->test_function_type == 1 ||
@@ -7190,12 +7779,8 @@ namespace getfem {
                      } else
                        pgai = std::make_shared<ga_instruction_simple_tmult>
                          (pnode->tensor(), child1->tensor(), child0->tensor());
-                   } else if (is_uniform) // Unrolled instruction
-                     pgai = ga_uniform_instruction_contraction_switch
-                       (pnode->t, child0->t, child1->t, s2, tensor_to_clear);
-                   else // Unrolled instruction
-                     pgai = ga_instruction_contraction_switch
-                       (pnode->t, child0->t, child1->t, s2, tensor_to_clear);
+                   } else // Unrolled instruction
+                     pgai = contraction(child0, child1, is_uniform);
                  } else
                    pgai = std::make_shared<ga_instruction_spec_contraction>
                      (pnode->tensor(), child1->tensor(), child0->tensor(), s2);
@@ -7209,18 +7794,11 @@ namespace getfem {
                    } else
                      pgai = std::make_shared<ga_instruction_simple_tmult>
                        (pnode->tensor(), child0->tensor(), child1->tensor());
-                 } else {
-                   if (is_uniform) // Unrolled instruction
-                     pgai = ga_uniform_instruction_contraction_switch
-                       (pnode->t, child1->t, child0->t, s2, tensor_to_clear);
-                   else // Unrolled instruction
-                     pgai = ga_instruction_contraction_switch
-                       (pnode->t, child1->t, child0->t, s2, tensor_to_clear);
-                 }
+                 } else // Unrolled instruction
+                   pgai = contraction(child1, child0, is_uniform);
                } else {
                  if (child0->tensor_proper_size() == s2)
-                   pgai = ga_uniform_instruction_contraction_switch
-                     (pnode->t, child1->t, child0->t, s2, tensor_to_clear);
+                   pgai = contraction(child1, child0, true);
                  else if (child1->tensor_proper_size() == s2)
                    pgai = std::make_shared<ga_instruction_spec_contraction>
                      (pnode->tensor(), child0->tensor(), child1->tensor(), s2);
@@ -7668,7 +8246,13 @@ namespace getfem {
         for (size_type i = 1; i < pnode->children.size(); ++i)
           args.push_back(&(pnode->children[i]->tensor()));
 
-        if (child0->der1 && child0->der2 == 0) {
+        if (rmi.batched_operators && if_hierarchy.size() == 1
+            && OP.has_batched_evaluation()) {
+          pgai = std::make_shared<ga_instruction_eval_OP_batched>
+            (pnode->tensor(), OP, args, child0->der1, child0->der2,
+             ga_batched_operator_level(pnode), gis.batch_sweep, gis.nbpt,
+             gis.ipt);
+        } else if (child0->der1 && child0->der2 == 0) {
           pgai = std::make_shared<ga_instruction_eval_derivative_OP>
              (pnode->tensor(), OP, args, child0->der1);
         } else if (child0->der1 && child0->der2) {
@@ -7908,6 +8492,91 @@ namespace getfem {
                                RQpr; // partial solution for condensed variables (initially stores residuals)
   };
 
+  // Gives to a matrix assembly instruction the locks of the assembled matrix
+  // when this matrix is shared by several threads.
+  static void ga_set_shared_matrix(const pga_instruction &pgai,
+                                   ga_workspace &workspace) {
+    if (workspace.assembled_matrix_locks()) {
+      auto pgaim = std::dynamic_pointer_cast
+        <ga_instruction_matrix_assembly_base>(pgai);
+      if (pgaim) {
+        pgaim->Kshared = &(workspace.assembled_matrix());
+        pgaim->Klocks = workspace.assembled_matrix_locks();
+      }
+    }
+  }
+
+  // Attributes the instructions compiled since the last call to the
+  // expression expr, for the profiling of the assembly.
+  static void ga_attribute_instructions(ga_instruction_set &gis,
+                                        const std::string &expr) {
+    size_type ind = gis.expressions.size();
+    bool used = false;
+    for (auto &&instr : gis.all_instructions) {
+      auto &rmi = instr.second;
+      used = used
+        || rmi.begin_instructions_expr.size() < rmi.begin_instructions.size()
+        || rmi.elt_instructions_expr.size() < rmi.elt_instructions.size()
+        || rmi.instructions_expr.size() < rmi.instructions.size();
+      rmi.begin_instructions_expr.resize(rmi.begin_instructions.size(), ind);
+      rmi.elt_instructions_expr.resize(rmi.elt_instructions.size(), ind);
+      rmi.instructions_expr.resize(rmi.instructions.size(), ind);
+    }
+    if (used) gis.expressions.push_back(expr);
+  }
+
+  // Sweeps of the Gauss points needed by the batched operators (see ga_exec)
+  static void ga_batched_operator_sweeps
+  (ga_instruction_set::region_mim_instructions &rmi) {
+    const std::vector<pga_instruction> &instructions = rmi.instructions;
+    rmi.batch_ends.clear(); rmi.batch_skip.clear();
+    std::vector<ga_instruction_eval_OP_batched *> batched;
+    std::map<size_type, size_type> ends; // level -> end of the sweep
+    for (size_type i = 0; i < instructions.size(); ++i) {
+      auto *pgai
+        = dynamic_cast<ga_instruction_eval_OP_batched *>(instructions[i].get());
+      if (pgai && pgai->level) {
+        batched.push_back(pgai);
+        ends[pgai->level] = i+1;
+      }
+    }
+    if (batched.empty()) return;
+
+    size_type end = 0;
+    for (const auto &e : ends) end = std::max(end, e.second);
+    rmi.batch_skip.assign(end, false);
+    for (size_type i = 0; i < end; ++i) {
+      const ga_instruction *pgai = instructions[i].get();
+      if (dynamic_cast<const ga_instruction_assignment *>(pgai) ||
+          dynamic_cast<const ga_instruction_extract_residual_on_imd_dofs *>
+          (pgai)) { // Values modified during the execution, no batching
+        for (auto *b : batched) b->level = 0;
+        rmi.batch_skip.clear();
+        return;
+      }
+      rmi.batch_skip[i]
+        = dynamic_cast<const ga_instruction_add_to_coeff *>(pgai) ||
+          dynamic_cast<const ga_instruction_scalar_assembly *>(pgai) ||
+          dynamic_cast<const ga_instruction_vector_assembly_mf *>(pgai) ||
+          dynamic_cast<const ga_instruction_vector_assembly_imd *>(pgai) ||
+          dynamic_cast<const ga_instruction_vector_assembly *>(pgai) ||
+          dynamic_cast<const ga_instruction_matrix_assembly_base *>(pgai) ||
+          dynamic_cast<const ga_instruction_contraction_batched *>(pgai) ||
+          dynamic_cast<const ga_instruction_condensation_sub *>(pgai) ||
+          dynamic_cast<const ga_instruction_condensation_super_K *>(pgai) ||
+          dynamic_cast<const ga_instruction_condensation_super_R *>(pgai) ||
+          dynamic_cast<const ga_instruction_print_tensor *>(pgai);
+    }
+
+    // The levels are renumbered consecutively
+    std::map<size_type, size_type> sweeps;
+    for (const auto &e : ends) {
+      sweeps[e.first] = rmi.batch_ends.size() + 1;
+      rmi.batch_ends.push_back(e.second);
+    }
+    for (auto *b : batched) b->level = sweeps[b->level];
+  }
+
   void ga_compile(ga_workspace &workspace,
                   ga_instruction_set &gis, size_type order, bool condensation) {
     gis.transformations.clear();
@@ -8027,10 +8696,11 @@ namespace getfem {
                                     ? gis.trees
                                     : gis.interpolation_trees;
           trees.push_back(*(td.ptree));
-          // Semantic analysis mainly to evaluate fixed size variables and data
+          // Semantic analysis mainly to evaluate fixed size variables and
+          // data, which are read at each execution by the kept instructions
           ga_semantic_analysis(trees.back(), workspace, td.mim->linked_mesh(),
                             ref_elt_dim_of_mesh(td.mim->linked_mesh(),*(td.rg)),
-                            true, false);
+                            !workspace.keeps_compiled_instructions(), false);
           pga_tree_node root = trees.back().root;
           if (root) {
             // Compile tree
@@ -8043,6 +8713,7 @@ namespace getfem {
             auto &rmi = gis.all_instructions[rm];
             rmi.m = td.m;
             rmi.im = td.mim;
+            rmi.batched_operators = !psd && !workspace.profiling_enabled();
             // rmi.interpolate_infos.clear();
             ga_compile_interpolate_trans(root, workspace, gis, rmi, *(td.m));
             ga_compile_node(root, workspace, gis, rmi, *(td.m), false,
@@ -8197,26 +8868,49 @@ namespace getfem {
                   const scalar_type
                     &alpha1 = workspace.factor_of_variable(root->name_test1),
                     &alpha2 = workspace.factor_of_variable(root->name_test2);
+
+                  // Contraction at the root batched on the Gauss points:
+                  // the root tensor then holds the weighted sum on the
+                  // element and the assembly is done once per element.
+                  static const size_type one_pt(1), zero_pt(0);
+                  auto itc = rmi.contractions.find(root);
+                  bool batched = workspace.batched_int_points() && !psd
+                    && intn1.empty() && intn2.empty()
+                    && itc != rmi.contractions.end()
+                    && itc->second.ind+1 == rmi.instructions.size();
+                  if (batched) {
+                    const auto &ci = itc->second;
+                    rmi.instructions.back()
+                      = std::make_shared<ga_instruction_contraction_batched>
+                      (root->tensor(), *(ci.tc1), *(ci.tc2), ci.n,
+                       gis.coeff, gis.nbpt, gis.ipt);
+                    // The root tensor cannot be shared with other nodes
+                    rmi.node_list[root->hash_value].remove(root);
+                  }
+                  const scalar_type &coeff = batched ? gis.ONE : gis.coeff;
+                  const size_type &nbpt = batched ? one_pt : gis.nbpt;
+                  const size_type &ipt = batched ? zero_pt : gis.ipt;
+
                   if (mf1->get_qdim() == 1 && mf2->get_qdim() == 1)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_scalar>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                       alpha1, alpha2, coeff, nbpt, ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 2)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<2>>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                       alpha1, alpha2, coeff, nbpt, ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 3)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<3>>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                       alpha1, alpha2, coeff, nbpt, ipt);
                   else
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector>
                       (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                       alpha1, alpha2, coeff, nbpt, ipt);
                 } else if (condensation &&
                            workspace.is_internal_variable(root->name_test1) &&
                            workspace.is_internal_variable(root->name_test2)) {
@@ -8420,10 +9114,14 @@ namespace getfem {
                 break;
               } // case 2
               } // switch(order)
-              if (pgai)
+              if (pgai) {
+                ga_set_shared_matrix(pgai, workspace);
                 rmi.instructions.push_back(std::move(pgai));
+              }
             }
           } // if (root)
+          if (workspace.profiling_enabled())
+            ga_attribute_instructions(gis, ga_tree_to_string(*(td.ptree)));
         } // if (td.order == order || td.order == size_type(-1))
       } // for (const ga_workspace::tree_description &td : trees_of_current_phase)
 
@@ -8606,6 +9304,7 @@ namespace getfem {
                          (Kij, Krr, gis.ctx, gis.ctx,
                           I1, imd1, alpha1, I2, imd2, alpha2,
                           gis.coeff, gis.ipt);
+                ga_set_shared_matrix(pgai, workspace);
                 rmi.instructions.push_back(std::move(pgai));
               } // if (Q_of_J[j2].size())
             } // for j2
@@ -8638,9 +9337,24 @@ namespace getfem {
             rmi.instructions.push_back(std::move(pgai));
           } // for i1
         } // for (const auto &key_val : condensations)
+        if (workspace.profiling_enabled())
+          ga_attribute_instructions(gis, "(static condensation)");
       } // if (phase == ga_workspace::ASSEMBLY)
     } // for (const auto &phase : phases)
 
+    if (ga_native_code_enabled() && !workspace.profiling_enabled())
+      for (auto &&instr : gis.all_instructions) {
+        // The interpolate filters skip a number of following instructions
+        bool filtered = false;
+        for (const pga_instruction &pgai : instr.second.instructions)
+          if (dynamic_cast<ga_instruction_interpolate_filter *>(pgai.get()))
+            filtered = true;
+        if (!filtered) ga_native_code_segments(instr.second.instructions);
+      }
+
+    for (auto &&instr : gis.all_instructions)
+      ga_batched_operator_sweeps(instr.second);
+
   } // ga_compile(...)
 
 
@@ -8748,11 +9462,65 @@ namespace getfem {
     gic.finalize();
   }
 
+  // Execution of a list of instructions. If prof is not null, each
+  // instruction is timed and its counters are stored in prof[j].
+  static inline void ga_exec_instructions
+  (const std::vector<pga_instruction> &gil, ga_profile_counters *prof) {
+    if (prof) {
+      for (size_type j=0; j < gil.size(); ++j) {
+        auto t0 = std::chrono::steady_clock::now();
+        size_type jump = gil[j]->exec();
+        prof[j].nb_calls++;
+        prof[j].time += std::chrono::duration<scalar_type>
+          (std::chrono::steady_clock::now() - t0).count();
+        j += jump;
+      }
+    } else
+      for (size_type j=0; j < gil.size(); ++j) j+=gil[j]->exec();
+  }
+
+  // Execution of the first end instructions for a sweep collecting the
+  // arguments of batched operators, the assembly and output ones excepted.
+  static inline void ga_exec_batch_sweep
+  (const std::vector<pga_instruction> &gil, size_type end,
+   const std::vector<bool> &skip) {
+    for (size_type j=0; j < end; ++j) if (!skip[j]) j+=gil[j]->exec();
+  }
+
+  static std::string ga_instruction_name(const ga_instruction &instr) {
+    std::string name = dal::demangle(typeid(instr).name());
+    for (size_type i = name.find("getfem::"); i != std::string::npos;
+         i = name.find("getfem::", i))
+      name.erase(i, 8);
+    return name;
+  }
+
+  // Adds the counters of the instructions of a region to the profile.
+  static void ga_add_to_profile
+  (ga_assembly_profile &profile, const ga_instruction_set &gis,
+   const std::vector<pga_instruction> &gil,
+   const std::vector<size_type> &gil_expr,
+   const std::vector<ga_profile_counters> &counters) {
+    for (size_type j = 0; j < gil.size(); ++j)
+      if (counters[j].nb_calls) {
+        profile.instructions[ga_instruction_name(*(gil[j]))] += counters[j];
+        if (j < gil_expr.size())
+          profile.expressions[gis.expressions[gil_expr[j]]].instructions
+            += counters[j];
+      }
+  }
+
   void ga_exec(ga_instruction_set &gis, ga_workspace &workspace) {
     base_matrix G1, G2;
     base_small_vector un;
     scalar_type J1(0), J2(0);
 
+    ga_assembly_profile *profile = workspace.profiling_enabled()
+                                 ? &(workspace.profile()) : nullptr;
+    std::vector<ga_profile_counters> counters_b, counters_e, counters;
+    ga_scatter_profile_guard scatter_guard(profile ? &(profile->scatter)
+                                                   : nullptr);
+
     for (const std::string &t : gis.transformations)
       workspace.interpolate_transformation(t)->init(workspace);
 
@@ -8765,19 +9533,22 @@ namespace getfem {
       const auto &gile = instr.second.elt_instructions;
       const auto &gil = instr.second.instructions;
 
-      // if (gilb.size()) cout << "Begin instructions\n";
-      // for (size_type j = 0; j < gilb.size(); ++j)
-      //   cout << typeid(*(gilb[j])).name() << endl;
-      // if (gile.size()) cout << "\nElement instructions\n";
-      // for (size_type j = 0; j < gile.size(); ++j)
-      //   cout << typeid(*(gile[j])).name() << endl;
-      // cout << "\nGauss pt instructions\n";
-      // for (size_type j = 0; j < gil.size(); ++j)
-      //   cout << typeid(*(gil[j])).name() << endl;
+      ga_profile_counters *profb(0), *profe(0), *prof(0);
+      size_type nb_elements(0), nb_gauss_points(0);
+      if (profile) {
+        counters_b.assign(gilb.size(), ga_profile_counters());
+        counters_e.assign(gile.size(), ga_profile_counters());
+        counters.assign(gil.size(), ga_profile_counters());
+        profb = counters_b.data(); profe = counters_e.data();
+        prof = counters.data();
+      }
 
       if (!psd) { // standard integration on a single domain
 
         const mesh_region &region = *(instr.first.region());
+        const auto &batch_ends = instr.second.batch_ends;
+        const auto &batch_skip = instr.second.batch_skip;
+        size_type nb_sweeps = batch_ends.size() + 1;
 
         // iteration on elements (or faces of elements)
         size_type old_cv = size_type(-1);
@@ -8787,7 +9558,24 @@ namespace getfem {
         bgeot::pstored_point_tab pspt = 0, old_pspt = 0;
         bgeot::pgeotrans_precomp pgp = 0;
         bool first_gp = true;
-        for (getfem::mr_visitor v(region, m, true); !v.finished(); ++v) {
+        // Estimated cost of an element or a face, for the balance of the
+        // partitions between the threads: number of integration points times
+        // the number of local dofs of the finite element methods used.
+        const auto &pfps = instr.second.pfps;
+        auto cost = [&mim, &pfps](size_type cv, short_type f) {
+          if (!mim.convex_index().is_in(cv)) return scalar_type(0);
+          pintegration_method pimc = mim.int_method_of_element(cv);
+          if (pimc->type() != IM_APPROX) return scalar_type(0);
+          papprox_integration paic = pimc->approx_method();
+          size_type nbpt = (f == short_type(-1)) ? paic->nb_points_on_convex()
+                                                 : paic->nb_points_on_face(f);
+          size_type nbdof = 1;
+          for (const auto &pfp : pfps)
+            if (pfp.first->convex_index().is_in(cv))
+              nbdof += pfp.first->nb_basic_dof_of_element(cv);
+          return scalar_type(nbpt * nbdof);
+        };
+        for (getfem::mr_visitor v(region, m, true, cost); !v.finished(); ++v){
           if (mim.convex_index().is_in(v.cv())) {
             // cout << "proceed with elt " << v.cv() << " face " << v.f()<<endl;
             if (v.cv() != old_cv) {
@@ -8831,39 +9619,47 @@ namespace getfem {
               } else {
                 gis.nbpt = pai->nb_points_on_convex();
               }
-              for (gis.ipt = 0; gis.ipt < gis.nbpt; ++(gis.ipt)) {
-                if (pgp) gis.ctx.set_ii(first_ind+gis.ipt);
-                else gis.ctx.set_xref((*pspt)[first_ind+gis.ipt]);
-                if (gis.ipt == 0 || !(pgt->is_linear())) {
-                  J1 = gis.ctx.J();
-                  // Computation of unit normal vector in case of a boundary
-                  if (v.f() != short_type(-1)) {
-                    gis.Normal.resize(G1.nrows());
-                    un.resize(pgt->dim());
-                    gmm::copy(pgt->normals()[v.f()], un);
-                    gmm::mult(gis.ctx.B(), un, gis.Normal);
-                    scalar_type nup = gmm::vect_norm2(gis.Normal);
-                    J1 *= nup;
-                    gmm::scale(gis.Normal, 1.0/nup);
-                    gmm::clean(gis.Normal, 1e-13);
-                  } else gis.Normal.resize(0);
-                }
-                auto ipt_coeff = pai->coeff(first_ind+gis.ipt);
-                gis.coeff = J1 * ipt_coeff;
-                bool enable_ipt = (gmm::abs(ipt_coeff) > 0.0 ||
-                                   workspace.include_empty_int_points());
-                if (!enable_ipt) gis.coeff = scalar_type(0);
-                if (first_gp) {
-                  for (size_type j=0; j < gilb.size(); ++j) j+=gilb[j]->exec();
-                  first_gp = false;
-                }
-                if (gis.ipt == 0) {
-                  for (size_type j=0; j < gile.size(); ++j) j+=gile[j]->exec();
-                }
-                if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
-                  for (size_type j=0; j < gil.size(); ++j) j+=gil[j]->exec();
+              ++nb_elements; nb_gauss_points += gis.nbpt;
+              // One sweep per level of batched operators, then the normal one
+              for (size_type sweep = 1; sweep <= nb_sweeps; ++sweep) {
+                gis.batch_sweep = (sweep < nb_sweeps) ? sweep : 0;
+                for (gis.ipt = 0; gis.ipt < gis.nbpt; ++(gis.ipt)) {
+                  if (pgp) gis.ctx.set_ii(first_ind+gis.ipt);
+                  else gis.ctx.set_xref((*pspt)[first_ind+gis.ipt]);
+                  if (gis.ipt == 0 || !(pgt->is_linear())) {
+                    J1 = gis.ctx.J();
+                    // Computation of unit normal vector in case of a boundary
+                    if (v.f() != short_type(-1)) {
+                      gis.Normal.resize(G1.nrows());
+                      un.resize(pgt->dim());
+                      gmm::copy(pgt->normals()[v.f()], un);
+                      gmm::mult(gis.ctx.B(), un, gis.Normal);
+                      scalar_type nup = gmm::vect_norm2(gis.Normal);
+                      J1 *= nup;
+                      gmm::scale(gis.Normal, 1.0/nup);
+                      gmm::clean(gis.Normal, 1e-13);
+                    } else gis.Normal.resize(0);
+                  }
+                  auto ipt_coeff = pai->coeff(first_ind+gis.ipt);
+                  gis.coeff = J1 * ipt_coeff;
+                  bool enable_ipt = (gmm::abs(ipt_coeff) > 0.0 ||
+                                     workspace.include_empty_int_points());
+                  if (!enable_ipt) gis.coeff = scalar_type(0);
+                  if (first_gp) {
+                    ga_exec_instructions(gilb, profb);
+                    first_gp = false;
+                  }
+                  if (gis.ipt == 0)
+                    ga_exec_instructions(gile, profe);
+                  if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
+                    if (gis.batch_sweep)
+                      ga_exec_batch_sweep(gil, batch_ends[sweep-1],
+                                          batch_skip);
+                    else
+                      ga_exec_instructions(gil, prof);
+                  }
+                  GA_DEBUG_INFO("");
                 }
-                GA_DEBUG_INFO("");
               }
             }
           }
@@ -8973,6 +9769,7 @@ namespace getfem {
                     nbpt2 = gis.nbpt = pai2->nb_points_on_convex();
                   }
                   gis.nbpt = nbpt1 * nbpt2;
+                  ++nb_elements; nb_gauss_points += gis.nbpt;
                   gis.ipt = 0;
                   for (size_type ipt1=0; ipt1 < nbpt1; ++ipt1) {
                     for (size_type ipt2=0; ipt2 < nbpt2; ++ipt2, ++(gis.ipt)) {
@@ -9018,18 +9815,13 @@ namespace getfem {
                       if (!enable_ipt) gis.coeff = scalar_type(0);
 
                       if (first_gp) {
-                        for (size_type j=0; j < gilb.size(); ++j)
-                          j+=gilb[j]->exec();
+                        ga_exec_instructions(gilb, profb);
                         first_gp = false;
                       }
-                      if (gis.ipt == 0) {
-                        for (size_type j=0; j < gile.size(); ++j)
-                          j+=gile[j]->exec();
-                      }
-                      if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
-                        for (size_type j=0; j < gil.size(); ++j)
-                          j+=gil[j]->exec();
-                      }
+                      if (gis.ipt == 0)
+                        ga_exec_instructions(gile, profe);
+                      if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1)
+                        ga_exec_instructions(gil, prof);
                       GA_DEBUG_INFO("");
                     }
                   }
@@ -9041,6 +9833,27 @@ namespace getfem {
         GA_DEBUG_INFO("-----------------------------");
       }
 
+      if (profile) {
+        const auto &rmi = instr.second;
+        profile->nb_elements += nb_elements;
+        profile->nb_gauss_points += nb_gauss_points;
+        ga_add_to_profile(*profile, gis, gilb, rmi.begin_instructions_expr,
+                          counters_b);
+        ga_add_to_profile(*profile, gis, gile, rmi.elt_instructions_expr,
+                          counters_e);
+        ga_add_to_profile(*profile, gis, gil, rmi.instructions_expr, counters);
+        std::set<size_type> expr_ind(rmi.instructions_expr.begin(),
+                                     rmi.instructions_expr.end());
+        expr_ind.insert(rmi.elt_instructions_expr.begin(),
+                        rmi.elt_instructions_expr.end());
+        expr_ind.insert(rmi.begin_instructions_expr.begin(),
+                        rmi.begin_instructions_expr.end());
+        for (size_type i : expr_ind) {
+          auto &ep = profile->expressions[gis.expressions[i]];
+          ep.nb_elements += nb_elements;
+          ep.nb_gauss_points += nb_gauss_points;
+        }
+      }
     }
 
     for (const std::string &t : gis.transformations)
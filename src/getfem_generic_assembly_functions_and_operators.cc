@@ -174,6 +174,56 @@ namespace getfem {
   // Structure dealing with predefined operators.
   //=========================================================================
 
+  // Default batched evaluation: the points are extracted one by one.
+  static void ga_operator_point_by_point
+  (const ga_nonlinear_operator::arg_list &args, size_type nbpt,
+   base_tensor &result,
+   const std::function<void(const ga_nonlinear_operator::arg_list &,
+                            base_tensor &)> &f) {
+    std::vector<base_tensor> pargs(args.size());
+    ga_nonlinear_operator::arg_list ppargs(args.size());
+    for (size_type k = 0; k < args.size(); ++k) {
+      bgeot::multi_index mi = args[k]->sizes(); mi.pop_back();
+      pargs[k].adjust_sizes(mi);
+      ppargs[k] = &(pargs[k]);
+    }
+    bgeot::multi_index mi = result.sizes(); mi.pop_back();
+    base_tensor presult(mi);
+    size_type s = presult.size();
+    for (size_type p = 0; p < nbpt; ++p) {
+      for (size_type k = 0; k < args.size(); ++k) {
+        size_type sa = pargs[k].size();
+        auto it = args[k]->begin() + p*sa;
+        std::copy(it, it + sa, pargs[k].begin());
+      }
+      f(ppargs, presult);
+      std::copy(presult.begin(), presult.end(), result.begin() + p*s);
+    }
+  }
+
+  void ga_nonlinear_operator::batched_value
+  (const arg_list &args, size_type nbpt, base_tensor &result) const {
+    ga_operator_point_by_point
+      (args, nbpt, result, [this](const arg_list &a, base_tensor &r)
+       { value(a, r); });
+  }
+
+  void ga_nonlinear_operator::batched_derivative
+  (const arg_list &args, size_type i, size_type nbpt,
+   base_tensor &result) const {
+    ga_operator_point_by_point
+      (args, nbpt, result, [this, i](const arg_list &a, base_tensor &r)
+       { derivative(a, i, r); });
+  }
+
+  void ga_nonlinear_operator::batched_second_derivative
+  (const arg_list &args, size_type i, size_type j, size_type nbpt,
+   base_tensor &result) const {
+    ga_operator_point_by_point
+      (args, nbpt, result, [this, i, j](const arg_list &a, base_tensor &r)
+       { second_derivative(a, i, j, r); });
+  }
+
   static void ga_init_scalar(bgeot::multi_index &mi) { mi.resize(0); }
   static void ga_init_square_matrix(bgeot::multi_index &mi, size_type N)
   { mi.resize(2); mi[0] = mi[1] = N; }
@@ -38,15 +38,74 @@ namespace getfem {
     ga_interpolation_exec(gis, workspace, gic);
   }
 
+  // Context of a thread in a parallel interpolation. Forwards everything
+  // to the shared context, which is finalized once all the threads are
+  // done.
+  struct ga_interpolation_context_thread : public ga_interpolation_context {
+    ga_interpolation_context &gic;
+
+    virtual bgeot::pstored_point_tab
+    ppoints_for_element(size_type cv, short_type f,
+                        std::vector<size_type> &ind) const
+    { return gic.ppoints_for_element(cv, f, ind); }
+    virtual bool use_pgp(size_type cv) const { return gic.use_pgp(cv); }
+    virtual bool use_mim() const { return gic.use_mim(); }
+    virtual void store_result(size_type cv, size_type i, base_tensor &t)
+    { gic.store_result(cv, i, t); }
+    virtual void finalize() {}
+    virtual const mesh &linked_mesh() { return gic.linked_mesh(); }
+
+    ga_interpolation_context_thread(ga_interpolation_context &gic_)
+      : gic(gic_) {}
+  };
+
+  // Interpolation of an expression of a model. The elements of the region
+  // are distributed among the threads, each one having its own workspace
+  // and instruction set. The context has to support concurrent calls of
+  // store_result, the column locks given being allocated only for a
+  // parallel interpolation. Expressions using interpolate transformations,
+  // which keep some state between the points, are interpolated serially.
+  template <typename MESH_OR_MIM>
+  static void ga_interpolation_parallel
+  (const getfem::model &md, const std::string &expr, const MESH_OR_MIM &mm,
+   const mesh_region &rg, ga_interpolation_context &gic,
+   std::unique_ptr<column_locks> *locks = nullptr) {
+    // The first compilation is used serially or by the first thread.
+    ga_workspace workspace(md);
+    workspace.add_interpolation_expression(expr, mm, rg);
+    ga_instruction_set gis;
+    ga_compile_interpolation(workspace, gis);
+    if (not_multithreaded() || !gis.transformations.empty()) {
+      ga_interpolation_exec(gis, workspace, gic);
+      return;
+    }
+    if (locks) locks->reset(new column_locks());
+    GETFEM_OMP_PARALLEL(
+      ga_interpolation_context_thread gict(gic);
+      if (true_thread_policy::this_thread() == 0)
+        ga_interpolation_exec(gis, workspace, gict);
+      else {
+        ga_workspace workspace_t(md);
+        workspace_t.add_interpolation_expression(expr, mm, rg);
+        ga_instruction_set gis_t;
+        ga_compile_interpolation(workspace_t, gis_t);
+        ga_interpolation_exec(gis_t, workspace_t, gict);
+      }
+    )
+    gic.finalize();
+  }
+
   // Interpolation on a Lagrange fem on the same mesh
   struct ga_interpolation_context_fem_same_mesh
     : public ga_interpolation_context {
     base_vector &result;
     std::vector<int> dof_count;
     const mesh_fem &mf;
-    bool initialized;
+    std::atomic_bool initialized;
     bool is_torus;
     size_type s;
+    // protect the dofs from concurrent accumulations (parallel interpolation)
+    std::unique_ptr<column_locks> locks;
 
     virtual bgeot::pstored_point_tab
     ppoints_for_element(size_type cv, short_type f,
@@ -86,8 +145,12 @@ namespace getfem {
       GMM_ASSERT2(target_dim == 3, "Invalid torus fem.");
       size_type qdim = 1;
       size_type result_dim = 2;
-      if (!initialized) {init_(qdim, qdim, qdim);}
+      if (!initialized) {
+        all_columns_guard g(locks.get());
+        if (!initialized) init_(qdim, qdim, qdim);
+      }
       size_type idof = mf.ind_basic_dof_of_element(cv)[i];
+      column_guard g(locks.get(), idof);
       result[idof] = t[idof%result_dim];
       ++dof_count[idof];
     }
@@ -102,9 +165,13 @@ namespace getfem {
       size_type qmult = si / q;
       GMM_ASSERT1( (si % q) == 0, "Incompatibility between the mesh_fem and "
                    "the size of the expression to be interpolated");
-      if (!initialized) { init_(si, q, qmult); }
+      if (!initialized) {
+        all_columns_guard g(locks.get());
+        if (!initialized) init_(si, q, qmult);
+      }
       GMM_ASSERT1(s == si, "Internal error");
       size_type idof = mf.ind_basic_dof_of_element(cv)[i*q];
+      column_guard g(locks.get(), idof/q);
       gmm::add(t.as_vector(),
                gmm::sub_vector(result, gmm::sub_interval(qmult*idof, s)));
       (dof_count[idof/q])++;
@@ -159,9 +226,9 @@ namespace getfem {
   void ga_interpolation_Lagrange_fem
   (const getfem::model &md, const std::string &expr, const mesh_fem &mf,
    base_vector &result, const mesh_region &rg) {
-    ga_workspace workspace(md);
-    workspace.add_interpolation_expression(expr, mf.linked_mesh(), rg);
-    ga_interpolation_Lagrange_fem(workspace, mf, result);
+    ga_interpolation_context_fem_same_mesh gic(mf, result);
+    ga_interpolation_parallel(md, expr, mf.linked_mesh(), rg, gic,
+                              &(gic.locks));
   }
 
   // Interpolation on a cloud of points
@@ -251,8 +318,9 @@ namespace getfem {
     : public ga_interpolation_context {
     base_vector &result;
     const im_data &imd;
-    bool initialized;
+    std::atomic_bool initialized;
     size_type s;
+    column_locks init_lock;
 
     virtual bgeot::pstored_point_tab
     ppoints_for_element(size_type cv, short_type f,
@@ -281,20 +349,27 @@ namespace getfem {
     }
     virtual bool use_mim() const { return true; }
 
+    void init_(const base_tensor &t) {
+      s = t.size();
+      GMM_ASSERT1(imd.tensor_size() == t.sizes() ||
+                  (imd.tensor_size().size() == size_type(1) &&
+                   imd.tensor_size()[0] == size_type(1) &&
+                   s == size_type(1)),
+                  "Im_data tensor size " << imd.tensor_size() <<
+                  " does not match the size of the interpolated "
+                  "expression " << t.sizes() << ".");
+      gmm::resize(result, s * imd.nb_filtered_index());
+      gmm::clear(result);
+      initialized = true;
+    }
+
+    // Each point is stored by a single thread, only the initialization
+    // has to be protected.
     virtual void store_result(size_type cv, size_type i, base_tensor &t) {
       size_type si = t.size();
       if (!initialized) {
-        s = si;
-        GMM_ASSERT1(imd.tensor_size() == t.sizes() ||
-                    (imd.tensor_size().size() == size_type(1) &&
-                     imd.tensor_size()[0] == size_type(1) &&
-                     si == size_type(1)),
-                    "Im_data tensor size " << imd.tensor_size() <<
-                    " does not match the size of the interpolated "
-                    "expression " << t.sizes() << ".");
-        gmm::resize(result, s * imd.nb_filtered_index());
-        gmm::clear(result);
-        initialized = true;
+        all_columns_guard g(&init_lock);
+        if (!initialized) init_(t);
       }
       GMM_ASSERT1(s == si, "Internal error");
       size_type ipt = imd.filtered_index_of_point(cv, i);
@@ -325,7 +400,7 @@ namespace getfem {
     virtual const mesh &linked_mesh() { return imd.linked_mesh(); }
 
     ga_interpolation_context_im_data(const im_data &imd_, base_vector &r)
-      : result(r), imd(imd_), initialized(false) { }
+      : result(r), imd(imd_), initialized(false), init_lock(1) { }
   };
 
   void ga_interpolation_im_data
@@ -337,11 +412,8 @@ namespace getfem {
   void ga_interpolation_im_data
   (const getfem::model &md, const std::string &expr, const im_data &imd,
    base_vector &result, const mesh_region &rg) {
-    ga_workspace workspace(md);
-    workspace.add_interpolation_expression
-      (expr, imd.linked_mesh_im(), rg);
-
-    ga_interpolation_im_data(workspace, imd, result);
+    ga_interpolation_context_im_data gic(imd, result);
+    ga_interpolation_parallel(md, expr, imd.linked_mesh_im(), rg, gic);
   }
 
 
@@ -350,9 +422,10 @@ namespace getfem {
     : public ga_interpolation_context {
     base_vector &result;
     const stored_mesh_slice &sl;
-    bool initialized;
+    std::atomic_bool initialized;
     size_type s;
     std::vector<size_type> first_node;
+    column_locks init_lock;
 
     virtual bgeot::pstored_point_tab
     ppoints_for_element(size_type cv, short_type f,
@@ -372,16 +445,23 @@ namespace getfem {
     virtual bool use_pgp(size_type /* cv */) const { return false; } // why not?
     virtual bool use_mim() const { return false; }
 
+    void init_(size_type si) {
+      s = si;
+      gmm::resize(result, s * sl.nb_points());
+      gmm::clear(result);
+      first_node.resize(sl.nb_convex());
+      for (size_type ic=0; ic < sl.nb_convex()-1; ++ic)
+        first_node[ic+1] = first_node[ic] + sl.nodes(ic).size();
+      initialized = true;
+    }
+
+    // Each point is stored by a single thread, only the initialization
+    // has to be protected.
     virtual void store_result(size_type cv, size_type i, base_tensor &t) {
       size_type si = t.size();
       if (!initialized) {
-        s = si;
-        gmm::resize(result, s * sl.nb_points());
-        gmm::clear(result);
-        initialized = true;
-        first_node.resize(sl.nb_convex());
-        for (size_type ic=0; ic < sl.nb_convex()-1; ++ic)
-          first_node[ic+1] = first_node[ic] + sl.nodes(ic).size();
+        all_columns_guard g(&init_lock);
+        if (!initialized) init_(si);
       }
       GMM_ASSERT1(s == si && result.size() == s * sl.nb_points(), "Internal error");
       size_type ic = sl.convex_pos(cv);
@@ -412,7 +492,7 @@ namespace getfem {
 
     ga_interpolation_context_mesh_slice(const stored_mesh_slice &sl_,
                                         base_vector &r)
-      : result(r), sl(sl_), initialized(false) { }
+      : result(r), sl(sl_), initialized(false), init_lock(1) { }
   };
 
   void ga_interpolation_mesh_slice
@@ -424,9 +504,8 @@ namespace getfem {
   void ga_interpolation_mesh_slice
   (const getfem::model &md, const std::string &expr, const stored_mesh_slice &sl,
    base_vector &result, const mesh_region &rg) {
-    ga_workspace workspace(md);
-    workspace.add_interpolation_expression(expr, sl.linked_mesh(), rg);
-    ga_interpolation_mesh_slice(workspace, sl, result);
+    ga_interpolation_context_mesh_slice gic(sl, result);
+    ga_interpolation_parallel(md, expr, sl.linked_mesh(), rg, gic);
   }
 
 
@@ -479,16 +558,6 @@ namespace getfem {
   // Interpolate transformation with an expression
   //=========================================================================
 
-  struct rated_box_index_compare {
-    bool operator()(
-      const std::pair<scalar_type, const bgeot::box_index*> &x,
-      const std::pair<scalar_type, const bgeot::box_index*> &y) const {
-      GMM_ASSERT2(x.second != nullptr, "x contains nullptr");
-      GMM_ASSERT2(y.second != nullptr, "y contains nullptr");
-      return (x.first < y.first) || (!(y.first < x.first) && (x.second->id < y.second->id));
-    }
-  };
-
   class interpolate_transformation_expression
     : public virtual_interpolate_transformation, public context_dependencies {
 
@@ -501,12 +570,19 @@ namespace getfem {
     const mesh &target_mesh;
     const size_type target_region;
     std::string expr;
-    mutable bgeot::rtree element_boxes;
+    mutable bgeot::flat_rtree element_boxes;
     mutable bool recompute_elt_boxes;
     mutable ga_workspace local_workspace;
     mutable ga_instruction_set local_gis;
-    mutable bgeot::geotrans_inv_convex gic;
+    // Inversions of the last convexes tried, reused for the next points
+    enum { NB_CACHED_GIC = 8 };
+    mutable std::vector<bgeot::geotrans_inv_convex> gics;
+    mutable std::vector<size_type> gics_cv;
+    mutable size_type next_gic;
+    mutable size_type last_cv; // convex of the previous located point
     mutable base_node P;
+    mutable std::vector<size_type> boxids, tried_cv;
+    mutable std::vector<std::pair<scalar_type, size_type>> rated_boxes;
     mutable std::set<var_trans_pair> used_vars;
     mutable std::set<var_trans_pair> used_data;
     mutable std::map<var_trans_pair,
@@ -515,7 +591,36 @@ namespace getfem {
     mutable bool extract_data_done;
 
   private:
-    mutable std::map<size_type, std::vector<size_type>> box_to_convexes;
+    mutable std::vector<size_type> box_to_convex;
+
+    // Try to locate P in a convex of the target mesh. Return 1 if P is
+    // inside, otherwise keep track of the nearest converged inversion.
+    int invert_in_convex(size_type convex, size_type &cv, base_node &P_ref,
+                         scalar_type &best_dist, size_type &best_cv,
+                         base_node &best_P_ref) const {
+      size_type i = 0;
+      while (i < NB_CACHED_GIC && gics_cv[i] != convex) ++i;
+      if (i == NB_CACHED_GIC) {
+        i = next_gic; next_gic = (next_gic + 1) % NB_CACHED_GIC;
+        gics[i].init(target_mesh.points_of_convex(convex),
+                     target_mesh.trans_of_convex(convex));
+        gics_cv[i] = convex;
+      }
+      bool converged;
+      bool is_in = gics[i].invert(P, P_ref, converged, 1E-4);
+      if (converged) {
+        cv = convex;
+        if (is_in) return 1;
+        scalar_type dist
+          = target_mesh.trans_of_convex(cv)->convex_ref()->is_in(P_ref);
+        if (dist < best_dist) {
+          best_dist = dist;
+          best_cv = cv;
+          best_P_ref = P_ref;
+        }
+      }
+      return 0;
+    }
 
   public:
     void update_from_context() const {
@@ -587,10 +692,13 @@ namespace getfem {
         }
       }
 
+      std::fill(gics_cv.begin(), gics_cv.end(), size_type(-1));
+      last_cv = size_type(-1);
+
       // Element_boxes update (if necessary)
       if (recompute_elt_boxes) {
 
-        box_to_convexes.clear();
+        box_to_convex.clear();
         element_boxes.clear();
         base_node bmin(N), bmax(N);
         const mesh_region &mr = target_mesh.region(target_region);
@@ -625,7 +733,8 @@ namespace getfem {
           for (auto &&val : bmin) val -= h*0.2;
           for (auto &&val : bmax) val += h*0.2;
 
-          box_to_convexes[element_boxes.add_box(bmin, bmax)].push_back(cv);
+          element_boxes.add_box(bmin, bmax);
+          box_to_convex.push_back(cv);
         }
         element_boxes.build_tree();
         recompute_elt_boxes = false;
@@ -676,67 +785,54 @@ namespace getfem {
 
       *m_t = &target_mesh;
 
-      bgeot::rtree::pbox_cont boxes;
-      {
-        bgeot::rtree::pbox_set bset;
-        element_boxes.find_boxes_at_point(P, bset);
+      scalar_type best_dist(1e10);
+      size_type best_cv(-1);
+      base_node best_P_ref;
+
+      // Consecutive points (Gauss points of the same element for instance)
+      // are often located in the last convex found or in one of the
+      // recently visited ones, whose inversions are already initialized.
+      // They are tried first.
+      tried_cv.resize(0);
+      if (last_cv != size_type(-1)) {
+        ret_type = invert_in_convex(last_cv, cv, P_ref,
+                                    best_dist, best_cv, best_P_ref);
+        tried_cv.push_back(last_cv);
+        for (size_type k = 0; k < NB_CACHED_GIC && !ret_type; ++k)
+          if (gics_cv[k] != size_type(-1) && gics_cv[k] != last_cv) {
+            tried_cv.push_back(gics_cv[k]);
+            ret_type = invert_in_convex(gics_cv[k], cv, P_ref,
+                                        best_dist, best_cv, best_P_ref);
+          }
+      }
 
-        // using a std::set as a sorter
-        std::set<std::pair<scalar_type, const bgeot::box_index*>,
-                 rated_box_index_compare> rated_boxes;
-        for (const auto &box : bset) {
+      if (!ret_type) {
+        element_boxes.find_boxes_at_point(P, boxids);
+        rated_boxes.resize(0);
+        for (size_type ib : boxids) {
+          const scalar_type *bmin = element_boxes.min_of_box(ib);
+          const scalar_type *bmax = element_boxes.max_of_box(ib);
           scalar_type rating = scalar_type(1);
           for (size_type i = 0; i < m.dim(); ++i) {
-            scalar_type h = box->max->at(i) - box->min->at(i);
+            scalar_type h = bmax[i] - bmin[i];
             if (h > scalar_type(0)) {
-              scalar_type r = std::min(box->max->at(i) - P[i],
-                                       P[i] - box->min->at(i)) / h;
+              scalar_type r = std::min(bmax[i] - P[i], P[i] - bmin[i]) / h;
               rating = std::min(r, rating);
             }
           }
-          rated_boxes.insert(std::make_pair(rating, box));
+          rated_boxes.push_back(std::make_pair(rating, ib));
         }
-
-        // boxes should now be ordered in increasing rating order
-        for (const auto &p : rated_boxes)
-          boxes.push_back(p.second);
-      }
-
-
-      scalar_type best_dist(1e10);
-      size_type best_cv(-1);
-      base_node best_P_ref;
-      for (size_type i = boxes.size(); i > 0 && !ret_type; --i) {
-        for (auto convex : box_to_convexes.at(boxes[i-1]->id)) {
-          gic.init(target_mesh.points_of_convex(convex),
-                   target_mesh.trans_of_convex(convex));
-
-          bool converged;
-          bool is_in = gic.invert(P, P_ref, converged, 1E-4);
-          // cout << "cv = " << convex << " P = " << P << " P_ref = " << P_ref;
-          // cout << " is_in = " << int(is_in) << endl;
-          // for (size_type iii = 0;
-          //     iii < target_mesh.points_of_convex(cv).size(); ++iii)
-          //  cout << target_mesh.points_of_convex(cv)[iii] << endl;
-
-          if (converged) {
-            cv = convex;
-            if (is_in) {
-              face_num = short_type(-1); // Should detect potential faces ?
-              ret_type = 1;
-              break;
-            } else {
-              scalar_type dist
-                = target_mesh.trans_of_convex(cv)->convex_ref()->is_in(P_ref);
-              if (dist < best_dist) {
-                best_dist = dist;
-                best_cv = cv;
-                best_P_ref = P_ref;
-              }
-            }
-          }
+        // boxes are tried in decreasing rating order
+        std::sort(rated_boxes.begin(), rated_boxes.end());
+        for (size_type i = rated_boxes.size(); i > 0 && !ret_type; --i) {
+          size_type icv = box_to_convex[rated_boxes[i-1].second];
+          if (std::find(tried_cv.begin(), tried_cv.end(), icv)
+              == tried_cv.end())
+            ret_type = invert_in_convex(icv, cv, P_ref,
+                                        best_dist, best_cv, best_P_ref);
         }
       }
+      if (ret_type) face_num = short_type(-1); // Should detect potential faces ?
 
       if (ret_type == 0 && best_dist < 5e-3) {
         cv = best_cv;
@@ -744,6 +840,7 @@ namespace getfem {
         face_num = short_type(-1); // Should detect potential faces ?
         ret_type = 1;
       }
+      if (ret_type) last_cv = cv;
 
       // Note on derivatives of the transformation : for efficiency and
       // simplicity reasons, the derivative should be computed with
@@ -765,8 +862,9 @@ namespace getfem {
     interpolate_transformation_expression
     (const mesh &sm, const mesh &tm, size_type trg, const std::string &expr_)
       : source_mesh(sm), target_mesh(tm), target_region(trg), expr(expr_),
-        recompute_elt_boxes(true), extract_variable_done(false),
-        extract_data_done(false)
+        recompute_elt_boxes(true), gics(NB_CACHED_GIC),
+        gics_cv(NB_CACHED_GIC, size_type(-1)), next_gic(0), last_cv(-1),
+        extract_variable_done(false), extract_data_done(false)
     { this->add_dependency(tm); }
 
   };
@@ -0,0 +1,382 @@
+/*===========================================================================
+
+ Copyright (C) 2020 Yves Renard
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+===========================================================================*/
+
+/* Native code backend of the generic assembly: the sequences of instructions
+   executed on each integration point which are supported (see
+   ga_instruction::emit) are translated into C++ with the sizes of the
+   tensors as constants, compiled with the system compiler and loaded with
+   dlopen. */
+
+#include "getfem/getfem_generic_assembly_compile_and_exec.h"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+
+#if defined(GETFEM_HAVE_DLOPEN)
+# include <dlfcn.h>
+# include <sys/stat.h>
+# include <sys/utsname.h>
+# include <unistd.h>
+# include <cstdio>
+#endif
+
+namespace getfem {
+
+  //=========================================================================
+  // Options of the native code backend
+  //=========================================================================
+
+  // The default cache is private to the user: the kernels found in it are
+  // loaded in the process.
+  static std::string ga_default_native_code_cache() {
+    const char *xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/getfem_native_code";
+    const char *home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/getfem_native_code";
+#if defined(GETFEM_HAVE_DLOPEN)
+    return "/tmp/getfem_native_code-" + std::to_string(getuid());
+#else
+    return "/tmp/getfem_native_code";
+#endif
+  }
+
+  struct ga_native_code_options {
+    bool enabled;
+    std::string compiler, cache;
+    size_type nb_loaded;
+    ga_native_code_options()
+      : enabled(false), compiler("c++ -O3 -march=native -fPIC -shared"),
+        cache(ga_default_native_code_cache()), nb_loaded(0) {}
+  };
+
+  static ga_native_code_options &native_code_options() {
+    static ga_native_code_options options;
+    return options;
+  }
+
+  void ga_enable_native_code(bool enable) {
+#if defined(GETFEM_HAVE_DLOPEN)
+    native_code_options().enabled = enable;
+#else
+    if (enable)
+      GMM_WARNING1("GetFEM has been built without dlopen support, the "
+                   "native code backend is not available");
+#endif
+  }
+
+  bool ga_native_code_enabled() { return native_code_options().enabled; }
+
+  void ga_set_native_code_compiler(const std::string &command)
+  { native_code_options().compiler = command; }
+
+  void ga_set_native_code_cache(const std::string &directory)
+  { native_code_options().cache = directory; }
+
+  size_type ga_nb_native_code_kernels()
+  { return native_code_options().nb_loaded; }
+
+  //=========================================================================
+  // Source of the kernels
+  //=========================================================================
+
+  std::string ga_native_code::add_operand(const void *key, const operand &o) {
+    auto it = names.find(key);
+    if (it != names.end()) return it->second;
+    std::string name = o.kind + std::to_string(operands.size());
+    operands.push_back(o);
+    names[key] = name;
+    return name;
+  }
+
+  std::string ga_native_code::tensor(const base_tensor &t)
+  { return add_operand(&t, operand{'T', &t, nullptr, nullptr}); }
+
+  std::string ga_native_code::vector(const base_vector &v)
+  { return add_operand(&v, operand{'V', nullptr, &v, nullptr}); }
+
+  std::string ga_native_code::scalar(const scalar_type &s) {
+    void *p = const_cast<scalar_type *>(&s);
+    return "(*" + add_operand(p, operand{'S', nullptr, nullptr, p}) + ")";
+  }
+
+  std::string ga_native_code::function(pscalar_func_onearg f) {
+    void *p = reinterpret_cast<void *>(f);
+    return add_operand(p, operand{'F', nullptr, nullptr, p});
+  }
+
+  std::string ga_native_code::source() const {
+    std::stringstream s;
+    s << "// Generated by GetFEM\n"
+      << "extern \"C\" void ga_native_kernel(void *const *a) {\n";
+    for (size_type i = 0; i < operands.size(); ++i)
+      if (operands[i].kind == 'F')
+        s << "double (*const F" << i << ")(double) = (double (*)(double))(a["
+          << i << "]);\n";
+      else
+        s << "double *const " << operands[i].kind << i << " = (double *)(a["
+          << i << "]);\n";
+    s << body.str() << "}\n";
+    return s.str();
+  }
+
+  //=========================================================================
+  // Compilation and loading of the kernels
+  //=========================================================================
+
+  typedef void (*ga_native_kernel)(void *const *);
+
+#if defined(GETFEM_HAVE_DLOPEN)
+  // Directory or file belonging to the user and not writable by others
+  // (symbolic links are refused).
+  static bool ga_native_code_is_private(const std::string &path, bool dir) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) return false;
+    if (dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) return false;
+    return st.st_uid == getuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+  }
+
+  // Creates the directory (and its parents) with mode 0700 if needed.
+  static void ga_native_code_mkdir(const std::string &path) {
+    for (size_type i = path.find('/', 1); i != std::string::npos;
+         i = path.find('/', i+1))
+      mkdir(path.substr(0, i).c_str(), 0700);
+    mkdir(path.c_str(), 0700);
+  }
+
+  static std::string ga_shell_quote(const std::string &st) {
+    std::string r("'");
+    for (char c : st)
+      if (c == '\'') r += "'\\''"; else r += c;
+    return r + "'";
+  }
+
+  // Identity of the processor the kernels are compiled for: the machine
+  // name and, on Linux, the model and the instruction set extensions. It is
+  // part of the hashed text, so that a cache shared by several hosts (home
+  // directory on NFS) never gives a kernel built with -march=native for
+  // another processor.
+  static std::string ga_native_code_host() {
+    std::string host;
+    struct utsname u;
+    if (uname(&u) == 0) host = u.machine;
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, model, flags;
+    while (std::getline(cpuinfo, line) && line.size()) {
+      std::string key = line.substr(0, line.find(':'));
+      key.erase(key.find_last_not_of(" \t") + 1);
+      if (key == "model name" || key == "CPU implementer"
+          || key == "CPU part")
+        model += line.substr(line.find(':') + 1);
+      else if (key == "flags" || key == "Features")
+        flags = line.substr(line.find(':') + 1);
+    }
+    return host + model + " " + flags;
+  }
+
+  // New file with a unique name built from prefix and suffix.
+  static std::string ga_native_code_temp_file(const std::string &prefix,
+                                              const std::string &suffix) {
+    std::string name = prefix + "_XXXXXX" + suffix;
+    std::vector<char> buf(name.begin(), name.end());
+    buf.push_back(0);
+    int fd = mkstemps(buf.data(), int(suffix.size()));
+    if (fd < 0) return std::string();
+    close(fd);
+    return std::string(buf.data());
+  }
+#endif
+
+  // Returns the kernel compiled from source, or nullptr if it cannot be
+  // built. The shared objects are kept in the cache directory under a name
+  // given by the hash of the source, of the compiler command and of the
+  // processor (see ga_native_code_host), which are stored beside for
+  // checking. The cache directory and its files have to belong to the user
+  // and not be writable by others, nothing is loaded otherwise.
+  static ga_native_kernel ga_load_native_kernel(const std::string &source) {
+#if defined(GETFEM_HAVE_DLOPEN)
+    static lock_factory locks;
+    static std::map<std::string, ga_native_kernel> kernels;
+    static size_type nb_failures = 0;
+    auto guard = locks.get_lock();
+
+    auto it = kernels.find(source);
+    if (it != kernels.end()) return it->second;
+    ga_native_kernel &kernel = kernels[source];
+    kernel = nullptr;
+    if (nb_failures >= 3) return kernel; // the compiler does not work
+
+    ga_native_code_options &options = native_code_options();
+    ga_native_code_mkdir(options.cache);
+    if (!ga_native_code_is_private(options.cache, true)) {
+      nb_failures = 3;
+      GMM_WARNING1("Native code cache " << options.cache << " is not a "
+                   "directory private to the user, the instructions are "
+                   "interpreted");
+      return kernel;
+    }
+    static const std::string host = ga_native_code_host();
+    std::string text = "// " + options.compiler + "\n// " + host + "\n"
+      + source;
+    std::stringstream name;
+    name << options.cache << "/ga_kernel_" << std::hex
+         << std::hash<std::string>()(text);
+    std::string src_file = name.str() + ".cc", obj_file = name.str() + ".so";
+
+    bool exists = ga_native_code_is_private(src_file, false);
+    std::stringstream previous;
+    if (exists) previous << std::ifstream(src_file).rdbuf();
+    if (exists && previous.str() != text) { // Hash collision, kept interpreted
+      GMM_WARNING1("Native code kernel " << obj_file << " conflicts with "
+                   "another one, the instructions are interpreted");
+      return kernel;
+    }
+    bool compiled = exists && ga_native_code_is_private(obj_file, false);
+    if (!compiled) {
+      std::string tmp_src = ga_native_code_temp_file(name.str(), ".cc");
+      std::string tmp_obj = ga_native_code_temp_file(name.str(), ".so");
+      if (tmp_src.size() && tmp_obj.size()) {
+        std::ofstream(tmp_src) << text;
+        std::string command = options.compiler + " -o "
+          + ga_shell_quote(tmp_obj) + " " + ga_shell_quote(tmp_src);
+        compiled = std::system(command.c_str()) == 0
+          && chmod(tmp_src.c_str(), 0600) == 0
+          && chmod(tmp_obj.c_str(), 0700) == 0
+          && std::rename(tmp_src.c_str(), src_file.c_str()) == 0
+          && std::rename(tmp_obj.c_str(), obj_file.c_str()) == 0;
+      }
+      if (!compiled) {
+        if (tmp_src.size()) std::remove(tmp_src.c_str());
+        if (tmp_obj.size()) std::remove(tmp_obj.c_str());
+      }
+    }
+
+    if (compiled && ga_native_code_is_private(obj_file, false)) {
+      void *handle = dlopen(obj_file.c_str(), RTLD_NOW | RTLD_LOCAL);
+      if (handle)
+        kernel = reinterpret_cast<ga_native_kernel>
+          (dlsym(handle, "ga_native_kernel"));
+    }
+    if (kernel) ++(options.nb_loaded);
+    else {
+      ++nb_failures;
+      GMM_WARNING1("Native code kernel " << obj_file << " could not be "
+                   "built or loaded, the instructions are interpreted");
+    }
+    return kernel;
+#else
+    GMM_NOPERATION_(source.size());
+    return nullptr;
+#endif
+  }
+
+  //=========================================================================
+  // Instruction executing a sequence of instructions with a kernel
+  //=========================================================================
+
+  struct ga_instruction_native : public ga_instruction {
+    std::vector<pga_instruction> instructions;
+    std::vector<ga_native_code::operand> operands;
+    struct variant { // A kernel for given sizes of the operands
+      std::vector<bgeot::multi_index> tensor_sizes;
+      std::vector<size_type> vector_sizes;
+      ga_native_kernel kernel;
+    };
+    std::vector<variant> variants;
+    size_type last;
+    std::vector<void *> args;
+
+    bool matches(const variant &v) const {
+      for (size_type i = 0, it = 0, iv = 0; i < operands.size(); ++i)
+        if (operands[i].t) {
+          if (operands[i].t->sizes() != v.tensor_sizes[it++]) return false;
+        } else if (operands[i].v) {
+          if (operands[i].v->size() != v.vector_sizes[iv++]) return false;
+        }
+      return true;
+    }
+
+    ga_native_kernel kernel() {
+      if (last < variants.size() && matches(variants[last]))
+        return variants[last].kernel;
+      for (last = 0; last < variants.size(); ++last)
+        if (matches(variants[last])) return variants[last].kernel;
+      if (variants.size() >= 8) return nullptr; // Too many different sizes
+      variant v;
+      for (const auto &o : operands)
+        if (o.t) v.tensor_sizes.push_back(o.t->sizes());
+        else if (o.v) v.vector_sizes.push_back(o.v->size());
+      ga_native_code nc;
+      for (const pga_instruction &pgai : instructions) pgai->emit(nc);
+      GMM_ASSERT1(nc.operands.size() == operands.size(), "Internal error");
+      v.kernel = ga_load_native_kernel(nc.source());
+      variants.push_back(v);
+      return v.kernel;
+    }
+
+    virtual int exec() {
+      ga_native_kernel k = kernel();
+      if (k) {
+        for (size_type i = 0; i < operands.size(); ++i) {
+          const ga_native_code::operand &o = operands[i];
+          if (o.t)
+            args[i] = const_cast<scalar_type *>(o.t->as_vector().data());
+          else if (o.v)
+            args[i] = const_cast<scalar_type *>(o.v->data());
+        }
+        (*k)(args.data());
+      } else
+        for (const pga_instruction &pgai : instructions) pgai->exec();
+      return 0;
+    }
+
+    ga_instruction_native(std::vector<pga_instruction>::const_iterator b,
+                          std::vector<pga_instruction>::const_iterator e)
+      : instructions(b, e), last(0) {
+      ga_native_code nc;
+      for (const pga_instruction &pgai : instructions) pgai->emit(nc);
+      operands = nc.operands;
+      args.resize(operands.size());
+      for (size_type i = 0; i < operands.size(); ++i)
+        args[i] = operands[i].p;
+    }
+  };
+
+  void ga_native_code_segments(std::vector<pga_instruction> &instructions) {
+    std::vector<pga_instruction> result;
+    auto it = instructions.cbegin(), ite = instructions.cend();
+    while (it != ite) {
+      auto it2 = it;
+      for (; it2 != ite; ++it2) {
+        ga_native_code nc;
+        if (!(*it2)->emit(nc)) break;
+      }
+      if (it2 - it >= 2) {
+        result.push_back(std::make_shared<ga_instruction_native>(it, it2));
+        it = it2;
+      } else {
+        if (it2 == it) ++it2;
+        for (; it != it2; ++it) result.push_back(*it);
+      }
+    }
+    instructions.swap(result);
+  }
+
+} /* end of namespace getfem.                                             */
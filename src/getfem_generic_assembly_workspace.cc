@@ -23,6 +23,7 @@
 #include "getfem/getfem_generic_assembly_semantic.h"
 #include "getfem/getfem_generic_assembly_compile_and_exec.h"
 #include "getfem/getfem_generic_assembly_functions_and_operators.h"
+#include <chrono>
 
 namespace getfem {
 
@@ -443,6 +444,7 @@ namespace getfem {
                               size_type add_derivative_order,
                               bool function_expr, operation_type op_type,
                               const std::string varname_interpolation) {
+    compiled_gis.clear();
     if (tree.root) {
       // cout << "add tree with tests functions of " <<  tree.root->name_test1
       //     << " and " << tree.root->name_test2 << endl;
@@ -802,9 +804,27 @@ namespace getfem {
     if (w->md) w->md->nb_dof(); // To eventually call actualize_sizes()
 
     GA_TIC;
-    ga_instruction_set gis;
-    ga_compile(*this, gis, order, condensation);
+    auto t0 = std::chrono::steady_clock::now();
+    std::shared_ptr<ga_instruction_set> pgis;
+    if (keep_compiled) pgis = compiled_gis[std::make_pair(order, condensation)];
+    if (!pgis) {
+      // The compilation resets the temporary intervals of the variables,
+      // to which the other kept instructions refer.
+      compiled_gis.clear();
+      pgis = std::make_shared<ga_instruction_set>();
+      ga_compile(*this, *pgis, order, condensation);
+      if (keep_compiled)
+        compiled_gis[std::make_pair(order, condensation)] = pgis;
+    } else
+      ga_update_extended_variables(*this, *pgis);
+    ga_instruction_set &gis = *pgis;
     GA_TOCTIC("Compile time");
+    if (profile_) {
+      auto t1 = std::chrono::steady_clock::now();
+      profile_->compile_time
+        += std::chrono::duration<scalar_type>(t1-t0).count();
+      t0 = t1;
+    }
 
     size_type nb_tot_dof = condensation ? nb_prim_dof + nb_intern_dof
                                         : nb_prim_dof;
@@ -857,6 +877,11 @@ namespace getfem {
     GA_TOCTIC("Init time");
     ga_exec(gis, *this);     // --> unreduced_V, *V,
     GA_TOCTIC("Exec time");  //     unreduced_K, *K
+    if (profile_) {
+      profile_->nb_assemblies++;
+      profile_->exec_time += std::chrono::duration<scalar_type>
+        (std::chrono::steady_clock::now() - t0).count();
+    }
 
     if (order == 0) {
       MPI_SUM_VECTOR(assemb_t.as_vector());
@@ -915,11 +940,13 @@ namespace getfem {
                               gmm::sub_matrix(row_col_unreduced_K, uI1, uI2),
                               aux);
                     gmm::mult(aux, mf2->extension_matrix(), M);
+                    all_columns_guard g(K_locks);
                     gmm::add(M, gmm::sub_matrix(*K, I1, I2));
                   } else if (I2.first() < nb_prim_dof) { // !is_internal_variable(vname2)
                     model_real_sparse_matrix M(I1.size(), I2.size());
                     gmm::mult(gmm::transposed(mf1->extension_matrix()),
                               gmm::sub_matrix(row_unreduced_K, uI1, I2), M);
+                    all_columns_guard g(K_locks);
                     gmm::add(M, gmm::sub_matrix(*K, I1, I2));
                   }
                 } else {
@@ -928,6 +955,7 @@ namespace getfem {
                             mf2->extension_matrix(), M);
                   if (I1.first() < nb_prim_dof) {
                     GMM_ASSERT1(I1.last() <= nb_prim_dof, "Internal error");
+                    all_columns_guard g(K_locks);
                     gmm::add(M, gmm::sub_matrix(*K, I1, I2)); // -> *K
                   } else { // vname1 is an internal variable
                     gmm::add(M, gmm::sub_matrix(*KQJpr, I1, I2)); // -> *KQJpr
@@ -950,6 +978,31 @@ namespace getfem {
     return include_empty_int_pts;
   }
 
+  void ga_workspace::set_batched_int_points(bool batched) {
+    batched_int_pts = batched;
+  }
+
+  bool ga_workspace::batched_int_points() const {
+    return batched_int_pts;
+  }
+
+  void ga_workspace::enable_profiling(bool enable) {
+    if (!enable)
+      profile_.reset();
+    else if (!profile_)
+      profile_.reset(new ga_assembly_profile());
+  }
+
+  const ga_assembly_profile &ga_workspace::profile() const {
+    GMM_ASSERT1(profile_, "The profiling is not enabled for this workspace");
+    return *profile_;
+  }
+
+  ga_assembly_profile &ga_workspace::profile() {
+    GMM_ASSERT1(profile_, "The profiling is not enabled for this workspace");
+    return *profile_;
+  }
+
   void ga_workspace::add_temporary_interval_for_unreduced_variable
     (const std::string &name)
   {
@@ -966,7 +1019,8 @@ namespace getfem {
     }
   }
 
-  void ga_workspace::clear_expressions() { trees.clear(); }
+  void ga_workspace::clear_expressions()
+  { compiled_gis.clear(); trees.clear(); }
 
   void ga_workspace::print(std::ostream &str) {
     for (size_type i = 0; i < trees.size(); ++i)
@@ -1007,6 +1061,7 @@ namespace getfem {
       nb_tmp_dof(0), macro_dict(md_.macro_dictionary())
   {
     init();
+    if (md->assembly_profiling_enabled()) enable_profiling();
     nb_prim_dof = with_parent_variables ? md->nb_primary_dof() : 0;
     nb_intern_dof = with_parent_variables ? md->nb_internal_dof() : 0;
     if (var_inherit == inherit::ALL) { // enable model's disabled variables
@@ -1050,7 +1105,58 @@ namespace getfem {
     : md(0), parent_workspace(0), with_parent_variables(false),
       nb_prim_dof(0), nb_intern_dof(0), first_intern_dof(0), nb_tmp_dof(0)
   { init(); }
-  ga_workspace::~ga_workspace() { clear_expressions(); }
+  ga_workspace::~ga_workspace() {
+    clear_expressions();
+    if (md && profile_ && md->assembly_profiling_enabled())
+      md->add_to_assembly_profile(*profile_);
+  }
+
+  //=========================================================================
+  // Profiling of the assembly
+  //=========================================================================
+
+  ga_expression_profile &
+  ga_expression_profile::operator +=(const ga_expression_profile &e) {
+    nb_elements += e.nb_elements;
+    nb_gauss_points += e.nb_gauss_points;
+    instructions += e.instructions;
+    return *this;
+  }
+
+  ga_assembly_profile &
+  ga_assembly_profile::operator +=(const ga_assembly_profile &p) {
+    nb_assemblies += p.nb_assemblies;
+    nb_elements += p.nb_elements;
+    nb_gauss_points += p.nb_gauss_points;
+    compile_time += p.compile_time;
+    exec_time += p.exec_time;
+    scatter += p.scatter;
+    for (const auto &i : p.instructions) instructions[i.first] += i.second;
+    for (const auto &e : p.expressions) expressions[e.first] += e.second;
+    return *this;
+  }
+
+  std::ostream &operator <<(std::ostream &o, const ga_assembly_profile &p) {
+    o << "Assemblies: " << p.nb_assemblies << ", elements: " << p.nb_elements
+      << ", integration points: " << p.nb_gauss_points << endl;
+    o << "Compile time: " << p.compile_time << "s, exec time: "
+      << p.exec_time << "s, scatter: " << p.scatter.time << "s ("
+      << p.scatter.nb_calls << " calls)" << endl;
+    std::vector<std::pair<scalar_type, std::string>> sorted;
+    for (const auto &i : p.instructions)
+      sorted.emplace_back(i.second.time, i.first);
+    std::sort(sorted.rbegin(), sorted.rend());
+    o << "Instructions:" << endl;
+    for (const auto &i : sorted)
+      o << "  " << i.first << "s, " << p.instructions.at(i.second).nb_calls
+        << " calls: " << i.second << endl;
+    o << "Expressions:" << endl;
+    for (const auto &e : p.expressions)
+      o << "  " << e.second.instructions.time << "s, " << e.second.nb_elements
+        << " elements, " << e.second.nb_gauss_points << " points: "
+        << e.first << endl;
+    return o;
+  }
 
   //=========================================================================
   // Extract the constant term of degree 1 expressions
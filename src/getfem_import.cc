@@ -22,8 +22,10 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <unordered_map>
 
 #include "getfem/getfem_mesh.h"
+#include "getfem/getfem_omp.h"
 #include "getfem/getfem_import.h"
 #include "getfem/getfem_regular_meshes.h"
 
@@ -168,6 +170,174 @@ namespace getfem {
       }
     }
 
+    // Reordering nodes for certain elements (should be completed ?)
+    void reorder_nodes() {
+      // http://www.geuz.org/gmsh/doc/texinfo/gmsh.html#Node-ordering
+      std::vector<size_type> tmp_nodes(nodes);
+      switch(type) {
+      case 3 : {
+        nodes[2] = tmp_nodes[3];
+        nodes[3] = tmp_nodes[2];
+      } break;
+      case 5 : { /* First order hexaedron */
+        //nodes[0] = tmp_nodes[0];
+        //nodes[1] = tmp_nodes[1];
+        nodes[2] = tmp_nodes[3];
+        nodes[3] = tmp_nodes[2];
+        //nodes[4] = tmp_nodes[4];
+        //nodes[5] = tmp_nodes[5];
+        nodes[6] = tmp_nodes[7];
+        nodes[7] = tmp_nodes[6];
+      } break;
+      case 7 : { /* first order pyramid */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[2];
+        nodes[2] = tmp_nodes[1];
+        // nodes[3] = tmp_nodes[3];
+        // nodes[4] = tmp_nodes[4];
+      } break;
+      case 8 : { /* Second order line */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[2];
+        nodes[2] = tmp_nodes[1];
+      } break;
+      case 9 : { /* Second order triangle */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[3];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[5];
+        //nodes[4] = tmp_nodes[4];
+        nodes[5] = tmp_nodes[2];
+      } break;
+      case 10 : { /* Second order quadrangle */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[4];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[7];
+        nodes[4] = tmp_nodes[8];
+        //nodes[5] = tmp_nodes[5];
+        nodes[6] = tmp_nodes[3];
+        nodes[7] = tmp_nodes[6];
+        nodes[8] = tmp_nodes[2];
+      } break;
+      case 11: { /* Second order tetrahedron */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[4];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[6];
+        nodes[4] = tmp_nodes[5];
+        nodes[5] = tmp_nodes[2];
+        nodes[6] = tmp_nodes[7];
+        nodes[7] = tmp_nodes[9];
+        //nodes[8] = tmp_nodes[8];
+        nodes[9] = tmp_nodes[3];
+      } break;
+      case 12: { /* Second order hexahedron */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[8];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[9];
+        nodes[4] = tmp_nodes[20];
+        nodes[5] = tmp_nodes[11];
+        nodes[6] = tmp_nodes[3];
+        nodes[7] = tmp_nodes[13];
+        nodes[8] = tmp_nodes[2];
+        nodes[9] = tmp_nodes[10];
+        nodes[10] = tmp_nodes[21];
+        nodes[11] = tmp_nodes[12];
+        nodes[12] = tmp_nodes[22];
+        nodes[13] = tmp_nodes[26];
+        nodes[14] = tmp_nodes[23];
+        //nodes[15] = tmp_nodes[15];
+        nodes[16] = tmp_nodes[24];
+        nodes[17] = tmp_nodes[14];
+        nodes[18] = tmp_nodes[4];
+        nodes[19] = tmp_nodes[16];
+        nodes[20] = tmp_nodes[5];
+        nodes[21] = tmp_nodes[17];
+        nodes[22] = tmp_nodes[25];
+        nodes[23] = tmp_nodes[18];
+        nodes[24] = tmp_nodes[7];
+        nodes[25] = tmp_nodes[19];
+        nodes[26] = tmp_nodes[6];
+      } break;
+      case 16 : { /* Incomplete second order quadrangle */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[4];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[7];
+        nodes[4] = tmp_nodes[5];
+        nodes[5] = tmp_nodes[3];
+        nodes[6] = tmp_nodes[6];
+        nodes[7] = tmp_nodes[2];
+      } break;
+      case 17: { /* Incomplete second order hexahedron */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[8];
+        nodes[2] = tmp_nodes[1];
+        nodes[3] = tmp_nodes[9];
+        nodes[4] = tmp_nodes[11];
+        nodes[5] = tmp_nodes[3];
+        nodes[6] = tmp_nodes[13];
+        nodes[7] = tmp_nodes[2];
+        nodes[8] = tmp_nodes[10];
+        nodes[9] = tmp_nodes[12];
+        nodes[10] = tmp_nodes[15];
+        nodes[11] = tmp_nodes[14];
+        nodes[12] = tmp_nodes[4];
+        nodes[13] = tmp_nodes[16];
+        nodes[14] = tmp_nodes[5];
+        nodes[15] = tmp_nodes[17];
+        nodes[16] = tmp_nodes[18];
+        nodes[17] = tmp_nodes[7];
+        nodes[18] = tmp_nodes[19];
+        nodes[19] = tmp_nodes[6];
+      } break;
+      case 26 : { /* Third order line */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[2];
+        nodes[2] = tmp_nodes[3];
+        nodes[3] = tmp_nodes[1];
+      } break;
+      case 21 : { /* Third order triangle */
+        //nodes[0] = tmp_nodes[0];
+        nodes[1] = tmp_nodes[3];
+        nodes[2] = tmp_nodes[4];
+        nodes[3] = tmp_nodes[1];
+        nodes[4] = tmp_nodes[8];
+        nodes[5] = tmp_nodes[9];
+        nodes[6] = tmp_nodes[5];
+        //nodes[7] = tmp_nodes[7];
+        nodes[8] = tmp_nodes[6];
+        nodes[9] = tmp_nodes[2];
+      } break;
+      case 23: { /* Fourth order triangle */
+      //nodes[0]  = tmp_nodes[0];
+        nodes[1]  = tmp_nodes[3];
+        nodes[2]  = tmp_nodes[4];
+        nodes[3]  = tmp_nodes[5];
+        nodes[4]  = tmp_nodes[1];
+        nodes[5]  = tmp_nodes[11];
+        nodes[6]  = tmp_nodes[12];
+        nodes[7]  = tmp_nodes[13];
+        nodes[8]  = tmp_nodes[6];
+        nodes[9]  = tmp_nodes[10];
+        nodes[10] = tmp_nodes[14];
+        nodes[11] = tmp_nodes[7];
+        nodes[12] = tmp_nodes[9];
+        nodes[13] = tmp_nodes[8];
+        nodes[14] = tmp_nodes[2];
+      } break;
+      case 27: { /* Fourth order line */
+      //nodes[0]  = tmp_nodes[0];
+        nodes[1]  = tmp_nodes[2];
+        nodes[2]  = tmp_nodes[3];
+        nodes[3]  = tmp_nodes[4];
+        nodes[4]  = tmp_nodes[1];
+      } break;
+      }
+    }
+
     bool operator<(const gmsh_cv_info& other) const {
       unsigned this_dim = (type == 15) ? 0 : pgt->dim();
       unsigned other_dim = (other.type == 15) ? 0 : other.pgt->dim();
@@ -176,10 +346,10 @@ namespace getfem {
     }
   };
 
-  std::map<std::string, size_type> read_region_names_from_gmsh_mesh_file(std::istream& f)
-  {
+  /* reads the content of a $PhysicalNames section (always in text format) */
+  static std::map<std::string, size_type>
+  read_gmsh_physical_names(std::istream& f) {
     std::map<std::string, size_type> region_map;
-    bgeot::read_until(f, "$PhysicalNames");
     size_type nb_regions;
     f >> nb_regions;
     size_type rt,ri;
@@ -200,6 +370,328 @@ namespace getfem {
     return region_map;
   }
 
+  std::map<std::string, size_type> read_region_names_from_gmsh_mesh_file(std::istream& f)
+  {
+    bgeot::read_until(f, "$PhysicalNames");
+    return read_gmsh_physical_names(f);
+  }
+
+  /* Adds the convexes read in a gmsh file to the mesh (see
+     import_gmsh_mesh_file below for the meaning of the options). Returns
+     false if the file only defines nodes. If unique_elements is false, an
+     element listed several times (once per physical group in the MSH2
+     format) is added once. */
+  static bool add_gmsh_convexes
+  (mesh &m, std::vector<gmsh_cv_info> &cvlst,
+   std::set<size_type> *lower_dim_convex_rg, bool add_all_element_type,
+   std::map<size_type, std::set<size_type>> *nodal_map,
+   bool unique_elements) {
+    size_type nb_cv = cvlst.size();
+    if (cvlst.size()) {
+      std::sort(cvlst.begin(), cvlst.end());
+      if (cvlst.front().type == 15) {
+        GMM_WARNING2("Only nodes defined in the mesh! No elements are added.");
+        return false;
+      }
+
+      unsigned N = cvlst.front().pgt->dim();
+      for (size_type cv=0; cv < nb_cv; ++cv) {
+        bool cvok = false;
+        gmsh_cv_info &ci = cvlst[cv];
+        bool is_node = (ci.type == 15);
+        unsigned ci_dim = (is_node) ? 0 : ci.pgt->dim();
+        //  cout << "importing cv dim=" << ci_dim << " N=" << N
+        //       << " region: " << ci.region << " type: " << ci.type << "\n";
+
+        //main convex import
+        if (ci_dim == N) {
+          size_type ic = unique_elements
+            ? m.add_convex_noverif(ci.pgt, ci.nodes.begin())
+            : m.add_convex(ci.pgt, ci.nodes.begin());
+          cvok = true;
+          m.region(ci.region).add(ic);
+
+        //convexes with lower dimensions
+        }
+        else {
+          //convex that lies within the regions of lower_dim_convex_rg
+          //is imported explicitly as a convex.
+          if (lower_dim_convex_rg != NULL &&
+              lower_dim_convex_rg->find(ci.region) != lower_dim_convex_rg->end()
+              && !is_node) {
+              size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
+              cvok = true; m.region(ci.region).add(ic);
+          }
+          //find if the convex is part of a face of higher dimension convex
+          else{
+            bgeot::mesh_structure::ind_cv_ct ct=m.convex_to_point(ci.nodes[0]);
+            for (bgeot::mesh_structure::ind_cv_ct::const_iterator
+                   it = ct.begin(); it != ct.end(); ++it) {
+              if (m.structure_of_convex(*it)->dim() == ci_dim + 1) {
+                for (short_type face=0;
+                     face < m.structure_of_convex(*it)->nb_faces(); ++face) {
+                  if (m.is_convex_face_having_points(*it, face,
+                                                    short_type(ci.nodes.size()),
+                                                    ci.nodes.begin())) {
+                    m.region(ci.region).add(*it,face);
+                    cvok = true;
+                  }
+                }
+              }
+            }
+            if (is_node && (nodal_map != NULL)) {
+              for (auto i : ci.nodes) (*nodal_map)[ci.region].insert(i);
+            }
+            // if the convex is not part of the face of others
+            if (!cvok) {
+              if (is_node) {
+                if (nodal_map == NULL){
+                  GMM_WARNING2("gmsh import ignored a node id: "
+                               << ci.id << " region :" << ci.region <<
+                               " point is not added explicitly as an element.");
+                }
+              }
+              else if (add_all_element_type) {
+                size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
+                m.region(ci.region).add(ic);
+                cvok = true;
+              } else {
+                GMM_WARNING2("gmsh import ignored an element of type "
+                             << bgeot::name_of_geometric_trans(ci.pgt) <<
+                    " as it does not belong to the face of another element");
+              }
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  /* Binary data of gmsh files, written in the native byte order. */
+  template <typename T>
+  static void read_gmsh_binary(std::istream& f, T *p, size_type n) {
+    f.read(reinterpret_cast<char *>(p), std::streamsize(n * sizeof(T)));
+    GMM_ASSERT1(f.good(), "unexpected end of binary gmsh file");
+  }
+
+  template <typename T> static T read_gmsh_binary(std::istream& f)
+  { T v; read_gmsh_binary(f, &v, 1); return v; }
+
+  /* Correspondence between gmsh node tags and mesh points. A direct table
+     is used when the tags are dense enough (the case of files written by
+     gmsh), a hash table otherwise. */
+  struct gmsh_node_map {
+    size_type min_tag = 0;
+    std::vector<size_type> table;
+    std::unordered_map<size_type, size_type> sparse;
+    bool dense = true;
+
+    void init(size_type min_tag_, size_type max_tag, size_type nb_node) {
+      min_tag = min_tag_;
+      dense = (max_tag >= min_tag && max_tag - min_tag < 2*nb_node + 1024);
+      if (dense) table.assign(max_tag - min_tag + 1, size_type(-1));
+      else sparse.reserve(nb_node);
+    }
+    void set(size_type tag, size_type ip) {
+      if (!dense) sparse[tag] = ip;
+      else {
+        GMM_ASSERT1(tag >= min_tag && tag - min_tag < table.size(),
+                    "Invalid node tag " << tag);
+        table[tag - min_tag] = ip;
+      }
+    }
+    size_type operator()(size_type tag) const {
+      if (dense)
+        return (tag >= min_tag && tag - min_tag < table.size())
+          ? table[tag - min_tag] : size_type(-1);
+      auto it = sparse.find(tag);
+      return (it == sparse.end()) ? size_type(-1) : it->second;
+    }
+  };
+
+  /* The $Entities section is not used (regions are given by the entity
+     tags of the element blocks as for the text format). */
+  static void skip_gmsh_binary_entities(std::istream& f) {
+    std::uint64_t nb_entities[4];
+    read_gmsh_binary(f, nb_entities, 4);
+    for (size_type d = 0; d < 4; ++d)
+      for (std::uint64_t i = 0; i < nb_entities[d]; ++i) {
+        f.ignore(sizeof(int) + (d == 0 ? 3 : 6) * sizeof(double));
+        std::uint64_t nb_tags = read_gmsh_binary<std::uint64_t>(f);
+        f.ignore(std::streamsize(nb_tags * sizeof(int))); // physical tags
+        if (d > 0) { // bounding entities
+          nb_tags = read_gmsh_binary<std::uint64_t>(f);
+          f.ignore(std::streamsize(nb_tags * sizeof(int)));
+        }
+      }
+  }
+
+  static void read_gmsh_binary_nodes
+  (std::istream& f, mesh& m, gmsh_node_map &node_map,
+   bool remove_duplicated_nodes) {
+    std::uint64_t head[4]; // nb of blocks, nb of nodes, min and max tags
+    read_gmsh_binary(f, head, 4);
+    size_type nb_node = size_type(head[1]);
+    std::vector<std::uint64_t> tags(nb_node);
+    std::vector<double> coords(3*nb_node);
+    size_type k = 0;
+    for (std::uint64_t block = 0; block < head[0]; ++block) {
+      int infos[3]; // entity dimension, entity tag, parametric
+      read_gmsh_binary(f, infos, 3);
+      size_type nb = size_type(read_gmsh_binary<std::uint64_t>(f));
+      GMM_ASSERT1(k + nb <= nb_node, "Inconsistent number of nodes");
+      read_gmsh_binary(f, &tags[k], nb);
+      if (infos[2] == 0)
+        read_gmsh_binary(f, &coords[3*k], 3*nb);
+      else
+        for (size_type i = 0; i < nb; ++i) {
+          read_gmsh_binary(f, &coords[3*(k+i)], 3);
+          f.ignore(std::streamsize(infos[0] * sizeof(double)));
+        }
+      k += nb;
+    }
+    GMM_ASSERT1(k == nb_node, "Inconsistent number of nodes");
+
+    /* Identical nodes are merged by sorting them, instead of searching
+       each one among the mesh points. */
+    std::vector<size_type> first_same(nb_node);
+    for (size_type i = 0; i < nb_node; ++i) first_same[i] = i;
+    bool search = remove_duplicated_nodes && m.points_index().card() != 0;
+    if (remove_duplicated_nodes && !search) {
+      std::vector<size_type> order(first_same);
+      auto less = [&coords](size_type i, size_type j) {
+        for (size_type l = 0; l < 3; ++l)
+          if (coords[3*i+l] != coords[3*j+l])
+            return coords[3*i+l] < coords[3*j+l];
+        return i < j;
+      };
+      std::sort(order.begin(), order.end(), less);
+      for (size_type i = 1; i < nb_node; ++i)
+        if (std::equal(&coords[3*order[i]], &coords[3*order[i]] + 3,
+                       &coords[3*order[i-1]]))
+          first_same[order[i]] = first_same[order[i-1]];
+    }
+
+    node_map.init(size_type(head[2]), size_type(head[3]), nb_node);
+    std::vector<size_type> ipts(nb_node);
+    base_node n(3);
+    for (size_type i = 0; i < nb_node; ++i) {
+      if (first_same[i] == i) {
+        std::copy(&coords[3*i], &coords[3*i] + 3, n.begin());
+        ipts[i] = m.add_point(n, search ? 0. : -1.);
+      } else
+        ipts[i] = ipts[first_same[i]];
+      node_map.set(size_type(tags[i]), ipts[i]);
+    }
+  }
+
+  static void read_gmsh_binary_elements
+  (std::istream& f, const gmsh_node_map &node_map,
+   std::vector<gmsh_cv_info> &cvlst) {
+    std::uint64_t head[4]; // nb of blocks, nb of elements, min and max tags
+    read_gmsh_binary(f, head, 4);
+
+    struct element_block {
+      gmsh_cv_info ci; // common part of the elements of the block
+      size_type first, nb_nodes, data;
+    };
+    std::vector<element_block> blocks;
+    std::vector<std::uint64_t> data;
+    dal::bit_vector reg;
+    size_type nb_cv = 0;
+    for (std::uint64_t block = 0; block < head[0]; ++block) {
+      int infos[3]; // entity dimension, entity tag, element type
+      read_gmsh_binary(f, infos, 3);
+      size_type nb = size_type(read_gmsh_binary<std::uint64_t>(f));
+      unsigned region = unsigned(infos[1]);
+      if (reg.is_in(region)) {
+        GMM_WARNING2("Two regions share the same number, "
+                     "the region numbering is modified");
+        while (reg.is_in(region)) region += 5;
+      }
+      reg.add(region);
+
+      element_block bl;
+      bl.ci.type = unsigned(infos[2]); bl.ci.region = region;
+      bl.ci.set_nb_nodes();
+      if (bl.ci.type != 15) bl.ci.set_pgt();
+      bl.first = nb_cv; bl.nb_nodes = bl.ci.nodes.size();
+      bl.data = data.size();
+      data.resize(data.size() + nb * (bl.nb_nodes + 1));
+      read_gmsh_binary(f, &data[bl.data], nb * (bl.nb_nodes + 1));
+      blocks.push_back(bl);
+      nb_cv += nb;
+    }
+
+    // Decoding of the elements, in parallel.
+    cvlst.resize(nb_cv);
+    auto decode = [&](size_type ipart, size_type nb_parts) {
+      size_type k0 = (nb_cv * ipart) / nb_parts;
+      size_type k1 = (nb_cv * (ipart+1)) / nb_parts;
+      size_type ib = 0;
+      for (size_type k = k0; k < k1; ++k) {
+        while (ib+1 < blocks.size() && blocks[ib+1].first <= k) ++ib;
+        const element_block &bl = blocks[ib];
+        const std::uint64_t *p
+          = &data[bl.data + (k - bl.first) * (bl.nb_nodes + 1)];
+        gmsh_cv_info &ci = cvlst[k];
+        ci = bl.ci;
+        ci.id = unsigned(p[0] - 1); /* gmsh numbering starts at 1 */
+        for (size_type i = 0; i < bl.nb_nodes; ++i) {
+          ci.nodes[i] = node_map(size_type(p[i+1]));
+          GMM_ASSERT1(ci.nodes[i] != size_type(-1), "Invalid node ID "
+                      << p[i+1] << " in gmsh element " << p[0]);
+        }
+        ci.reorder_nodes();
+      }
+    };
+    if (me_is_multithreaded_now())
+      decode(0, 1);
+    else
+      GETFEM_OMP_PARALLEL(decode(global_thread_policy::this_thread(),
+                                 global_thread_policy::num_threads()));
+  }
+
+  /* Format version 4.1 in binary mode, whose $MeshFormat header has just
+     been read. The $Entities, $Nodes and $Elements sections are binary
+     (with 4 bytes int and 8 bytes size_t), the other ones are in text. */
+  static void read_gmsh_msh4_binary
+  (std::istream& f, mesh& m, std::vector<gmsh_cv_info> &cvlst,
+   std::map<std::string, size_type> *region_map,
+   bool remove_duplicated_nodes) {
+    f.get(); // end of line
+    GMM_ASSERT1(read_gmsh_binary<int>(f) == 1,
+                "binary gmsh file written with a different byte order");
+    bgeot::read_until(f, "$EndMeshFormat");
+
+    gmsh_node_map node_map;
+    std::string section;
+    for (bool elements_read = false; !elements_read; ) {
+      f >> section;
+      if (bgeot::casecmp(section, "$PhysicalNames") == 0) {
+        std::map<std::string, size_type> names = read_gmsh_physical_names(f);
+        if (region_map != NULL) *region_map = names;
+        bgeot::read_until(f, "$EndPhysicalNames");
+      } else if (bgeot::casecmp(section, "$Entities") == 0) {
+        f.get();
+        skip_gmsh_binary_entities(f);
+        bgeot::read_until(f, "$EndEntities");
+      } else if (bgeot::casecmp(section, "$Nodes") == 0) {
+        f.get();
+        read_gmsh_binary_nodes(f, m, node_map, remove_duplicated_nodes);
+        bgeot::read_until(f, "$EndNodes");
+      } else if (bgeot::casecmp(section, "$Elements") == 0) {
+        f.get();
+        read_gmsh_binary_elements(f, node_map, cvlst);
+        bgeot::read_until(f, "$EndElements");
+        elements_read = true;
+      } else
+        GMM_ASSERT1(false, "Section " << section
+                    << " of binary gmsh files is not supported");
+    }
+  }
+
   /*
      Format version 1 [for gmsh version < 2.0].
      structure: $NOD list_of_nodes $ENDNOD $ELT list_of_elt $ENDELT
@@ -210,6 +702,8 @@ namespace getfem {
      structure: $Nodes list_of_nodes $EndNodes $Elements list_of_elt
      $EndElements
 
+     Format version 4.1 is read in text or binary mode.
+
      Lower dimensions elements in the regions of lower_dim_convex_rg will
      be imported as independant convexes.
 
@@ -247,15 +741,28 @@ namespace getfem {
 
     /* read the version */
     double version;
+    int file_type = 0, data_size = 0;
     std::string header;
     f >> header;
     if (bgeot::casecmp(header,"$MeshFormat")==0)
-      f >> version;
+      f >> version >> file_type >> data_size;
     else if (bgeot::casecmp(header,"$NOD")==0)
       version = 1;
     else
       GMM_ASSERT1(false, "can't read Gmsh format: " << header);
 
+    if (file_type == 1) { /* binary mode */
+      GMM_ASSERT1(version >= 4.05 && data_size == 8, "Only the version 4.1 "
+                  "of the gmsh binary format is supported");
+      std::vector<gmsh_cv_info> cvlst;
+      read_gmsh_msh4_binary(f, m, cvlst, region_map, remove_duplicated_nodes);
+      if (add_gmsh_convexes(m, cvlst, lower_dim_convex_rg,
+                            add_all_element_type, nodal_map, true)
+          && remove_last_dimension)
+        maybe_remove_last_dimension(m);
+      return;
+    }
+
     /* read the region names */
     if (region_map != NULL) {
       if (version >= 2.) {
@@ -379,251 +886,13 @@ namespace getfem {
         }
         if (ci.type != 15)
           ci.set_pgt();
-        // Reordering nodes for certain elements (should be completed ?)
-        // http://www.geuz.org/gmsh/doc/texinfo/gmsh.html#Node-ordering
-        std::vector<size_type> tmp_nodes(ci.nodes);
-        switch(ci.type) {
-        case 3 : {
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[2];
-        } break;
-        case 5 : { /* First order hexaedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          //ci.nodes[1] = tmp_nodes[1];
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[2];
-          //ci.nodes[4] = tmp_nodes[4];
-          //ci.nodes[5] = tmp_nodes[5];
-          ci.nodes[6] = tmp_nodes[7];
-          ci.nodes[7] = tmp_nodes[6];
-        } break;
-        case 7 : { /* first order pyramid */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[1];
-          // ci.nodes[3] = tmp_nodes[3];
-          // ci.nodes[4] = tmp_nodes[4];
-        } break;
-        case 8 : { /* Second order line */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[1];
-        } break;
-        case 9 : { /* Second order triangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[3];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[5];
-          //ci.nodes[4] = tmp_nodes[4];
-          ci.nodes[5] = tmp_nodes[2];
-        } break;
-        case 10 : { /* Second order quadrangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[8];
-          //ci.nodes[5] = tmp_nodes[5];
-          ci.nodes[6] = tmp_nodes[3];
-          ci.nodes[7] = tmp_nodes[6];
-          ci.nodes[8] = tmp_nodes[2];
-        } break;
-        case 11: { /* Second order tetrahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[6];
-          ci.nodes[4] = tmp_nodes[5];
-          ci.nodes[5] = tmp_nodes[2];
-          ci.nodes[6] = tmp_nodes[7];
-          ci.nodes[7] = tmp_nodes[9];
-          //ci.nodes[8] = tmp_nodes[8];
-          ci.nodes[9] = tmp_nodes[3];
-        } break;
-        case 12: { /* Second order hexahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[8];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[9];
-          ci.nodes[4] = tmp_nodes[20];
-          ci.nodes[5] = tmp_nodes[11];
-          ci.nodes[6] = tmp_nodes[3];
-          ci.nodes[7] = tmp_nodes[13];
-          ci.nodes[8] = tmp_nodes[2];
-          ci.nodes[9] = tmp_nodes[10];
-          ci.nodes[10] = tmp_nodes[21];
-          ci.nodes[11] = tmp_nodes[12];
-          ci.nodes[12] = tmp_nodes[22];
-          ci.nodes[13] = tmp_nodes[26];
-          ci.nodes[14] = tmp_nodes[23];
-          //ci.nodes[15] = tmp_nodes[15];
-          ci.nodes[16] = tmp_nodes[24];
-          ci.nodes[17] = tmp_nodes[14];
-          ci.nodes[18] = tmp_nodes[4];
-          ci.nodes[19] = tmp_nodes[16];
-          ci.nodes[20] = tmp_nodes[5];
-          ci.nodes[21] = tmp_nodes[17];
-          ci.nodes[22] = tmp_nodes[25];
-          ci.nodes[23] = tmp_nodes[18];
-          ci.nodes[24] = tmp_nodes[7];
-          ci.nodes[25] = tmp_nodes[19];
-          ci.nodes[26] = tmp_nodes[6];
-        } break;
-        case 16 : { /* Incomplete second order quadrangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[4];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[7];
-          ci.nodes[4] = tmp_nodes[5];
-          ci.nodes[5] = tmp_nodes[3];
-          ci.nodes[6] = tmp_nodes[6];
-          ci.nodes[7] = tmp_nodes[2];
-        } break;
-        case 17: { /* Incomplete second order hexahedron */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[8];
-          ci.nodes[2] = tmp_nodes[1];
-          ci.nodes[3] = tmp_nodes[9];
-          ci.nodes[4] = tmp_nodes[11];
-          ci.nodes[5] = tmp_nodes[3];
-          ci.nodes[6] = tmp_nodes[13];
-          ci.nodes[7] = tmp_nodes[2];
-          ci.nodes[8] = tmp_nodes[10];
-          ci.nodes[9] = tmp_nodes[12];
-          ci.nodes[10] = tmp_nodes[15];
-          ci.nodes[11] = tmp_nodes[14];
-          ci.nodes[12] = tmp_nodes[4];
-          ci.nodes[13] = tmp_nodes[16];
-          ci.nodes[14] = tmp_nodes[5];
-          ci.nodes[15] = tmp_nodes[17];
-          ci.nodes[16] = tmp_nodes[18];
-          ci.nodes[17] = tmp_nodes[7];
-          ci.nodes[18] = tmp_nodes[19];
-          ci.nodes[19] = tmp_nodes[6];
-        } break;
-        case 26 : { /* Third order line */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[2];
-          ci.nodes[2] = tmp_nodes[3];
-          ci.nodes[3] = tmp_nodes[1];
-        } break;
-        case 21 : { /* Third order triangle */
-          //ci.nodes[0] = tmp_nodes[0];
-          ci.nodes[1] = tmp_nodes[3];
-          ci.nodes[2] = tmp_nodes[4];
-          ci.nodes[3] = tmp_nodes[1];
-          ci.nodes[4] = tmp_nodes[8];
-          ci.nodes[5] = tmp_nodes[9];
-          ci.nodes[6] = tmp_nodes[5];
-          //ci.nodes[7] = tmp_nodes[7];
-          ci.nodes[8] = tmp_nodes[6];
-          ci.nodes[9] = tmp_nodes[2];
-        } break;
-        case 23: { /* Fourth order triangle */
-        //ci.nodes[0]  = tmp_nodes[0];
-          ci.nodes[1]  = tmp_nodes[3];
-          ci.nodes[2]  = tmp_nodes[4];
-          ci.nodes[3]  = tmp_nodes[5];
-          ci.nodes[4]  = tmp_nodes[1];
-          ci.nodes[5]  = tmp_nodes[11];
-          ci.nodes[6]  = tmp_nodes[12];
-          ci.nodes[7]  = tmp_nodes[13];
-          ci.nodes[8]  = tmp_nodes[6];
-          ci.nodes[9]  = tmp_nodes[10];
-          ci.nodes[10] = tmp_nodes[14];
-          ci.nodes[11] = tmp_nodes[7];
-          ci.nodes[12] = tmp_nodes[9];
-          ci.nodes[13] = tmp_nodes[8];
-          ci.nodes[14] = tmp_nodes[2];
-        } break;
-        case 27: { /* Fourth order line */
-        //ci.nodes[0]  = tmp_nodes[0];
-          ci.nodes[1]  = tmp_nodes[2];
-          ci.nodes[2]  = tmp_nodes[3];
-          ci.nodes[3]  = tmp_nodes[4];
-          ci.nodes[4]  = tmp_nodes[1];
-        } break;
-        }
+        ci.reorder_nodes();
       }
     }
 
-    nb_cv = cvlst.size();
-    if (cvlst.size()) {
-      std::sort(cvlst.begin(), cvlst.end());
-      if (cvlst.front().type == 15) {
-        GMM_WARNING2("Only nodes defined in the mesh! No elements are added.");
-        return;
-      }
-
-      unsigned N = cvlst.front().pgt->dim();
-      for (size_type cv=0; cv < nb_cv; ++cv) {
-        bool cvok = false;
-        gmsh_cv_info &ci = cvlst[cv];
-        bool is_node = (ci.type == 15);
-        unsigned ci_dim = (is_node) ? 0 : ci.pgt->dim();
-        //  cout << "importing cv dim=" << ci_dim << " N=" << N
-        //       << " region: " << ci.region << " type: " << ci.type << "\n";
-
-        //main convex import
-        if (ci_dim == N) {
-          size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-          cvok = true;
-          m.region(ci.region).add(ic);
-
-        //convexes with lower dimensions
-        }
-        else {
-          //convex that lies within the regions of lower_dim_convex_rg
-          //is imported explicitly as a convex.
-          if (lower_dim_convex_rg != NULL &&
-              lower_dim_convex_rg->find(ci.region) != lower_dim_convex_rg->end()
-              && !is_node) {
-              size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-              cvok = true; m.region(ci.region).add(ic);
-          }
-          //find if the convex is part of a face of higher dimension convex
-          else{
-            bgeot::mesh_structure::ind_cv_ct ct=m.convex_to_point(ci.nodes[0]);
-            for (bgeot::mesh_structure::ind_cv_ct::const_iterator
-                   it = ct.begin(); it != ct.end(); ++it) {
-              if (m.structure_of_convex(*it)->dim() == ci_dim + 1) {
-                for (short_type face=0;
-                     face < m.structure_of_convex(*it)->nb_faces(); ++face) {
-                  if (m.is_convex_face_having_points(*it, face,
-                                                    short_type(ci.nodes.size()),
-                                                    ci.nodes.begin())) {
-                    m.region(ci.region).add(*it,face);
-                    cvok = true;
-                  }
-                }
-              }
-            }
-            if (is_node && (nodal_map != NULL)) {
-              for (auto i : ci.nodes) (*nodal_map)[ci.region].insert(i);
-            }
-            // if the convex is not part of the face of others
-            if (!cvok) {
-              if (is_node) {
-                if (nodal_map == NULL){
-                  GMM_WARNING2("gmsh import ignored a node id: "
-                               << ci.id << " region :" << ci.region <<
-                               " point is not added explicitly as an element.");
-                }
-              }
-              else if (add_all_element_type) {
-                size_type ic = m.add_convex(ci.pgt, ci.nodes.begin());
-                m.region(ci.region).add(ic);
-                cvok = true;
-              } else {
-                GMM_WARNING2("gmsh import ignored an element of type "
-                             << bgeot::name_of_geometric_trans(ci.pgt) <<
-                    " as it does not belong to the face of another element");
-              }
-            }
-          }
-        }
-      }
-    }
+    if (!add_gmsh_convexes(m, cvlst, lower_dim_convex_rg,
+                           add_all_element_type, nodal_map, false))
+      return;
     if (remove_last_dimension) maybe_remove_last_dimension(m);
   }
 
@@ -1451,7 +1720,10 @@ namespace getfem {
       else if (bgeot::casecmp(format,"structured_ball_shell")==0)
         { regular_ball_shell_mesh(m, filename); return; }
 
-      std::ifstream f(filename.c_str());
+      /* gmsh files may be binary */
+      std::ifstream f(filename.c_str(), std::ios::in |
+                      (bgeot::casecmp(format.substr(0, 4), "gmsh") == 0
+                       ? std::ios::binary : std::ios::openmode(0)));
       GMM_ASSERT1(f.good(), "can't open file " << filename);
       /* throw exceptions when an error occurs */
       f.exceptions(std::ifstream::badbit | std::ifstream::failbit);
@@ -1505,7 +1777,7 @@ namespace getfem {
   {
     m.clear();
     try {
-      std::ifstream f(filename.c_str());
+      std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary);
       GMM_ASSERT1(f.good(), "can't open file " << filename);
       /* throw exceptions when an error occurs */
       f.exceptions(std::ifstream::badbit | std::ifstream::failbit);
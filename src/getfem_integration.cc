@@ -42,6 +42,7 @@ namespace getfem {
   }
 
   long_scalar_type poly_integration::int_poly(const base_poly &P) const {
+    GLOBAL_OMP_GUARD
     long_scalar_type res = 0.0;
     if (P.size() > int_monomials.size()) {
       std::vector<long_scalar_type> *hum = &int_monomials;
@@ -61,6 +62,7 @@ namespace getfem {
 
   long_scalar_type
     poly_integration::int_poly_on_face(const base_poly &P,short_type f) const {
+    GLOBAL_OMP_GUARD
     long_scalar_type res = 0.0;
     std::vector<long_scalar_type> *hum = &(int_face_monomials[f]);
     if (P.size() > hum->size()) {
@@ -20,6 +20,7 @@
 ===========================================================================*/
 
 #include <iostream>
+#include <mutex>
 
 #include <getfem/getfem_locale.h>
 #include <getfem/getfem_omp.h>
@@ -44,13 +45,29 @@ namespace getfem{
 
   #else
 
-    standard_locale::standard_locale()
-      : cloc(setlocale(LC_NUMERIC, 0)), cinloc(std::cin.getloc()){
-      setlocale(LC_NUMERIC,"C"); std::cin.imbue(std::locale("C"));
+    // The locale is global to the process: with several caller threads, the
+    // first standard_locale sets the "C" locale and the last one restores
+    // the locale it has saved.
+    static std::mutex locale_mutex;
+    static size_type nb_locale_users = 0;
+    static std::string saved_cloc;
+    static std::locale saved_cinloc;
+
+    standard_locale::standard_locale() {
+      std::lock_guard<std::mutex> lock(locale_mutex);
+      if (nb_locale_users++ == 0) {
+        saved_cloc = setlocale(LC_NUMERIC, 0);
+        saved_cinloc = std::cin.getloc();
+        setlocale(LC_NUMERIC,"C"); std::cin.imbue(std::locale("C"));
+      }
     }
 
     standard_locale::~standard_locale(){
-      setlocale(LC_NUMERIC, cloc.c_str()); std::cin.imbue(cinloc);
+      std::lock_guard<std::mutex> lock(locale_mutex);
+      if (--nb_locale_users == 0) {
+        setlocale(LC_NUMERIC, saved_cloc.c_str());
+        std::cin.imbue(saved_cinloc);
+      }
     }
 
   #endif
@@ -222,10 +222,21 @@ namespace getfem {
 
   void mesh::optimize_structure(bool with_renumbering) {
     pts.resort();
+    // The regions are renumbered at once at the end: orig[i] is the
+    // initial index of the convex of index i.
+    std::vector<size_type> orig(nb_allocated_convex());
+    for (size_type k = 0; k < orig.size(); ++k) orig[k] = k;
+    auto swap_cv = [this, &orig](size_type k, size_type l) {
+      if (k != l) {
+        swap_convex_except_regions(k, l);
+        std::swap(orig[k], orig[l]);
+      }
+    };
+
     size_type i, j = nb_convex(), nbc = j;
     for (i = 0; i < j; i++)
       if (!convex_tab.index_valid(i))
-        swap_convex(i, convex_tab.ind_last());
+        swap_cv(i, convex_tab.ind_last());
     if (pts.size())
       for (i = 0, j = pts.size()-1;
            i < j && j != ST_NIL; ++i, --j) {
@@ -241,12 +252,24 @@ namespace getfem {
       for (i = 0; i < nbc; ++i) {
         j = iordinv[cmk[i]];
         if (i != j) {
-          swap_convex(i, j);
+          swap_cv(i, j);
           std::swap(iord[i], iord[j]);
           std::swap(iordinv[iord[i]], iordinv[iord[j]]);
         }
       }
     }
+
+    std::vector<size_type> new_numbers(orig.size());
+    bool renumbered = false;
+    for (size_type k = 0; k < orig.size(); ++k) {
+      new_numbers[orig[k]] = k;
+      if (orig[k] != k) renumbered = true;
+    }
+    if (renumbered) {
+      for (dal::bv_visitor ir(valid_cvf_sets); !ir.finished(); ++ir)
+        cvf_sets[ir].renumber_convexes(new_numbers);
+      touch();
+    }
   }
 
   void mesh::translation(const base_small_vector &V)
@@ -270,6 +293,33 @@ namespace getfem {
     }
   }
 
+  const std::vector<dal::bit_vector> &mesh::convex_colors() const {
+    if (!colors_uptodate) {
+      // Greedy coloring: each convex takes the first color not used by a
+      // convex sharing one of its points.
+      cv_colors.clear();
+      std::vector<size_type> color_of(nb_allocated_convex(), size_type(-1));
+      std::vector<size_type> used_by; // last convex having seen a color
+      for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+        for (size_type ip : ind_points_of_convex(cv))
+          for (size_type cv2 : convex_to_point(ip)) {
+            size_type c = color_of[cv2];
+            if (c != size_type(-1)) used_by[c] = cv;
+          }
+        size_type c = 0;
+        while (c < used_by.size() && used_by[c] == cv) ++c;
+        if (c == used_by.size()) {
+          used_by.push_back(size_type(-1));
+          cv_colors.push_back(dal::bit_vector());
+        }
+        color_of[cv] = c;
+        cv_colors[c].add(cv);
+      }
+      colors_uptodate = true;
+    }
+    return cv_colors;
+  }
+
   void mesh::clear(void) {
     mesh_structure::clear();
     pts.clear();
@@ -356,7 +406,7 @@ namespace getfem {
   }
 
   void mesh::sup_convex(size_type ic, bool sup_points) {
-    static std::vector<size_type> ipt;
+    THREAD_SAFE_STATIC std::vector<size_type> ipt;
     if (sup_points) {
       const ind_cv_ct &ct = ind_points_of_convex(ic);
       ipt.assign(ct.begin(), ct.end());
@@ -372,15 +422,19 @@ namespace getfem {
 
   void mesh::swap_convex(size_type i, size_type j) {
     if (i != j) {
-      bgeot::mesh_structure::swap_convex(i,j);
-      trans_exists.swap(i, j);
-      gtab.swap(i,j);
+      swap_convex_except_regions(i, j);
       swap_convex_in_regions(i, j);
-      if (Bank_info.get()) Bank_swap_convex(i,j);
-      cvs_v_num[i] = cvs_v_num[j] = act_counter(); touch();
     }
   }
 
+  void mesh::swap_convex_except_regions(size_type i, size_type j) {
+    bgeot::mesh_structure::swap_convex(i,j);
+    trans_exists.swap(i, j);
+    gtab.swap(i,j);
+    if (Bank_info.get()) Bank_swap_convex(i,j);
+    cvs_v_num[i] = cvs_v_num[j] = act_counter(); touch();
+  }
+
   base_small_vector mesh::normal_of_face_of_convex(size_type ic, short_type f,
                                                    const base_node &pt) const {
     bgeot::pgeometric_trans pgt = trans_of_convex(ic);
@@ -653,6 +707,11 @@ namespace getfem {
   }
 
   void mesh::read_from_file(const std::string &name) {
+    if (bgeot::binary_file_reader::is_binary_file(name)) {
+      bgeot::binary_file_reader r(name);
+      read_from_binary(r);
+      return;
+    }
     std::ifstream o(name.c_str());
     GMM_ASSERT1(o, "Mesh file '" << name << "' does not exist");
     read_from_file(o);
@@ -715,6 +774,102 @@ namespace getfem {
     o.close();
   }
 
+  /* Binary MESH section: the points (indices and coordinates), the
+     convexes grouped by geometric transformation and the regions. */
+  void mesh::write_to_binary(bgeot::binary_file_writer &w) const {
+    w.begin_section("MESH");
+    w.put(uint32_t(dim()));
+    std::vector<uint64_t> ind; std::vector<double> coords;
+    ind.reserve(nb_points()); coords.reserve(nb_points() * dim());
+    for (dal::bv_visitor ip(points_index()); !ip.finished(); ++ip) {
+      ind.push_back(ip);
+      coords.insert(coords.end(), pts[ip].begin(), pts[ip].end());
+    }
+    w.put(uint64_t(ind.size()));
+    w.put_array(ind.data(), ind.size());
+    w.put_array(coords.data(), coords.size());
+
+    std::map<bgeot::pgeometric_trans, std::vector<size_type>> groups;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+      groups[trans_of_convex(cv)].push_back(cv);
+    w.put(uint64_t(groups.size()));
+    for (const auto &group : groups) {
+      size_type nb = group.first->nb_points();
+      w.put_string(bgeot::name_of_geometric_trans(group.first));
+      ind.assign(group.second.begin(), group.second.end());
+      w.put(uint64_t(ind.size()));
+      w.put_array(ind.data(), ind.size());
+      ind.resize(0); ind.reserve(group.second.size() * nb);
+      for (size_type cv : group.second)
+        ind.insert(ind.end(), ind_points_of_convex(cv).begin(),
+                   ind_points_of_convex(cv).end());
+      w.put_array(ind.data(), ind.size());
+    }
+
+    w.put(uint64_t(valid_cvf_sets.card()));
+    for (dal::bv_visitor bnum(valid_cvf_sets); !bnum.finished(); ++bnum) {
+      w.put(uint64_t(bnum));
+      region(bnum).write_to_binary(w);
+    }
+    w.end_section();
+  }
+
+  void mesh::read_from_binary(bgeot::binary_file_reader &r) {
+    GMM_ASSERT1(r.find_section("MESH"), "No mesh in this binary file");
+    clear();
+    dim_type N = dim_type(r.get<uint32_t>());
+    size_type nbpt = size_type(r.get<uint64_t>());
+    std::vector<uint64_t> ind(nbpt);
+    std::vector<double> coords(nbpt * N);
+    r.get_array(ind.data(), nbpt);
+    r.get_array(coords.data(), nbpt * N);
+    base_node P(N);
+    for (size_type i = 0; i < nbpt; ++i) {
+      std::copy(coords.begin() + i*N, coords.begin() + (i+1)*N, P.begin());
+      size_type ipl = add_point(P, scalar_type(0), false);
+      if (ipl != ind[i]) swap_points(ind[i], ipl);
+    }
+
+    size_type nbgroups = size_type(r.get<uint64_t>());
+    for (size_type g = 0; g < nbgroups; ++g) {
+      bgeot::pgeometric_trans pgt
+        = bgeot::geometric_trans_descriptor(r.get_string());
+      size_type nb = pgt->nb_points(), nbcv = size_type(r.get<uint64_t>());
+      std::vector<uint64_t> cvs(nbcv);
+      r.get_array(cvs.data(), nbcv);
+      ind.resize(nbcv * nb);
+      r.get_array(ind.data(), ind.size());
+      for (size_type k = 0; k < nbcv; ++k) {
+        size_type i = add_convex_noverif(pgt, ind.begin() + k*nb);
+        if (i != cvs[k]) swap_convex(i, size_type(cvs[k]));
+      }
+    }
+    touch();
+
+    size_type nbregions = size_type(r.get<uint64_t>());
+    std::vector<int16_t> faces;
+    for (size_type k = 0; k < nbregions; ++k) {
+      size_type bnum = size_type(r.get<uint64_t>());
+      if (r.version() >= 2) { region(bnum).read_from_binary(r); continue; }
+      // Format version 1: the convex and the face of each element
+      size_type nb = size_type(r.get<uint64_t>());
+      ind.resize(nb); faces.resize(nb);
+      r.get_array(ind.data(), nb);
+      r.get_array(faces.data(), nb);
+      mesh_region &rg = region(bnum);
+      for (size_type i = 0; i < nb; ++i)
+        rg.add(size_type(ind[i]), short_type(faces[i]));
+    }
+  }
+
+  void mesh::write_to_binary_file(const std::string &name) const {
+    std::ofstream o(name.c_str(), std::ios::binary);
+    GMM_ASSERT1(o, "impossible to write to file '" << name << "'");
+    bgeot::binary_file_writer w(o);
+    write_to_binary(w);
+    o.close();
+  }
+
   size_type mesh::memsize(void) const {
     return bgeot::mesh_structure::memsize() - sizeof(bgeot::mesh_structure)
       + pts.memsize() + (pts.index().last_true()+1)*dim()*sizeof(scalar_type)
@@ -746,9 +901,9 @@ namespace getfem {
                                    const base_matrix& G,
                                    pintegration_method pi) {
     double area(0);
-    static bgeot::pgeometric_trans pgt_old = 0;
-    static bgeot::pgeotrans_precomp pgp = 0;
-    static pintegration_method pim_old = 0;
+    THREAD_SAFE_STATIC bgeot::pgeometric_trans pgt_old = 0;
+    THREAD_SAFE_STATIC bgeot::pgeotrans_precomp pgp = 0;
+    THREAD_SAFE_STATIC pintegration_method pim_old = 0;
     papprox_integration pai = get_approx_im_or_fail(pi);
     if (pgt_old != pgt || pim_old != pi) {
       pgt_old = pgt;
@@ -771,8 +926,8 @@ namespace getfem {
   */
   scalar_type convex_quality_estimate(bgeot::pgeometric_trans pgt,
                                       const base_matrix& G) {
-    static bgeot::pgeometric_trans pgt_old = 0;
-    static bgeot::pgeotrans_precomp pgp = 0;
+    THREAD_SAFE_STATIC bgeot::pgeometric_trans pgt_old = 0;
+    THREAD_SAFE_STATIC bgeot::pgeotrans_precomp pgp = 0;
     if (pgt_old != pgt) {
       pgt_old=pgt;
       pgp=bgeot::geotrans_precomp(pgt, pgt->pgeometric_nodes(), 0);
@@ -797,8 +952,8 @@ namespace getfem {
 
   scalar_type convex_radius_estimate(bgeot::pgeometric_trans pgt,
                                      const base_matrix& G) {
-    static bgeot::pgeometric_trans pgt_old = 0;
-    static bgeot::pgeotrans_precomp pgp = 0;
+    THREAD_SAFE_STATIC bgeot::pgeometric_trans pgt_old = 0;
+    THREAD_SAFE_STATIC bgeot::pgeotrans_precomp pgp = 0;
     if (pgt_old != pgt) {
       pgt_old=pgt;
       pgp=bgeot::geotrans_precomp(pgt, pgt->pgeometric_nodes(), 0);
@@ -1114,19 +1269,27 @@ namespace getfem {
       m.add_simplex(dim_type(n), tab);
   }
 
-  struct mesh_cache_for_Bank_basic_refine_convex : public mesh {};
+  // The cached refinement is kept with the singleton mesh so that each
+  // caller thread uses its own one.
+  struct mesh_cache_for_Bank_basic_refine_convex : public mesh {
+    bgeot::pgeometric_trans pgt1 = 0;
+    bgeot::pstored_point_tab pspt = 0;
+    bgeot::pgeotrans_precomp pgp = 0;
+    std::vector<size_type> ipt, ipt2, icl;
+  };
 
   void mesh::Bank_basic_refine_convex(size_type i) {
     bgeot::pgeometric_trans pgt = trans_of_convex(i);
     size_type n = pgt->basic_structure()->dim();
 
-    static bgeot::pgeometric_trans pgt1 = 0;
-
-    mesh &mesh2 = dal::singleton<mesh_cache_for_Bank_basic_refine_convex>::instance();
-
-    static bgeot::pstored_point_tab pspt = 0;
-    static bgeot::pgeotrans_precomp pgp = 0;
-    static std::vector<size_type> ipt, ipt2, icl;
+    mesh_cache_for_Bank_basic_refine_convex &cache
+      = dal::singleton<mesh_cache_for_Bank_basic_refine_convex>::instance();
+    mesh &mesh2 = cache;
+    bgeot::pgeometric_trans &pgt1 = cache.pgt1;
+    bgeot::pstored_point_tab &pspt = cache.pspt;
+    bgeot::pgeotrans_precomp &pgp = cache.pgp;
+    std::vector<size_type> &ipt = cache.ipt, &ipt2 = cache.ipt2;
+    std::vector<size_type> &icl = cache.icl;
 
     if (pgt != pgt1) {
       pgt1 = pgt;
@@ -1233,7 +1396,10 @@ namespace getfem {
     return size_type(-1);
   }
 
-  struct mesh_cache_for_Bank_build_green_simplexes : public mesh {};
+  struct mesh_cache_for_Bank_build_green_simplexes : public mesh {
+    size_type d0 = 0;
+    bgeot::pstored_point_tab pspt1 = 0;
+  };
 
   void mesh::Bank_build_green_simplexes(size_type ic,
                                         std::vector<size_type> &ipt) {
@@ -1248,10 +1414,11 @@ namespace getfem {
     bgeot::pgeometric_trans pgt = gs.pgt = trans_of_convex(ic);
 
     size_type d = ipt.size() - 1, n = structure_of_convex(ic)->dim();
-    static size_type d0 = 0;
-    static bgeot::pstored_point_tab pspt1 = 0;
-    mesh &mesh1
+    mesh_cache_for_Bank_build_green_simplexes &cache
       = dal::singleton<mesh_cache_for_Bank_build_green_simplexes>::instance();
+    mesh &mesh1 = cache;
+    size_type &d0 = cache.d0;
+    bgeot::pstored_point_tab &pspt1 = cache.pspt1;
     if (d0 != d) {
       d0 = d;
       Bank_build_first_mesh(mesh1, d);
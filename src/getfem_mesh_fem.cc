@@ -329,6 +329,7 @@ namespace getfem {
     pfem first_pf = f_elems[fe_convex.first_true()];
     if (first_pf && first_pf->is_on_real_element()) is_uniform_ = false;
     if (first_pf && first_pf->target_dim() > 1) is_uniformly_vectorized_=false;
+    if (enumerate_dof_para()) return;
 
     // Dof counter
     size_type nbdof = 0;
@@ -701,11 +702,157 @@ namespace getfem {
   }
 
   void mesh_fem::read_from_file(const std::string &name) {
+    if (bgeot::binary_file_reader::is_binary_file(name)) {
+      bgeot::binary_file_reader r(name);
+      read_from_binary(r);
+      return;
+    }
     std::ifstream o(name.c_str());
     GMM_ASSERT1(o, "Mesh_fem file '" << name << "' does not exist");
     read_from_file(o);
   }
 
+  template<typename MAT> static void
+  write_compressed_matrix(bgeot::binary_file_writer &w, const MAT &M) {
+    std::vector<uint64_t> jc(M.jc.begin(), M.jc.end());
+    std::vector<uint64_t> ir(M.ir.begin(), M.ir.end());
+    w.put(uint64_t(M.nr)); w.put(uint64_t(M.nc));
+    w.put(uint64_t(jc.size())); w.put(uint64_t(ir.size()));
+    w.put_array(jc.data(), jc.size());
+    w.put_array(ir.data(), ir.size());
+    w.put_array(M.pr.data(), M.pr.size());
+  }
+
+  template<typename MAT> static void
+  read_compressed_matrix(bgeot::binary_file_reader &r, MAT &M) {
+    M.nr = size_type(r.get<uint64_t>()); M.nc = size_type(r.get<uint64_t>());
+    std::vector<uint64_t> jc(size_type(r.get<uint64_t>()));
+    std::vector<uint64_t> ir(size_type(r.get<uint64_t>()));
+    r.get_array(jc.data(), jc.size());
+    r.get_array(ir.data(), ir.size());
+    M.jc.assign(jc.begin(), jc.end());
+    M.ir.assign(ir.begin(), ir.end());
+    M.pr.resize(ir.size());
+    r.get_array(M.pr.data(), M.pr.size());
+  }
+
+  /* Binary MFEM section: the fems grouped by name, the dof partition,
+     the dof enumeration and the optional reduction matrices. */
+  void mesh_fem::write_to_binary(bgeot::binary_file_writer &w) const {
+    context_check();
+    w.begin_section("MFEM");
+    w.put(uint32_t(get_qdim()));
+    std::map<std::string, std::vector<uint64_t>> groups;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+      groups[name_of_fem(fem_of_element(cv))].push_back(cv);
+    w.put(uint64_t(groups.size()));
+    for (const auto &group : groups) {
+      w.put_string(group.first);
+      w.put(uint64_t(group.second.size()));
+      w.put_array(group.second.data(), group.second.size());
+    }
+
+    std::vector<uint32_t> parts;
+    if (!dof_partition.empty())
+      for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+        parts.push_back(get_dof_partition(cv));
+    w.put(uint64_t(parts.size()));
+    w.put_array(parts.data(), parts.size());
+
+    // skip repeated dofs for "pseudo" vector elements
+    std::vector<uint64_t> dofs;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+      size_type q = size_type(get_qdim()) / fem_of_element(cv)->target_dim();
+      const auto &ct = ind_basic_dof_of_element(cv);
+      for (size_type i = 0; i < ct.size(); i += q) dofs.push_back(ct[i]);
+    }
+    w.put(uint64_t(dofs.size()));
+    w.put_array(dofs.data(), dofs.size());
+
+    w.put(uint32_t(use_reduction));
+    if (use_reduction) {
+      write_compressed_matrix(w, R_);
+      write_compressed_matrix(w, E_);
+    }
+    w.end_section();
+  }
+
+  void mesh_fem::read_from_binary(bgeot::binary_file_reader &r) {
+    GMM_ASSERT1(linked_mesh_ != 0, "Uninitialized mesh_fem");
+    GMM_ASSERT1(r.find_section("MFEM"), "No mesh_fem in this binary file");
+    clear();
+    set_qdim(dim_type(r.get<uint32_t>()));
+    size_type nbgroups = size_type(r.get<uint64_t>());
+    for (size_type g = 0; g < nbgroups; ++g) {
+      std::string name = r.get_string();
+      pfem pf = fem_descriptor(name);
+      GMM_ASSERT1(pf, "could not create the FEM '" << name << "'");
+      std::vector<uint64_t> cvs(size_type(r.get<uint64_t>()));
+      r.get_array(cvs.data(), cvs.size());
+      dal::bit_vector bv;
+      for (uint64_t cv : cvs) {
+        GMM_ASSERT1(linked_mesh().convex_index().is_in(cv), "Convex " << cv
+                    << " does not exist, are you sure "
+                    "that the mesh attached to this object is right one ?");
+        bv.add(size_type(cv));
+      }
+      set_finite_element(bv, pf);
+    }
+
+    std::vector<uint32_t> parts(size_type(r.get<uint64_t>()));
+    r.get_array(parts.data(), parts.size());
+    if (parts.size()) {
+      GMM_ASSERT1(parts.size() == convex_index().card(),
+                  "Wrong size of the dof partition");
+      size_type k = 0;
+      for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+        set_dof_partition(cv, parts[k++]);
+    }
+
+    std::vector<uint64_t> dofs(size_type(r.get<uint64_t>()));
+    r.get_array(dofs.data(), dofs.size());
+    dal::bit_vector doflst;
+    std::vector<size_type> tab;
+    dof_structure.clear();
+    is_uniform_ = true;
+    size_type nbdof_unif = size_type(-1), k = 0;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv) {
+      pfem pf = fem_of_element(cv);
+      size_type nbd = nb_basic_dof_of_element(cv);
+      if (nbdof_unif == size_type(-1))
+        nbdof_unif = nbd;
+      else if (nbdof_unif != nbd)
+        is_uniform_ = false;
+      size_type q = size_type(get_qdim()) / pf->target_dim();
+      GMM_ASSERT1(k + pf->nb_dof(cv) <= dofs.size(),
+                  "Wrong number of dofs in the dof enumeration");
+      tab.resize(nbd);
+      for (size_type i = 0; i < pf->nb_dof(cv); ++i) {
+        tab[i] = size_type(dofs[k++]);
+        for (size_type j = 0; j < q; ++j) doflst.add(tab[i]+j);
+      }
+      dof_structure.add_convex_noverif(pf->structure(cv), tab.begin(), cv);
+    }
+    dof_enumeration_made = true;
+    nb_total_dof = doflst.card();
+    touch(); v_num = act_counter();
+
+    if (r.get<uint32_t>()) {
+      read_compressed_matrix(r, R_);
+      read_compressed_matrix(r, E_);
+      use_reduction = true;
+    }
+  }
+
+  void mesh_fem::write_to_binary_file(const std::string &name,
+                                      bool with_mesh) const {
+    std::ofstream o(name.c_str(), std::ios::binary);
+    GMM_ASSERT1(o, "impossible to open file '" << name << "'");
+    bgeot::binary_file_writer w(o);
+    if (with_mesh) linked_mesh().write_to_binary(w);
+    write_to_binary(w);
+  }
+
   template<typename VECT> static void
   write_col(std::ostream &ost, const VECT &v) {
     typename gmm::linalg_traits<VECT>::const_iterator it = v.begin();
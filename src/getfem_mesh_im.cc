@@ -196,6 +196,11 @@ namespace getfem {
 
   void mesh_im::read_from_file(const std::string &name)
   { 
+    if (bgeot::binary_file_reader::is_binary_file(name)) {
+      bgeot::binary_file_reader r(name);
+      read_from_binary(r);
+      return;
+    }
     std::ifstream o(name.c_str());
     GMM_ASSERT1(o, "mesh_im file '" << name << "' does not exist");
     read_from_file(o);
@@ -226,6 +231,54 @@ namespace getfem {
     o.close();
   }
 
+  /* Binary MSIM section: the integration methods grouped by name. */
+  void mesh_im::write_to_binary(bgeot::binary_file_writer &w) const {
+    context_check();
+    w.begin_section("MSIM");
+    std::map<std::string, std::vector<uint64_t>> groups;
+    for (dal::bv_visitor cv(convex_index()); !cv.finished(); ++cv)
+      groups[name_of_int_method(int_method_of_element(cv))].push_back(cv);
+    w.put(uint64_t(groups.size()));
+    for (const auto &group : groups) {
+      w.put_string(group.first);
+      w.put(uint64_t(group.second.size()));
+      w.put_array(group.second.data(), group.second.size());
+    }
+    w.end_section();
+  }
+
+  void mesh_im::read_from_binary(bgeot::binary_file_reader &r) {
+    GMM_ASSERT1(linked_mesh_ != 0, "Uninitialized mesh_im");
+    GMM_ASSERT1(r.find_section("MSIM"), "No mesh_im in this binary file");
+    clear();
+    size_type nbgroups = size_type(r.get<uint64_t>());
+    for (size_type g = 0; g < nbgroups; ++g) {
+      std::string name = r.get_string();
+      pintegration_method pim = int_method_descriptor(name);
+      GMM_ASSERT1(pim, "could not create the integration method '"
+                  << name << "'");
+      std::vector<uint64_t> cvs(size_type(r.get<uint64_t>()));
+      r.get_array(cvs.data(), cvs.size());
+      dal::bit_vector bv;
+      for (uint64_t cv : cvs) {
+        GMM_ASSERT1(linked_mesh().convex_index().is_in(cv), "Convex " << cv
+                    << " does not exist, are you sure "
+                    "that the mesh attached to this object is right one ?");
+        bv.add(size_type(cv));
+      }
+      set_integration_method(bv, pim);
+    }
+  }
+
+  void mesh_im::write_to_binary_file(const std::string &name,
+                                     bool with_mesh) const {
+    std::ofstream o(name.c_str(), std::ios::binary);
+    GMM_ASSERT1(o, "impossible to open file '" << name << "'");
+    bgeot::binary_file_writer w(o);
+    if (with_mesh) linked_mesh().write_to_binary(w);
+    write_to_binary(w);
+  }
+
   struct dummy_mesh_im_ {
     mesh_im mim;
     dummy_mesh_im_() : mim() {}
@@ -19,7 +19,9 @@
 
 ===========================================================================*/
 
+#include <atomic>
 #include "getfem/getfem_mesh_level_set.h"
+#include "getfem/getfem_omp.h"
 
 
 namespace getfem {
@@ -302,7 +304,7 @@ struct Chrono {
   void mesh_level_set::run_delaunay(std::vector<base_node> &fixed_points,
 				    gmm::dense_matrix<size_type> &simplexes,
 				    std::vector<dal::bit_vector> &
-				    /* fixed_points_constraints */) {
+				    /* fixed_points_constraints */) const {
     double t0=gmm::uclock_sec();
     if (noisy) cout << "running delaunay with " << fixed_points.size()
 		    << " points.." << std::flush;
@@ -363,10 +365,12 @@ struct Chrono {
      This information is now refined for each sub-convex.
   */
   void mesh_level_set::find_zones_of_element(size_type cv,
-					     std::string &prezone,
-					     scalar_type radius) {
-    convex_info &cvi = cut_cv[cv];
-    cvi.zones.clear();
+					     const convex_info &cvi,
+					     const std::string &prezone,
+					     scalar_type radius,
+					     std::vector<std::string> &subzones)
+    const {
+    subzones.resize(0);
     for (dal::bv_visitor i(cvi.pmsh->convex_index()); !i.finished();++i) {
       // If the sub element is too small, the zone is not taken into account
       if (cvi.pmsh->convex_area_estimate(i) > 1e-8) {
@@ -374,26 +378,25 @@ struct Chrono {
 	//cout << "prezone for convex " << cv << " : " << subz << endl;
 	for (size_type j = 0; j < level_sets.size(); ++j) {
 	  if (subz[j] == '*' || subz[j] == '0') {
-	    int s = sub_simplex_is_not_crossed_by(cv, level_sets[j], i,radius);
+	    int s = sub_simplex_is_not_crossed_by(cv, cvi, level_sets[j], i,
+						  radius);
 	    // cout << "sub_simplex_is_not_crossed_by = " << s << endl;
 	    subz[j] = (s < 0) ? '-' : ((s > 0) ? '+' : '0');
 	  }
 	}
-	merge_zoneset(cvi.zones, subz);
+	subzones.push_back(subz);
       }
     }
-    if (noisy) cout << "Number of zones for convex " << cv << " : "
-		    << cvi.zones.size() << endl;
   }
 
 
   void mesh_level_set::cut_element(size_type cv,
 				   const dal::bit_vector &primary,
 				   const dal::bit_vector &secondary,
-				   scalar_type radius_cv) {
+				   scalar_type radius_cv,
+				   convex_info &cvi) const {
     
-    cut_cv[cv] = convex_info();
-    cut_cv[cv].pmsh = std::make_shared<mesh>();
+    cvi.pmsh = std::make_shared<mesh>();
     if (noisy) cout << "cutting element " << cv << endl;
     bgeot::pgeometric_trans pgt = linked_mesh().trans_of_convex(cv);
     pmesher_signed_distance ref_element = new_ref_element(pgt);
@@ -525,9 +528,9 @@ struct Chrono {
       
       std::vector<base_node> fixed_points;
       std::vector<dal::bit_vector> fixed_points_constraints;
-      mesh &msh(*(cut_cv[cv].pmsh));
+      mesh &msh(*(cvi.pmsh));
 	
-      mesh_region &ls_border_faces(cut_cv[cv].ls_border_faces);
+      mesh_region &ls_border_faces(cvi.ls_border_faces);
       std::vector<base_node> cvpts;
 
       size_type nb_delaunay = 0;
@@ -858,33 +861,108 @@ struct Chrono {
     }    
   }
 
-  void mesh_level_set::adapt(void) {
+  bool mesh_level_set::level_set_values_changed(size_type cv) const {
+    for (size_type k = 0; k < level_sets.size(); ++k) {
+      const mesh_fem &mf = level_sets[k]->get_mesh_fem();
+      for (unsigned lsnum = 0; lsnum < 2; ++lsnum) {
+	if (lsnum == 1 && !(level_sets[k]->has_secondary())) break;
+	const std::vector<scalar_type> &v = level_sets[k]->values(lsnum);
+	const std::vector<scalar_type> &v0 = adapted_values[2*k+lsnum];
+	for (const size_type &dof : mf.ind_basic_dof_of_element(cv))
+	  if (v[dof] != v0[dof]) return true;
+      }
+    }
+    return false;
+  }
+
+  void mesh_level_set::adapt(bool incremental) {
 
     // compute the elements touched by each level set
     // for each element touched, compute the sub mesh
     //   then compute the adapted integration method
     GMM_ASSERT1(linked_mesh_ != 0, "Uninitialized mesh_level_set");
-    cut_cv.clear();
-    allsubzones.clear();
-    zones_of_convexes.clear();
-    allzones.clear();
+    context_check();
+    const mesh &m = linked_mesh();
+
+    bool incr = incremental && is_adapted_ && adapted_level_sets == level_sets;
+    for (size_type k = 0; k < level_sets.size(); ++k) {
+      level_sets[k]->get_mesh_fem().nb_dof(); // dof enumeration, not in //
+      for (unsigned lsnum = 0; lsnum < 2 && incr; ++lsnum)
+	incr = (level_sets[k]->values(lsnum).size()
+		== adapted_values[2*k+lsnum].size());
+    }
+
+    dal::bit_vector to_adapt;
+    if (incr) {
+      for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+	if (level_set_values_changed(cv)) to_adapt.add(cv);
+      for (dal::bv_visitor cv(to_adapt); !cv.finished(); ++cv)
+	cut_cv.erase(cv);
+      // allsubzones and allzones are kept, the zones of the convexes
+      // which are not cut again refer to them.
+    } else {
+      cut_cv.clear();
+      allsubzones.clear();
+      zones_of_convexes.clear();
+      allzones.clear();
+      to_adapt = m.convex_index();
+    }
 
     // noisy = true;
 
-    std::string z;
-    for (dal::bv_visitor cv(linked_mesh().convex_index()); 
-	 !cv.finished(); ++cv) {
-      scalar_type radius = linked_mesh().convex_radius_estimate(cv);
+    std::vector<size_type> cvs;
+    cvs.reserve(to_adapt.card());
+    for (dal::bv_visitor cv(to_adapt); !cv.finished(); ++cv) cvs.push_back(cv);
+
+    /* The elements are taken one by one from a shared queue since the
+       cost of cutting an element is very variable. Each cut element is
+       built independently into its own sub-mesh, the zones are merged
+       afterwards in the element order.
+    */
+    struct cut_result {
+      convex_info cvi;
+      std::vector<std::string> subzones;
+    };
+    std::vector<std::string> prezones(cvs.size());
+    std::vector<std::unique_ptr<cut_result>> cuts(cvs.size());
+    std::atomic<size_type> next_cv(0);
+
+    auto adapt_elements = [&]() {
       dal::bit_vector prim, sec;
-      find_crossing_level_set(cv, prim, sec, z, radius);
-      zones_of_convexes[cv] = &(*(allsubzones.insert(z).first));
-      if (noisy) cout << "element " << cv << " cut level sets : "
-		      << prim << " zone : " << z << endl;
-      if (prim.card()) {
-	cut_element(cv, prim, sec, radius);
-	find_zones_of_element(cv, z, radius);
+      for (size_type k = next_cv++; k < cvs.size(); k = next_cv++) {
+	size_type cv = cvs[k];
+	scalar_type radius = m.convex_radius_estimate(cv);
+	find_crossing_level_set(cv, prim, sec, prezones[k], radius);
+	if (noisy) cout << "element " << cv << " cut level sets : "
+			<< prim << " zone : " << prezones[k] << endl;
+	if (prim.card()) {
+	  cuts[k] = std::make_unique<cut_result>();
+	  cut_element(cv, prim, sec, radius, cuts[k]->cvi);
+	  find_zones_of_element(cv, cuts[k]->cvi, prezones[k], radius,
+				cuts[k]->subzones);
+	}
+      }
+    };
+
+    if (noisy || me_is_multithreaded_now())
+      adapt_elements();
+    else
+      GETFEM_OMP_PARALLEL_NO_PARTITION(adapt_elements());
+
+    for (size_type k = 0; k < cvs.size(); ++k) {
+      size_type cv = cvs[k];
+      zones_of_convexes[cv] = &(*(allsubzones.insert(prezones[k]).first));
+      if (cuts[k]) {
+	convex_info &cvi = cut_cv[cv];
+	cvi = cuts[k]->cvi;
+	for (const std::string &subz : cuts[k]->subzones)
+	  merge_zoneset(cvi.zones, subz);
+	if (noisy) cout << "Number of zones for convex " << cv << " : "
+			<< cvi.zones.size() << endl;
+	cuts[k].reset();
       }
     }
+
     if (noisy) {
       getfem::stored_mesh_slice sl;
       sl.build(global_mesh(), getfem::slicer_none(), 6);
@@ -895,6 +973,12 @@ struct Chrono {
     }
 
     update_crack_tip_convexes();
+
+    adapted_level_sets = level_sets;
+    adapted_values.resize(2*level_sets.size());
+    for (size_type k = 0; k < level_sets.size(); ++k)
+      for (unsigned lsnum = 0; lsnum < 2; ++lsnum)
+	adapted_values[2*k+lsnum] = level_sets[k]->values(lsnum);
     is_adapted_ = true;
   }
 
@@ -923,12 +1007,11 @@ struct Chrono {
   //         0 if the sub-element is one the positive part of the secundary
   //           level-set if any.
   int mesh_level_set::sub_simplex_is_not_crossed_by(size_type cv,
+						    const convex_info &cvi,
 						    plevel_set ls,
 						    size_type sub_cv,
-						    scalar_type radius) {
+						    scalar_type radius) const {
     scalar_type EPS = 1e-7 * radius;
-    bgeot::pgeometric_trans pgt = linked_mesh().trans_of_convex(cv);
-    convex_info &cvi = cut_cv[cv];
     bgeot::pgeometric_trans pgt2 = cvi.pmsh->trans_of_convex(sub_cv);
 
     // cout << "cv " << cv << " radius = " << radius << endl;
@@ -958,7 +1041,8 @@ struct Chrono {
   }
 
   int mesh_level_set::is_not_crossed_by(size_type cv, plevel_set ls,
-					unsigned lsnum, scalar_type radius) {
+					unsigned lsnum,
+					scalar_type radius) const {
     const mesh_fem &mf = ls->get_mesh_fem();
     GMM_ASSERT1(!mf.is_reduced(), "Internal error");
     const mesh_fem::ind_dof_ct &dofs = mf.ind_basic_dof_of_element(cv);
@@ -1006,7 +1090,7 @@ struct Chrono {
 					       dal::bit_vector &prim,
 					       dal::bit_vector &sec,
 					       std::string &z,
-					       scalar_type radius) {
+					       scalar_type radius) const {
     prim.clear(); sec.clear();
     z = std::string(level_sets.size(), '*');
     unsigned lsnum = 0;
@@ -19,9 +19,12 @@
 
 ===========================================================================*/
 
+#include <algorithm>
+#include <iterator>
 #include "getfem/getfem_mesh_region.h"
 #include "getfem/getfem_mesh.h"
 #include "getfem/getfem_omp.h"
+#include "getfem/bgeot_ftool.h"
 
 namespace getfem {
 
@@ -61,7 +64,6 @@ namespace getfem {
 
   void mesh_region::mark_region_changed() const{
     index_updated.all_threads() = false;
-    partitions_updated.all_threads() = false;
     serial_index_updated = false;
   }
 
@@ -132,72 +134,143 @@ namespace getfem {
     mr.from_mesh(m2);
     if (p && !(mr.p)) return false;
     if (!p && mr.p) return false;
-    if (p)
-      if (p->m != mr.p->m) return false;
+    if (p) {
+      // The entries emptied by sup() are ignored.
+      const entries_t &e1 = rp().m, &e2 = mr.rp().m;
+      auto it1 = e1.begin(), it2 = e2.begin();
+      for (;; ++it1, ++it2) {
+        while (it1 != e1.end() && it1->second.none()) ++it1;
+        while (it2 != e2.end() && it2->second.none()) ++it2;
+        if (it1 == e1.end() || it2 == e2.end()) break;
+        if (*it1 != *it2) return false;
+      }
+      if (it1 != e1.end() || it2 != e2.end()) return false;
+    }
     return true;
   }
 
+  static bool entry_less(const mesh_region::entry &a,
+                         const mesh_region::entry &b)
+  { return a.first < b.first; }
+
+  mesh_region::impl &mesh_region::impl::operator=(const impl &other) {
+    other.sort();
+    m = other.m;
+    sorted = true;
+    index_ = other.index_;
+    serial_index_ = other.serial_index_;
+    return *this;
+  }
+
+  void mesh_region::impl::sort() const {
+    GLOBAL_OMP_GUARD
+    if (sorted) return;
+    std::stable_sort(m.begin(), m.end(), entry_less);
+    auto itw = m.begin();
+    for (auto it = m.begin(); it != m.end(); ) {
+      entry e = *it;
+      for (++it; it != m.end() && it->first == e.first; ++it)
+        e.second |= it->second;
+      if (e.second.any()) *itw++ = e;
+    }
+    m.erase(itw, m.end());
+    sorted = true;
+  }
+
+  void mesh_region::impl::compact() const {
+    m.erase(std::remove_if(m.begin(), m.end(),
+                           [](const entry &e) { return e.second.none(); }),
+            m.end());
+  }
+
+  mesh_region::entries_t::iterator mesh_region::find(size_type cv) {
+    entries_t &m = wp().m;
+    auto it = std::lower_bound(m.begin(), m.end(), entry(cv, face_bitset()),
+                               entry_less);
+    return (it != m.end() && it->first == cv) ? it : m.end();
+  }
+
+  mesh_region::entries_t::const_iterator
+    mesh_region::find(size_type cv) const {
+    const entries_t &m = rp().m;
+    auto it = std::lower_bound(m.begin(), m.end(), entry(cv, face_bitset()),
+                               entry_less);
+    return (it != m.end() && it->first == cv) ? it : m.end();
+  }
+
   face_bitset mesh_region::operator[](size_t cv) const{
-    auto it = rp().m.find(cv);
+    auto it = find(cv);
     if (it != rp().m.end()) return it->second;
     else return {};
   }
 
-  void mesh_region::update_partition_iterators() const{
-    if ((partitions_updated.thrd_cast() == true)) return;
-    itbegin = partition_begin();
-    itend = partition_end  ();
-    partitions_updated = true;
-  }
   mesh_region::const_iterator
     mesh_region::partition_begin( ) const{
     auto region_size = rp().m.size();
-    if (region_size < partitions_updated.num_threads()){
+    auto nb_partitions = index_updated.num_threads();
+    if (region_size < nb_partitions){
       //for small regions: put the whole region into zero thread
-      if (partitions_updated.this_thread() == 0) return rp().m.begin();
+      if (index_updated.this_thread() == 0) return rp().m.begin();
       else return rp().m.end();
     }
-    auto partition_size = static_cast<size_type>
-      (std::ceil(static_cast<scalar_type>(region_size)/
-       static_cast<scalar_type >(partitions_updated.num_threads())));
-    auto index_begin = partition_size * partitions_updated.this_thread();
-    if (index_begin >= region_size ) return rp().m.end();
-
-    auto it = rp().m.begin();
-    for (size_type i = 0; i != index_begin; ++i) ++it;
-    return it;
+    auto partition_size = (region_size + nb_partitions - 1) / nb_partitions;
+    auto index_begin = partition_size * index_updated.this_thread();
+    return rp().m.begin() + std::min(index_begin, region_size);
   }
 
   mesh_region::const_iterator
     mesh_region::partition_end( ) const{
     auto region_size = rp().m.size();
-    if (region_size< partitions_updated.num_threads()) return rp().m.end();
-
-    auto partition_size = static_cast<size_type>
-      (std::ceil(static_cast<scalar_type>(region_size)/
-       static_cast<scalar_type >(partitions_updated.num_threads())));
-    auto index_end = partition_size * (partitions_updated.this_thread() + 1);
-    if (index_end >= region_size ) return  rp().m.end();
+    auto nb_partitions = index_updated.num_threads();
+    if (region_size < nb_partitions) return rp().m.end();
+    auto partition_size = (region_size + nb_partitions - 1) / nb_partitions;
+    auto index_end = partition_size * (index_updated.this_thread() + 1);
+    return rp().m.begin() + std::min(index_end, region_size);
+  }
+
+  std::pair<mesh_region::const_iterator, mesh_region::const_iterator>
+    mesh_region::balanced_partition(const entry_cost &cost) const{
+    const entries_t &m = rp().m;
+    auto nb_partitions = index_updated.num_threads();
+    auto partition = index_updated.this_thread();
+    std::vector<scalar_type> costs(m.size());
+    scalar_type total_cost(0);
+    size_type i = 0;
+    for (const auto &e : m) {
+      scalar_type c(0);
+      for (short_type f = 0; f <= MAX_FACES_PER_CV; ++f)
+        if (e.second.test(f)) c += cost(e.first, short_type(f-1));
+      costs[i++] = c; total_cost += c;
+    }
 
-    auto it = rp().m.begin();
-    for (size_type i = 0; i < index_end && it != rp().m.end(); ++i) ++it;
-    return it;
+    // An entry goes to the partition containing the cost accumulated before
+    // it. The result only depends on the costs, so that all the threads
+    // agree on the partitions. Equal sizes if the costs are all zero.
+    auto it = m.begin(), itb = m.end(), ite = m.end();
+    scalar_type acc(0);
+    for (i = 0; it != m.end(); ++it, ++i) {
+      size_type p = (total_cost > scalar_type(0))
+        ? size_type(acc * scalar_type(nb_partitions) / total_cost)
+        : (i * nb_partitions) / m.size();
+      p = std::min(p, nb_partitions - 1);
+      if (p > partition) { ite = it; break; }
+      if (p == partition && itb == m.end()) itb = it;
+      acc += costs[i];
+    }
+    if (itb == m.end()) ite = m.end();
+    return {itb, ite};
   }
 
   mesh_region::const_iterator mesh_region::begin() const{
     GMM_ASSERT1(p != 0, "Internal error");
-    if (me_is_multithreaded_now() && partitioning_allowed){
-      update_partition_iterators();
-      return itbegin;
-    }
+    if (me_is_multithreaded_now() && partitioning_allowed)
+      return partition_begin();
     else return rp().m.begin();
   }
 
   mesh_region::const_iterator mesh_region::end() const{
-    if (me_is_multithreaded_now() && partitioning_allowed){
-      update_partition_iterators();
-      return itend;
-    }
+    if (me_is_multithreaded_now() && partitioning_allowed)
+      return partition_end();
     else return rp().m.end();
   }
 
@@ -253,33 +326,50 @@ namespace getfem {
   }
 
   void mesh_region::add(const dal::bit_vector &bv){
-    for (dal::bv_visitor i(bv); !i.finished(); ++i){
-      wp().m[i].set(0, 1);
+    entries_t &m = wp().m;
+    size_type n = m.size(), i = 0;
+    for (dal::bv_visitor cv(bv); !cv.finished(); ++cv){
+      while (i < n && m[i].first < cv) ++i;
+      if (i < n && m[i].first == cv) m[i].second.set(0, 1);
+      else m.push_back(entry(cv, face_bitset(1)));
     }
+    std::inplace_merge(m.begin(), m.begin() + n, m.end(), entry_less);
     touch_parent_mesh();
     mark_region_changed();
   }
 
   void mesh_region::add(size_type cv, short_type f){
-    wp().m[cv].set(short_type(f + 1), 1);
+    // Entries added in increasing order are appended, the other ones are
+    // appended too if not already present and sorted at the next access.
+    impl &r = *p;
+    entries_t::iterator it = r.m.end();
+    if (!r.m.empty() && r.m.back().first == cv) it = r.m.end() - 1;
+    else if (r.sorted && !r.m.empty() && r.m.back().first > cv) {
+      it = std::lower_bound(r.m.begin(), r.m.end(),
+                            entry(cv, face_bitset()), entry_less);
+      if (it->first != cv) { it = r.m.end(); r.sorted = false; }
+    }
+    else if (!r.m.empty() && r.m.back().first > cv) r.sorted = false;
+    if (it == r.m.end())
+      r.m.push_back(entry(cv, face_bitset().set(short_type(f + 1))));
+    else it->second.set(short_type(f + 1), 1);
     touch_parent_mesh();
     mark_region_changed();
   }
 
   void mesh_region::sup_all(size_type cv){
-    auto it = wp().m.find(cv);
+    auto it = find(cv);
     if (it != wp().m.end()){
-      wp().m.erase(it);
+      it->second.reset();
       touch_parent_mesh();
       mark_region_changed();
     }
   }
 
   void mesh_region::sup(size_type cv, short_type f){
-    auto it = wp().m.find(cv);
+    auto it = find(cv);
     if (it != wp().m.end()) {
       it->second.set(short_type(f + 1), 0);
-      if (it->second.none()) wp().m.erase(it);
       touch_parent_mesh();
       mark_region_changed();
     }
@@ -292,42 +382,52 @@ namespace getfem {
   }
 
   void mesh_region::clean(){
-    for (map_t::iterator it = wp().m.begin(), itn;
-         it != wp().m.end(); it = itn) {
-      itn = it;
-      ++itn;
-      if (!(*it).second.any()) wp().m.erase(it);
-    }
+    wp().compact();
     touch_parent_mesh();
     mark_region_changed();
   }
 
   void mesh_region::swap_convex(size_type cv1, size_type cv2){
-    auto it1 = wp().m.find(cv1);
-    auto it2 = wp().m.find(cv2);
-    auto ite = wp().m.end();
+    auto it1 = find(cv1), it2 = find(cv2), ite = wp().m.end();
     face_bitset f1, f2;
-
     if (it1 != ite) f1 = it1->second;
     if (it2 != ite) f2 = it2->second;
-    if (!f1.none()) wp().m[cv2] = f1;
-    else if (it2 != ite) wp().m.erase(it2);
-    if (!f2.none()) wp().m[cv1] = f2;
-    else if (it1 != ite) wp().m.erase(it1);
+    if (it1 != ite && it2 != ite) {
+      it1->second = f2; it2->second = f1;
+    } else if (it1 != ite || it2 != ite) {
+      // The entry changes of convex and is moved to its place
+      entries_t &m = p->m;
+      auto it = (it1 != ite) ? it1 : it2;
+      size_type cv = (it1 != ite) ? cv2 : cv1;
+      auto itn = std::lower_bound(m.begin(), m.end(),
+                                  entry(cv, face_bitset()), entry_less);
+      if (itn > it) { std::rotate(it, it + 1, itn); --itn; }
+      else std::rotate(itn, it, it + 1);
+      itn->first = cv;
+    }
+    touch_parent_mesh();
+    mark_region_changed();
+  }
+
+  void mesh_region::renumber_convexes
+  (const std::vector<size_type> &new_numbers){
+    for (entry &e : wp().m)
+      if (e.first < new_numbers.size()) e.first = new_numbers[e.first];
+    std::sort(p->m.begin(), p->m.end(), entry_less);
     touch_parent_mesh();
     mark_region_changed();
   }
 
   bool mesh_region::is_in(size_type cv, short_type f) const{
     GMM_ASSERT1(p, "Use from mesh on that region before");
-    auto it = rp().m.find(cv);
+    auto it = find(cv);
     if (it == rp().m.end() || short_type(f+1) >= MAX_FACES_PER_CV) return false;
     return ((*it).second)[short_type(f+1)];
   }
 
   bool mesh_region::is_in(size_type cv, short_type f, const mesh &m) const{
     if (p) {
-      auto it = rp().m.find(cv);
+      auto it = find(cv);
       if (it == rp().m.end() || short_type(f+1) >= MAX_FACES_PER_CV)
         return false;
       return ((*it).second)[short_type(f+1)];
@@ -339,7 +439,8 @@ namespace getfem {
   }
 
   bool mesh_region::is_empty() const{
-    return rp().m.empty();
+    for (const entry &e : rp().m) if (e.second.any()) return false;
+    return true;
   }
 
   bool mesh_region::is_only_convexes() const{
@@ -352,23 +453,24 @@ namespace getfem {
   }
 
   face_bitset mesh_region::faces_of_convex(size_type cv) const{
-    auto it = rp().m.find(cv);
+    auto it = find(cv);
     if (it != rp().m.end()) return ((*it).second) >> 1;
     else return face_bitset();
   }
 
   face_bitset mesh_region::and_mask() const{
     face_bitset bs;
-    if (rp().m.empty()) return bs;
-    bs.set();
+    bool first = true;
     for (auto it = rp().m.begin(); it != rp().m.end(); ++it)
-      if ( (*it).second.any() )  bs &= (*it).second;
+      if ( (*it).second.any() ) {
+        if (first) bs = (*it).second; else bs &= (*it).second;
+        first = false;
+      }
     return bs;
   }
 
   face_bitset mesh_region::or_mask() const{
     face_bitset bs;
-    if (rp().m.empty()) return bs;
     for (auto it = rp().m.begin(); it != rp().m.end(); ++it)
       if ( (*it).second.any() )  bs |= (*it).second;
     return bs;
@@ -399,12 +501,15 @@ namespace getfem {
     GMM_ASSERT1(a.id() !=  size_type(-1)||
                 b.id() != size_type(-1), "the 'all_convexes' regions "
                 "are not supported for set operations");
+    auto non_empty = [](const entry &e) { return e.second.any(); };
     if (a.id() == size_type(-1)){
-      for (const_iterator it = b.begin();it != b.end(); ++it) r.wp().m.insert(*it);
+      std::copy_if(b.begin(), b.end(), std::back_inserter(r.wp().m),
+                   non_empty);
       return r;
     }
     else if (b.id() == size_type(-1)){
-      for (const_iterator it = a.begin();it != a.end(); ++it) r.wp().m.insert(*it);
+      std::copy_if(a.begin(), a.end(), std::back_inserter(r.wp().m),
+                   non_empty);
       return r;
     }
 
@@ -419,7 +524,7 @@ namespace getfem {
         if (maska[0] && !maskb[0]) bs = maskb;
         else if (maskb[0] && !maska[0]) bs = maska;
         else bs = maska & maskb;
-        if (bs.any()) r.wp().m.insert(r.wp().m.end(), std::make_pair(ita->first,bs));
+        if (bs.any()) r.wp().m.push_back(entry(ita->first, bs));
         ++ita; ++itb;
       }
     }
@@ -433,11 +538,20 @@ namespace getfem {
     GMM_ASSERT1(a.id() != size_type(-1) &&
       b.id() != size_type(-1), "the 'all_convexes' regions "
       "are not supported for set operations");
-    for (auto it = a.begin();it != a.end(); ++it){
-      r.wp().m.insert(*it);
-    }
-    for (auto it = b.begin();it != b.end(); ++it){
-      r.wp().m[it->first] |= it->second;
+    auto ita = a.begin(), enda = a.end(),
+         itb = b.begin(), endb = b.end();
+
+    while (ita != enda || itb != endb) {
+      entry e;
+      if (itb == endb || (ita != enda && ita->first < itb->first))
+        e = *ita++;
+      else if (ita == enda || itb->first < ita->first)
+        e = *itb++;
+      else {
+        e = entry(ita->first, ita->second | itb->second);
+        ++ita; ++itb;
+      }
+      if (e.second.any()) r.wp().m.push_back(e);
     }
     return r;
   }
@@ -450,20 +564,74 @@ namespace getfem {
     GMM_ASSERT1(a.id() != size_type(-1) &&
       b.id() != size_type(-1), "the 'all_convexes' regions "
       "are not supported for set operations");
-    for (auto ita = a.begin();ita != a.end(); ++ita)
-      r.wp().m.insert(*ita);
-
-    for (auto itb = b.begin();itb != b.end(); ++itb){
-      auto cv = itb->first;
-      auto it = r.wp().m.find(cv);
-      if (it != r.wp().m.end()){
-                it->second &= ~(itb->second);
-                if (it->second.none()) r.wp().m.erase(it);
-          }
+    auto itb = b.begin(), endb = b.end();
+    for (auto ita = a.begin(); ita != a.end(); ++ita){
+      while (itb != endb && itb->first < ita->first) ++itb;
+      face_bitset bs = ita->second;
+      if (itb != endb && itb->first == ita->first) bs &= ~(itb->second);
+      if (bs.any()) r.wp().m.push_back(entry(ita->first, bs));
     }
     return r;
   }
 
+  template <typename T, typename V>
+  static void put_array_as(bgeot::binary_file_writer &w, const V &v) {
+    std::vector<T> t(v.begin(), v.end());
+    w.put_array(t.data(), t.size());
+  }
+
+  template <typename T, typename V>
+  static void get_array_as(bgeot::binary_file_reader &r, V &v) {
+    std::vector<T> t(v.size());
+    r.get_array(t.data(), t.size());
+    std::copy(t.begin(), t.end(), v.begin());
+  }
+
+  void mesh_region::write_to_binary(bgeot::binary_file_writer &w) const {
+    std::vector<uint64_t> deltas, masks;
+    size_type last = 0;
+    for (const entry &e : rp().m)
+      if (e.second.any()) {
+        deltas.push_back(e.first - last); last = e.first;
+        masks.push_back(e.second.to_ulong());
+      }
+    uint64_t max_delta = 0, or_masks = 0;
+    for (uint64_t d : deltas) max_delta = std::max(max_delta, d);
+    for (uint64_t m : masks) or_masks |= m;
+    uint8_t cv_size = (max_delta >> 32) ? 8 : 4;
+    uint8_t mask_size = (or_masks >> 8) ? 4 : 1;
+    w.put(uint64_t(deltas.size()));
+    w.put(cv_size); w.put(mask_size);
+    if (cv_size == 4) put_array_as<uint32_t>(w, deltas);
+    else put_array_as<uint64_t>(w, deltas);
+    if (mask_size == 1) put_array_as<uint8_t>(w, masks);
+    else put_array_as<uint32_t>(w, masks);
+  }
+
+  void mesh_region::read_from_binary(bgeot::binary_file_reader &r) {
+    size_type nb = size_type(r.get<uint64_t>());
+    uint8_t cv_size = r.get<uint8_t>(), mask_size = r.get<uint8_t>();
+    GMM_ASSERT1((cv_size == 4 || cv_size == 8) &&
+                (mask_size == 1 || mask_size == 4), "Wrong region format");
+    std::vector<uint64_t> deltas(nb), masks(nb);
+    if (cv_size == 4) get_array_as<uint32_t>(r, deltas);
+    else get_array_as<uint64_t>(r, deltas);
+    if (mask_size == 1) get_array_as<uint8_t>(r, masks);
+    else get_array_as<uint32_t>(r, masks);
+
+    entries_t &m = wp().m;
+    bool was_empty = m.empty();
+    m.reserve(m.size() + nb);
+    size_type cv = 0;
+    for (size_type i = 0; i < nb; ++i) {
+      cv += size_type(deltas[i]);
+      m.push_back(entry(cv, face_bitset(masks[i])));
+    }
+    if (!was_empty) p->sorted = false;
+    touch_parent_mesh();
+    mark_region_changed();
+  }
+
   int mesh_region::region_is_faces_of(const getfem::mesh& m1,
                                       const mesh_region &rg2,
                                       const getfem::mesh& m2) const{
@@ -550,6 +718,18 @@ namespace getfem {
 
 #endif
 
+  mesh_region::visitor::visitor(const mesh_region &s, const mesh &m,
+                                bool intersect_with_mpi,
+                                const entry_cost &cost)
+    : visitor(s, m, intersect_with_mpi) {
+    if (me_is_multithreaded_now() && s.partitioning_allowed) {
+      std::tie(it, ite) = s.balanced_partition(cost);
+      c.reset();
+      cv_ = size_type(-1); f_ = short_type(-1); finished_ = false;
+      next();
+    }
+  }
+
   bool mesh_region::visitor::next(){
     if (whole_mesh) {
       if (itb == iteb) {
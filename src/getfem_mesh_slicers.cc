@@ -198,7 +198,7 @@ namespace getfem {
                                     std::bitset<32> spin, std::bitset<32> spbin) {
     scalar_type alpha = 0; size_type iA=0, iB = 0;
     bool intersection = false;
-    static int level = 0;
+    THREAD_SAFE_STATIC int level = 0;
 
     level++;    
     /*
@@ -36,12 +36,14 @@ namespace getfem {
   public:
     typedef typename PLSOLVER::element_type::MATRIX MATRIX;
     typedef typename PLSOLVER::element_type::VECTOR VECTOR;
+    typedef typename PLSOLVER::element_type::CSC_CACHE CSC_CACHE;
     typedef typename gmm::linalg_traits<VECTOR>::value_type T;
     typedef typename gmm::number_traits<T>::magnitude_type R;
 
   protected:
     PLSOLVER linear_solver;
     const MATRIX &K;
+    CSC_CACHE *K_csc; // compressed copy of K kept by the model, if any
     VECTOR &rhs;
     VECTOR state;
 
@@ -66,11 +68,14 @@ namespace getfem {
     }
 
     virtual void linear_solve(VECTOR &dr, gmm::iteration &iter) {
-      (*linear_solver)(K, dr, rhs, iter);
+      if (K_csc) linear_solver->solve_with_cache(K, *K_csc, dr, rhs, iter);
+      else (*linear_solver)(K, dr, rhs, iter);
     }
 
-    pb_base(PLSOLVER linsolv, const MATRIX &K_, VECTOR &rhs_)
-      : linear_solver(linsolv), K(K_), rhs(rhs_), state(gmm::vect_size(rhs_)) {}
+    pb_base(PLSOLVER linsolv, const MATRIX &K_, VECTOR &rhs_,
+            CSC_CACHE *K_csc_ = 0)
+      : linear_solver(linsolv), K(K_), K_csc(K_csc_), rhs(rhs_),
+        state(gmm::vect_size(rhs_)) {}
     virtual ~pb_base() {}
   };
 
@@ -93,14 +98,16 @@ namespace getfem {
   lin_model_pb<rmodel_plsolver_type>::lin_model_pb
     (model &md_, rmodel_plsolver_type linsolv)
     : pb_base<rmodel_plsolver_type>
-      (linsolv, md_.real_tangent_matrix(), md_.set_real_rhs()),
+      (linsolv, md_.real_tangent_matrix(), md_.set_real_rhs(),
+       &(md_.real_tangent_matrix_csc())),
       md(md_)
   { md.from_variables(state_vector()); }
   template <>
   lin_model_pb<cmodel_plsolver_type>::lin_model_pb
     (model &md_, cmodel_plsolver_type linsolv)
     : pb_base<cmodel_plsolver_type>
-      (linsolv, md_.complex_tangent_matrix(), md_.set_complex_rhs()),
+      (linsolv, md_.complex_tangent_matrix(), md_.set_complex_rhs(),
+       &(md_.complex_tangent_matrix_csc())),
       md(md_)
   { md.from_variables(state_vector()); }
 
@@ -178,14 +185,16 @@ namespace getfem {
   nonlin_model_pb<rmodel_plsolver_type>::nonlin_model_pb
     (model &md_, abstract_newton_line_search &ls_, rmodel_plsolver_type linsolv)
     : pb_base<rmodel_plsolver_type>
-      (linsolv, md_.real_tangent_matrix(), md_.set_real_rhs()),
+      (linsolv, md_.real_tangent_matrix(), md_.set_real_rhs(),
+       &(md_.real_tangent_matrix_csc())),
       md(md_), ls(ls_)
   { md.from_variables(state_vector()); }
   template <>
   nonlin_model_pb<cmodel_plsolver_type>::nonlin_model_pb
     (model &md_, abstract_newton_line_search &ls_, cmodel_plsolver_type linsolv)
     : pb_base<cmodel_plsolver_type>
-      (linsolv, md_.complex_tangent_matrix(), md_.set_complex_rhs()),
+      (linsolv, md_.complex_tangent_matrix(), md_.set_complex_rhs(),
+       &(md_.complex_tangent_matrix_csc())),
       md(md_), ls(ls_)
   { md.from_variables(state_vector()); }
 
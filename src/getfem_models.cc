@@ -332,11 +332,15 @@ namespace getfem {
     if (complex_version) {
       gmm::resize(cTM, primary_size, primary_size);
       gmm::resize(crhs, primary_size);
+      cTM_csc.invalidate();
     }
     else {
       gmm::resize(rTM, primary_size, primary_size);
       gmm::resize(rrhs, primary_size);
+      rTM_pattern_valid = false;
+      rTM_csc.invalidate();
     }
+    reset_compiled_expressions();
 
     if (full_size > primary_size) {
       GMM_ASSERT1(has_internal_variables(), "Internal error");
@@ -498,16 +502,17 @@ namespace getfem {
                   GMM_TRACE2("Generic assembly for actualize sizes");
                   {
                     gmm::clear(rTM);
-                    accumulated_distro<decltype(rTM)>  distro_rTM(rTM);
+                    rTM_pattern_valid = false;
+                    column_locks rTM_locks; // rTM is shared by the threads
                     GETFEM_OMP_PARALLEL(
                         ga_workspace workspace(*this);
                         for (const auto &ge : generic_expressions)
                           workspace.add_expression(ge.expr, ge.mim, ge.region,
                                                    2, ge.secondary_domain);
-                        workspace.set_assembled_matrix(distro_rTM);
+                        workspace.set_assembled_matrix(rTM, rTM_locks);
                         workspace.assembly(2);
                     );
-                  } //accumulated_distro scope
+                  }
                   gmm::add(gmm::sub_matrix(rTM, vdescr.I, multdescr.I), MM);
                   gmm::add(gmm::transposed
                            (gmm::sub_matrix(rTM, multdescr.I, vdescr.I)), MM);
@@ -951,10 +956,11 @@ namespace getfem {
   void model::add_macro(const std::string &name, const std::string &expr) {
     check_name_validity(name.substr(0, name.find("(")));
     macro_dict.add_macro(name, expr);
+    reset_compiled_expressions();
   }
 
   void model::del_macro(const std::string &name)
-  { macro_dict.del_macro(name); }
+  { macro_dict.del_macro(name); reset_compiled_expressions(); }
 
   void model::delete_brick(size_type ib) {
      GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
@@ -982,6 +988,9 @@ namespace getfem {
        is_coercive_ = is_coercive_ &&  bricks[ibb].pbr->is_coercive();
      }
      bricks[ib] = brick_description();
+     rTM_pattern_valid = false;
+     rTM_csc.invalidate(); cTM_csc.invalidate();
+     reset_compiled_expressions();
   }
 
   void model::delete_variable(const std::string &varname) {
@@ -1047,6 +1056,8 @@ namespace getfem {
                                      mims, region);
     active_bricks.add(ib);
     valid_bricks.add(ib);
+    rTM_pattern_valid = false;
+    rTM_csc.invalidate(); cTM_csc.invalidate();
 
     // The brick itself already reacts to a mesh_im change in update_brick()
     // for (size_type i = 0; i < bricks[ib].mims.size(); ++i)
@@ -1088,6 +1099,8 @@ namespace getfem {
   void model::change_terms_of_brick(size_type ib, const termlist &terms) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
     touch_brick(ib);
+    rTM_pattern_valid = false;
+    rTM_csc.invalidate(); cTM_csc.invalidate();
     bricks[ib].tlist = terms;
     if (is_complex() && bricks[ib].pbr->is_complex()) {
       bricks.back().cmatlist.resize(terms.size());
@@ -1103,6 +1116,8 @@ namespace getfem {
   void model::change_variables_of_brick(size_type ib, const varnamelist &vl) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
     touch_brick(ib);
+    rTM_pattern_valid = false;
+    rTM_csc.invalidate(); cTM_csc.invalidate();
     bricks[ib].vlist = vl;
     for (const auto &v : vl)
       GMM_ASSERT1(variables.count(v), "Undefined model variable " << v);
@@ -1119,6 +1134,8 @@ namespace getfem {
   void model::change_mims_of_brick(size_type ib, const mimlist &ml) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
     touch_brick(ib);
+    rTM_pattern_valid = false;
+    rTM_csc.invalidate(); cTM_csc.invalidate();
     bricks[ib].mims = ml;
     for (const auto &mim : ml) add_dependency(*mim);
   }
@@ -1129,6 +1146,25 @@ namespace getfem {
     bricks[ib].is_update_brick = flag;
   }
 
+  void model::enable_assembly_profiling(bool enable) {
+    reset_compiled_expressions(); // the workspaces are profiled or not
+    if (!enable)
+      assembly_profile_.reset();
+    else if (!assembly_profile_)
+      assembly_profile_ = std::make_shared<ga_assembly_profile>();
+  }
+
+  const ga_assembly_profile &model::assembly_profile() const {
+    GMM_ASSERT1(assembly_profile_, "The assembly profiling is not enabled");
+    return *assembly_profile_;
+  }
+
+  void model::add_to_assembly_profile(const ga_assembly_profile &p) const {
+    GMM_ASSERT1(assembly_profile_, "The assembly profiling is not enabled");
+    GLOBAL_OMP_GUARD
+    *assembly_profile_ += p;
+  }
+
   void model::set_time(scalar_type t, bool to_init) {
     static const std::string varname("t");
     VAR_SET::iterator it = variables.find(varname);
@@ -2328,6 +2364,172 @@ namespace getfem {
 
 
 
+  // Returns true if the residual terms of the workspace only add
+  // contributions to the dofs of its fem or im_data variables on the
+  // current element, so that they can be assembled concurrently on
+  // convexes sharing no point (see mesh::convex_colors).
+  static bool ga_residual_is_local(ga_workspace &workspace) {
+    for (size_type i = 0; i < workspace.nb_trees(); ++i) {
+      const ga_workspace::tree_description &td = workspace.tree_info(i);
+      if (td.order != 1) continue;
+      if (td.operation != ga_workspace::ASSEMBLY
+          || !(td.interpolate_name_test1.empty())
+          || !(td.secondary_domain.empty()))
+        return false;
+      const std::vector<std::string> vg_(1, td.name_test1),
+        &vg = workspace.variable_group_exists(td.name_test1)
+            ? workspace.variable_group(td.name_test1) : vg_;
+      for (const std::string &name : vg) {
+        if (workspace.associated_im_data(name)) continue;
+        const mesh_fem *mf = workspace.associated_mf(name);
+        if (!mf || mf->is_reduced()) return false;
+        for (dal::bv_visitor cv(mf->convex_index()); !cv.finished(); ++cv)
+          if (mf->fem_of_element(cv)->is_on_real_element()) return false;
+      }
+    }
+    return true;
+  }
+
+  // Sets to zero all the stored entries of a sparse matrix, keeping them
+  // stored so that a new assembly of the same terms does not insert
+  // anything in the columns.
+  static void clear_values_keeping_pattern(model_real_sparse_matrix &M) {
+    for (size_type j = 0; j < gmm::mat_ncols(M); ++j) {
+      std::vector<gmm::elt_rsvector_<scalar_type>> &col = M[j];
+      for (auto &ev : col) ev.e = scalar_type(0);
+    }
+  }
+
+  void model::check_compiled_expressions() const {
+    size_type nbt = global_thread_policy::num_threads();
+    if (compiled_nb_threads != nbt) { // the locks depend on it
+      reset_compiled_expressions();
+      compiled_nb_threads = nbt;
+    }
+    // The compiled instructions refer directly to the vectors of values
+    // (current iteration or temporaries of the time dispatchers), including
+    // the ones of the fixed size data, so that only the structure of the
+    // model is checked here.
+    std::vector<const void *> values;
+    std::vector<scalar_type> constants;
+    values.reserve(3*variables.size());
+    for (const auto &v : variables) {
+      const var_description &vd = v.second;
+      values.push_back(vd.real_value.data());
+      values.push_back(vd.real_value.size() > vd.default_iter
+                       ? vd.real_value[vd.default_iter].data() : nullptr);
+      values.push_back(vd.affine_real_value.data());
+      constants.push_back(vd.is_disabled ? scalar_type(1) : scalar_type(0));
+      if (vd.is_affine_dependent) constants.push_back(vd.alpha);
+      if (!vd.mf && !vd.imd)
+        for (const auto &val : vd.real_value)
+          constants.push_back(scalar_type(val.size()));
+    }
+    if (values != compiled_values || constants != compiled_constants) {
+      reset_compiled_expressions();
+      compiled_values.swap(values);
+      compiled_constants.swap(constants);
+    }
+    if (!compiled_exprs) {
+      compiled_exprs.reset(new omp_distribute<compiled_expressions>());
+      if (!compiled_rTM_locks) compiled_rTM_locks.reset(new column_locks());
+    }
+
+    auto same_expr = [](const gen_expr &ge1, const gen_expr &ge2) {
+      return ge1.expr == ge2.expr && &(ge1.mim) == &(ge2.mim)
+        && ge1.region == ge2.region
+        && ge1.secondary_domain == ge2.secondary_domain;
+    };
+    auto same_assignment = [](const assignement_desc &ad1,
+                              const assignement_desc &ad2) {
+      return ad1.varname == ad2.varname && ad1.expr == ad2.expr
+        && ad1.region == ad2.region && ad1.before == ad2.before
+        && ad1.order == ad2.order;
+    };
+    for (size_type t = 0; t < nbt; ++t) {
+      compiled_expressions &ce = (*compiled_exprs)(t);
+      if (ce.expressions.size() != generic_expressions.size()
+          || ce.assignments.size() != assignments.size()
+          || !std::equal(generic_expressions.begin(),
+                         generic_expressions.end(),
+                         ce.expressions.begin(), same_expr)
+          || !std::equal(assignments.begin(), assignments.end(),
+                         ce.assignments.begin(), same_assignment)) {
+        ce.workspace[0].reset(); ce.workspace[1].reset();
+        ce.colored_workspaces.clear();
+        compiled_colored.reset();
+        ce.expressions.clear();
+        ce.expressions.insert(ce.expressions.end(),
+                              generic_expressions.begin(),
+                              generic_expressions.end());
+        ce.assignments = assignments;
+      }
+    }
+  }
+
+  ga_workspace &model::compiled_workspace(size_type order) const {
+    compiled_expressions &ce = compiled_exprs->thrd_cast();
+    std::unique_ptr<ga_workspace> &pw = ce.workspace[order-1];
+    if (!pw) {
+      pw.reset(new ga_workspace(*this));
+      for (const auto &ad : ce.assignments)
+        pw->add_assignment_expression
+          (ad.varname, ad.expr, ad.region, ad.order, ad.before);
+      for (const auto &ge : ce.expressions)
+        pw->add_expression(ge.expr, ge.mim, ge.region,
+                           2, ge.secondary_domain);
+      pw->keep_compiled_instructions();
+      if (order == 1)
+        pw->set_assembled_vector(ce.V);
+      else
+        pw->set_assembled_matrix(rTM, *compiled_rTM_locks);
+    }
+    if (order == 1) {
+      gmm::resize(ce.V, gmm::vect_size(rrhs));
+      gmm::clear(ce.V);
+    }
+    return *pw;
+  }
+
+  void model::init_colored_residual(colored_residual_info &cr) const {
+    ga_workspace workspace(*this);
+    for (const auto &ge : generic_expressions)
+      workspace.add_expression(ge.expr, ge.mim, ge.region,
+                               2, ge.secondary_domain);
+    cr.is_local = ga_residual_is_local(workspace);
+    if (!cr.is_local) return;
+    size_type nb_colors = 0;
+    for (const auto &ge : generic_expressions)
+      nb_colors = std::max(nb_colors,
+                           ge.mim.linked_mesh().convex_colors().size());
+    cr.regions.resize(nb_colors);
+    for (size_type c = 0; c < nb_colors; ++c)
+      for (const auto &ge : generic_expressions) {
+        const mesh &m = ge.mim.linked_mesh();
+        const auto &colors = m.convex_colors();
+        cr.regions[c].push_back(c < colors.size()
+                                ? mesh_region::intersection
+                                  (mesh_region(colors[c]), m.region(ge.region))
+                                : mesh_region());
+      }
+  }
+
+  ga_workspace &model::compiled_colored_workspace(size_type color) const {
+    compiled_expressions &ce = compiled_exprs->thrd_cast();
+    ce.colored_workspaces.resize(compiled_colored->regions.size());
+    std::unique_ptr<ga_workspace> &pw = ce.colored_workspaces[color];
+    if (!pw) {
+      pw.reset(new ga_workspace(*this));
+      auto itrg = compiled_colored->regions[color].begin();
+      for (const auto &ge : ce.expressions)
+        pw->add_expression(ge.expr, ge.mim, *itrg++,
+                           2, ge.secondary_domain);
+      pw->keep_compiled_instructions();
+      pw->set_assembled_vector(compiled_colored->V);
+    }
+    return *pw;
+  }
+
   void model::assembly(build_version version) {
 
     GMM_ASSERT1(version != BUILD_ON_DATA_CHANGE,
@@ -2350,7 +2552,13 @@ namespace getfem {
       if (version & BUILD_RHS) gmm::clear(crhs);
     }
     else {
-      if (version & BUILD_MATRIX) gmm::clear(rTM);
+      if (version & BUILD_MATRIX) {
+        if (reuse_rTM_pattern && rTM_pattern_valid)
+          clear_values_keeping_pattern(rTM);
+        else
+          gmm::clear(rTM);
+        rTM_pattern_valid = true;
+      }
       if (version & BUILD_RHS) gmm::clear(rrhs);
     }
     clear_dof_constraints();
@@ -2667,6 +2875,18 @@ namespace getfem {
 
       const bool with_internal = version & BUILD_WITH_INTERNAL
                                  && has_internal_variables();
+      const bool compiled = keep_compiled_exprs && !with_internal;
+      if (compiled) check_compiled_expressions();
+      // auxilliary lambda function for the kept workspaces
+      auto compiled_assembly = [&](size_type order) -> ga_workspace & {
+        ga_workspace &workspace = compiled_workspace(order);
+        workspace.assembly(order);
+        if (workspace.profiling_enabled()) {
+          add_to_assembly_profile(workspace.profile());
+          workspace.clear_profile();
+        }
+        return workspace;
+      };
       model_real_sparse_matrix intern_mat; // temp for extracting condensation info
       model_real_plain_vector res0, // holds the original RHS
                               res1; // holds the condensed RHS
@@ -2684,11 +2904,22 @@ namespace getfem {
           gmm::resize(intern_mat, full_size, primary_size);
           gmm::resize(res1, full_size);
         }
-        accumulated_distro<decltype(rTM)> tangent_matrix_distro(rTM);
+        // The tangent matrix is assembled in place by all the threads, the
+        // concurrent additions being protected column-wise by locks.
+        column_locks tangent_matrix_locks;
         accumulated_distro<decltype(intern_mat)> intern_mat_distro(intern_mat);
         accumulated_distro<model_real_plain_vector> res1_distro(res1);
 
-        if (version & BUILD_RHS) { // both BUILD_RHS & BUILD_MATRIX
+        if (compiled) {
+          accumulated_distro<model_real_plain_vector> res0_distro(res0);
+          GETFEM_OMP_PARALLEL( // running the assembly in parallel
+            if (version & BUILD_RHS)
+              gmm::add(compiled_assembly(1).assembled_vector(),
+                       res0_distro.get());
+            compiled_assembly(2);
+          ) // end GETFEM_OMP_PARALLEL
+        }
+        else if (version & BUILD_RHS) { // both BUILD_RHS & BUILD_MATRIX
           accumulated_distro<model_real_plain_vector> res0_distro(res0);
           GETFEM_OMP_PARALLEL( // running the assembly in parallel
             ga_workspace workspace(*this);
@@ -2702,7 +2933,7 @@ namespace getfem {
               workspace.set_assembled_vector(res1_distro);
               workspace.set_internal_coupling_matrix(intern_mat_distro);
             }
-            workspace.set_assembled_matrix(tangent_matrix_distro);
+            workspace.set_assembled_matrix(rTM, tangent_matrix_locks);
             workspace.assembly(2, with_internal);
           ) // end GETFEM_OMP_PARALLEL
         } // end of res0_distro scope
@@ -2716,20 +2947,66 @@ namespace getfem {
               workspace.set_assembled_vector(res1_distro);
               workspace.set_internal_coupling_matrix(intern_mat_distro);
             }
-            workspace.set_assembled_matrix(tangent_matrix_distro);
+            workspace.set_assembled_matrix(rTM, tangent_matrix_locks);
             workspace.assembly(2, with_internal);
           ) // end GETFEM_OMP_PARALLEL
         }
-      } // end of tangent_matrix_distro, intern_mat_distro, res1_distro scope
+      } // end of intern_mat_distro, res1_distro scope
       else if (version & BUILD_RHS) {
-        accumulated_distro<model_real_plain_vector> res0_distro(res0);
-        GETFEM_OMP_PARALLEL( // running the assembly in parallel
-          ga_workspace workspace(*this);
-          add_assignments_and_expressions_to_workspace(workspace);
-          workspace.set_assembled_vector(res0_distro);
-          workspace.assembly(1, with_internal);
-        ) // end GETFEM_OMP_PARALLEL
-      } // end of res0_distro scope
+        // The locality of the residual terms and the regions restricted to
+        // each color are kept with the compiled expressions.
+        std::unique_ptr<colored_residual_info> local_colored;
+        colored_residual_info *colored = nullptr;
+        if (colored_residual && !with_internal && assignments.empty()) {
+          std::unique_ptr<colored_residual_info> &pcr
+            = compiled ? compiled_colored : local_colored;
+          if (!pcr) {
+            pcr.reset(new colored_residual_info());
+            init_colored_residual(*pcr);
+          }
+          if (pcr->is_local) colored = pcr.get();
+        }
+        if (colored) {
+          // Assembly color by color, all the threads adding to colored->V
+          gmm::resize(colored->V, gmm::vect_size(res0));
+          gmm::clear(colored->V);
+          for (size_type c = 0; c < colored->regions.size(); ++c) {
+            GETFEM_OMP_PARALLEL(
+              if (compiled) {
+                ga_workspace &workspace = compiled_colored_workspace(c);
+                workspace.assembly(1);
+                if (workspace.profiling_enabled()) {
+                  add_to_assembly_profile(workspace.profile());
+                  workspace.clear_profile();
+                }
+              } else {
+                ga_workspace workspace(*this);
+                auto itrg = colored->regions[c].begin();
+                for (const auto &ge : generic_expressions)
+                  workspace.add_expression(ge.expr, ge.mim, *itrg++,
+                                           2, ge.secondary_domain);
+                workspace.set_assembled_vector(colored->V);
+                workspace.assembly(1);
+              }
+            ) // end GETFEM_OMP_PARALLEL
+          }
+          gmm::copy(colored->V, res0);
+        } else if (compiled) {
+          accumulated_distro<model_real_plain_vector> res0_distro(res0);
+          GETFEM_OMP_PARALLEL( // running the assembly in parallel
+            gmm::add(compiled_assembly(1).assembled_vector(),
+                     res0_distro.get());
+          ) // end GETFEM_OMP_PARALLEL
+        } else {
+          accumulated_distro<model_real_plain_vector> res0_distro(res0);
+          GETFEM_OMP_PARALLEL( // running the assembly in parallel
+            ga_workspace workspace(*this);
+            add_assignments_and_expressions_to_workspace(workspace);
+            workspace.set_assembled_vector(res0_distro);
+            workspace.assembly(1, with_internal);
+          ) // end GETFEM_OMP_PARALLEL
+        } // end of res0_distro scope
+      }
 
       if (version & BUILD_RHS) {
         gmm::scale(res0, scalar_type(-1)); // from residual to rhs
@@ -3109,7 +3386,10 @@ namespace getfem {
     complex_dof_constraints.clear();
     bricks.resize(0);
     rTM = model_real_sparse_matrix();
+    rTM_pattern_valid = false;
+    reset_compiled_expressions();
     cTM = model_complex_sparse_matrix();
+    rTM_csc.invalidate(); cTM_csc.invalidate();
     rrhs = model_real_plain_vector();
     crhs = model_complex_plain_vector();
   }
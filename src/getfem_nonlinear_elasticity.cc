@@ -1834,6 +1834,61 @@ namespace getfem {
       GMM_ASSERT1(false, "Sorry, second derivative not implemented");
     }
 
+    // Batched evaluations on the Gauss points of an element, the work
+    // matrices being allocated once.
+    bool has_batched_evaluation() const { return true; }
+
+    // Computes Gu = I + grad(u) and E for the point ipt, returns det(Gu).
+    scalar_type strain(const arg_list &args, size_type ipt, base_vector &params,
+                       base_matrix &Gu, base_matrix &E) const {
+      size_type N = gmm::mat_nrows(Gu), nbp = params.size();
+      auto itu = args[0]->begin() + ipt*N*N, itp = args[1]->begin() + ipt*nbp;
+      std::copy(itp, itp + nbp, params.begin());
+      std::copy(itu, itu + N*N, Gu.begin());
+      gmm::mult(gmm::transposed(Gu), Gu, E);
+      gmm::add(Gu, E); gmm::add(gmm::transposed(Gu), E);
+      gmm::scale(E, scalar_type(0.5));
+      gmm::add(gmm::identity_matrix(), Gu);
+      return bgeot::lu_det(&(*(Gu.begin())), N);
+    }
+
+    void batched_value(const arg_list &args, size_type nbpt,
+                       base_tensor &result) const {
+      size_type N = args[0]->sizes()[0];
+      base_vector params(AHL->nb_params());
+      base_matrix Gu(N, N), E(N,N), sigma(N,N);
+      for (size_type ipt = 0; ipt < nbpt; ++ipt) {
+        scalar_type det = strain(args, ipt, params, Gu, E);
+        AHL->sigma(E, sigma, params, det);
+        std::copy(sigma.begin(), sigma.end(), result.begin() + ipt*N*N);
+      }
+    }
+
+    void batched_derivative(const arg_list &args, size_type nder,
+                            size_type nbpt, base_tensor &result) const {
+      GMM_ASSERT1(nder == 1, "Sorry, the derivative of this hyperelastic "
+                  "law with respect to its parameters is not available.");
+      size_type N = args[0]->sizes()[0], N2 = N*N;
+      base_vector params(AHL->nb_params());
+      base_tensor grad_sigma(N, N, N, N);
+      base_matrix Gu(N, N), E(N,N);
+      base_tensor::iterator it = result.begin();
+      for (size_type ipt = 0; ipt < nbpt; ++ipt) {
+        scalar_type det = strain(args, ipt, params, Gu, E);
+        AHL->grad_sigma(E, grad_sigma, params, det);
+        for (size_type l = 0; l < N; ++l)
+          for (size_type k = 0; k < N; ++k, it += N2) {
+            std::fill(it, it + N2, scalar_type(0));
+            for (size_type m = 0; m < N; ++m) {
+              scalar_type a = Gu(k, m);
+              auto itg = grad_sigma.begin() + (l*N + m)*N2;
+              for (size_type ij = 0; ij < N2; ++ij) it[ij] += a * itg[ij];
+            }
+          }
+      }
+      GMM_ASSERT1(it == result.end(), "Internal error");
+    }
+
     AHL_wrapper_sigma(const phyperelastic_law &A) : AHL(A) {}
 
   };
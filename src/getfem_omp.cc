@@ -23,7 +23,11 @@
 #include "getfem/getfem_locale.h"
 #include "getfem/getfem_omp.h"
 
+#include <algorithm>
+#include <mutex>
+
 #ifdef GETFEM_HAS_OPENMP
+  #include <condition_variable>
   #include <thread>
   #include <omp.h>
 #endif
@@ -32,19 +36,35 @@ using bgeot::scalar_type;
 
 namespace getfem{
 
+  // Caller thread (see caller_thread) of the current thread. The threads of
+  // the parallel sections get the one of the thread which started them.
+  static size_type &caller_slot() {
+    THREAD_SAFE_STATIC size_type slot = 0;
+    return slot;
+  }
+
 #ifdef GETFEM_HAS_OPENMP
 
+  static std::atomic<size_type> nb_callers{1};
+  static std::atomic<int> nb_threads_of_callers{1};
+
+  // The data shared by the threads have to be protected in the parallel
+  // sections, and anywhere as soon as several caller threads are allowed.
+  static bool must_lock() {
+    return me_is_multithreaded_now() || nb_callers > 1;
+  }
+
   std::recursive_mutex omp_guard::mutex;
 
   omp_guard::omp_guard()
-    : plock{me_is_multithreaded_now() ?
+    : plock{must_lock() ?
        std::make_unique<std::lock_guard<std::recursive_mutex>>(mutex)
       : nullptr}
   {}
 
   local_guard::local_guard(std::recursive_mutex& m) :
     mutex{m},
-    plock{me_is_multithreaded_now() ?
+    plock{must_lock() ?
       std::make_shared<std::lock_guard<std::recursive_mutex>>(m)
       : nullptr}
   {}
@@ -53,6 +73,19 @@ namespace getfem{
     return local_guard{mutex};
   }
 
+  column_locks::column_locks(size_type nb_mutexes)
+    : nb{std::max(nb_mutexes, size_type(1))},
+      mutexes{new std::mutex[nb]}
+  {}
+
+  void column_locks::lock_all() const{
+    for (size_type i = 0; i != nb; ++i) mutexes[i].lock();
+  }
+
+  void column_locks::unlock_all() const{
+    for (size_type i = nb; i != 0; --i) mutexes[i-1].unlock();
+  }
+
   size_type global_thread_policy::this_thread() {
     return partition_master::get().get_current_partition();
   }
@@ -70,10 +103,81 @@ namespace getfem{
   }
 
   void set_num_threads(int n){
+    nb_threads_of_callers = n;
     omp_set_num_threads(n);
     partition_master::get().check_threads();
   }
 
+  void set_nb_caller_threads(size_type n){
+    if (n > nb_callers) {
+      nb_callers = n;
+      dal::singletons_manager::on_partitions_change();
+    }
+  }
+
+  size_type nb_caller_threads() {
+    return nb_callers;
+  }
+
+  // Caller threads in use, the current thread being one of them if
+  // is_caller() is set.
+  struct caller_slots {
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<bool> used;
+  };
+
+  static caller_slots &slots() {
+    static caller_slots s;
+    return s;
+  }
+
+  static bool &is_caller() {
+    THREAD_SAFE_STATIC bool caller = false;
+    return caller;
+  }
+
+  caller_thread::caller_thread()
+    : owner{!is_caller()}, slot{0}, nb_threads_before{omp_get_max_threads()} {
+    if (!owner) return; // nested caller_thread
+    auto &s = slots();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    s.used.resize(std::max(s.used.size(), size_type(nb_callers)), false);
+    s.released.wait(lock, [&]() {
+      slot = std::find(s.used.begin(), s.used.end(), false) - s.used.begin();
+      return slot < s.used.size();
+    });
+    s.used[slot] = true;
+    is_caller() = true;
+    caller_slot() = slot;
+    omp_set_num_threads(nb_threads_of_callers);
+  }
+
+  caller_thread::~caller_thread() {
+    if (!owner) return;
+    omp_set_num_threads(nb_threads_before);
+    is_caller() = false;
+    caller_slot() = 0;
+    auto &s = slots();
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.used[slot] = false;
+    }
+    s.released.notify_one();
+  }
+
+  size_type caller_thread_policy::first_thread() {
+    return caller_slot() * global_thread_policy::num_threads();
+  }
+
+  size_type caller_thread_policy::this_thread() {
+    return first_thread() + global_thread_policy::this_thread();
+  }
+
+  size_type caller_thread_policy::num_threads() {
+    return nb_callers * global_thread_policy::num_threads();
+  }
+
   bool me_is_multithreaded_now(){
     // serial region
     if(omp_get_num_threads() == 1 && omp_get_level() == 0) return false;
@@ -107,6 +211,28 @@ namespace getfem{
 
   void set_num_threads(int /*n*/){}
 
+  void set_nb_caller_threads(size_type /*n*/){}
+
+  size_type nb_caller_threads() {return 1;}
+
+  // Without OpenMP, GetFEM is not thread safe: the caller threads run one
+  // at a time.
+  static std::recursive_mutex &caller_mutex() {
+    static std::recursive_mutex mutex;
+    return mutex;
+  }
+
+  caller_thread::caller_thread()
+    : owner{true}, slot{0}, nb_threads_before{1} { caller_mutex().lock(); }
+
+  caller_thread::~caller_thread() { caller_mutex().unlock(); }
+
+  size_type caller_thread_policy::first_thread() {return 0;}
+
+  size_type caller_thread_policy::this_thread() {return 0;}
+
+  size_type caller_thread_policy::num_threads(){return 1;}
+
   bool not_multithreaded(){return true;}
 
   size_type max_concurrency() {return 1;}
@@ -174,6 +300,18 @@ namespace getfem{
 
   partition_master partition_master::instance;
 
+  // Current partition of the thread, valid for a generation of the
+  // partitions.
+  struct thread_partition {
+    size_type generation = size_type(-1);
+    size_type partition = 0;
+  };
+
+  static thread_partition &current_partition() {
+    THREAD_SAFE_STATIC thread_partition p;
+    return p;
+  }
+
   partition_master& partition_master::get(){
     return instance;
   }
@@ -216,7 +354,7 @@ namespace getfem{
     GMM_ASSERT1(nb_user_threads == true_thread_policy::num_threads(),
                 "The number of omp threads was changed outside partition_master."
                 "Please use getfem::set_num_threads for this.");
-    current_partition = *(std::begin(partitions.thrd_cast()));
+    current_partition() = {generation, *(std::begin(partitions.thrd_cast()))};
     return partition_iterator{*this, std::begin(partitions.thrd_cast())};
   }
 
@@ -247,8 +385,14 @@ namespace getfem{
                 true_thread_policy::this_thread() <<
                 " while number of partitions is " << nb_partitions
                 << ".");
-    return behaviour == thread_behaviour::partition_threads ?
-           current_partition : true_thread_policy::this_thread();
+    if (behaviour != thread_behaviour::partition_threads)
+      return true_thread_policy::this_thread();
+    auto &p = current_partition();
+    if (p.generation != generation) {
+      const auto &ps = partitions(true_thread_policy::this_thread());
+      p = {generation, ps.empty() ? 0 : *(std::begin(ps))};
+    }
+    return p.partition;
   }
 
   size_type partition_master::get_nb_partitions() const {
@@ -262,19 +406,12 @@ namespace getfem{
                   << p << " is not a valid partitions for thread "
                   << true_thread_policy::this_thread()
                   << ".");
-      current_partition = p;
+      current_partition() = {generation, p};
     }
   }
 
   void partition_master::rewind_partitions(){
-    if (me_is_multithreaded_now()){
-      current_partition = *(std::begin(partitions.thrd_cast()));
-    }
-    else{
-      for (size_type t = 0; t != partitions.num_threads(); ++t){
-        current_partition(t) = *(std::begin(partitions(t)));
-      }
-    }
+    current_partition() = {generation, *(std::begin(partitions.thrd_cast()))};
   }
 
   void partition_master::update_partitions(){
@@ -285,7 +422,6 @@ namespace getfem{
     if (partitions_updated) return;
 
     partitions = decltype(partitions){};
-    current_partition = decltype(current_partition){};
 
     auto n_threads = true_thread_policy::num_threads();
     if(n_threads > nb_partitions){
@@ -306,16 +442,15 @@ namespace getfem{
         for (size_type i = partition_begin; i != partition_end; ++i){
           hint_it = partitions(t).insert(hint_it, i);
         }
-        current_partition(t) = partition_begin;
       }
     }
     else{
       for (size_type t = 0; t != n_threads; ++t){
         partitions(t).insert(t);
-        current_partition(t) = t;
       }
     }
 
+    ++generation;
     partitions_updated = true;
   }
 
@@ -326,13 +461,15 @@ namespace getfem{
   parallel_boilerplate::
   parallel_boilerplate()
   : plocale{std::make_unique<standard_locale>()},
-    pexception{std::make_unique<thread_exception>()} {
+    pexception{std::make_unique<thread_exception>()},
+    caller{caller_slot()} {
     #ifdef GETFEM_ON_WIN
       _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
     #endif
   }
 
   void parallel_boilerplate::run_lambda(std::function<void(void)> lambda){
+    caller_slot() = caller;
     pexception->run(lambda);
   }
 
@@ -124,6 +124,7 @@ namespace getfem {
     getfem::pfem pf_old = 0;
     getfem::pfem_precomp pfp = 0;
     pintegration_method pim1 = 0;
+    papprox_integration pai2_old = 0;
 
     std::vector<scalar_type> areas(mf.nb_basic_dof());
     std::vector<scalar_type> area_supports(mf.nb_basic_dof());
@@ -138,7 +139,6 @@ namespace getfem {
       GMM_ASSERT1(pim->type() == IM_APPROX,
                   "Works only with approximate integration");
       papprox_integration pai2= pim->approx_method();
-      static papprox_integration pai2_old = 0;
       if (pgt_old != pgt || pai2 != pai2_old) {
         pim1 = getfem::classical_approx_im(pgt, 2);
 	pgp2 = bgeot::geotrans_precomp(pgt, pai2->pintegration_points(),pim);
@@ -196,6 +196,23 @@ namespace getfem {
       gmm::copy(outmat.as_vector(), result.as_vector());
     }
 
+    // Batched value, the work matrices being allocated once.
+    bool has_batched_evaluation() const { return true; }
+
+    void batched_value(const arg_list &args, size_type nbpt,
+                       base_tensor &result) const {
+      size_type N = args[0]->sizes()[0], N2 = N*N;
+      base_matrix inpmat(N,N), outmat(N,N);
+      for (size_type ipt = 0; ipt < nbpt; ++ipt) {
+        auto it = args[0]->begin() + ipt*N2;
+        std::copy(it, it + N2, inpmat.begin());
+        bool info = expm(inpmat, outmat);
+        GMM_ASSERT1(info, "Matrix exponential calculation "
+                          "failed to converge");
+        std::copy(outmat.begin(), outmat.end(), result.begin() + ipt*N2);
+      }
+    }
+
     // Derivative:
     void derivative(const arg_list &args, size_type /*nder*/,
                     base_tensor &result) const {
@@ -471,15 +488,13 @@ namespace getfem {
       return true;
     }
 
-    // Value:
-    void value(const arg_list &args, base_tensor &result) const {
-      size_type N = (args[0]->sizes().size() == 2) ? args[0]->sizes()[0] : 1;
-      base_matrix tau(N, N), tau_D(N, N);
-      gmm::copy(args[0]->as_vector(), tau.as_vector());
-      scalar_type s = (*(args[1]))[0];
+    // Value on a point, tau_D being a N x N work matrix.
+    static void projection(const scalar_type *tau, scalar_type s,
+                           base_matrix &tau_D, scalar_type *result) {
+      size_type N = gmm::mat_nrows(tau_D);
+      std::copy(tau, tau + N*N, tau_D.begin());
 
-      scalar_type tau_m = gmm::mat_trace(tau) / scalar_type(N);
-      gmm::copy(tau, tau_D);
+      scalar_type tau_m = gmm::mat_trace(tau_D) / scalar_type(N);
       for (size_type i = 0; i < N; ++i) tau_D(i,i) -= tau_m;
 
       scalar_type norm_tau_D = gmm::mat_euclidean_norm(tau_D);
@@ -488,18 +503,16 @@ namespace getfem {
 
       for (size_type i = 0; i < N; ++i) tau_D(i,i) += tau_m;
 
-      gmm::copy(tau_D.as_vector(), result.as_vector());
+      std::copy(tau_D.begin(), tau_D.end(), result);
     }
 
-    // Derivative:
-    void derivative(const arg_list &args, size_type nder,
-                    base_tensor &result) const {
-      size_type N = (args[0]->sizes().size() == 2) ? args[0]->sizes()[0] : 1;
-      base_matrix tau(N, N), tau_D(N, N);
-      gmm::copy(args[0]->as_vector(), tau.as_vector());
-      scalar_type s = (*(args[1]))[0];
-      scalar_type tau_m = gmm::mat_trace(tau) / scalar_type(N);
-      gmm::copy(tau, tau_D);
+    // Derivative on a point, tau_D being a N x N work matrix.
+    static void projection_derivative(const scalar_type *tau, scalar_type s,
+                                      size_type nder, base_matrix &tau_D,
+                                      scalar_type *result) {
+      size_type N = gmm::mat_nrows(tau_D), N2 = N*N;
+      std::copy(tau, tau + N2, tau_D.begin());
+      scalar_type tau_m = gmm::mat_trace(tau_D) / scalar_type(N);
       for (size_type i = 0; i < N; ++i) tau_D(i,i) -= tau_m;
       scalar_type norm_tau_D = gmm::mat_euclidean_norm(tau_D);
 
@@ -508,35 +521,77 @@ namespace getfem {
 
       switch(nder) {
       case 1:
+        // result(i,j,m,n) is result[i + N*j + N2*m + N2*N*n]
         if (norm_tau_D <= s) {
-          gmm::clear(result.as_vector());
+          std::fill(result, result + N2*N2, scalar_type(0));
           for (size_type i = 0; i < N; ++i)
             for (size_type j = 0; j < N; ++j)
-              result(i,j,i,j) = scalar_type(1);
+              result[(i + N*j)*(N2+1)] = scalar_type(1);
         } else {
           for (size_type i = 0; i < N; ++i)
             for (size_type j = 0; j < N; ++j)
               for (size_type m = 0; m < N; ++m)
                 for (size_type n = 0; n < N; ++n)
-                  result(i,j,m,n)
+                  result[i + N*j + N2*(m + N*n)]
                     = s * (-tau_D(i,j) * tau_D(m,n)
                            + ((i == m && j == n) ? scalar_type(1) : scalar_type(0))
                            - ((i == j && m == n) ? scalar_type(1)/scalar_type(N)
                               : scalar_type(0))) / norm_tau_D;
           for (size_type i = 0; i < N; ++i)
             for (size_type j = 0; j < N; ++j)
-              result(i,i,j,j) += scalar_type(1)/scalar_type(N);
+              result[i*(N+1) + N2*j*(N+1)] += scalar_type(1)/scalar_type(N);
         }
         break;
       case 2:
         if (norm_tau_D < s)
-          gmm::clear(result.as_vector());
+          std::fill(result, result + N2, scalar_type(0));
         else
-          gmm::copy(tau_D.as_vector(), result.as_vector());
+          std::copy(tau_D.begin(), tau_D.end(), result);
         break;
       }
     }
 
+    // Value:
+    void value(const arg_list &args, base_tensor &result) const {
+      size_type N = (args[0]->sizes().size() == 2) ? args[0]->sizes()[0] : 1;
+      base_matrix tau_D(N, N);
+      projection(&(*(args[0]->begin())), (*(args[1]))[0], tau_D,
+                 &(*(result.begin())));
+    }
+
+    // Derivative:
+    void derivative(const arg_list &args, size_type nder,
+                    base_tensor &result) const {
+      size_type N = (args[0]->sizes().size() == 2) ? args[0]->sizes()[0] : 1;
+      base_matrix tau_D(N, N);
+      projection_derivative(&(*(args[0]->begin())), (*(args[1]))[0], nder,
+                            tau_D, &(*(result.begin())));
+    }
+
+    // Batched evaluations, the work matrix being allocated once.
+    bool has_batched_evaluation() const { return true; }
+
+    void batched_value(const arg_list &args, size_type nbpt,
+                       base_tensor &result) const {
+      size_type N2 = args[0]->size() / nbpt;
+      size_type N = (N2 == 1) ? 1 : args[0]->sizes()[0];
+      base_matrix tau_D(N, N);
+      for (size_type ipt = 0; ipt < nbpt; ++ipt)
+        projection(&(*(args[0]->begin())) + ipt*N2, (*(args[1]))[ipt], tau_D,
+                   &(*(result.begin())) + ipt*N2);
+    }
+
+    void batched_derivative(const arg_list &args, size_type nder,
+                            size_type nbpt, base_tensor &result) const {
+      size_type N2 = args[0]->size() / nbpt, s = result.size() / nbpt;
+      size_type N = (N2 == 1) ? 1 : args[0]->sizes()[0];
+      base_matrix tau_D(N, N);
+      for (size_type ipt = 0; ipt < nbpt; ++ipt)
+        projection_derivative(&(*(args[0]->begin())) + ipt*N2,
+                              (*(args[1]))[ipt], nder, tau_D,
+                              &(*(result.begin())) + ipt*s);
+    }
+
     // Second derivative : not implemented
     void second_derivative(const arg_list &, size_type, size_type,
                            base_tensor &) const {
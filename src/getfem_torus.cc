@@ -178,11 +178,11 @@ namespace getfem
   DAL_SIMPLE_KEY(torus_fem_key, bgeot::size_type);
 
   getfem::pfem new_torus_fem(getfem::pfem pf) {
-    static bgeot::size_type key_count = 0;
-    ++key_count;
+    static std::atomic<bgeot::size_type> key_count{0};
+    bgeot::size_type key = ++key_count;
     getfem::pfem pfem_torus = std::make_shared<torus_fem>(pf);
     dal::pstatic_stored_object_key
-      pk = std::make_shared<torus_fem_key>(key_count);
+      pk = std::make_shared<torus_fem_key>(key);
     dal::add_stored_object(pk, pfem_torus, pfem_torus->node_tab(0));
     return pfem_torus;
   }
@@ -75,6 +75,7 @@ namespace gmm {
     std::vector<int> irn;
     std::vector<int> jcn;
     std::vector<T> a;
+    const T *pa; // values given to MUMPS (a or the values of a csc_matrix)
     bool sym;
 
     template <typename L> void store(const L& l, size_type i) {
@@ -104,7 +105,50 @@ namespace gmm {
       irn.reserve(nz); jcn.reserve(nz); a.reserve(nz);
       build_from(A,  typename principal_orientation_type<typename
                  linalg_traits<L>::sub_orientation>::potype());
+      pa = a.data();
     }
+
+    /* From a csc_matrix, the values are not copied in the non symmetric
+       case (the entries are stored in the order of the csc_matrix). */
+    template <typename IND_TYPE, int shift>
+    ij_sparse_matrix(const csc_matrix<T, IND_TYPE, shift> &A, bool sym_) {
+      sym = sym_;
+      irn.reserve(nnz(A)); jcn.reserve(nnz(A));
+      for (size_type j = 0; j < mat_ncols(A); ++j)
+        for (size_type k = A.jc[j]-shift; k < size_type(A.jc[j+1]-shift); ++k) {
+          int ir = int(A.ir[k]) - shift + 1, jc = int(j) + 1;
+          if (!sym || ir >= jc) { irn.push_back(ir); jcn.push_back(jc); }
+        }
+      refresh_values(A);
+    }
+
+    /* Takes the values of a matrix having the pattern used to build the
+       indices. */
+    template <typename L> void refresh_values(const L& A) {
+      irn.resize(0); jcn.resize(0); a.resize(0);
+      build_from(A,  typename principal_orientation_type<typename
+                 linalg_traits<L>::sub_orientation>::potype());
+      pa = a.data();
+    }
+
+    template <typename IND_TYPE, int shift>
+    void refresh_values(const csc_matrix<T, IND_TYPE, shift> &A) {
+      if (sym) {
+        a.resize(0); a.reserve(irn.size());
+        for (size_type j = 0; j < mat_ncols(A); ++j)
+          for (size_type k = A.jc[j]-shift; k < size_type(A.jc[j+1]-shift);
+               ++k)
+            if (int(A.ir[k]) - shift >= int(j)) a.push_back(A.pr[k]);
+      }
+      pa = sym ? a.data() : A.pr.data();
+    }
+
+    void swap(ij_sparse_matrix<T> &m) {
+      irn.swap(m.irn); jcn.swap(m.jcn); a.swap(m.a);
+      std::swap(pa, m.pa); std::swap(sym, m.sym);
+    }
+
+    ij_sparse_matrix() : pa(0), sym(false) {}
   };
 
   /* ********************************************************************* */
@@ -167,55 +211,89 @@ namespace gmm {
   }
 
 
-  /** MUMPS solve interface
+  /** MUMPS factorization of a matrix kept between several solves, with
+   *  separate analysis, factorization and solve phases: the analysis can
+   *  be reused for a new matrix with the same sparsity pattern, and the
+   *  factorization for several right hand sides.
    *  Works only with sparse or skyline matrices
    */
-  template <typename MAT, typename VECTX, typename VECTB>
-  bool MUMPS_solve(const MAT &A, const VECTX &X_, const VECTB &B,
-                   bool sym = false, bool distributed = false) {
-    VECTX &X = const_cast<VECTX &>(X_);
-
-    typedef typename linalg_traits<MAT>::value_type T;
+  template <typename T> class MUMPS_factor {
     typedef typename mumps_interf<T>::value_type MUMPS_T;
-    GMM_ASSERT2(gmm::mat_nrows(A) == gmm::mat_ncols(A), "Non-square matrix");
+    mutable typename mumps_interf<T>::MUMPS_STRUC_C id;
+    ij_sparse_matrix<T> AA;
+    mutable std::vector<T> rhs;
+    int rank;
+    bool is_init, analyzed, factorized, distributed;
+
+    void set_matrix() {
+      if (rank == 0 || distributed) {
+        if (distributed) {
+          id.nz_loc = int(AA.irn.size());
+          id.irn_loc = &(AA.irn[0]);
+          id.jcn_loc = &(AA.jcn[0]);
+          id.a_loc = (MUMPS_T*)(AA.pa);
+        } else {
+          id.nz = int(AA.irn.size());
+          id.irn = &(AA.irn[0]);
+          id.jcn = &(AA.jcn[0]);
+          id.a = (MUMPS_T*)(AA.pa);
+        }
+      }
+    }
 
-    std::vector<T> rhs(gmm::vect_size(B)); gmm::copy(B, rhs);
+  public :
+    /** Symbolic analysis of A (job 1). */
+    template <typename MAT>
+    void analyze(const MAT &A, bool sym = false, bool distributed_ = false);
+    /** Numerical factorization of A, which has the sparsity pattern of the
+        analyzed matrix (job 2). Returns false if A is singular. */
+    template <typename MAT> bool factorize(const MAT &A);
+    /** Solve with the current factorization (job 3). */
+    template <typename VECTX, typename VECTB>
+    bool solve(const VECTX &X, const VECTB &B) const;
+    bool is_analyzed() const { return analyzed; }
+    bool is_factorized() const { return factorized; }
+    void clear();
+
+    MUMPS_factor() : rank(0), is_init(false), analyzed(false),
+                     factorized(false), distributed(false) {
+#ifdef GMM_USES_MPI
+      MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+    }
+    MUMPS_factor(const MUMPS_factor &) = delete;
+    MUMPS_factor &operator =(const MUMPS_factor &) = delete;
+    ~MUMPS_factor() { clear(); }
+  };
 
-    ij_sparse_matrix<T> AA(A, sym);
+  template <typename T>
+  void MUMPS_factor<T>::clear() {
+    if (is_init) {
+      id.job = -2; // JOB_END
+      mumps_interf<T>::mumps_c(id);
+    }
+    is_init = analyzed = factorized = false;
+  }
+
+  template <typename T> template <typename MAT>
+  void MUMPS_factor<T>::analyze(const MAT &A, bool sym, bool distributed_) {
+    GMM_ASSERT2(gmm::mat_nrows(A) == gmm::mat_ncols(A), "Non-square matrix");
+    clear();
+    distributed = distributed_;
+    ij_sparse_matrix<T>(A, sym).swap(AA);
 
     const int JOB_INIT = -1;
-    const int JOB_END = -2;
     const int USE_COMM_WORLD = -987654;
 
-    typename mumps_interf<T>::MUMPS_STRUC_C id;
-
-    int rank(0);
-#ifdef GMM_USES_MPI
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-#endif
-
     id.job = JOB_INIT;
     id.par = 1;
     id.sym = sym ? 2 : 0;
     id.comm_fortran = USE_COMM_WORLD;
     mumps_interf<T>::mumps_c(id);
+    is_init = true;
 
-    if (rank == 0 || distributed) {
-      id.n = int(gmm::mat_nrows(A));
-      if (distributed) {
-        id.nz_loc = int(AA.irn.size());
-        id.irn_loc = &(AA.irn[0]);
-        id.jcn_loc = &(AA.jcn[0]);
-        id.a_loc = (MUMPS_T*)(&(AA.a[0]));
-      } else {
-        id.nz = int(AA.irn.size());
-        id.irn = &(AA.irn[0]);
-        id.jcn = &(AA.jcn[0]);
-        id.a = (MUMPS_T*)(&(AA.a[0]));
-      }
-      if (rank == 0)
-        id.rhs = (MUMPS_T*)(&(rhs[0]));
-    }
+    if (rank == 0 || distributed) id.n = int(gmm::mat_nrows(A));
+    set_matrix();
 
     id.ICNTL(1) = -1; // output stream for error messages
     id.ICNTL(2) = -1; // output stream for other messages
@@ -236,21 +314,54 @@ namespace gmm {
 
     // id.ICNTL(22) = 1;   /* enables out-of-core support */
 
-    id.job = 6;
+    id.job = 1;
     mumps_interf<T>::mumps_c(id);
-    bool ok = mumps_error_check(id);
+    analyzed = mumps_error_check(id);
+  }
 
-    id.job = JOB_END;
+  template <typename T> template <typename MAT>
+  bool MUMPS_factor<T>::factorize(const MAT &A) {
+    GMM_ASSERT1(analyzed, "MUMPS_factor: the analysis has to be done first");
+    size_type nz = AA.irn.size();
+    AA.refresh_values(A);
+    GMM_ASSERT1(AA.irn.size() == nz, "MUMPS_factor: the sparsity pattern "
+                "of the matrix is not the one of the analysis");
+    set_matrix();
+    id.job = 2;
     mumps_interf<T>::mumps_c(id);
+    factorized = mumps_error_check(id);
+    return factorized;
+  }
+
+  template <typename T> template <typename VECTX, typename VECTB>
+  bool MUMPS_factor<T>::solve(const VECTX &X_, const VECTB &B) const {
+    GMM_ASSERT1(factorized, "MUMPS_factor: no valid factorization");
+    VECTX &X = const_cast<VECTX &>(X_);
+    gmm::resize(rhs, gmm::vect_size(B)); gmm::copy(B, rhs);
+    if (rank == 0) id.rhs = (MUMPS_T*)(&(rhs[0]));
+    id.job = 3;
+    mumps_interf<T>::mumps_c(id);
+    bool ok = mumps_error_check(id);
 
 #ifdef GMM_USES_MPI
     MPI_Bcast(&(rhs[0]),id.n,gmm::mpi_type(T()),0,MPI_COMM_WORLD);
 #endif
 
     gmm::copy(rhs, X);
-
     return ok;
+  }
 
+
+  /** MUMPS solve interface
+   *  Works only with sparse or skyline matrices
+   */
+  template <typename MAT, typename VECTX, typename VECTB>
+  bool MUMPS_solve(const MAT &A, const VECTX &X_, const VECTB &B,
+                   bool sym = false, bool distributed = false) {
+    typedef typename linalg_traits<MAT>::value_type T;
+    MUMPS_factor<T> F;
+    F.analyze(A, sym, distributed);
+    return F.is_analyzed() && F.factorize(A) && F.solve(X_, B);
   }
 
 
@@ -308,12 +419,12 @@ namespace gmm {
         id.nz_loc = int(AA.irn.size());
         id.irn_loc = &(AA.irn[0]);
         id.jcn_loc = &(AA.jcn[0]);
-        id.a_loc = (MUMPS_T*)(&(AA.a[0]));
+        id.a_loc = (MUMPS_T*)(AA.pa);
       } else {
         id.nz = int(AA.irn.size());
         id.irn = &(AA.irn[0]);
         id.jcn = &(AA.jcn[0]);
-        id.a = (MUMPS_T*)(&(AA.a[0]));
+        id.a = (MUMPS_T*)(AA.pa);
       }
     }
 
@@ -51,6 +51,51 @@ namespace gmm {
   /* ******************************************************************** */
 
 
+  /* ******************************************************************** */
+  /*            Multithreading of the kernels                             */
+  /* ******************************************************************** */
+
+  /** Size under which the matrix-vector products and the operations on
+      dense vectors are not shared between the threads (when compiled with
+      OpenMP). Default value is GMM_OMP_THRESHOLD. */
+  inline size_type &omp_threshold() {
+    static size_type threshold = GMM_OMP_THRESHOLD;
+    return threshold;
+  }
+
+#ifdef GMM_USES_OPENMP
+  ///@cond DOXY_SHOW_ALL_FUNCTIONS
+  inline bool omp_parallelize(size_type n) {
+    return n >= omp_threshold() && !omp_in_parallel()
+      && omp_get_max_threads() > 1;
+  }
+
+  // Calls f(i0, i1) on contiguous chunks of [0, n), one per thread.
+  template <typename F> void omp_for_range(size_type n, F f) {
+    #pragma omp parallel
+    {
+      size_type t = omp_get_thread_num(), nth = omp_get_num_threads();
+      f((n * t) / nth, (n * (t+1)) / nth);
+    }
+  }
+
+  // Sum of f(i0, i1) on contiguous chunks of [0, n), one per thread. The
+  // partial results are summed in a fixed order, so that the result does
+  // not depend on the scheduling for a given number of threads.
+  template <typename T, typename F> T omp_reduce(size_type n, F f) {
+    std::vector<T> partial(omp_get_max_threads(), T(0));
+    #pragma omp parallel
+    {
+      size_type t = omp_get_thread_num(), nth = omp_get_num_threads();
+      partial[t] = f((n * t) / nth, (n * (t+1)) / nth);
+    }
+    T res(0);
+    for (const T &p : partial) res += p;
+    return res;
+  }
+  ///@endcond
+#endif
+
   /* ******************************************************************** */
   /*            Miscellaneous                                             */
   /* ******************************************************************** */
@@ -407,6 +452,16 @@ namespace gmm {
   template <typename V1, typename V2> inline
   typename strongest_value_type<V1,V2>::value_type
     vect_sp(const V1 &v1, const V2 &v2, abstract_dense, abstract_dense) {
+#ifdef GMM_USES_OPENMP
+    size_type n = vect_size(v1);
+    if (omp_parallelize(n)) {
+      auto it1 = vect_const_begin(v1);
+      auto it2 = vect_const_begin(v2);
+      return omp_reduce<typename strongest_value_type<V1,V2>::value_type>
+        (n, [&](size_type i0, size_type i1)
+         { return vect_sp_dense_(it1 + i0, it1 + i1, it2 + i0); });
+    }
+#endif
     return vect_sp_dense_(vect_const_begin(v1), vect_const_end(v1),
                           vect_const_begin(v2));
   }
@@ -542,14 +597,44 @@ namespace gmm {
   typename number_traits<typename linalg_traits<V>::value_type>
   ::magnitude_type
   vect_norm2_sqr(const V &v) {
-    typedef typename linalg_traits<V>::value_type T;
-    typedef typename number_traits<T>::magnitude_type R;
-    auto it = vect_const_begin(v), ite = vect_const_end(v);
+    return vect_norm2_sqr(v, typename linalg_traits<V>::storage_type());
+  }
+
+  ///@cond DOXY_SHOW_ALL_FUNCTIONS
+  template <typename R, typename IT> inline
+  R vect_norm2_sqr_(IT it, IT ite) {
     R res(0);
     for (; it != ite; ++it) res += gmm::abs_sqr(*it);
     return res;
   }
 
+  template <typename V, typename ST> inline
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr(const V &v, ST) {
+    typedef typename linalg_traits<V>::value_type T;
+    return vect_norm2_sqr_<typename number_traits<T>::magnitude_type>
+      (vect_const_begin(v), vect_const_end(v));
+  }
+
+  template <typename V> inline
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr(const V &v, abstract_dense) {
+    typedef typename linalg_traits<V>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
+#ifdef GMM_USES_OPENMP
+    size_type n = vect_size(v);
+    if (omp_parallelize(n)) {
+      auto it = vect_const_begin(v);
+      return omp_reduce<R>(n, [&](size_type i0, size_type i1)
+                           { return vect_norm2_sqr_<R>(it + i0, it + i1); });
+    }
+#endif
+    return vect_norm2_sqr_<R>(vect_const_begin(v), vect_const_end(v));
+  }
+  ///@endcond
+
   /** Euclidean norm of a vector. */
   template <typename V> inline
    typename number_traits<typename linalg_traits<V>::value_type>
@@ -1485,6 +1570,17 @@ namespace gmm {
   template <typename L1, typename L2, typename L3> inline
   void add(const L1& l1, const L2& l2, L3& l3,
            abstract_dense, abstract_dense, abstract_dense) {
+#ifdef GMM_USES_OPENMP
+    size_type n = vect_size(l3);
+    if (omp_parallelize(n)) {
+      auto it1 = vect_const_begin(l1);
+      auto it2 = vect_const_begin(l2);
+      auto it3 = vect_begin(l3);
+      omp_for_range(n, [&](size_type i0, size_type i1)
+                    { add_full_(it1 + i0, it2 + i0, it3 + i0, it3 + i1); });
+      return;
+    }
+#endif
     add_full_(vect_const_begin(l1), vect_const_begin(l2),
               vect_begin(l3), vect_end(l3));
   }
@@ -1551,6 +1647,17 @@ namespace gmm {
   void add(const L1& l1, L2& l2, abstract_dense, abstract_dense) {
     auto it1 = vect_const_begin(l1); 
     auto it2 = vect_begin(l2), ite = vect_end(l2);
+#ifdef GMM_USES_OPENMP
+    size_type n = vect_size(l2);
+    if (omp_parallelize(n)) {
+      omp_for_range(n, [&](size_type i0, size_type i1) {
+          auto itb1 = it1 + i0;
+          for (auto itb2 = it2 + i0, itbe = it2 + i1; itb2 != itbe;
+               ++itb2, ++itb1) *itb2 += *itb1;
+        });
+      return;
+    }
+#endif
     for (; it2 != ite; ++it2, ++it1) *it2 += *it1;
   }
 
@@ -1686,6 +1793,88 @@ namespace gmm {
     }
   }
 
+#ifdef GMM_USES_OPENMP
+  ///@cond DOXY_SHOW_ALL_FUNCTIONS
+  // Parallel l3 = l1*l2 (or l3 += l1*l2) for a row major matrix and a dense
+  // l3, each thread computing a block of rows.
+  template <typename L1, typename L2, typename L3>
+  bool omp_mult_by_row(const L1& l1, const L2& l2, L3& l3, bool add) {
+    size_type nr = mat_nrows(l1);
+    if (!omp_parallelize(nr)) return false;
+    auto it3 = vect_begin(l3);
+    omp_for_range(nr, [&](size_type i0, size_type i1) {
+        for (size_type i = i0; i < i1; ++i) {
+          if (add) *(it3 + i) += vect_sp(mat_const_row(l1, i), l2);
+          else *(it3 + i) = vect_sp(mat_const_row(l1, i), l2);
+        }
+      });
+    return true;
+  }
+
+  // Parallel l3 += l1*l2 for a column major matrix with sparse columns, l2
+  // and l3 being dense. Each thread accumulates the contribution of a block
+  // of columns in a buffer restricted to the rows it touches (a band for
+  // the usual matrices with a reasonable numbering) and the buffers are
+  // then summed, each thread taking care of a block of rows.
+  template <typename L1, typename L2, typename L3, typename ST1, typename ST3>
+  bool omp_mult_add_by_col(const L1&, const L2&, L3&, ST1, ST3)
+  { return false; }
+
+  template <typename L1, typename L2, typename L3>
+  bool omp_mult_add_by_col(const L1& l1, const L2& l2, L3& l3,
+                           abstract_sparse, abstract_dense) {
+    typedef typename linalg_traits<L3>::value_type T;
+    size_type nr = mat_nrows(l1), nc = mat_ncols(l1);
+    if (!omp_parallelize(nc)) return false;
+    size_type nt = omp_get_max_threads();
+    std::vector<std::vector<T>> buf(nt);
+    std::vector<size_type> rmin(nt, 0), rmax(nt, 0);
+    auto it2 = vect_const_begin(l2);
+    auto it3 = vect_begin(l3);
+    #pragma omp parallel
+    {
+      size_type t = omp_get_thread_num(), nth = omp_get_num_threads();
+      size_type j0 = (nc * t) / nth, j1 = (nc * (t+1)) / nth;
+      size_type r0 = nr, r1 = 0;
+      for (size_type j = j0; j < j1; ++j) {
+        auto it = vect_const_begin(mat_const_col(l1, j));
+        auto ite = vect_const_end(mat_const_col(l1, j));
+        for (; it != ite; ++it) {
+          r0 = std::min(r0, it.index());
+          r1 = std::max(r1, it.index() + 1);
+        }
+      }
+      if (r1 < r0) r1 = r0;
+      rmin[t] = r0; rmax[t] = r1;
+      std::vector<T> &b = buf[t];
+      b.assign(r1 - r0, T(0));
+      for (size_type j = j0; j < j1; ++j) {
+        T x = *(it2 + j);
+        if (x != T(0)) {
+          auto it = vect_const_begin(mat_const_col(l1, j));
+          auto ite = vect_const_end(mat_const_col(l1, j));
+          for (; it != ite; ++it) b[it.index() - r0] += (*it) * x;
+        }
+      }
+      #pragma omp barrier
+      size_type i0 = (nr * t) / nth, i1 = (nr * (t+1)) / nth;
+      for (size_type s = 0; s < nth; ++s) {
+        size_type k0 = std::max(i0, rmin[s]), k1 = std::min(i1, rmax[s]);
+        for (size_type i = k0; i < k1; ++i) *(it3 + i) += buf[s][i - rmin[s]];
+      }
+    }
+    return true;
+  }
+
+  template <typename L1, typename L2, typename L3> inline
+  bool omp_mult_add_by_col(const L1& l1, const L2& l2, L3& l3) {
+    return omp_mult_add_by_col(l1, l2, l3, typename linalg_traits<typename
+                      linalg_traits<L1>::const_sub_col_type>::storage_type(),
+                               typename linalg_traits<L3>::storage_type());
+  }
+  ///@endcond
+#endif
+
   template <typename L1, typename L2, typename L3>
   void mult_by_row(const L1& l1, const L2& l2, L3& l3, abstract_sparse) {
     typedef typename  linalg_traits<L3>::value_type T;
@@ -1710,6 +1899,9 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+#ifdef GMM_USES_OPENMP
+    if (omp_mult_by_row(l1, l2, l3, false)) return;
+#endif
     typename linalg_traits<L3>::iterator it=vect_begin(l3), ite=vect_end(l3);
     auto itr = mat_row_const_begin(l1); 
     for (; it != ite; ++it, ++itr)
@@ -1721,6 +1913,9 @@ namespace gmm {
   template <typename L1, typename L2, typename L3>
   void mult_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
     clear(l3);
+#ifdef GMM_USES_OPENMP
+    if (omp_mult_add_by_col(l1, l2, l3)) return;
+#endif
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
@@ -1831,6 +2026,9 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+#ifdef GMM_USES_OPENMP
+    if (omp_mult_by_row(l1, l2, l3, true)) return;
+#endif
     auto it=vect_begin(l3), ite=vect_end(l3);
     auto itr = mat_row_const_begin(l1);
     for (; it != ite; ++it, ++itr)
@@ -1839,6 +2037,9 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+#ifdef GMM_USES_OPENMP
+    if (omp_mult_add_by_col(l1, l2, l3)) return;
+#endif
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
@@ -183,6 +183,34 @@ namespace gmm {
     void  sger_(...); void  dger_(...); void  cgerc_(...); void  zgerc_(...);
   }
 
+  /* ********************************************************************* */
+  /* Level 1 calls on large vectors shared between the threads (see        */
+  /* omp_threshold() in gmm_blas.h). f(i0, m) works on x[i0 .. i0+m-1].    */
+  /* ********************************************************************* */
+
+#ifdef GMM_USES_OPENMP
+  inline bool blas_parallelize(BLAS_INT n)
+  { return omp_parallelize(size_type(n)); }
+
+  template <typename T, typename F> inline T blas_reduce(BLAS_INT n, F f) {
+    return omp_reduce<T>(size_type(n), [&](size_type i0, size_type i1)
+                         { return f(BLAS_INT(i0), BLAS_INT(i1 - i0)); });
+  }
+
+  template <typename F> inline void blas_for_range(BLAS_INT n, F f) {
+    omp_for_range(size_type(n), [&](size_type i0, size_type i1)
+                  { f(BLAS_INT(i0), BLAS_INT(i1 - i0)); });
+  }
+#else
+  inline bool blas_parallelize(BLAS_INT) { return false; }
+
+  template <typename T, typename F> inline T blas_reduce(BLAS_INT n, F f)
+  { return f(BLAS_INT(0), n); }
+
+  template <typename F> inline void blas_for_range(BLAS_INT n, F f)
+  { f(BLAS_INT(0), n); }
+#endif
+
 
   /* ********************************************************************* */
   /* vect_norm2(x).                                                        */
@@ -192,7 +220,11 @@ namespace gmm {
   inline number_traits<base_type>::magnitude_type         \
   vect_norm2(const std::vector<base_type> &x) {           \
     GMMLAPACK_TRACE("nrm2_interface");                    \
+    typedef number_traits<base_type>::magnitude_type R;   \
     BLAS_INT inc(1), n(BLAS_INT(vect_size(x)));           \
+    if (blas_parallelize(n))                              \
+      return sqrt(blas_reduce<R>(n, [&](BLAS_INT i0, BLAS_INT m) \
+        { R r = blas_name(&m, x.data() + i0, &inc); return r*r; })); \
     return blas_name(&n, &x[0], &inc);                    \
   }
 
@@ -205,12 +237,25 @@ namespace gmm {
   /* vect_sp(x,y) = vect_hp(x,y) for real vectors                          */
   /* ********************************************************************* */
 
+# define dot_omp_interface(blas_name, base_type)                            \
+  inline base_type blas_dot(BLAS_INT n, const base_type *x,                \
+                            const base_type *y) {                          \
+    BLAS_INT inc(1);                                                       \
+    if (blas_parallelize(n))                                               \
+      return blas_reduce<base_type>(n, [&](BLAS_INT i0, BLAS_INT m)        \
+        { return blas_name(&m, x + i0, &inc, y + i0, &inc); });            \
+    return blas_name(&n, x, &inc, y, &inc);                                \
+  }
+
+  dot_omp_interface(sdot_, BLAS_S)
+  dot_omp_interface(ddot_, BLAS_D)
+
 # define dot_interface(funcname, msg, blas_name, base_type)                \
   inline base_type funcname(const std::vector<base_type> &x,               \
                             const std::vector<base_type> &y) {             \
     GMMLAPACK_TRACE(msg);                                                  \
-    BLAS_INT inc(1), n(BLAS_INT(vect_size(y)));                            \
-    return blas_name(&n, &x[0], &inc, &y[0], &inc);                        \
+    BLAS_INT n(BLAS_INT(vect_size(y)));                                    \
+    return blas_dot(n, &x[0], &y[0]);                                      \
   }                                                                        \
   inline base_type funcname                                                \
    (const scaled_vector_const_ref<std::vector<base_type>,base_type> &x_,   \
@@ -218,8 +263,8 @@ namespace gmm {
     GMMLAPACK_TRACE(msg);                                                  \
     const std::vector<base_type> &x = *(linalg_origin(x_));                \
     base_type a(x_.r);                                                     \
-    BLAS_INT inc(1), n(BLAS_INT(vect_size(y)));                            \
-    return a * blas_name(&n, &x[0], &inc, &y[0], &inc);                    \
+    BLAS_INT n(BLAS_INT(vect_size(y)));                                    \
+    return a * blas_dot(n, &x[0], &y[0]);                                  \
   }                                                                        \
   inline base_type funcname                                                \
     (const std::vector<base_type> &x,                                      \
@@ -227,8 +272,8 @@ namespace gmm {
     GMMLAPACK_TRACE(msg);                                                  \
     const std::vector<base_type> &y = *(linalg_origin(y_));                \
     base_type b(y_.r);                                                     \
-    BLAS_INT inc(1), n(BLAS_INT(vect_size(y)));                            \
-    return b * blas_name(&n, &x[0], &inc, &y[0], &inc);                    \
+    BLAS_INT n(BLAS_INT(vect_size(y)));                                    \
+    return b * blas_dot(n, &x[0], &y[0]);                                  \
   }                                                                        \
   inline base_type funcname                                                \
     (const scaled_vector_const_ref<std::vector<base_type>,base_type> &x_,  \
@@ -237,8 +282,8 @@ namespace gmm {
     const std::vector<base_type> &x = *(linalg_origin(x_));                \
     const std::vector<base_type> &y = *(linalg_origin(y_));                \
     base_type a(x_.r), b(y_.r);                                            \
-    BLAS_INT inc(1), n(BLAS_INT(vect_size(y)));                            \
-    return a*b * blas_name(&n, &x[0], &inc, &y[0], &inc);                  \
+    BLAS_INT n(BLAS_INT(vect_size(y)));                                    \
+    return a*b * blas_dot(n, &x[0], &y[0]);                                \
   }
 
   dot_interface(vect_sp, "dot_interface", sdot_,  BLAS_S)
@@ -392,6 +437,9 @@ namespace gmm {
     BLAS_INT inc(1), n(BLAS_INT(vect_size(y))); base_type a(1);            \
     if(n == 0) return;                                                     \
     else if(n < 25) add_for_short_vectors(x, y, n);                        \
+    else if (blas_parallelize(n))                                          \
+      blas_for_range(n, [&](BLAS_INT i0, BLAS_INT m)                       \
+        { blas_name(&m, &a, x.data()+i0, &inc, y.data()+i0, &inc); });     \
     else blas_name(&n, &a, &x[0], &inc, &y[0], &inc);                      \
   }
 
@@ -411,6 +459,9 @@ namespace gmm {
     base_type a(x_.r);                                                     \
     if(n == 0) return;                                                     \
     else if(n < 25) add_for_short_vectors(x, y, a, n);                     \
+    else if (blas_parallelize(n))                                          \
+      blas_for_range(n, [&](BLAS_INT i0, BLAS_INT m)                       \
+        { blas_name(&m, &a, x.data()+i0, &inc, y.data()+i0, &inc); });     \
     else blas_name(&n, &a, &x[0], &inc, &y[0], &inc);                      \
   }
 
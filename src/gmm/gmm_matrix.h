@@ -637,6 +637,85 @@ namespace gmm
   inline void copy(const Matrix &A, csc_matrix<T, IND_TYPE, shift>& M)
   { M.init_with(A); }
 
+  /** Data attached by a solver to a csc_matrix_cache (a factorization of
+      the matrix for instance). */
+  struct csc_matrix_cache_data { virtual ~csc_matrix_cache_data() {} };
+
+  /** Compressed sparse column copy of a matrix, refreshed by update().
+      As long as the sparsity pattern of the source matrix is the one of the
+      previous call, only the values are copied, in place and without any
+      allocation. Otherwise, or after a call to invalidate(), the whole
+      structure is rebuilt and pattern_version() is incremented, which
+      allows a direct solver to reuse an analysis of the same pattern.
+      values_version() is incremented each time the values change, so that
+      a factorization of an unchanged matrix can be reused as well. The
+      solver keeps its data with the cache (solver_data()). It is not
+      copied with the cache.
+      The values of matrix() may be modified by a solver (scaling), so that
+      update() has to be called before each use.
+  */
+  template <typename T> class csc_matrix_cache {
+    csc_matrix<T> M;
+    size_type version, values_version_;
+    bool valid;
+    std::shared_ptr<csc_matrix_cache_data> data;
+
+    template <typename Matrix> bool copy_values(const Matrix &, row_major)
+    { return false; }
+    template <typename Matrix> bool copy_values(const Matrix &A, col_major);
+
+  public :
+    template <typename Matrix> csc_matrix<T> &update(const Matrix &A);
+    void invalidate() { valid = false; }
+    bool is_valid() const { return valid; }
+    size_type pattern_version() const { return version; }
+    size_type values_version() const { return values_version_; }
+    const csc_matrix<T> &matrix() const { return M; }
+    csc_matrix<T> &matrix() { return M; }
+    std::shared_ptr<csc_matrix_cache_data> &solver_data() { return data; }
+
+    csc_matrix_cache() : version(0), values_version_(0), valid(false) {}
+    csc_matrix_cache(const csc_matrix_cache &c)
+      : M(c.M), version(c.version), values_version_(c.values_version_),
+        valid(c.valid) {}
+    csc_matrix_cache &operator =(const csc_matrix_cache &c) {
+      M = c.M; version = c.version; values_version_ = c.values_version_;
+      valid = c.valid; data.reset();
+      return *this;
+    }
+  };
+
+  template <typename T> template <typename Matrix>
+  bool csc_matrix_cache<T>::copy_values(const Matrix &A, col_major) {
+    typedef typename linalg_traits<Matrix>::const_sub_col_type col_type;
+    if (mat_nrows(A) != M.nr || mat_ncols(A) != M.nc) return false;
+    bool changed = false;
+    for (size_type j = 0; j < M.nc; ++j) {
+      col_type col = mat_const_col(A, j);
+      typename linalg_traits<typename org_type<col_type>::t>::const_iterator
+        it = vect_const_begin(col), ite = vect_const_end(col);
+      size_type k = M.jc[j], ke = M.jc[j+1];
+      for (; it != ite; ++it, ++k) {
+        if (k == ke || size_type(M.ir[k]) != it.index()) return false;
+        if (M.pr[k] != *it) { M.pr[k] = *it; changed = true; }
+      }
+      if (k != ke) return false;
+    }
+    if (changed) ++values_version_;
+    return true;
+  }
+
+  template <typename T> template <typename Matrix>
+  csc_matrix<T> &csc_matrix_cache<T>::update(const Matrix &A) {
+    if (!valid || !copy_values(A, typename principal_orientation_type
+                               <typename linalg_traits<Matrix>::sub_orientation>
+                               ::potype())) {
+      M.init_with(A);
+      ++version; ++values_version_; valid = true;
+    }
+    return M;
+  }
+
   /* ******************************************************************** */
   /*                                                                      */
   /*             Read only compressed sparse row matrix                   */
@@ -321,6 +321,23 @@ typedef fixed_size_integer_generator<8>::uint_base_type uint64_type;
 
 }
 
+  /* ******************************************************************** */
+  /*	Multithreading of the basic linear algebra kernels                  */
+  /* ******************************************************************** */
+
+/* When compiled with OpenMP, the matrix-vector products and the operations
+   on large dense vectors are shared between the threads (see gmm_blas.h).
+   Define GMM_NO_OPENMP to keep them sequential. */
+#if defined(_OPENMP) && !defined(GMM_NO_OPENMP)
+# include <omp.h>
+# define GMM_USES_OPENMP
+#endif
+
+/* Default size under which the kernels stay sequential. */
+#ifndef GMM_OMP_THRESHOLD
+# define GMM_OMP_THRESHOLD 20000
+#endif
+
   /* ******************************************************************** */
   /*	Import/export classes and interfaces from a shared library          */
   /* ******************************************************************** */
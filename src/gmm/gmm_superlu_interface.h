@@ -161,9 +161,11 @@ namespace gmm {
   /*   SuperLU solve interface                                             */
   /* ********************************************************************* */
 
-  template <typename MAT, typename VECTX, typename VECTB>
-  int SuperLU_solve(const MAT &A, const VECTX &X, const VECTB &B,
-                    double& rcond_, int permc_spec = 3) {
+  /** Solve with a matrix already in the compressed sparse column format,
+      without any copy. The values of csc_A may be modified (scaling). */
+  template <typename T, typename VECTX, typename VECTB>
+  int SuperLU_csc_solve(csc_matrix<T> &csc_A, const VECTX &X,
+                        const VECTB &B, double& rcond_, int permc_spec = 3) {
     /*
      * Get column permutation vector perm_c[], according to permc_spec:
      *   permc_spec = 0: use the natural ordering
@@ -171,13 +173,11 @@ namespace gmm {
      *   permc_spec = 2: use minimum degree ordering on structure of A'+A
      *   permc_spec = 3: use approximate minimum degree column ordering
      */
-    typedef typename linalg_traits<MAT>::value_type T;
     typedef typename number_traits<T>::magnitude_type R;
 
-    int m = int(mat_nrows(A)), n = int(mat_ncols(A)), nrhs = 1, info = 0;
+    int m = int(mat_nrows(csc_A)), n = int(mat_ncols(csc_A)), nrhs = 1;
+    int info = 0;
 
-    csc_matrix<T> csc_A(m, n);
-    gmm::copy(A, csc_A);
     std::vector<T> rhs(m), sol(m);
     gmm::copy(B, rhs);
 
@@ -245,6 +245,15 @@ namespace gmm {
     return info;
   }
 
+  template <typename MAT, typename VECTX, typename VECTB>
+  int SuperLU_solve(const MAT &A, const VECTX &X, const VECTB &B,
+                    double& rcond_, int permc_spec = 3) {
+    typedef typename linalg_traits<MAT>::value_type T;
+    csc_matrix<T> csc_A(mat_nrows(A), mat_ncols(A));
+    gmm::copy(A, csc_A);
+    return SuperLU_csc_solve(csc_A, X, B, rcond_, permc_spec);
+  }
+
   template <class T>
   class SuperLU_factor {
     typedef typename number_traits<T>::magnitude_type R;
@@ -247,6 +247,30 @@ bool laplacian_problem::solve(void) {
   gmm::iteration iter(residual, 1, 40000);
   getfem::standard_solve(model, iter);
 
+  // A new assembly reuses the sparsity pattern of the tangent matrix
+  size_type nbd = gmm::mat_nrows(model.real_tangent_matrix());
+  getfem::model_real_sparse_matrix K(nbd, nbd);
+  gmm::copy(model.real_tangent_matrix(), K);
+  model.assembly(getfem::model::BUILD_MATRIX);
+  gmm::add(gmm::scaled(model.real_tangent_matrix(), scalar_type(-1)), K);
+  GMM_ASSERT1(gmm::mat_maxnorm(K)
+              <= 1E-12 * gmm::mat_maxnorm(model.real_tangent_matrix()),
+              "Error in the reassembly of the tangent matrix");
+
+  // Its compressed copy for the direct solvers only refreshes the values,
+  // which are unchanged for a linear model (no new factorization)
+  gmm::csc_matrix_cache<scalar_type> &Kc = model.real_tangent_matrix_csc();
+  Kc.update(model.real_tangent_matrix());
+  size_type pattern_version = Kc.pattern_version();
+  size_type values_version = Kc.values_version();
+  model.assembly(getfem::model::BUILD_MATRIX);
+  gmm::copy(Kc.update(model.real_tangent_matrix()), K);
+  gmm::add(gmm::scaled(model.real_tangent_matrix(), scalar_type(-1)), K);
+  GMM_ASSERT1(Kc.pattern_version() == pattern_version &&
+              Kc.values_version() == values_version &&
+              gmm::mat_maxnorm(K) == scalar_type(0),
+              "Error in the compressed copy of the tangent matrix");
+
   gmm::resize(U, mf_u.nb_dof());
   gmm::copy(model.real_variable("u"), U);
 
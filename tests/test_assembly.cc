@@ -20,6 +20,7 @@
 ===========================================================================*/
 #include "getfem/getfem_assembling.h"
 #include "getfem/getfem_generic_assembly.h"
+#include "getfem/getfem_models.h"
 #include "getfem/getfem_export.h"
 #include "getfem/getfem_regular_meshes.h"
 #include "getfem/getfem_partial_mesh_fem.h"
@@ -548,6 +549,41 @@ void g_params::init(int argc, char *argv[]) {
 
 
 
+// Operator x -> (1+|x|^2) x with a batched evaluation (the default one)
+struct test_cubic_operator : public getfem::ga_nonlinear_operator {
+  bool result_size(const arg_list &args, bgeot::multi_index &sizes) const {
+    if (args.size() != 1) return false;
+    sizes = args[0]->sizes();
+    return true;
+  }
+  void value(const arg_list &args, bgeot::base_tensor &result) const {
+    scalar_type a = scalar_type(1) + gmm::vect_norm2_sqr(args[0]->as_vector());
+    for (size_type i = 0; i < result.size(); ++i)
+      result[i] = a * (*args[0])[i];
+  }
+  void derivative(const arg_list &args, size_type,
+                  bgeot::base_tensor &result) const {
+    const bgeot::base_tensor &x = *args[0];
+    size_type n = x.size();
+    scalar_type a = scalar_type(1) + gmm::vect_norm2_sqr(x.as_vector());
+    for (size_type j = 0; j < n; ++j)
+      for (size_type i = 0; i < n; ++i)
+        result[i+n*j] = scalar_type(2) * x[i] * x[j] + ((i == j) ? a : 0.);
+  }
+  void second_derivative(const arg_list &args, size_type, size_type,
+                         bgeot::base_tensor &result) const {
+    const bgeot::base_tensor &x = *args[0];
+    size_type n = x.size();
+    for (size_type k = 0; k < n; ++k)
+      for (size_type j = 0; j < n; ++j)
+        for (size_type i = 0; i < n; ++i)
+          result[i+n*(j+n*k)] = scalar_type(2) * (((i == j) ? x[k] : 0.)
+                                + ((i == k) ? x[j] : 0.)
+                                + ((j == k) ? x[i] : 0.));
+  }
+  bool has_batched_evaluation() const { return true; }
+};
+
 static void test_new_assembly(int N, int NX, int pK) {
 
     // std::string expr="([1,2;3,4]@[1,2;1,2])(:,2,1,1)(1)+ [1,2;3,4](1,:)(2)"; // should give 4
@@ -778,6 +814,9 @@ static void test_new_assembly(int N, int NX, int pK) {
       MAT_TEST_2(ndofp, ndofp, "(Grad_p:Grad_p)/2", mim2, Ip, Ip);
       MAT_TEST_2(ndofp, ndofp, "sqr(Norm(Grad_p))/2", mim2, Ip, Ip);
       MAT_TEST_2(ndofp, ndofp, "Norm_sqr(Grad_p)/2", mim2, Ip, Ip);
+      workspace.set_batched_int_points(true);
+      MAT_TEST_2(ndofp, ndofp, "Grad_Test_p:Grad_Test2_p", mim2, Ip, Ip);
+      workspace.set_batched_int_points(false);
       if (N == 2) {
         MAT_TEST_2(ndofp, ndofp,
                    "(sqr(Grad_p(1)) + sqr(Grad_p(2)))/2", mim2, Ip, Ip);
@@ -816,6 +855,10 @@ static void test_new_assembly(int N, int NX, int pK) {
                  Iu, Iu,
                  getfem::old_asm_stiffness_matrix_for_homogeneous_linear_elasticity
                  (K, mim2, mf_u, lambda, mu));
+      workspace.set_batched_int_points(true);
+      MAT_TEST_2(ndofu, ndofu, "(lambda*Trace(Grad_Test_u)*Id(qdim(u)) "
+                 "+ mu*(Grad_Test_u'+Grad_Test_u)):Grad_Test2_u", mim2, Iu, Iu);
+      workspace.set_batched_int_points(false);
       MAT_TEST_2(ndofu, ndofu, "lambda*Div_Test_u*Div_Test2_u "
                  "+ mu*(Grad_Test_u'+Grad_Test_u):Grad_Test2_u", mim2, Iu, Iu);
       
@@ -880,6 +923,192 @@ static void test_new_assembly(int N, int NX, int pK) {
                  mim2, Iu, Iu,
                  getfem::old_asm_stiffness_matrix_for_linear_elasticity
                  (K, mim2, mf_u, mf_p, lambda2, mu2));
+
+      // Parallel assembly into a matrix shared by all the threads (with the
+      // threads requested in main, so that the column locks are exercised)
+      getfem::model_real_sparse_matrix
+        KS(gmm::mat_nrows(workspace.assembled_matrix()),
+           gmm::mat_ncols(workspace.assembled_matrix()));
+      getfem::column_locks KS_locks;
+      GETFEM_OMP_PARALLEL(
+        getfem::ga_workspace workspace2
+          (workspace, getfem::ga_workspace::inherit::ALL);
+        workspace2.add_expression("(lambda2*Trace(Grad_Test_u)*Id(meshdim) "
+                                  "+ mu2*(Grad_Test_u'+Grad_Test_u))"
+                                  ":Grad_Test2_u", mim2);
+        workspace2.set_assembled_matrix(KS, KS_locks);
+        workspace2.assembly(2);
+      )
+      gmm::copy(K2, K);
+      gmm::add(gmm::scaled(gmm::sub_matrix(KS, Iu, Iu), scalar_type(-1)), K);
+      norm_error = gmm::mat_norminf(K);
+      cout << "Error of the assembly in a shared matrix : " << norm_error
+           << endl;
+      GMM_ASSERT1(norm_error < 1E-10, "Error in shared matrix assembly");
+    }
+
+    if (all) { // Residual of a model assembled color by color, with and
+               // without kept compiled expressions, at several iterates
+      getfem::model md0, md1, md2;
+      md1.set_colored_residual_assembly(true);
+      md2.set_colored_residual_assembly(true);
+      md2.set_keep_compiled_expressions(false);
+      scalar_type norm_error(0);
+      for (getfem::model *md : {&md0, &md1, &md2}) {
+        md->add_fem_variable("u", mf_u);
+        getfem::add_nonlinear_term(*md, mim, "sqr(Norm(u))*(u.Test_u) "
+                                   "+ (Grad_u+Grad_u'):Grad_Test_u");
+      }
+      for (size_type k = 0; k < 2; ++k) {
+        for (getfem::model *md : {&md0, &md1, &md2}) {
+          gmm::copy(gmm::scaled(U, scalar_type(k+1)),
+                    md->set_real_variable("u"));
+          md->assembly(getfem::model::BUILD_RHS);
+        }
+        for (getfem::model *md : {&md1, &md2}) {
+          base_vector R(md0.real_rhs());
+          gmm::add(gmm::scaled(md->real_rhs(), scalar_type(-1)), R);
+          norm_error = std::max(norm_error, gmm::vect_norminf(R));
+        }
+      }
+      cout << "\nError of the colored assembly of a residual : "
+           << norm_error << endl;
+      GMM_ASSERT1(norm_error < 1E-10, "Error in colored residual assembly");
+    }
+
+    if (all) { // Profiling of the assembly of a model
+      getfem::model md;
+      md.add_fem_variable("u", mf_u);
+      gmm::copy(U, md.set_real_variable("u"));
+      getfem::add_nonlinear_term(md, mim, "sqr(Norm(u))*(u.Test_u) "
+                                 "+ (Grad_u+Grad_u'):Grad_Test_u");
+      md.enable_assembly_profiling();
+      md.assembly(getfem::model::BUILD_ALL);
+      const getfem::ga_assembly_profile &p = md.assembly_profile();
+      cout << "\nProfile of the assembly of a model :\n" << p;
+      size_type nb_cv = m.convex_index().card();
+      GMM_ASSERT1(p.nb_assemblies >= 2 && p.nb_assemblies % 2 == 0,
+                  "Wrong number of assemblies"); // Two per thread
+      GMM_ASSERT1(p.nb_elements == 2 * nb_cv, "Wrong number of elements");
+      GMM_ASSERT1(p.nb_gauss_points
+                  == 2 * nb_cv * mim.int_method_of_element(0)
+                                ->approx_method()->nb_points_on_convex(),
+                  "Wrong number of integration points");
+      GMM_ASSERT1(!p.instructions.empty() && !p.expressions.empty()
+                  && p.scatter.nb_calls == nb_cv, "Incomplete profile");
+      size_type nb_calls = 0;
+      for (const auto &e : p.expressions)
+        nb_calls += e.second.instructions.nb_calls;
+      for (const auto &i : p.instructions) nb_calls -= i.second.nb_calls;
+      GMM_ASSERT1(nb_calls == 0, "Inconsistent profile");
+      md.clear_assembly_profile();
+      GMM_ASSERT1(md.assembly_profile().nb_elements == 0,
+                  "The profile has not been cleared");
+    }
+
+    if (all) { // Assemblies of a model with kept compiled expressions
+      getfem::model md1, md2;
+      md2.set_keep_compiled_expressions(false);
+      for (getfem::model *md : {&md1, &md2}) {
+        md->add_fem_variable("u", mf_u);
+        md->add_fixed_size_data("a", 1);
+        getfem::add_nonlinear_term(*md, mim, "a*sqr(Norm(u))*(u.Test_u) "
+                                   "+ (Grad_u+Grad_u'):Grad_Test_u");
+      }
+      scalar_type norm_error(0);
+      for (size_type k = 0; k < 3; ++k) {
+        for (getfem::model *md : {&md1, &md2}) {
+          gmm::copy(gmm::scaled(U, scalar_type(k+1)),
+                    md->set_real_variable("u"));
+          md->set_real_variable("a")[0] = scalar_type(k+2);
+          md->assembly(getfem::model::BUILD_ALL);
+        }
+        getfem::model_real_sparse_matrix K(md1.real_tangent_matrix());
+        gmm::add(gmm::scaled(md2.real_tangent_matrix(), scalar_type(-1)), K);
+        base_vector R(md1.real_rhs());
+        gmm::add(gmm::scaled(md2.real_rhs(), scalar_type(-1)), R);
+        norm_error = std::max(norm_error, gmm::mat_norminf(K)
+                                          + gmm::vect_norminf(R));
+      }
+      cout << "\nError of the assembly with kept compiled expressions : "
+           << norm_error << endl;
+      GMM_ASSERT1(norm_error < 1E-10,
+                  "Error in assembly with kept compiled expressions");
+    }
+
+#if defined(GETFEM_HAVE_DLOPEN)
+    if (all) { // Assemblies with the native code backend
+      // Fresh cache, so that the kernels are compiled by the test and do not
+      // end up in the cache of the user.
+      char cache[] = "/tmp/test_assembly_native_XXXXXX";
+      GMM_ASSERT1(mkdtemp(cache), "Cannot create a temporary directory");
+      getfem::ga_set_native_code_cache(cache);
+      getfem::ga_enable_native_code();
+      if (getfem::ga_native_code_enabled()) {
+        std::string expr = "exp(-Norm_sqr(u))*(Grad_u:Grad_Test_u) "
+          "+ sqr(Norm(u))*(u.Test_u) + (Grad_u+Grad_u'):Grad_Test_u "
+          "+ Trace(Sym(Grad_u)*Grad_u')*Div_Test_u";
+        getfem::model md1, md2;
+        scalar_type E[2];
+        for (size_type i = 0; i < 2; ++i) {
+          getfem::ga_enable_native_code(i == 0);
+          getfem::model &md = i ? md2 : md1;
+          md.add_fem_variable("u", mf_u);
+          gmm::copy(U, md.set_real_variable("u"));
+          getfem::add_nonlinear_term(md, mim, expr);
+          md.assembly(getfem::model::BUILD_ALL);
+          getfem::ga_workspace workspace_md(md);
+          workspace_md.add_expression("Norm_sqr(Grad_u)+sin(u(1))", mim);
+          workspace_md.assembly(0);
+          E[i] = workspace_md.assembled_potential();
+        }
+        getfem::model_real_sparse_matrix K(md1.real_tangent_matrix());
+        gmm::add(gmm::scaled(md2.real_tangent_matrix(), scalar_type(-1)), K);
+        base_vector R(md1.real_rhs());
+        gmm::add(gmm::scaled(md2.real_rhs(), scalar_type(-1)), R);
+        scalar_type norm_error = gmm::mat_norminf(K) + gmm::vect_norminf(R)
+                               + gmm::abs(E[0] - E[1]);
+        cout << "\nError of the assembly with the native code backend : "
+             << norm_error << endl;
+        GMM_ASSERT1(norm_error < 1E-10,
+                    "Error in assembly with the native code backend");
+        if (std::system("c++ --version > /dev/null 2>&1") == 0)
+          GMM_ASSERT1(getfem::ga_nb_native_code_kernels() > 0,
+                      "No native code kernel has been loaded");
+      }
+      getfem::ga_enable_native_code(false);
+      GMM_ASSERT1(std::system((std::string("rm -rf ") + cache).c_str()) == 0,
+                  "Cannot remove " << cache);
+    }
+#endif
+
+    if (all) { // Assemblies with batched operators (disabled by profiling)
+      dal::singleton<getfem::ga_predef_operator_tab>::instance().add_method
+        ("Test_cubic", std::make_shared<test_cubic_operator>());
+      std::string expr = "Test_cubic(0.1*Test_cubic(u)).Test_u "
+        "+ Test_cubic(Grad_u):Grad_Test_u "
+        "+ Von_Mises_projection(Grad_u+Grad_u', 0.5):Grad_Test_u "
+        "+ Ciarlet_Geymonat_sigma(0.01*Grad_u, [1,1,0.3])"
+        ":Grad_Test_u + Expm(0.01*Grad_u):Grad_Test_u";
+      getfem::model md1, md2;
+      md2.enable_assembly_profiling();
+      for (getfem::model *md : {&md1, &md2}) {
+        md->add_fem_variable("u", mf_u);
+        gmm::copy(U, md->set_real_variable("u"));
+        getfem::add_nonlinear_term(*md, mim, expr);
+        md->assembly(getfem::model::BUILD_ALL);
+      }
+      getfem::model_real_sparse_matrix K(md1.real_tangent_matrix());
+      gmm::add(gmm::scaled(md2.real_tangent_matrix(), scalar_type(-1)), K);
+      base_vector R(md1.real_rhs());
+      gmm::add(gmm::scaled(md2.real_rhs(), scalar_type(-1)), R);
+      scalar_type norm_error = (gmm::mat_norminf(K) + gmm::vect_norminf(R))
+        / (gmm::mat_norminf(md1.real_tangent_matrix())
+           + gmm::vect_norminf(md1.real_rhs()));
+      cout << "\nRelative error of the assembly with batched operators : "
+           << norm_error << endl;
+      GMM_ASSERT1(norm_error < 1E-12,
+                  "Error in assembly with batched operators");
     }
 
 }
@@ -892,6 +1121,10 @@ int main(int argc, char *argv[]) {
   GETFEM_MPI_INIT(argc, argv);
   GMM_SET_EXCEPTION_DEBUG; // Exceptions make a memory fault, to debug.
   FE_ENABLE_EXCEPT;        // Enable floating point exception for Nan.
+  // Several threads for the parallel assemblies. Set before anything else,
+  // since the functions defined by an expression are compiled for each
+  // thread at their definition.
+  getfem::set_num_threads(4);
   
   test_new_assembly(2, 25, 2);
   test_new_assembly(3, 7, 2);
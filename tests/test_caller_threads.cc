@@ -0,0 +1,111 @@
+/*===========================================================================
+
+ Copyright (C) 2020-2020 Yves Renard.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+===========================================================================*/
+
+/* Independent models assembled at the same time by several threads of the
+   program, each one holding a getfem::caller_thread. The results are
+   compared with the ones of a sequential assembly. */
+
+#include "getfem/getfem_models.h"
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_generic_assembly.h"
+#include <atomic>
+#include <thread>
+
+using std::endl; using std::cout; using std::cerr;
+using bgeot::size_type;
+using bgeot::scalar_type;
+
+struct assembly_result {
+  getfem::model_real_sparse_matrix K;
+  getfem::model_real_plain_vector F;
+};
+
+static void assemble_model(size_type k, assembly_result &res) {
+  size_type N = 2 + (k % 2); // 2D and 3D models use different caches
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(N, (N == 2) ? 6 + k : 2 + k/4);
+  getfem::regular_unit_mesh(m, nsubdiv, (k % 4 < 2)
+                            ? bgeot::simplex_geotrans(N, 1)
+                            : bgeot::parallelepiped_geotrans(N, 1));
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf);
+  md.add_initialized_scalar_data("f", scalar_type(1 + k));
+  getfem::add_nonlinear_term(md, mim, "Grad_u.Grad_Test_u + myf(u)*Test_u");
+  getfem::add_source_term(md, mim, "f*myf(X(1))*Test_u");
+  md.assembly(getfem::model::BUILD_ALL);
+
+  gmm::resize(res.K, md.nb_dof(), md.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), res.K);
+  res.F = md.real_rhs();
+}
+
+static bool same_results(const assembly_result &a, const assembly_result &b){
+  if (gmm::mat_nrows(a.K) != gmm::mat_nrows(b.K)) return false;
+  getfem::model_real_sparse_matrix D(gmm::mat_nrows(a.K),
+                                     gmm::mat_ncols(a.K));
+  gmm::copy(a.K, D); gmm::add(gmm::scaled(b.K, scalar_type(-1)), D);
+  getfem::model_real_plain_vector V(a.F);
+  gmm::add(gmm::scaled(b.F, scalar_type(-1)), V);
+  return gmm::mat_maxnorm(D) < 1E-12 && gmm::vect_norminf(V) < 1E-12;
+}
+
+int main(void) {
+
+  GMM_SET_EXCEPTION_DEBUG; // Exceptions make a memory fault, to debug.
+  FE_ENABLE_EXCEPT;        // Enable floating point exception for Nan.
+
+  const size_type NB_CALLERS = 2, NB_MODELS = 8;
+  getfem::set_num_threads(2);
+  getfem::set_nb_caller_threads(NB_CALLERS);
+  getfem::ga_define_function("myf", 1, "sqr(t)+1");
+
+  try {
+    std::vector<assembly_result> ref(NB_MODELS), res(NB_MODELS);
+    for (size_type k = 0; k < NB_MODELS; ++k) assemble_model(k, ref[k]);
+
+    std::atomic<size_type> next_model{0}, nb_errors{0};
+    std::vector<std::thread> threads;
+    for (size_type i = 0; i < NB_CALLERS; ++i)
+      threads.emplace_back([&] {
+        getfem::caller_thread caller;
+        try {
+          for (size_type k = next_model++; k < NB_MODELS; k = next_model++)
+            assemble_model(k, res[k]);
+        } catch (const std::exception &e) {
+          cerr << e.what() << endl; ++nb_errors;
+        }
+      });
+    for (auto &t : threads) t.join();
+
+    GMM_ASSERT1(nb_errors == 0, "Error in a caller thread");
+    for (size_type k = 0; k < NB_MODELS; ++k)
+      GMM_ASSERT1(same_results(ref[k], res[k]),
+                  "Wrong concurrent assembly of model " << k);
+  }
+  GMM_STANDARD_CATCH_ERROR;
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/*===========================================================================
+
+ Copyright (C) 2020-2020 Yves Renard.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+===========================================================================*/
+
+/* Comparison of the multithreaded kernels of gmm (matrix-vector products
+   and operations on dense vectors) with the sequential ones. */
+
+#include "gmm/gmm.h"
+
+using std::endl; using std::cout; using std::cerr;
+using gmm::size_type;
+
+typedef gmm::col_matrix<gmm::rsvector<double>> col_rs_matrix;
+typedef gmm::row_matrix<gmm::rsvector<double>> row_rs_matrix;
+
+static void set_sequential(bool seq)
+{ gmm::omp_threshold() = seq ? size_type(-1) : size_type(1); }
+
+template <typename MAT, typename VEC>
+static void check_mult(const MAT &A, const VEC &x, const VEC &b,
+                       const char *name) {
+  size_type n = gmm::mat_nrows(A);
+  std::vector<double> y1(n), y2(n), z1(n), z2(n);
+  set_sequential(true);
+  gmm::mult(A, x, y1);
+  gmm::mult(A, x, b, z1);
+  gmm::mult(gmm::transposed(A), x, y2);
+  set_sequential(false);
+  gmm::mult(A, x, z2);
+  gmm::add(gmm::scaled(y1, -1.0), z2);
+  GMM_ASSERT1(gmm::vect_norminf(z2) < 1E-12, "Wrong parallel product with "
+              << name << " : " << gmm::vect_norminf(z2));
+  gmm::mult(A, x, b, z2);
+  gmm::add(gmm::scaled(z1, -1.0), z2);
+  GMM_ASSERT1(gmm::vect_norminf(z2) < 1E-12, "Wrong parallel product "
+              "and addition with " << name);
+  gmm::mult(gmm::transposed(A), x, z2);
+  gmm::add(gmm::scaled(y2, -1.0), z2);
+  GMM_ASSERT1(gmm::vect_norminf(z2) < 1E-12, "Wrong parallel transposed "
+              "product with " << name);
+}
+
+int main(void) {
+
+  GMM_SET_EXCEPTION_DEBUG; // Exceptions make a memory fault, to debug.
+
+#ifdef GMM_USES_OPENMP
+  omp_set_num_threads(4);
+#endif
+
+  size_type n = 5000, nb = 60;
+  // Nonsymmetric diagonally dominant band matrix with a few remote terms
+  col_rs_matrix A(n, n);
+  for (size_type i = 0; i < n; ++i) {
+    A(i, i) = 4.0;
+    for (size_type k = 1; k < 5 && i + k < n; ++k)
+      { A(i, i+k) = -0.4 / double(k); A(i+k, i) = -0.5 / double(k); }
+    if (i + nb < n) A(i, i+nb) = 0.1;
+    if (i % 7 == 0) A(i, (i * 131) % n) += 0.01;
+  }
+  gmm::csr_matrix<double> A_csr; gmm::copy(A, A_csr);
+  gmm::csc_matrix<double> A_csc; gmm::copy(A, A_csc);
+  row_rs_matrix A_row(n, n); gmm::copy(A, A_row);
+  gmm::dense_matrix<double> A_dense(500, 500);
+  gmm::copy(gmm::sub_matrix(A, gmm::sub_interval(0, 500)), A_dense);
+
+  std::vector<double> x(n), b(n), y(n);
+  for (size_type i = 0; i < n; ++i)
+    { x[i] = sin(double(i)); b[i] = cos(double(3*i)); }
+
+  check_mult(A, x, b, "col_matrix<rsvector>");
+  check_mult(A_csr, x, b, "csr_matrix");
+  check_mult(A_csc, x, b, "csc_matrix");
+  check_mult(A_row, x, b, "row_matrix<rsvector>");
+  check_mult(A_dense, gmm::sub_vector(x, gmm::sub_interval(0, 500)),
+             gmm::sub_vector(b, gmm::sub_interval(0, 500)), "dense_matrix");
+
+  // Reductions and additions on dense vectors
+  set_sequential(true);
+  double sp1 = gmm::vect_sp(x, b), nrm1 = gmm::vect_norm2(x);
+  gmm::add(x, gmm::scaled(b, 2.0), y);
+  set_sequential(false);
+  double sp2 = gmm::vect_sp(x, b), nrm2 = gmm::vect_norm2(x);
+  GMM_ASSERT1(gmm::abs(sp1 - sp2) < 1E-10 && gmm::abs(nrm1 - nrm2) < 1E-10,
+              "Wrong parallel reduction");
+  std::vector<double> y2(b);
+  gmm::add(gmm::scaled(b, 1.0), y2);
+  gmm::add(gmm::scaled(x, 1.0), y2);
+  gmm::add(gmm::scaled(y, -1.0), y2);
+  GMM_ASSERT1(gmm::vect_norminf(y2) < 1E-12, "Wrong parallel addition");
+  std::vector<std::complex<double>> c1(n), c2(n);
+  for (size_type i = 0; i < n; ++i)
+    { c1[i] = std::complex<double>(x[i], b[i]); c2[i] = c1[i] * b[i]; }
+  std::complex<double> csp2 = gmm::vect_sp(c1, c2);
+  set_sequential(true);
+  std::complex<double> csp1 = gmm::vect_sp(c1, c2);
+  GMM_ASSERT1(gmm::abs(csp1 - csp2) < 1E-10, "Wrong complex reduction");
+
+  // Iterative solvers with sequential and parallel kernels
+  for (int version = 0; version < 2; ++version) {
+    std::vector<double> x1(n), x2(n);
+    gmm::ilu_precond<gmm::csr_matrix<double>> P(A_csr);
+    gmm::iteration iter1(1E-10), iter2(1E-10);
+    set_sequential(true);
+    if (version == 0) gmm::gmres(A, x1, b, P, 50, iter1);
+    else gmm::bicgstab(A_csr, x1, b, P, iter1);
+    set_sequential(false);
+    if (version == 0) gmm::gmres(A, x2, b, P, 50, iter2);
+    else gmm::bicgstab(A_csr, x2, b, P, iter2);
+    GMM_ASSERT1(iter1.converged() && iter2.converged(), "Not converged");
+    gmm::add(gmm::scaled(x1, -1.0), x2);
+    cout << (version == 0 ? "gmres" : "bicgstab") << " iterations : "
+         << iter1.get_iteration() << " / " << iter2.get_iteration()
+         << ", difference : " << gmm::vect_norminf(x2) << endl;
+    GMM_ASSERT1(gmm::vect_norminf(x2) < 1E-8,
+                "Different results with the parallel kernels");
+  }
+
+  return 0;
+}
@@ -21,6 +21,8 @@
 #include "getfem/getfem_export.h"
 #include "getfem/getfem_export.h"
 #include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_generic_assembly.h"
+#include "getfem/getfem_models.h"
 #ifdef GETFEM_HAVE_SYS_TIMES
 #  include <sys/times.h>
 #endif
@@ -401,6 +403,85 @@ void testDim_3D() {
   cerr << "Ok, it works !\n";
 }
 
+/* Interpolate transformation defined by an expression between two
+   non-matching meshes. The field is affine, hence exactly represented on
+   both meshes. */
+void test_interpolate_transformation(size_type N, size_type NX) {
+  cout << "  Interpolate transformation from expression, N=" << N
+       << ", NX=" << NX << ":"; cout.flush();
+  mesh m1, m2;
+  build_mesh(m1, 0, N, N, NX, 1, true);
+  build_mesh(m2, 0, N, N, NX+3, 1, true);
+  mesh_fem mf2(m2);
+  mf2.set_finite_element(getfem::PK_fem(dim_type(N), 1));
+  getfem::mesh_im mim1(m1);
+  mim1.set_integration_method(getfem::int_method_descriptor
+                              (N == 2 ? "IM_TRIANGLE(4)" : "IM_TETRAHEDRON(5)"));
+  std::vector<scalar_type> U(mf2.nb_dof());
+  for (size_type i = 0; i < mf2.nb_dof(); ++i) {
+    base_node P = mf2.point_of_basic_dof(i);
+    U[i] = 1. + P[0] + 2.*P[1];
+  }
+  getfem::ga_workspace workspace;
+  workspace.add_fem_constant("u", mf2, U);
+  getfem::add_interpolate_transformation_from_expression
+    (workspace, "trans", m1, m2, "X");
+  chrono c; c.init().tic();
+  workspace.add_expression("Interpolate(u,trans)", mim1);
+  workspace.assembly(0);
+  scalar_type I1 = workspace.assembled_potential();
+  c.toc();
+  workspace.clear_expressions();
+  workspace.add_expression("1+X(1)+2*X(2)", mim1);
+  workspace.assembly(0);
+  scalar_type I2 = workspace.assembled_potential();
+  cout << " " << c.cpu()*1000. << " ms, error = " << gmm::abs(I1-I2) << "\n";
+  GMM_ASSERT1(gmm::abs(I1-I2) < 1e-10, "Wrong interpolation");
+}
+
+/* Interpolations of an expression of a model with several threads, compared
+   to the serial ones. The gradient of a P2 field is interpolated on a P1
+   fem, so that the values of the shared dofs are averaged. */
+void test_parallel_interpolation(size_type NX) {
+  cout << "  Parallel interpolation of a model expression, NX=" << NX
+       << ":"; cout.flush();
+  mesh m;
+  build_mesh(m, 0, 2, 2, NX, 1, true);
+  mesh_fem mf_u(m), mf_p(m);
+  mf_u.set_finite_element(getfem::PK_fem(2, 2));
+  mf_p.set_finite_element(getfem::PK_fem(2, 1));
+  mf_p.set_qdim(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(getfem::int_method_descriptor
+                             ("IM_TRIANGLE(4)"));
+  getfem::im_data imd(mim);
+  getfem::stored_mesh_slice sl;
+  sl.build(m, getfem::slicer_none(), 3);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf_u);
+  std::vector<scalar_type> &U = md.set_real_variable("u");
+  for (size_type i = 0; i < mf_u.nb_dof(); ++i)
+    U[i] = func(mf_u.point_of_basic_dof(i));
+
+  std::vector<scalar_type> V[2][3]; // serial and parallel results
+  for (size_type t = 0; t < 2; ++t) {
+    getfem::set_num_threads(t ? 4 : 1);
+    getfem::ga_interpolation_Lagrange_fem(md, "Grad_u", mf_p, V[t][0]);
+    getfem::ga_interpolation_im_data(md, "u*Norm(Grad_u)", imd, V[t][1]);
+    getfem::ga_interpolation_mesh_slice(md, "sqr(u)", sl, V[t][2]);
+  }
+  getfem::set_num_threads(1);
+  scalar_type error(0);
+  for (size_type k = 0; k < 3; ++k) {
+    GMM_ASSERT1(V[0][k].size() && V[0][k].size() == V[1][k].size(),
+                "Wrong size of the parallel interpolation");
+    error = std::max(error, gmm::vect_dist2(V[0][k], V[1][k]));
+  }
+  cout << " error = " << error << "\n";
+  GMM_ASSERT1(error < 1e-10, "Wrong parallel interpolation");
+}
+
 int main(int argc, char *argv[]) {
 
   FE_ENABLE_EXCEPT;        // Enable floating point exception for Nan.
@@ -427,4 +508,7 @@ int main(int argc, char *argv[]) {
       test_different_mesh(0, 3, 2, quick ? 8 : 50, 2);
     }
   }
+  test_interpolate_transformation(2, quick ? 10 : 40);
+  test_interpolate_transformation(3, quick ? 4 : 10);
+  test_parallel_interpolation(quick ? 10 : 40);
 }
@@ -18,11 +18,16 @@
  Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
 
 ===========================================================================*/
+#include <iomanip>
 #include "getfem/getfem_regular_meshes.h"
 #include "getfem/bgeot_poly_composite.h"
 #include "getfem/bgeot_comma_init.h"
 #include "getfem/getfem_export.h"
+#include "getfem/getfem_import.h"
 #include "getfem/bgeot_node_tab.h"
+#ifdef GETFEM_HAVE_ZLIB_H
+# include <zlib.h>
+#endif
 using std::endl; using std::cout; using std::cerr;
 using std::ends; using std::cin;
 using getfem::size_type;
@@ -303,6 +308,90 @@ void test_region() {
   b.add(8);
   r = getfem::mesh_region::intersection(a,b);
   cout << "a=" << a << "\nb=" << b << "a inter b=" << r << "\n";
+
+  auto str = [](const getfem::mesh_region &rg)
+  { std::stringstream ss; ss << rg; return ss.str(); };
+  GMM_ASSERT1(str(r) == "2 3/7 9/1 9/5 ", "Wrong intersection " << r);
+  r = getfem::mesh_region::merge(a,b);
+  GMM_ASSERT1(str(r) == "2 3/2 3/3 3/7 4 5 8 9 9/1 9/5 ",
+              "Wrong merge " << r);
+  r = getfem::mesh_region::subtract(a,b);
+  GMM_ASSERT1(str(r) == "3/3 4 5 9 ", "Wrong subtraction " << r);
+
+  a.sup(3, 7); a.sup(4);
+  a.swap_convex(5, 12); a.swap_convex(3, 1);
+  GMM_ASSERT1(str(a) == "1/3 2 9 12 " && !a.is_in(4) && a.is_in(1, 3),
+              "Wrong region after suppressions and swaps " << a);
+  std::vector<size_type> new_numbers(13);
+  for (size_type i = 0; i < 13; ++i) new_numbers[i] = 12 - i;
+  a.renumber_convexes(new_numbers);
+  GMM_ASSERT1(str(a) == "0 3 10 11/3 ", "Wrong renumbering " << a);
+  a.sup_all(0); a.sup_all(3); a.sup(10); a.sup(11, 3);
+  GMM_ASSERT1(a.is_empty() && a.size() == 0, "Region should be empty");
+
+  // Removing the visited elements does not invalidate the iteration, and
+  // the emptied entries are not taken into account by compare.
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 4);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  size_type nb_visited = 0;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    if (cv < 10) m.region(1).add(cv);
+    m.region(2).add(cv);
+  }
+  for (getfem::mr_visitor v(m.region(2)); !v.finished(); ++v, ++nb_visited)
+    if (v.cv() >= 10) m.region(2).sup_all(v.cv());
+  GMM_ASSERT1(nb_visited == m.nb_convex(), "Wrong number of visited entries");
+  GMM_ASSERT1(m.region(1).compare(m, m.region(2), m)
+              && m.region(2).compare(m, m.region(1), m),
+              "Regions with the same elements should compare equal");
+  m.region(2).sup(3);
+  GMM_ASSERT1(!m.region(1).compare(m, m.region(2), m),
+              "Regions with different elements should differ");
+}
+
+// Partitions of a region with a few costly elements between the threads:
+// each entry has to be visited once and the partitions of similar cost.
+void test_region_partitions() {
+  size_type nb_partitions = 4;
+  getfem::partition_master::get().set_nb_partitions(nb_partitions);
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 10);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    m.region(1).add(cv);
+    if (cv % 7 == 0) m.region(1).add(cv, 1);
+  }
+  getfem::mesh_region rg(m.region(1));
+  auto cost = [](size_type cv, bgeot::short_type f)
+  { return (f == bgeot::short_type(-1) && cv < 20) ? 50. : 1.; };
+
+  std::vector<std::vector<std::pair<size_type, bgeot::short_type>>>
+    visited(nb_partitions);
+  std::vector<double> partition_cost(nb_partitions);
+  GETFEM_OMP_PARALLEL(
+    size_type p = getfem::global_thread_policy::this_thread();
+    for (getfem::mr_visitor v(rg, m, false, cost); !v.finished(); ++v) {
+      visited[p].push_back(std::make_pair(v.cv(), v.f()));
+      partition_cost[p] += cost(v.cv(), v.f());
+    }
+  )
+
+  std::set<std::pair<size_type, bgeot::short_type>> entries;
+  size_type nb_visited = 0;
+  double total_cost = 0., max_cost = 0.;
+  for (size_type p = 0; p < nb_partitions; ++p) {
+    nb_visited += visited[p].size();
+    entries.insert(visited[p].begin(), visited[p].end());
+    total_cost += partition_cost[p];
+    max_cost = std::max(max_cost, partition_cost[p]);
+  }
+  GMM_ASSERT1(nb_visited == rg.size() && entries.size() == nb_visited,
+              "Wrong partitions of the region");
+  if (visited[1].size()) // The region has been partitioned
+    GMM_ASSERT1(max_cost <= total_cost / double(nb_partitions) + 51.,
+                "Unbalanced partitions, max cost: " << max_cost
+                << ", total cost: " << total_cost);
 }
 
 void test_convex_ref() {
@@ -348,6 +437,350 @@ void test_convex_ref() {
 //};
 
 
+void test_convex_colors(int dim, int Nsubdiv) {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(dim, Nsubdiv);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(dim, 1));
+  const std::vector<dal::bit_vector> &colors = m.convex_colors();
+  cout << "Coloring of " << m.nb_convex() << " convexes with "
+       << colors.size() << " colors\n";
+  size_type nbcv = 0;
+  for (const dal::bit_vector &color : colors) {
+    dal::bit_vector pts;
+    for (dal::bv_visitor cv(color); !cv.finished(); ++cv, ++nbcv)
+      for (size_type ip : m.ind_points_of_convex(cv)) {
+        GMM_ASSERT1(!pts.is_in(ip), "Two convexes of the same color "
+                    "share a point");
+        pts.add(ip);
+      }
+  }
+  GMM_ASSERT1(nbcv == m.nb_convex(), "Some convexes are not colored");
+  assert(&(m.convex_colors()) == &colors);
+}
+
+void test_dof_enumeration(const char *geotrans, const char *fem,
+                          int Nsubdiv, size_type nb_dof_expected) {
+  getfem::mesh m;
+  bgeot::pgeometric_trans pgt = bgeot::geometric_trans_descriptor(geotrans);
+  std::vector<size_type> nsubdiv(pgt->dim(), Nsubdiv);
+  getfem::regular_unit_mesh(m, nsubdiv, pgt, true);
+  getfem::mesh_fem mf(m);
+  mf.set_finite_element(getfem::fem_descriptor(fem));
+  cout << "Enumeration of the dofs of " << fem << " : "
+       << mf.nb_dof() << " dofs\n";
+  GMM_ASSERT1(mf.nb_dof() == nb_dof_expected, "Wrong number of dofs");
+
+  // Each dof has to be at the same place in all the elements sharing it
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    getfem::pfem pf = mf.fem_of_element(cv);
+    bgeot::pgeotrans_precomp pgp
+      = bgeot::geotrans_precomp(m.trans_of_convex(cv), pf->node_tab(cv), pf);
+    for (size_type i = 0; i < pf->nb_dof(cv); ++i) {
+      base_node P(m.dim());
+      pgp->transform(m.points_of_convex(cv), i, P);
+      size_type dof = mf.ind_basic_dof_of_element(cv)[i];
+      GMM_ASSERT1(gmm::vect_dist2(P, mf.point_of_basic_dof(dof)) < 1E-10,
+                  "Dof " << dof << " is not shared at the right place");
+    }
+  }
+}
+
+void test_binary_files() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 5);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::parallelepiped_geotrans(2, 1),
+                            true);
+  m.add_triangle_by_points(base_node(1.0, 0.0), base_node(1.5, 0.5),
+                           base_node(1.0, 0.2));
+  m.sup_convex(3, true);
+  m.region(1).add(5); m.region(1).add(7, 2);
+  m.region(4).add(m.convex_index());
+  getfem::mesh_fem mf(m, 2);
+  mf.set_classical_finite_element(2);
+  mf.set_finite_element(0, getfem::fem_descriptor
+                        ("FEM_QK_DISCONTINUOUS(2,1)"));
+  dal::bit_vector kept; kept.add(0, mf.nb_dof() / 2);
+  mf.reduce_to_basic_dof(kept);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  mf.write_to_file("test_mesh_text.mf", true);
+  mim.write_to_file("test_mesh_text.mim");
+  mf.write_to_binary_file("test_mesh_binary.mf", true);
+  mim.write_to_binary_file("test_mesh_binary.mim");
+
+  getfem::mesh mt, mb;
+  mt.read_from_file("test_mesh_text.mf");
+  mb.read_from_file("test_mesh_binary.mf");
+  getfem::mesh_fem mft(mt), mfb(mb);
+  mft.read_from_file("test_mesh_text.mf");
+  mfb.read_from_file("test_mesh_binary.mf");
+  getfem::mesh_im mimt(mt), mimb(mb);
+  mimt.read_from_file("test_mesh_text.mim");
+  mimb.read_from_file("test_mesh_binary.mim");
+
+  GMM_ASSERT1(mb.points_index() == mt.points_index() &&
+              mb.convex_index() == mt.convex_index(), "Wrong mesh indices");
+  for (dal::bv_visitor ip(mt.points_index()); !ip.finished(); ++ip)
+    GMM_ASSERT1(gmm::vect_dist2(m.points()[ip], mb.points()[ip]) == 0 &&
+                gmm::vect_dist2(mt.points()[ip], mb.points()[ip]) < 1E-12,
+                "Wrong point " << ip);
+  for (dal::bv_visitor cv(mt.convex_index()); !cv.finished(); ++cv) {
+    GMM_ASSERT1(mt.trans_of_convex(cv) == mb.trans_of_convex(cv) &&
+                std::equal(mt.ind_points_of_convex(cv).begin(),
+                           mt.ind_points_of_convex(cv).end(),
+                           mb.ind_points_of_convex(cv).begin()),
+                "Wrong convex " << cv);
+    GMM_ASSERT1(mft.fem_of_element(cv) == mfb.fem_of_element(cv) &&
+                std::equal(mft.ind_basic_dof_of_element(cv).begin(),
+                           mft.ind_basic_dof_of_element(cv).end(),
+                           mfb.ind_basic_dof_of_element(cv).begin()),
+                "Wrong dofs on convex " << cv);
+    GMM_ASSERT1(mimt.int_method_of_element(cv)
+                == mimb.int_method_of_element(cv),
+                "Wrong integration method on convex " << cv);
+  }
+  for (size_type rg : {1, 4}) {
+    std::stringstream st, sb;
+    st << mt.region(rg); sb << mb.region(rg);
+    GMM_ASSERT1(st.str() == sb.str(), "Wrong region " << rg);
+  }
+  GMM_ASSERT1(mfb.nb_dof() == mft.nb_dof() &&
+              mfb.nb_basic_dof() == mft.nb_basic_dof() &&
+              mfb.is_reduced() && gmm::nnz(mfb.reduction_matrix())
+              == gmm::nnz(mft.reduction_matrix()),
+              "Wrong dof numbers or reduction");
+  cout << "Binary files: " << mb.nb_points() << " points, "
+       << mb.nb_convex() << " convexes, " << mfb.nb_dof() << " dofs\n";
+}
+
+/* read back the data arrays of a vtu file with appended data */
+std::vector<std::vector<float>> read_appended_vtu(const std::string &name) {
+  std::ifstream f(name, std::ios::binary);
+  std::string s((std::istreambuf_iterator<char>(f)),
+                std::istreambuf_iterator<char>());
+  const std::string tag = "<AppendedData encoding=\"raw\">\n_";
+  size_type base = s.find(tag);
+  GMM_ASSERT1(base != std::string::npos, "No appended data in " << name);
+  base += tag.size();
+  bool compressed = (s.find("vtkZLibDataCompressor") < base);
+  std::vector<std::vector<float>> arrays;
+  for (size_type pos = s.find("offset=\""); pos < base;
+       pos = s.find("offset=\"", pos+1)) {
+    size_type off = std::stoull(s.substr(pos + 8));
+    const char *p = s.data() + base + off;
+    std::uint64_t head[3];
+    memcpy(head, p, sizeof(head));
+    std::vector<unsigned char> data;
+    if (!compressed) {
+      data.assign(p + 8, p + 8 + head[0]);
+    } else {
+#ifdef GETFEM_HAVE_ZLIB_H
+      const char *pz = p + (3 + head[0]) * 8;
+      for (size_type i = 0; i < head[0]; ++i) {
+        std::uint64_t zsize;
+        memcpy(&zsize, p + (3 + i) * 8, 8);
+        uLongf size = uLongf((i+1 == head[0] && head[2]) ? head[2] : head[1]);
+        data.resize(data.size() + size);
+        GMM_ASSERT1(uncompress(&data[data.size()-size], &size,
+                               (const Bytef *)(pz), uLong(zsize)) == Z_OK,
+                    "Wrong compressed block");
+        pz += zsize;
+      }
+#endif
+    }
+    arrays.emplace_back(data.size() / sizeof(float));
+    memcpy(arrays.back().data(), data.data(), data.size());
+  }
+  return arrays;
+}
+
+void test_vtu_export() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 10);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(2);
+  std::vector<double> U(mf.nb_dof());
+  for (size_type i = 0; i < mf.nb_dof(); ++i)
+    U[i] = mf.point_of_basic_dof(i)[0];
+
+  std::vector<bool> compress(1, false);
+#ifdef GETFEM_HAVE_ZLIB_H
+  compress.push_back(true);
+#endif
+  std::vector<std::vector<float>> raw_arrays;
+  for (bool c : compress) {
+    std::string name = c ? "test_mesh_zlib.vtu" : "test_mesh_raw.vtu";
+    {
+      getfem::vtu_export exp(name);
+      exp.set_appended_data(c);
+      exp.exporting(mf);
+      exp.write_point_data(mf, U, "x");
+      GMM_ASSERT1(exp.data_arrays().size() == 1, "Wrong data arrays");
+    }
+    // Points, connectivity, offsets, types and x
+    std::vector<std::vector<float>> arrays = read_appended_vtu(name);
+    GMM_ASSERT1(arrays.size() == 5, "Wrong number of arrays in " << name);
+    const std::vector<float> &pts = arrays[0], &x = arrays[4];
+    GMM_ASSERT1(pts.size() == 3 * x.size(), "Wrong size of data arrays");
+    for (size_type i = 0; i < x.size(); ++i)
+      GMM_ASSERT1(gmm::abs(pts[3*i] - x[i]) < 1E-6, "Wrong exported value");
+    if (!c) raw_arrays = arrays;
+    GMM_ASSERT1(arrays == raw_arrays, "Wrong compressed data");
+  }
+
+  // partitioned export, in two pieces
+  getfem::pvtu_export pexp("test_mesh_part.pvtu", 2);
+  size_type nb_cells = 0, nb_cv = m.convex_index().card();
+  for (size_type i = 0; i < pexp.nb_piece(); ++i) {
+    getfem::mesh_region rg;
+    for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+      if ((cv < nb_cv / 2) == (i == 0)) rg.add(cv);
+    std::unique_ptr<getfem::vtu_export> exp = pexp.piece(i);
+    exp->exporting(mf, rg);
+    exp->write_point_data(mf, U, "x");
+    if (i == 0) pexp.write_pvtu_file(exp->data_arrays());
+    exp.reset();
+    std::vector<std::vector<float>> arrays
+      = read_appended_vtu(pexp.piece_file_name(i));
+    nb_cells += arrays[3].size();
+  }
+  GMM_ASSERT1(nb_cells == nb_cv, "Wrong number of cells in the pieces");
+  std::ifstream f("test_mesh_part.pvtu");
+  std::string s((std::istreambuf_iterator<char>(f)),
+                std::istreambuf_iterator<char>());
+  GMM_ASSERT1(s.find("<Piece Source=\"test_mesh_part_1.vtu\"/>")
+              != std::string::npos && s.find("Name=\"x\"")
+              != std::string::npos, "Wrong pvtu file");
+  cout << "Vtu export: " << raw_arrays[4].size() << " points\n";
+}
+
+/* write a triangle mesh and its boundary in the gmsh format 4.1 */
+void write_gmsh_41(const getfem::mesh &m, const std::string &name,
+                   bool binary) {
+  std::ofstream f(name, std::ios::binary);
+  size_type nbpt = m.nb_points() + 1; // a node duplicated, to be merged
+  std::vector<size_type> elts;        // triangles
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    for (size_type ip : m.ind_points_of_convex(cv)) elts.push_back(ip+1);
+  elts[0] = nbpt;
+  getfem::mesh_region border;
+  getfem::outer_faces_of_mesh(m, border);
+  std::vector<size_type> edges;       // boundary lines
+  for (getfem::mr_visitor i(border); !i.finished(); ++i)
+    for (size_type ip : m.ind_points_of_face_of_convex(i.cv(), i.f()))
+      edges.push_back(ip+1);
+  size_type nbt = elts.size() / 3, nbl = edges.size() / 2;
+
+  auto put_i = [&f](int i) { f.write((const char *)(&i), sizeof(int)); };
+  auto put_s = [&f](std::uint64_t i) { f.write((const char *)(&i), 8); };
+  auto put_d = [&f](double d) { f.write((const char *)(&d), 8); };
+  f << "$MeshFormat\n4.1 " << (binary ? 1 : 0) << " 8\n";
+  if (binary) { put_i(1); f << "\n"; }
+  f << "$EndMeshFormat\n$PhysicalNames\n2\n1 2 \"boundary\"\n"
+    << "2 1 \"domain\"\n$EndPhysicalNames\n";
+  if (binary) { // one curve and one surface
+    f << "$Entities\n";
+    put_s(0); put_s(1); put_s(1); put_s(0);
+    for (int d = 1; d <= 2; ++d) {
+      put_i(d == 1 ? 2 : 1);
+      for (int k = 0; k < 6; ++k) put_d(0.);
+      put_s(1); put_i(d == 1 ? 2 : 1);
+      put_s(0);
+    }
+    f << "\n$EndEntities\n";
+  }
+  f << "$Nodes\n";
+  if (binary) {
+    put_s(1); put_s(nbpt); put_s(1); put_s(nbpt);
+    put_i(2); put_i(1); put_i(0); put_s(nbpt);
+    for (size_type i = 0; i < nbpt; ++i) put_s(i+1);
+    for (size_type i = 0; i < nbpt; ++i)
+      for (size_type k = 0; k < 3; ++k)
+        put_d(k < 2 ? m.points()[i < nbpt-1 ? i : 0][k] : 0.);
+    f << "\n";
+  } else {
+    f << "1 " << nbpt << " 1 " << nbpt << "\n2 1 0 " << nbpt << "\n";
+    for (size_type i = 0; i < nbpt; ++i) f << i+1 << "\n";
+    f << std::setprecision(17);
+    for (size_type i = 0; i < nbpt; ++i) {
+      const base_node &P = m.points()[i < nbpt-1 ? i : 0];
+      f << P[0] << " " << P[1] << " 0\n";
+    }
+  }
+  f << "$EndNodes\n$Elements\n";
+  if (binary) {
+    put_s(2); put_s(nbt + nbl); put_s(1); put_s(nbt + nbl);
+    put_i(2); put_i(1); put_i(2); put_s(nbt);
+    for (size_type k = 0; k < nbt; ++k)
+      { put_s(k+1); for (size_type l = 0; l < 3; ++l) put_s(elts[3*k+l]); }
+    put_i(1); put_i(2); put_i(1); put_s(nbl);
+    for (size_type k = 0; k < nbl; ++k)
+      { put_s(nbt+k+1); put_s(edges[2*k]); put_s(edges[2*k+1]); }
+    f << "\n";
+  } else {
+    f << "2 " << nbt + nbl << " 1 " << nbt + nbl << "\n2 1 2 " << nbt << "\n";
+    for (size_type k = 0; k < nbt; ++k)
+      f << k+1 << " " << elts[3*k] << " " << elts[3*k+1] << " "
+        << elts[3*k+2] << "\n";
+    f << "1 2 1 " << nbl << "\n";
+    for (size_type k = 0; k < nbl; ++k)
+      f << nbt+k+1 << " " << edges[2*k] << " " << edges[2*k+1] << "\n";
+  }
+  f << "$EndElements\n";
+}
+
+void test_gmsh_import() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 12);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  write_gmsh_41(m, "test_mesh_ascii.msh", false);
+  write_gmsh_41(m, "test_mesh_binary.msh", true);
+  getfem::mesh ma, mb;
+  std::map<std::string, size_type> rna, rnb;
+  getfem::import_mesh_gmsh("test_mesh_ascii.msh", ma, rna);
+  getfem::import_mesh_gmsh("test_mesh_binary.msh", mb, rnb);
+
+  GMM_ASSERT1(rna == rnb && rnb.size() == 2 && rnb["boundary"] == 2,
+              "Wrong region names");
+  GMM_ASSERT1(mb.dim() == 2 && mb.nb_points() == m.nb_points()
+              && mb.points_index() == ma.points_index()
+              && mb.convex_index() == ma.convex_index()
+              && mb.convex_index().card() == m.convex_index().card(),
+              "Wrong binary gmsh import");
+  for (dal::bv_visitor ip(mb.points_index()); !ip.finished(); ++ip)
+    GMM_ASSERT1(gmm::vect_dist2(ma.points()[ip], mb.points()[ip]) < 1E-15,
+                "Wrong point " << ip);
+  for (dal::bv_visitor cv(mb.convex_index()); !cv.finished(); ++cv)
+    GMM_ASSERT1(std::equal(ma.ind_points_of_convex(cv).begin(),
+                           ma.ind_points_of_convex(cv).end(),
+                           mb.ind_points_of_convex(cv).begin()),
+                "Wrong convex " << cv);
+  for (size_type rg : {1, 2}) {
+    std::stringstream sa, sb;
+    sa << ma.region(rg); sb << mb.region(rg);
+    GMM_ASSERT1(sa.str() == sb.str(), "Wrong region " << rg);
+  }
+  GMM_ASSERT1(mb.region(2).size() == 48, "Wrong boundary region");
+  cout << "Gmsh import: " << mb.nb_points() << " points, "
+       << mb.nb_convex() << " convexes\n";
+
+  // In the MSH2 format, an element of several physical groups is repeated
+  {
+    std::ofstream f("test_mesh_msh2.msh");
+    f << "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n$Nodes\n4\n1 0 0 0\n"
+      << "2 1 0 0\n3 1 1 0\n4 0 1 0\n$EndNodes\n$Elements\n3\n"
+      << "1 2 2 1 1 1 2 3\n2 2 2 2 1 1 2 3\n3 2 2 1 2 1 3 4\n"
+      << "$EndElements\n";
+  }
+  getfem::mesh m2;
+  getfem::import_mesh("gmsh:test_mesh_msh2.msh", m2);
+  GMM_ASSERT1(m2.nb_convex() == 2 && m2.region(1).size() == 2
+              && m2.region(2).size() == 1, "Wrong import of repeated "
+              "elements in the MSH2 format");
+}
+
 void test_mesh_building(int dim, int Nsubdiv) {
 
   double exectime = gmm::uclock_sec();
@@ -457,6 +890,44 @@ void test_mesh_building(int dim, int Nsubdiv) {
 }
 
 
+static void check_points_of_convexes(const getfem::mesh &m) {
+  getfem::base_matrix G;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    m.points_of_convex(cv, G);
+    for (size_type i = 0; i < m.nb_points_of_convex(cv); ++i)
+      for (size_type k = 0; k < m.dim(); ++k)
+        GMM_ASSERT1(G(k, i) == m.points_of_convex(cv)[i][k],
+                    "Wrong coordinates gathered for convex " << cv);
+  }
+}
+
+void test_points_gathering() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(3, 4);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(3, 1));
+  check_points_of_convexes(m);
+  check_points_of_convexes(m);
+
+  // Modifications through the non-const accessor of the points.
+  for (dal::bv_visitor ip(m.points().index()); !ip.finished(); ++ip) {
+    m.points()[ip][0] += 0.5 * m.points()[ip][1];
+    check_points_of_convexes(m);
+  }
+
+  m.sup_convex(0, true);
+  m.optimize_structure();
+  check_points_of_convexes(m);
+  base_small_vector V(3); V[2] = 1.;
+  m.translation(V);
+  check_points_of_convexes(m);
+
+  const bgeot::node_tab &pts = m.points();
+  for (dal::bv_visitor ip(pts.index()); !ip.finished(); ++ip)
+    for (size_type k = 0; k < pts.dim(); ++k)
+      GMM_ASSERT1(pts.coordinates()[ip*pts.dim()+k] == pts[ip][k],
+                  "Wrong contiguous coordinates");
+}
+
 void test_search_point() {
   const char *s = "BEGIN POINTS LIST\n"
     "  POINT  1  -4  6  2\n"
@@ -645,8 +1116,19 @@ int main(void) {
   test_convex_quality(-0.2,0);
   test_convex_quality(-0.01,-0.2);
   test_region();
+  test_convex_colors(2, 10);
+  test_convex_colors(3, 4);
+  test_dof_enumeration("GT_PK(2,1)", "FEM_PK(2,3)", 5, 16*16);
+  test_dof_enumeration("GT_PK(3,1)", "FEM_PK(3,2)", 3, 7*7*7);
+  test_dof_enumeration("GT_PK(3,2)", "FEM_PK(3,4)", 2, 9*9*9);
+  test_dof_enumeration("GT_QK(3,1)", "FEM_QK(3,3)", 2, 7*7*7);
+  test_dof_enumeration("GT_PK(2,1)", "FEM_PK_DISCONTINUOUS(2,1)", 4, 32*3);
+  test_binary_files();
+  test_vtu_export();
+  test_gmsh_import();
 
   test_search_point();
+  test_points_gathering();
   
   for (size_type d = 1; d <= 4 /* 6 */; ++d)
     test_mesh_matching(d);
@@ -659,6 +1141,8 @@ int main(void) {
   test_refinable(3, 3);
 
   test_incomplete_Q2();
+
+  test_region_partitions();
   
   return 0;
 }
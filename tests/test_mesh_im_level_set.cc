@@ -98,6 +98,28 @@ void test_2d() {
   if (gmm::abs(area - M_PI*R1*R1) > 1E-3)
     GMM_ASSERT1(false, "Cutting integration method has failed : " << area
 		<< " instead of " << M_PI*R1*R1 << ".");
+
+  // Move the smallest circle and only cut again the concerned elements
+  for (unsigned i=0; i < ls3mf.nb_dof(); ++i) {
+    ls3.values()[i] = -gmm::vect_dist2_sqr(ls3mf.point_of_basic_dof(i), 
+					   getfem::base_node(0.05,0.48)) +R3*R3;
+  }
+  mls.adapt(true);
+  getfem::mesh_level_set mls2(m);
+  mls2.add_level_set(ls1);
+  mls2.add_level_set(ls2);
+  mls2.add_level_set(ls3);
+  mls2.adapt();
+  for (dal::bv_visitor i(m.convex_index()); !i.finished(); ++i) {
+    GMM_ASSERT1(mls.is_convex_cut(i) == mls2.is_convex_cut(i)
+		&& mls.primary_zone_of_convex(i)
+		== mls2.primary_zone_of_convex(i),
+		"Incremental adapt differs on convex " << i);
+    if (mls.is_convex_cut(i))
+      GMM_ASSERT1(mls.zoneset_of_convex(i).size()
+		  == mls2.zoneset_of_convex(i).size(),
+		  "Incremental adapt differs on convex " << i);
+  }
 }
 
 
@@ -26,6 +26,7 @@ using std::ends; using std::cin;
 using bgeot::base_node;
 using bgeot::size_type;
 using bgeot::dim_type;
+using bgeot::scalar_type;
 using bgeot::rtree;
 
 static bool quick = false;
@@ -87,6 +88,30 @@ struct has_point_p {
   bool accept(const base_node& min2, const base_node& max2) 
   { return operator()(min2,max2); }
 };
+
+struct line_p {
+  const base_node org, dirv, min, max;
+  line_p(const base_node& org_, const base_node& dirv_,
+         const base_node& min_, const base_node& max_)
+    : org(org_), dirv(dirv_), min(min_), max(max_) {}
+  bool operator()(const base_node& min2, const base_node& max2) {
+    if (!r1_inter_r2(min,max,min2,max2)) return false;
+    size_type N = org.size();
+    for (size_type i = 0; i < N; ++i)
+      if (dirv[i] != 0.) {
+        double a1=(min2[i]-org[i])/dirv[i], a2=(max2[i]-org[i])/dirv[i];
+        bool interf1 = true, interf2 = true;
+        for (size_type j = 0; j < N; ++j)
+          if (j != i) {
+            double y1 = org[j] + a1*dirv[j], y2 = org[j] + a2*dirv[j];
+            if (y1 < min2[j] || y1 > max2[j]) interf1 = false;
+            if (y2 < min2[j] || y2 > max2[j]) interf2 = false;
+          }
+        if (interf1 || interf2) return true;
+      }
+    return false;
+  }
+};
   
 template <typename Predicate>
 static void brute_force_check(const std::vector<base_node>& rmin,
@@ -236,10 +261,104 @@ static void check_tree() {
   cout << "\nthe rtree is ok!\n";
 }
 
+static void verify_flat(const std::vector<base_node>& rmin,
+                        const std::vector<base_node>& rmax,
+                        const bgeot::flat_rtree& ftree, bgeot::rtree &tree) {
+  size_type N=rmin.front().size();
+  std::vector<size_type> pbset, pbset2;
+  std::vector<base_node> pts;
+  for (size_type i=0; i < 100; ++i) {
+    base_node min(N), max(N);
+    for (size_type k=0; k < N; ++k) { min[k] = gmm::random(double()*1.3); max[k] = min[k]+gmm::random()*0.1; }
+    ftree.find_intersecting_boxes(min,max,pbset);
+    brute_force_check(rmin,rmax,pbset,intersection_p(min,max));
+
+    ftree.find_boxes_at_point(min,pbset);
+    brute_force_check(rmin,rmax,pbset,has_point_p(min));
+    pts.push_back(min);
+
+    bgeot::base_small_vector dir(N);
+    for (size_type k=0; k < N; ++k) dir[k] = gmm::random(double());
+    ftree.find_line_intersecting_boxes(min, dir, pbset);
+    tree.find_line_intersecting_boxes(min, dir, pbset2);
+    assert(pbset == pbset2);
+    ftree.find_line_intersecting_boxes(min, dir, min, max, pbset);
+    brute_force_check(rmin,rmax,pbset,line_p(min, dir, min, max));
+    tree.find_line_intersecting_boxes(min, dir, min, max, pbset2);
+    assert(std::includes(pbset.begin(), pbset.end(),
+                         pbset2.begin(), pbset2.end()));
+  }
+  for (size_type i=0; i < rmin.size(); ++i) {
+    ftree.find_boxes_at_point(rmin[i],pbset);
+    assert(std::find(pbset.begin(), pbset.end(), i) != pbset.end());
+    ftree.find_boxes_at_point(rmax[i],pbset);
+    assert(std::find(pbset.begin(), pbset.end(), i) != pbset.end());
+    pts.push_back(rmax[i]);
+  }
+  std::vector<size_type> offsets;
+  ftree.find_boxes_at_points(pts, offsets, pbset2);
+  assert(offsets.size() == pts.size()+1);
+  for (size_type i=0; i < pts.size(); ++i) {
+    ftree.find_boxes_at_point(pts[i],pbset);
+    assert(std::equal(pbset.begin(), pbset.end(),
+                      pbset2.begin()+offsets[i]) &&
+           offsets[i+1]-offsets[i] == pbset.size());
+  }
+}
+
+static void check_flat_tree() {
+  for (size_type N = 2; N <= 3; ++N) {
+    cout << N << "D flat tree check\n";
+    bgeot::flat_rtree ftree;
+    bgeot::rtree tree;
+    std::vector<base_node> rmin, rmax;
+    for (size_type i=0; i < 600; ++i) {
+      base_node a(N), b(N);
+      for (size_type k=0; k < N; ++k)
+        { a[k] = gmm::random(double()); b[k] = a[k] + (1.+gmm::random())/10.; }
+      rmin.push_back(a); rmax.push_back(b);
+      assert(ftree.add_box(a, b) == i);
+      tree.add_box(a, b);
+    }
+    ftree.build_tree(); tree.build_tree();
+    verify_flat(rmin, rmax, ftree, tree);
+
+    // Deform the boxes and refit the tree without rebuilding it.
+    tree.clear();
+    for (size_type i=0; i < rmin.size(); ++i) {
+      for (size_type k=0; k < N; ++k) {
+        scalar_type d = 0.3*sin(3.*rmin[i][(k+1)%N]);
+        rmin[i][k] = 1.2*rmin[i][k] + d;
+        rmax[i][k] = 1.2*rmax[i][k] + d + 0.01*gmm::random();
+      }
+      ftree.set_box(i, rmin[i], rmax[i]);
+      tree.add_box(rmin[i], rmax[i]);
+    }
+    ftree.refit(); tree.build_tree();
+    verify_flat(rmin, rmax, ftree, tree);
+
+    // Scatter the boxes: the refitted nodes would overlap, the tree is
+    // built again by refit.
+    tree.clear();
+    for (size_type i=0; i < rmin.size(); ++i) {
+      for (size_type k=0; k < N; ++k) {
+        rmin[i][k] = gmm::random(double());
+        rmax[i][k] = rmin[i][k] + (1.+gmm::random())/10.;
+      }
+      ftree.set_box(i, rmin[i], rmax[i]);
+      tree.add_box(rmin[i], rmax[i]);
+    }
+    ftree.refit(); tree.build_tree();
+    verify_flat(rmin, rmax, ftree, tree);
+  }
+  cout << "\nthe flat rtree is ok!\n";
+}
+
 int main(int argc, char **argv) {
   if (argc == 2 && strcmp(argv[1],"-quick")==0) quick = true;
   try {
     check_tree();
+    check_flat_tree();
     /*if (!quick)
       speed_test(3,300000,20000);
       else speed_test(2,10000,100);*/